@@ -0,0 +1,71 @@
+// Copyright 2023, The Khronos Group Inc.
+//
+// SPDX-License-Identifier: MIT
+
+// OpenXR Tutorial for Khronos Group
+
+#pragma once
+
+// C/C++ Headers
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+
+// A fixed capacity FIFO for handing work from one thread to another.
+// Push() blocks while the queue is full and Pop() blocks while it is empty, so a producer can never run more than 'capacity'
+// items ahead of its consumer. Close() wakes every waiter: after it, Push() is refused and Pop() drains the items already
+// queued before returning false.
+template <typename T>
+class BoundedQueue {
+public:
+    explicit BoundedQueue(size_t capacity)
+        : capacity(capacity) {}
+
+    // Returns false, dropping the value, if the queue was closed.
+    bool Push(const T &value) {
+        std::unique_lock<std::mutex> lock(mutex);
+        notFull.wait(lock, [this] { return closed || items.size() < capacity; });
+        if (closed) {
+            return false;
+        }
+        items.push_back(value);
+        notEmpty.notify_one();
+        return true;
+    }
+
+    // Returns false once the queue is closed and empty.
+    bool Pop(T &value) {
+        std::unique_lock<std::mutex> lock(mutex);
+        notEmpty.wait(lock, [this] { return closed || !items.empty(); });
+        if (items.empty()) {
+            return false;
+        }
+        value = items.front();
+        items.pop_front();
+        notFull.notify_one();
+        return true;
+    }
+
+    void Close() {
+        std::lock_guard<std::mutex> lock(mutex);
+        closed = true;
+        notEmpty.notify_all();
+        notFull.notify_all();
+    }
+
+    // Empties and reopens the queue. No thread may be waiting on it.
+    void Reset() {
+        std::lock_guard<std::mutex> lock(mutex);
+        items.clear();
+        closed = false;
+    }
+
+private:
+    const size_t capacity;
+    std::deque<T> items{};
+    bool closed = false;
+    std::mutex mutex;
+    std::condition_variable notEmpty;
+    std::condition_variable notFull;
+};
@@ -0,0 +1,315 @@
+// Copyright 2023, The Khronos Group Inc.
+//
+// SPDX-License-Identifier: MIT
+
+// OpenXR Tutorial for Khronos Group
+
+#include <CommandBuffer.h>
+
+#pragma region CommandArguments
+namespace {
+struct SetBufferDataArguments {
+    void *buffer;
+    size_t offset;
+    size_t size;
+};
+struct ClearColorArguments {
+    void *imageView;
+    float r, g, b, a;
+};
+struct ClearDepthArguments {
+    void *imageView;
+    float d;
+    uint32_t padding;  // Named so that it is zeroed, keeping GetHash() deterministic.
+};
+struct SetRenderAttachmentsArguments {
+    size_t colorViewCount;  // The color views follow as an array.
+    void *depthStencilView;
+    uint32_t width;
+    uint32_t height;
+    void *pipeline;
+};
+struct ArrayArguments {
+    size_t count;  // The elements follow as an array.
+};
+struct HandleArguments {
+    void *handle;
+};
+struct DrawIndexedArguments {
+    uint32_t indexCount;
+    uint32_t instanceCount;
+    uint32_t firstIndex;
+    int32_t vertexOffset;
+    uint32_t firstInstance;
+};
+struct DrawArguments {
+    uint32_t vertexCount;
+    uint32_t instanceCount;
+    uint32_t firstVertex;
+    uint32_t firstInstance;
+};
+struct NameArguments {
+    const char *name;
+};
+struct DrawIndirectArguments {
+    void *indirectBuffer;
+    size_t offset;
+    uint32_t drawCount;
+    uint32_t stride;
+};
+}  // namespace
+#pragma endregion
+
+#pragma region Recording
+template <typename Arguments>
+void CommandBuffer::Record(Command command, const Arguments &arguments, const void *arrayData, size_t arrayDataSize) {
+    const size_t argumentsOffset = Align(sizeof(CommandHeader), commandAlignment);
+    const size_t arrayOffset = argumentsOffset + Align(sizeof(Arguments), commandAlignment);
+    const size_t size = Align(arrayOffset + arrayDataSize, commandAlignment);
+
+    const size_t begin = data.size();
+    data.resize(begin + size);
+    uint8_t *commandData = data.data() + begin;
+
+    CommandHeader header{command, static_cast<uint32_t>(size)};
+    memcpy(commandData, &header, sizeof(CommandHeader));
+    memcpy(commandData + argumentsOffset, &arguments, sizeof(Arguments));
+    if (arrayDataSize) {
+        memcpy(commandData + arrayOffset, arrayData, arrayDataSize);
+    }
+    commandCount++;
+}
+
+void CommandBuffer::Record(Command command) {
+    const size_t size = Align(sizeof(CommandHeader), commandAlignment);
+    const size_t begin = data.size();
+    data.resize(begin + size);
+
+    CommandHeader header{command, static_cast<uint32_t>(size)};
+    memcpy(data.data() + begin, &header, sizeof(CommandHeader));
+    commandCount++;
+}
+
+void CommandBuffer::BeginRendering() {
+    Record(Command::BEGIN_RENDERING);
+}
+
+void CommandBuffer::EndRendering() {
+    Record(Command::END_RENDERING);
+}
+
+void CommandBuffer::SetBufferData(void *buffer, size_t offset, size_t size, const void *data) {
+    Record(Command::SET_BUFFER_DATA, SetBufferDataArguments{buffer, offset, size}, data, data ? size : 0);
+}
+
+void CommandBuffer::ClearColor(void *imageView, float r, float g, float b, float a) {
+    Record(Command::CLEAR_COLOR, ClearColorArguments{imageView, r, g, b, a});
+}
+
+void CommandBuffer::ClearDepth(void *imageView, float d) {
+    Record(Command::CLEAR_DEPTH, ClearDepthArguments{imageView, d});
+}
+
+void CommandBuffer::SetRenderAttachments(void *const *colorViews, size_t colorViewCount, void *depthStencilView, uint32_t width, uint32_t height, void *pipeline) {
+    Record(Command::SET_RENDER_ATTACHMENTS, SetRenderAttachmentsArguments{colorViewCount, depthStencilView, width, height, pipeline}, colorViews, sizeof(void *) * colorViewCount);
+}
+
+void CommandBuffer::SetViewports(const GraphicsAPI::Viewport *viewports, size_t count) {
+    Record(Command::SET_VIEWPORTS, ArrayArguments{count}, viewports, sizeof(GraphicsAPI::Viewport) * count);
+}
+
+void CommandBuffer::SetScissors(const GraphicsAPI::Rect2D *scissors, size_t count) {
+    Record(Command::SET_SCISSORS, ArrayArguments{count}, scissors, sizeof(GraphicsAPI::Rect2D) * count);
+}
+
+void CommandBuffer::SetPipeline(void *pipeline) {
+    Record(Command::SET_PIPELINE, HandleArguments{pipeline});
+}
+
+void CommandBuffer::SetDescriptor(const GraphicsAPI::DescriptorInfo &descriptorInfo) {
+    // DescriptorInfo has padding between its members. Copy it member by member into zeroed storage, so that GetHash() does not
+    // see uninitialized bytes.
+    GraphicsAPI::DescriptorInfo arguments;
+    memset(&arguments, 0, sizeof(arguments));
+    arguments.bindingIndex = descriptorInfo.bindingIndex;
+    arguments.resource = descriptorInfo.resource;
+    arguments.type = descriptorInfo.type;
+    arguments.stage = descriptorInfo.stage;
+    arguments.readWrite = descriptorInfo.readWrite;
+    arguments.bufferOffset = descriptorInfo.bufferOffset;
+    arguments.bufferSize = descriptorInfo.bufferSize;
+    Record(Command::SET_DESCRIPTOR, arguments);
+}
+
+void CommandBuffer::UpdateDescriptors() {
+    Record(Command::UPDATE_DESCRIPTORS);
+}
+
+void CommandBuffer::SetVertexBuffers(void *const *vertexBuffers, size_t count) {
+    Record(Command::SET_VERTEX_BUFFERS, ArrayArguments{count}, vertexBuffers, sizeof(void *) * count);
+}
+
+void CommandBuffer::SetIndexBuffer(void *indexBuffer) {
+    Record(Command::SET_INDEX_BUFFER, HandleArguments{indexBuffer});
+}
+
+void CommandBuffer::DrawIndexed(uint32_t indexCount, uint32_t instanceCount, uint32_t firstIndex, int32_t vertexOffset, uint32_t firstInstance) {
+    Record(Command::DRAW_INDEXED, DrawIndexedArguments{indexCount, instanceCount, firstIndex, vertexOffset, firstInstance});
+}
+
+void CommandBuffer::Draw(uint32_t vertexCount, uint32_t instanceCount, uint32_t firstVertex, uint32_t firstInstance) {
+    Record(Command::DRAW, DrawArguments{vertexCount, instanceCount, firstVertex, firstInstance});
+}
+
+void CommandBuffer::DrawIndexedIndirect(void *indirectBuffer, size_t offset) {
+    Record(Command::DRAW_INDEXED_INDIRECT, DrawIndirectArguments{indirectBuffer, offset, 1, sizeof(GraphicsAPI::DrawIndexedIndirectCommand)});
+}
+
+void CommandBuffer::MultiDrawIndexedIndirect(void *indirectBuffer, size_t offset, uint32_t drawCount, uint32_t stride) {
+    Record(Command::MULTI_DRAW_INDEXED_INDIRECT, DrawIndirectArguments{indirectBuffer, offset, drawCount, stride});
+}
+
+void CommandBuffer::BeginGpuZone(const char *name) {
+    Record(Command::BEGIN_GPU_ZONE, NameArguments{name});
+}
+
+void CommandBuffer::EndGpuZone() {
+    Record(Command::END_GPU_ZONE);
+}
+#pragma endregion
+
+#pragma region Replay
+void CommandBuffer::Replay(GraphicsAPI &graphicsAPI) const {
+    const size_t argumentsOffset = Align(sizeof(CommandHeader), commandAlignment);
+
+    size_t offset = 0;
+    while (offset < data.size()) {
+        const uint8_t *commandData = data.data() + offset;
+        CommandHeader header;
+        memcpy(&header, commandData, sizeof(CommandHeader));
+
+        // Every part of a command is 8 byte aligned, so its arguments and arrays can be read in place. The GraphicsAPI
+        // functions take non-const array pointers, but do not write through them.
+        auto GetArguments = [&](auto &arguments) {
+            memcpy(&arguments, commandData + argumentsOffset, sizeof(arguments));
+            return const_cast<uint8_t *>(commandData) + argumentsOffset + Align(sizeof(arguments), commandAlignment);
+        };
+
+        switch (header.command) {
+        case Command::BEGIN_RENDERING: {
+            graphicsAPI.BeginRendering();
+            break;
+        }
+        case Command::END_RENDERING: {
+            graphicsAPI.EndRendering();
+            break;
+        }
+        case Command::SET_BUFFER_DATA: {
+            SetBufferDataArguments arguments;
+            uint8_t *bufferData = GetArguments(arguments);
+            graphicsAPI.SetBufferData(arguments.buffer, arguments.offset, arguments.size, bufferData);
+            break;
+        }
+        case Command::CLEAR_COLOR: {
+            ClearColorArguments arguments;
+            GetArguments(arguments);
+            graphicsAPI.ClearColor(arguments.imageView, arguments.r, arguments.g, arguments.b, arguments.a);
+            break;
+        }
+        case Command::CLEAR_DEPTH: {
+            ClearDepthArguments arguments;
+            GetArguments(arguments);
+            graphicsAPI.ClearDepth(arguments.imageView, arguments.d);
+            break;
+        }
+        case Command::SET_RENDER_ATTACHMENTS: {
+            SetRenderAttachmentsArguments arguments;
+            void **colorViews = reinterpret_cast<void **>(GetArguments(arguments));
+            graphicsAPI.SetRenderAttachments(colorViews, arguments.colorViewCount, arguments.depthStencilView, arguments.width, arguments.height, arguments.pipeline);
+            break;
+        }
+        case Command::SET_VIEWPORTS: {
+            ArrayArguments arguments;
+            GraphicsAPI::Viewport *viewports = reinterpret_cast<GraphicsAPI::Viewport *>(GetArguments(arguments));
+            graphicsAPI.SetViewports(viewports, arguments.count);
+            break;
+        }
+        case Command::SET_SCISSORS: {
+            ArrayArguments arguments;
+            GraphicsAPI::Rect2D *scissors = reinterpret_cast<GraphicsAPI::Rect2D *>(GetArguments(arguments));
+            graphicsAPI.SetScissors(scissors, arguments.count);
+            break;
+        }
+        case Command::SET_PIPELINE: {
+            HandleArguments arguments;
+            GetArguments(arguments);
+            graphicsAPI.SetPipeline(arguments.handle);
+            break;
+        }
+        case Command::SET_DESCRIPTOR: {
+            GraphicsAPI::DescriptorInfo descriptorInfo;
+            GetArguments(descriptorInfo);
+            graphicsAPI.SetDescriptor(descriptorInfo);
+            break;
+        }
+        case Command::UPDATE_DESCRIPTORS: {
+            graphicsAPI.UpdateDescriptors();
+            break;
+        }
+        case Command::SET_VERTEX_BUFFERS: {
+            ArrayArguments arguments;
+            void **vertexBuffers = reinterpret_cast<void **>(GetArguments(arguments));
+            graphicsAPI.SetVertexBuffers(vertexBuffers, arguments.count);
+            break;
+        }
+        case Command::SET_INDEX_BUFFER: {
+            HandleArguments arguments;
+            GetArguments(arguments);
+            graphicsAPI.SetIndexBuffer(arguments.handle);
+            break;
+        }
+        case Command::DRAW_INDEXED: {
+            DrawIndexedArguments arguments;
+            GetArguments(arguments);
+            graphicsAPI.DrawIndexed(arguments.indexCount, arguments.instanceCount, arguments.firstIndex, arguments.vertexOffset, arguments.firstInstance);
+            break;
+        }
+        case Command::DRAW: {
+            DrawArguments arguments;
+            GetArguments(arguments);
+            graphicsAPI.Draw(arguments.vertexCount, arguments.instanceCount, arguments.firstVertex, arguments.firstInstance);
+            break;
+        }
+        case Command::DRAW_INDEXED_INDIRECT: {
+            DrawIndirectArguments arguments;
+            GetArguments(arguments);
+            graphicsAPI.DrawIndexedIndirect(arguments.indirectBuffer, arguments.offset);
+            break;
+        }
+        case Command::MULTI_DRAW_INDEXED_INDIRECT: {
+            DrawIndirectArguments arguments;
+            GetArguments(arguments);
+            graphicsAPI.MultiDrawIndexedIndirect(arguments.indirectBuffer, arguments.offset, arguments.drawCount, arguments.stride);
+            break;
+        }
+        case Command::BEGIN_GPU_ZONE: {
+            NameArguments arguments;
+            GetArguments(arguments);
+            graphicsAPI.BeginGpuZone(arguments.name);
+            break;
+        }
+        case Command::END_GPU_ZONE: {
+            graphicsAPI.EndGpuZone();
+            break;
+        }
+        default: {
+            std::cout << "ERROR: CommandBuffer: Unknown Command: " << (uint32_t)header.command << std::endl;
+            DEBUG_BREAK;
+            return;
+        }
+        }
+
+        offset += header.size;
+    }
+}
+#pragma endregion
@@ -0,0 +1,94 @@
+// Copyright 2023, The Khronos Group Inc.
+//
+// SPDX-License-Identifier: MIT
+
+// OpenXR Tutorial for Khronos Group
+
+#pragma once
+#include <GraphicsAPI.h>
+
+// Records GraphicsAPI commands into a linear byte stream that GraphicsAPI::Submit() replays later.
+// Recording makes no graphics API calls, so a CommandBuffer can be built on any thread and submitted on the thread that owns the
+// graphics context. Arrays and data are copied when recorded; resource handles are not, so the resources must stay alive until
+// the CommandBuffer has been submitted.
+class CommandBuffer {
+public:
+    enum class Command : uint32_t {
+        BEGIN_RENDERING,
+        END_RENDERING,
+        SET_BUFFER_DATA,
+        CLEAR_COLOR,
+        CLEAR_DEPTH,
+        SET_RENDER_ATTACHMENTS,
+        SET_VIEWPORTS,
+        SET_SCISSORS,
+        SET_PIPELINE,
+        SET_DESCRIPTOR,
+        UPDATE_DESCRIPTORS,
+        SET_VERTEX_BUFFERS,
+        SET_INDEX_BUFFER,
+        DRAW_INDEXED,
+        DRAW,
+        DRAW_INDEXED_INDIRECT,
+        MULTI_DRAW_INDEXED_INDIRECT,
+        BEGIN_GPU_ZONE,
+        END_GPU_ZONE,
+    };
+
+public:
+    void Reset() {
+        data.clear();
+        commandCount = 0;
+    }
+    bool IsEmpty() const { return commandCount == 0; }
+    size_t GetCommandCount() const { return commandCount; }
+    size_t GetSize() const { return data.size(); }
+    // Of the recorded bytes. Two CommandBuffers with equal hashes replay the same commands with the same arguments, which lets a
+    // GraphicsAPI reuse work it did for an earlier submission. Array data is hashed by value and handles by identity.
+    uint64_t GetHash() const { return HashFNV1a(data.data(), data.size()); }
+
+    // These mirror the GraphicsAPI functions of the same name.
+    void BeginRendering();
+    void EndRendering();
+
+    void SetBufferData(void* buffer, size_t offset, size_t size, const void* data);
+
+    void ClearColor(void* imageView, float r, float g, float b, float a);
+    void ClearDepth(void* imageView, float d);
+
+    void SetRenderAttachments(void* const* colorViews, size_t colorViewCount, void* depthStencilView, uint32_t width, uint32_t height, void* pipeline);
+    void SetViewports(const GraphicsAPI::Viewport* viewports, size_t count);
+    void SetScissors(const GraphicsAPI::Rect2D* scissors, size_t count);
+
+    void SetPipeline(void* pipeline);
+    void SetDescriptor(const GraphicsAPI::DescriptorInfo& descriptorInfo);
+    void UpdateDescriptors();
+    void SetVertexBuffers(void* const* vertexBuffers, size_t count);
+    void SetIndexBuffer(void* indexBuffer);
+    void DrawIndexed(uint32_t indexCount, uint32_t instanceCount = 1, uint32_t firstIndex = 0, int32_t vertexOffset = 0, uint32_t firstInstance = 0);
+    void Draw(uint32_t vertexCount, uint32_t instanceCount = 1, uint32_t firstVertex = 0, uint32_t firstInstance = 0);
+    void DrawIndexedIndirect(void* indirectBuffer, size_t offset);
+    void MultiDrawIndexedIndirect(void* indirectBuffer, size_t offset, uint32_t drawCount, uint32_t stride = sizeof(GraphicsAPI::DrawIndexedIndirectCommand));
+
+    // Only the pointer is recorded, as GraphicsAPI::BeginGpuZone() requires a name that outlives it anyway.
+    void BeginGpuZone(const char* name);
+    void EndGpuZone();
+
+    // Calls the recorded commands, in order, on graphicsAPI. Called by GraphicsAPI::Submit().
+    void Replay(GraphicsAPI& graphicsAPI) const;
+
+private:
+    // Each command is a CommandHeader, its arguments struct and then any array data, each part starting on an 8 byte boundary.
+    static constexpr size_t commandAlignment = 8;
+    struct CommandHeader {
+        Command command;
+        uint32_t size;  // Of the whole command, including this header and any padding.
+    };
+    template <typename Arguments>
+    void Record(Command command, const Arguments& arguments, const void* arrayData = nullptr, size_t arrayDataSize = 0);
+    void Record(Command command);
+
+private:
+    std::vector<uint8_t> data{};
+    size_t commandCount = 0;
+};
@@ -0,0 +1,189 @@
+// Copyright 2023, The Khronos Group Inc.
+//
+// SPDX-License-Identifier: MIT
+
+// OpenXR Tutorial for Khronos Group
+
+#include <DrawQueue.h>
+
+namespace {
+bool SameDescriptor(const GraphicsAPI::DescriptorInfo &a, const GraphicsAPI::DescriptorInfo &b) {
+    return a.resource == b.resource && a.type == b.type && a.stage == b.stage && a.readWrite == b.readWrite && a.bufferOffset == b.bufferOffset && a.bufferSize == b.bufferSize;
+}
+bool SameScissor(const GraphicsAPI::Rect2D &a, const GraphicsAPI::Rect2D &b) {
+    return a.offset.x == b.offset.x && a.offset.y == b.offset.y && a.extent.width == b.extent.width && a.extent.height == b.extent.height;
+}
+}  // namespace
+
+uint64_t DrawQueue::MakeSortKey(Layer layer, uint32_t pipelineId, uint32_t materialId, float depth, float maxDepth) {
+    static constexpr uint32_t depthMask = (1u << 24) - 1;
+    const float normalizedDepth = maxDepth > 0.0f ? std::min(std::max(depth / maxDepth, 0.0f), 1.0f) : 0.0f;
+    uint64_t quantizedDepth = static_cast<uint64_t>(normalizedDepth * depthMask);
+    const uint64_t pipelineAndMaterial = (static_cast<uint64_t>(pipelineId & maxPipelineId) << 24) | (materialId & maxMaterialId);
+
+    uint64_t key = static_cast<uint64_t>(layer) << 60;
+    if (layer == Layer::TRANSLUCENT) {
+        quantizedDepth = depthMask - quantizedDepth;
+        key |= (quantizedDepth << 36) | pipelineAndMaterial;
+    } else {
+        key |= (pipelineAndMaterial << 24) | quantizedDepth;
+    }
+    return key;
+}
+
+void DrawQueue::Add(const DrawPacket &packet, const GraphicsAPI::DescriptorInfo *descriptorInfos, size_t descriptorCount) {
+    DrawPacket drawPacket = packet;
+    drawPacket.firstDescriptor = static_cast<uint32_t>(descriptors.size());
+    drawPacket.descriptorCount = static_cast<uint32_t>(descriptorCount);
+    descriptors.insert(descriptors.end(), descriptorInfos, descriptorInfos + descriptorCount);
+    packets.push_back(drawPacket);
+}
+
+void DrawQueue::Submit(CommandBuffer &commandBuffer) {
+    if (packets.empty()) {
+        return;
+    }
+
+    // What recording in the order the draws were added would have cost.
+    uint32_t unsortedPipelineSwitches = 0;
+    uint32_t unsortedBindingSwitches = 0;
+    uint32_t unsortedScissorSwitches = 0;
+    order.resize(packets.size());
+    for (uint32_t i = 0; i < static_cast<uint32_t>(order.size()); i++) {
+        order[i] = i;
+    }
+    Record(order, nullptr, unsortedPipelineSwitches, unsortedBindingSwitches, unsortedScissorSwitches);
+
+    keys.resize(packets.size());
+    for (size_t i = 0; i < packets.size(); i++) {
+        keys[i] = packets[i].sortKey;
+    }
+    RadixSort(keys, order, scratch);
+    uint32_t pipelineSwitches = 0;
+    uint32_t bindingSwitches = 0;
+    uint32_t scissorSwitches = 0;
+    Record(order, &commandBuffer, pipelineSwitches, bindingSwitches, scissorSwitches);
+
+    statistics.draws += static_cast<uint32_t>(packets.size());
+    statistics.pipelineSwitches += pipelineSwitches;
+    statistics.bindingSwitches += bindingSwitches;
+    statistics.scissorSwitches += scissorSwitches;
+    statistics.pipelineSwitchesAvoided += static_cast<int32_t>(unsortedPipelineSwitches) - static_cast<int32_t>(pipelineSwitches);
+    statistics.bindingSwitchesAvoided += static_cast<int32_t>(unsortedBindingSwitches) - static_cast<int32_t>(bindingSwitches);
+    statistics.scissorSwitchesAvoided += static_cast<int32_t>(unsortedScissorSwitches) - static_cast<int32_t>(scissorSwitches);
+
+    packets.clear();
+    descriptors.clear();
+}
+
+void DrawQueue::RadixSort(const std::vector<uint64_t> &keys, std::vector<uint32_t> &order, std::vector<uint32_t> &scratch) {
+    const size_t count = keys.size();
+    order.resize(count);
+    scratch.resize(count);
+    for (uint32_t i = 0; i < static_cast<uint32_t>(count); i++) {
+        order[i] = i;
+    }
+    if (count == 0) {
+        return;
+    }
+
+    std::array<uint32_t, 256> histogram;
+    for (uint32_t shift = 0; shift < 64; shift += 8) {
+        histogram.fill(0);
+        for (uint64_t key : keys) {
+            histogram[(key >> shift) & 0xFF]++;
+        }
+        // A digit all keys share leaves the order as it is.
+        if (histogram[(keys[0] >> shift) & 0xFF] == count) {
+            continue;
+        }
+        uint32_t offset = 0;
+        for (uint32_t &bucket : histogram) {
+            const uint32_t bucketCount = bucket;
+            bucket = offset;
+            offset += bucketCount;
+        }
+        for (uint32_t index : order) {
+            scratch[histogram[(keys[index] >> shift) & 0xFF]++] = index;
+        }
+        order.swap(scratch);
+    }
+}
+
+void DrawQueue::Record(const std::vector<uint32_t> &order, CommandBuffer *commandBuffer, uint32_t &pipelineSwitches, uint32_t &bindingSwitches, uint32_t &scissorSwitches) {
+    const GraphicsAPI::Rect2D *boundScissor = nullptr;
+    void *boundPipeline = nullptr;
+    void *boundVertexBuffer = nullptr;
+    void *boundIndexBuffer = nullptr;
+    boundDescriptors.clear();
+    boundDescriptorsValid.clear();
+
+    for (uint32_t index : order) {
+        const DrawPacket &packet = packets[index];
+        bool updateDescriptors = false;
+        if (packet.pipeline != boundPipeline) {
+            boundPipeline = packet.pipeline;
+            // The vertex buffer bindings belong to the pipeline's vertex input state.
+            boundVertexBuffer = nullptr;
+            updateDescriptors = true;
+            pipelineSwitches++;
+            if (commandBuffer) {
+                commandBuffer->SetPipeline(packet.pipeline);
+            }
+        }
+
+        for (uint32_t i = packet.firstDescriptor; i < packet.firstDescriptor + packet.descriptorCount; i++) {
+            const GraphicsAPI::DescriptorInfo &descriptorInfo = descriptors[i];
+            const uint32_t bindingIndex = descriptorInfo.bindingIndex;
+            if (bindingIndex >= boundDescriptors.size()) {
+                boundDescriptors.resize(bindingIndex + 1);
+                boundDescriptorsValid.resize(bindingIndex + 1, false);
+            }
+            if (boundDescriptorsValid[bindingIndex] && SameDescriptor(boundDescriptors[bindingIndex], descriptorInfo)) {
+                continue;
+            }
+            boundDescriptors[bindingIndex] = descriptorInfo;
+            boundDescriptorsValid[bindingIndex] = true;
+            updateDescriptors = true;
+            bindingSwitches++;
+            if (commandBuffer) {
+                commandBuffer->SetDescriptor(descriptorInfo);
+            }
+        }
+        if (updateDescriptors && commandBuffer) {
+            commandBuffer->UpdateDescriptors();
+        }
+
+        if (packet.vertexBuffer && packet.vertexBuffer != boundVertexBuffer) {
+            boundVertexBuffer = packet.vertexBuffer;
+            bindingSwitches++;
+            if (commandBuffer) {
+                commandBuffer->SetVertexBuffers(&packet.vertexBuffer, 1);
+            }
+        }
+        if (packet.indexBuffer && packet.indexBuffer != boundIndexBuffer) {
+            boundIndexBuffer = packet.indexBuffer;
+            bindingSwitches++;
+            if (commandBuffer) {
+                commandBuffer->SetIndexBuffer(packet.indexBuffer);
+            }
+        }
+
+        if (!boundScissor || !SameScissor(*boundScissor, packet.scissor)) {
+            boundScissor = &packet.scissor;
+            scissorSwitches++;
+            if (commandBuffer) {
+                commandBuffer->SetScissors(&packet.scissor, 1);
+            }
+        }
+
+        if (!commandBuffer) {
+            continue;
+        }
+        if (packet.indexBuffer) {
+            commandBuffer->DrawIndexed(packet.count, packet.instanceCount, packet.first, packet.vertexOffset, packet.firstInstance);
+        } else {
+            commandBuffer->Draw(packet.count, packet.instanceCount, packet.first, packet.firstInstance);
+        }
+    }
+}
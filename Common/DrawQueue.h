@@ -0,0 +1,87 @@
+// Copyright 2023, The Khronos Group Inc.
+//
+// SPDX-License-Identifier: MIT
+
+// OpenXR Tutorial for Khronos Group
+
+#pragma once
+#include <CommandBuffer.h>
+
+// Collects a pass's draws as packets with a 64-bit sort key, radix sorts them and records them into a CommandBuffer, setting
+// the pipeline, descriptors, buffers and scissor only where they differ from the previous draw. The viewport is the pass's, set
+// before Submit().
+//
+// From the most significant bit, a key holds the layer (4 bits), then the pipeline id (12 bits), the material id (24 bits) and
+// the quantized view depth (24 bits). Layers draw in order. Within a layer, draws are grouped by pipeline, then material, and
+// go front to back for early depth rejection, except in the TRANSLUCENT layer, where the inverted depth comes first so that
+// blended draws go back to front. Pipeline and material ids are the caller's; draws with the same material id are expected to
+// use mostly the same descriptors.
+class DrawQueue {
+public:
+    enum class Layer : uint8_t {
+        BACKGROUND,
+        SOLID,
+        TRANSLUCENT,
+        OVERLAY
+    };
+    static constexpr uint32_t maxPipelineId = (1u << 12) - 1;
+    static constexpr uint32_t maxMaterialId = (1u << 24) - 1;
+    // The depth is clamped to [0, maxDepth] and quantized to 24 bits.
+    static uint64_t MakeSortKey(Layer layer, uint32_t pipelineId, uint32_t materialId, float depth, float maxDepth);
+
+    struct DrawPacket {
+        uint64_t sortKey;
+        void* pipeline;
+        void* vertexBuffer;  // nullptr if the pipeline has no vertex input.
+        void* indexBuffer;   // nullptr for a Draw() rather than a DrawIndexed().
+        uint32_t count;      // Of indices, or of vertices without an index buffer.
+        uint32_t instanceCount;
+        uint32_t first;      // Index, or vertex without an index buffer.
+        int32_t vertexOffset;
+        uint32_t firstInstance;
+        GraphicsAPI::Rect2D scissor;
+        uint32_t firstDescriptor;  // Into the queue's descriptors, set by Add().
+        uint32_t descriptorCount;
+    };
+
+    // Accumulated over Submit() calls until ResetStatistics(). The avoided switches compare against recording the same draws
+    // in the order they were added, and are negative if the sort cost switches.
+    struct Statistics {
+        uint32_t draws;
+        uint32_t pipelineSwitches;  // SetPipeline() calls recorded.
+        uint32_t bindingSwitches;   // SetDescriptor(), SetVertexBuffers() and SetIndexBuffer() calls recorded.
+        uint32_t scissorSwitches;   // SetScissors() calls recorded.
+        int32_t pipelineSwitchesAvoided;
+        int32_t bindingSwitchesAvoided;
+        int32_t scissorSwitchesAvoided;
+    };
+
+public:
+    // Copies the packet and its descriptors.
+    void Add(const DrawPacket& packet, const GraphicsAPI::DescriptorInfo* descriptors, size_t descriptorCount);
+    bool IsEmpty() const { return packets.empty(); }
+
+    // Sorts the packets added since the last Submit(), records them into commandBuffer and empties the queue.
+    void Submit(CommandBuffer& commandBuffer);
+
+    const Statistics& GetStatistics() const { return statistics; }
+    void ResetStatistics() { statistics = {}; }
+
+    // Fills order with the indices of keys in ascending key order, keeping the order of equal keys. An LSD radix sort on 8-bit
+    // digits, which skips the digits that all keys share.
+    static void RadixSort(const std::vector<uint64_t>& keys, std::vector<uint32_t>& order, std::vector<uint32_t>& scratch);
+
+private:
+    // Walks the packets in 'order', recording them into commandBuffer unless it is nullptr, and counts the switches.
+    void Record(const std::vector<uint32_t>& order, CommandBuffer* commandBuffer, uint32_t& pipelineSwitches, uint32_t& bindingSwitches, uint32_t& scissorSwitches);
+
+    std::vector<DrawPacket> packets;
+    std::vector<GraphicsAPI::DescriptorInfo> descriptors;
+    // Per frame scratch, kept to avoid reallocating.
+    std::vector<uint64_t> keys;
+    std::vector<uint32_t> order;
+    std::vector<uint32_t> scratch;
+    std::vector<GraphicsAPI::DescriptorInfo> boundDescriptors;  // By binding index, while recording.
+    std::vector<bool> boundDescriptorsValid;
+    Statistics statistics{};
+};
@@ -0,0 +1,52 @@
+// Copyright 2023, The Khronos Group Inc.
+//
+// SPDX-License-Identifier: MIT
+
+// OpenXR Tutorial for Khronos Group
+
+#include <Foveation.h>
+
+#include <cmath>
+
+namespace {
+uint32_t ScaleExtent(uint32_t extent, float scale) {
+    const float clampedScale = std::min(std::max(scale, 0.0f), 1.0f);
+    return std::min(std::max(static_cast<uint32_t>(std::ceil(extent * clampedScale)), 1u), std::max(extent, 1u));
+}
+}  // namespace
+
+Foveation::Region Foveation::GetRegion(const Profile &profile, const XrFovf &fov, const XrVector3f &direction, uint32_t width, uint32_t height, bool originTopLeft) {
+    // Where the direction meets the image, from 0 to 1 across its width and up its height.
+    const float tanLeft = std::tan(fov.angleLeft);
+    const float tanRight = std::tan(fov.angleRight);
+    const float tanDown = std::tan(fov.angleDown);
+    const float tanUp = std::tan(fov.angleUp);
+    float tanX = 0.0f;
+    float tanY = 0.0f;
+    if (direction.z < 0.0f) {
+        tanX = direction.x / -direction.z;
+        tanY = direction.y / -direction.z;
+    }
+    const float u = std::min(std::max((tanX - tanLeft) / (tanRight - tanLeft), 0.0f), 1.0f);
+    float v = std::min(std::max((tanY - tanDown) / (tanUp - tanDown), 0.0f), 1.0f);
+    if (originTopLeft) {
+        v = 1.0f - v;
+    }
+
+    Region region{};
+    const uint32_t insetWidth = ScaleExtent(width, profile.insetSize);
+    const uint32_t insetHeight = ScaleExtent(height, profile.insetSize);
+    // Centered on the point of interest, and moved back inside the image where it would cross an edge.
+    const float x = std::round(u * width - insetWidth * 0.5f);
+    const float y = std::round(v * height - insetHeight * 0.5f);
+    region.inset.offset.x = static_cast<int32_t>(std::min(std::max(x, 0.0f), static_cast<float>(width - std::min(insetWidth, width))));
+    region.inset.offset.y = static_cast<int32_t>(std::min(std::max(y, 0.0f), static_cast<float>(height - std::min(insetHeight, height))));
+    region.inset.extent.width = insetWidth;
+    region.inset.extent.height = insetHeight;
+
+    region.peripheryWidth = ScaleExtent(width, profile.peripheryScale);
+    region.peripheryHeight = ScaleExtent(height, profile.peripheryScale);
+    region.fullPixels = static_cast<uint64_t>(width) * height;
+    region.shadedPixels = static_cast<uint64_t>(insetWidth) * insetHeight + static_cast<uint64_t>(region.peripheryWidth) * region.peripheryHeight;
+    return region;
+}
@@ -0,0 +1,38 @@
+// Copyright 2023, The Khronos Group Inc.
+//
+// SPDX-License-Identifier: MIT
+
+// OpenXR Tutorial for Khronos Group
+
+#pragma once
+#include <GraphicsAPI.h>
+
+// Splits a view's image into a full resolution inset around a point of interest and a periphery that is rendered over the
+// whole field of view at a reduced resolution, then upsampled into the image around the inset. With fixed foveation the point
+// of interest is the lens center, where the view's optical axis (-Z) meets the image; with eye-tracked foveation it is where
+// the gaze meets it.
+class Foveation {
+public:
+    enum class Mode : uint8_t {
+        OFF,
+        FIXED,
+        EYE_TRACKED
+    };
+
+    struct Profile {
+        float insetSize;       // Fraction of the image's width and height covered by the inset, in (0, 1].
+        float peripheryScale;  // Resolution of the periphery, as a fraction of the image's width and height, in (0, 1].
+    };
+
+    struct Region {
+        GraphicsAPI::Rect2D inset;  // In the image's pixels, with the framebuffer origin of the graphics API.
+        uint32_t peripheryWidth;
+        uint32_t peripheryHeight;
+        uint64_t fullPixels;     // Shaded without foveation: the whole image.
+        uint64_t shadedPixels;   // Shaded with it: the inset and the periphery.
+    };
+
+    // 'direction' is the point of interest as a direction in the view's space. It is clamped to the field of view; a direction
+    // that does not point forward falls back to the lens center. Vulkan's framebuffer origin is top left, OpenGL's bottom left.
+    static Region GetRegion(const Profile& profile, const XrFovf& fov, const XrVector3f& direction, uint32_t width, uint32_t height, bool originTopLeft);
+};
@@ -0,0 +1,350 @@
+// Copyright 2023, The Khronos Group Inc.
+//
+// SPDX-License-Identifier: MIT
+
+// OpenXR Tutorial for Khronos Group
+
+#include <FrameGraph.h>
+
+#include <algorithm>
+
+namespace {
+bool SameImageCreateInfo(const GraphicsAPI::ImageCreateInfo &a, const GraphicsAPI::ImageCreateInfo &b) {
+    return a.dimension == b.dimension && a.width == b.width && a.height == b.height && a.depth == b.depth && a.mipLevels == b.mipLevels && a.arrayLayers == b.arrayLayers && a.sampleCount == b.sampleCount && a.format == b.format && a.cubemap == b.cubemap && a.colorAttachment == b.colorAttachment && a.depthAttachment == b.depthAttachment && a.sampled == b.sampled;
+}
+}  // namespace
+
+#pragma region PassBuilder
+FrameGraph::PassBuilder &FrameGraph::PassBuilder::SetColorAttachment(Resource resource, LoadOp loadOp, float r, float g, float b, float a) {
+    if (resource >= frameGraph.images.size()) {
+        DEBUG_BREAK;
+        std::cout << "ERROR: FRAMEGRAPH: SetColorAttachment() called with an invalid Resource." << std::endl;
+        return *this;
+    }
+    std::vector<Attachment> &attachments = frameGraph.passes[passIndex].attachments;
+    const auto depthAttachment = std::find_if(attachments.begin(), attachments.end(), [](const Attachment &attachment) { return attachment.depth; });
+    attachments.insert(depthAttachment, {resource, loadOp, false, {r, g, b, a}});
+    return *this;
+}
+
+FrameGraph::PassBuilder &FrameGraph::PassBuilder::SetDepthAttachment(Resource resource, LoadOp loadOp, float d) {
+    if (resource >= frameGraph.images.size()) {
+        DEBUG_BREAK;
+        std::cout << "ERROR: FRAMEGRAPH: SetDepthAttachment() called with an invalid Resource." << std::endl;
+        return *this;
+    }
+    std::vector<Attachment> &attachments = frameGraph.passes[passIndex].attachments;
+    if (!attachments.empty() && attachments.back().depth) {
+        attachments.pop_back();
+    }
+    attachments.push_back({resource, loadOp, true, {d, 0.0f, 0.0f, 0.0f}});
+    return *this;
+}
+
+FrameGraph::PassBuilder &FrameGraph::PassBuilder::Read(Resource resource) {
+    if (resource >= frameGraph.images.size()) {
+        DEBUG_BREAK;
+        std::cout << "ERROR: FRAMEGRAPH: Read() called with an invalid Resource." << std::endl;
+        return *this;
+    }
+    frameGraph.passes[passIndex].reads.push_back(resource);
+    return *this;
+}
+
+FrameGraph::PassBuilder &FrameGraph::PassBuilder::SetSideEffects() {
+    frameGraph.passes[passIndex].sideEffects = true;
+    return *this;
+}
+#pragma endregion
+
+FrameGraph::FrameGraph(GraphicsAPI *graphicsAPI)
+    : graphicsAPI(graphicsAPI) {
+}
+
+FrameGraph::~FrameGraph() {
+    for (PhysicalImage &physicalImage : physicalImages) {
+        graphicsAPI->DestroyImageView(physicalImage.imageView);
+        graphicsAPI->DestroyImage(physicalImage.image);
+    }
+}
+
+void FrameGraph::Reset() {
+    images.clear();
+    passes.clear();
+    compiledPasses.clear();
+}
+
+FrameGraph::Resource FrameGraph::ImportImage(const char *name, void *imageView, uint32_t width, uint32_t height) {
+    ImageResource image{};
+    image.name = name;
+    image.imported = true;
+    image.width = width;
+    image.height = height;
+    image.physicalImage = ~0u;
+    image.imageView = imageView;
+    images.push_back(image);
+    return static_cast<Resource>(images.size() - 1);
+}
+
+FrameGraph::Resource FrameGraph::CreateTransientImage(const char *name, const GraphicsAPI::ImageCreateInfo &imageCI) {
+    if (!imageCI.colorAttachment && !imageCI.depthAttachment) {
+        DEBUG_BREAK;
+        std::cout << "ERROR: FRAMEGRAPH: Transient image " << name << " is neither a color nor a depth attachment." << std::endl;
+    }
+    ImageResource image{};
+    image.name = name;
+    image.imported = false;
+    image.imageCI = imageCI;
+    image.width = imageCI.width;
+    image.height = imageCI.height;
+    image.physicalImage = ~0u;
+    images.push_back(image);
+    return static_cast<Resource>(images.size() - 1);
+}
+
+FrameGraph::PassBuilder FrameGraph::AddPass(const char *name, ExecuteFunction execute) {
+    passes.push_back({name, std::move(execute), {}, {}, false});
+    return PassBuilder(*this, static_cast<uint32_t>(passes.size() - 1));
+}
+
+void FrameGraph::Compile() {
+    const uint32_t passCount = static_cast<uint32_t>(passes.size());
+    statistics = {};
+    statistics.passesDeclared = passCount;
+
+    // Walk the passes backwards and keep those with side effects, or that write an imported image or an image a kept later pass
+    // loads or reads. A pass that clears or overwrites an image ends the need for what the passes before it wrote there.
+    std::vector<bool> kept(passCount, false);
+    std::vector<bool> needed(images.size(), false);
+    for (uint32_t i = passCount; i-- > 0;) {
+        const Pass &pass = passes[i];
+        bool keep = pass.sideEffects;
+        for (const Attachment &attachment : pass.attachments) {
+            keep = keep || images[attachment.resource].imported || needed[attachment.resource];
+        }
+        if (!keep) {
+            statistics.passesCulled++;
+            continue;
+        }
+        kept[i] = true;
+        for (const Attachment &attachment : pass.attachments) {
+            needed[attachment.resource] = attachment.loadOp == LoadOp::LOAD;
+        }
+        for (Resource resource : pass.reads) {
+            needed[resource] = true;
+        }
+    }
+
+    // A pass depends on the earlier passes that touch what it writes, or write what it touches. Passes are declared in a valid
+    // order, so the dependencies point backwards only.
+    std::vector<uint32_t> dependencyCounts(passCount, 0);
+    std::vector<std::vector<uint32_t>> dependents(passCount);
+    for (uint32_t j = 0; j < passCount; j++) {
+        for (uint32_t i = 0; kept[j] && i < j; i++) {
+            if (!kept[i]) {
+                continue;
+            }
+            bool dependent = false;
+            for (const Attachment &attachment : passes[i].attachments) {
+                dependent = dependent || Touches(passes[j], attachment.resource);
+            }
+            for (Resource resource : passes[i].reads) {
+                dependent = dependent || Writes(passes[j], resource);
+            }
+            if (dependent) {
+                dependents[i].push_back(j);
+                dependencyCounts[j]++;
+            }
+        }
+    }
+
+    // Schedule the first ready pass in declaration order, unless a ready pass renders into the attachments of the pass just
+    // scheduled, in which case it goes next and shares its SetRenderAttachments().
+    compiledPasses.clear();
+    std::vector<bool> scheduled(passCount, false);
+    while (compiledPasses.size() < passCount - statistics.passesCulled) {
+        uint32_t next = ~0u;
+        for (uint32_t i = 0; i < passCount; i++) {
+            if (!kept[i] || scheduled[i] || dependencyCounts[i] != 0) {
+                continue;
+            }
+            if (next == ~0u) {
+                next = i;
+            }
+            if (!compiledPasses.empty() && SameAttachments(passes[compiledPasses.back()], passes[i])) {
+                next = i;
+                break;
+            }
+        }
+        scheduled[next] = true;
+        for (uint32_t dependent : dependents[next]) {
+            dependencyCounts[dependent]--;
+        }
+        compiledPasses.push_back(next);
+    }
+
+    // Lifetimes, as positions in the compiled order.
+    for (ImageResource &image : images) {
+        image.firstPass = ~0u;
+        image.lastPass = 0;
+    }
+    for (uint32_t k = 0; k < static_cast<uint32_t>(compiledPasses.size()); k++) {
+        const Pass &pass = passes[compiledPasses[k]];
+        auto Use = [&](Resource resource) {
+            images[resource].firstPass = std::min(images[resource].firstPass, k);
+            images[resource].lastPass = k;
+        };
+        for (const Attachment &attachment : pass.attachments) {
+            Use(attachment.resource);
+        }
+        for (Resource resource : pass.reads) {
+            Use(resource);
+        }
+    }
+
+    // Destroy the transient images unused for too long. The rest are free for this frame.
+    for (size_t i = physicalImages.size(); i-- > 0;) {
+        PhysicalImage &physicalImage = physicalImages[i];
+        physicalImage.unusedFrames = physicalImage.lastPass == ~0u ? physicalImage.unusedFrames + 1 : 0;
+        physicalImage.lastPass = ~0u;
+        if (physicalImage.unusedFrames > maxUnusedFrames) {
+            graphicsAPI->DestroyImageView(physicalImage.imageView);
+            graphicsAPI->DestroyImage(physicalImage.image);
+            physicalImages.erase(physicalImages.begin() + i);
+        }
+    }
+
+    // Place the transient images in order of first use, each on the first compatible image free by then.
+    std::vector<Resource> transientImages;
+    for (Resource resource = 0; resource < static_cast<Resource>(images.size()); resource++) {
+        if (!images[resource].imported && images[resource].firstPass != ~0u) {
+            transientImages.push_back(resource);
+        }
+    }
+    std::stable_sort(transientImages.begin(), transientImages.end(), [&](Resource a, Resource b) { return images[a].firstPass < images[b].firstPass; });
+    for (ImageResource &image : images) {
+        image.physicalImage = ~0u;
+    }
+    for (Resource resource : transientImages) {
+        ImageResource &image = images[resource];
+        image.physicalImage = GetPhysicalImage(image.imageCI, image.firstPass, image.lastPass);
+    }
+    statistics.transientImages = static_cast<uint32_t>(transientImages.size());
+}
+
+void FrameGraph::Execute(CommandBuffer &commandBuffer) {
+    if (compiledPasses.empty()) {
+        return;
+    }
+
+    commandBuffer.BeginRendering();
+    const Pass *previousPass = nullptr;
+    for (uint32_t passIndex : compiledPasses) {
+        const Pass &pass = passes[passIndex];
+        commandBuffer.BeginGpuZone(pass.name);
+
+        // Clear right before setting the attachments, where GraphicsAPI_Vulkan turns the clears into load operations. When the
+        // attachments are already set, the clears happen within the render pass instead.
+        colorViews.clear();
+        void *depthView = nullptr;
+        for (const Attachment &attachment : pass.attachments) {
+            void *imageView = GetImageView(attachment.resource);
+            if (attachment.loadOp == LoadOp::CLEAR) {
+                if (attachment.depth) {
+                    commandBuffer.ClearDepth(imageView, attachment.clearValue[0]);
+                } else {
+                    commandBuffer.ClearColor(imageView, attachment.clearValue[0], attachment.clearValue[1], attachment.clearValue[2], attachment.clearValue[3]);
+                }
+                statistics.clearsIssued++;
+            }
+            if (attachment.depth) {
+                depthView = imageView;
+            } else {
+                colorViews.push_back(imageView);
+            }
+        }
+
+        if (previousPass && SameAttachments(*previousPass, pass)) {
+            statistics.passesMerged++;
+        } else if (!pass.attachments.empty()) {
+            const ImageResource &image = images[pass.attachments[0].resource];
+            commandBuffer.SetRenderAttachments(colorViews.data(), colorViews.size(), depthView, image.width, image.height, nullptr);
+        }
+        pass.execute(commandBuffer);
+
+        commandBuffer.EndGpuZone();
+        previousPass = &pass;
+    }
+    commandBuffer.EndRendering();
+}
+
+void *FrameGraph::GetImage(Resource resource) const {
+    if (resource >= images.size() || images[resource].imported || images[resource].physicalImage == ~0u) {
+        return nullptr;
+    }
+    return physicalImages[images[resource].physicalImage].image;
+}
+
+void *FrameGraph::GetImageView(Resource resource) const {
+    if (resource >= images.size()) {
+        return nullptr;
+    }
+    const ImageResource &image = images[resource];
+    if (image.imported) {
+        return image.imageView;
+    }
+    return image.physicalImage == ~0u ? nullptr : physicalImages[image.physicalImage].imageView;
+}
+
+bool FrameGraph::Writes(const Pass &pass, Resource resource) const {
+    return std::any_of(pass.attachments.begin(), pass.attachments.end(), [&](const Attachment &attachment) { return attachment.resource == resource; });
+}
+
+bool FrameGraph::Touches(const Pass &pass, Resource resource) const {
+    return Writes(pass, resource) || std::find(pass.reads.begin(), pass.reads.end(), resource) != pass.reads.end();
+}
+
+bool FrameGraph::SameAttachments(const Pass &a, const Pass &b) const {
+    if (a.attachments.size() != b.attachments.size() || a.attachments.empty()) {
+        return false;
+    }
+    for (size_t i = 0; i < a.attachments.size(); i++) {
+        if (a.attachments[i].depth != b.attachments[i].depth || a.attachments[i].resource != b.attachments[i].resource) {
+            return false;
+        }
+    }
+    return true;
+}
+
+uint32_t FrameGraph::GetPhysicalImage(const GraphicsAPI::ImageCreateInfo &imageCI, uint32_t firstPass, uint32_t lastPass) {
+    for (uint32_t i = 0; i < static_cast<uint32_t>(physicalImages.size()); i++) {
+        PhysicalImage &physicalImage = physicalImages[i];
+        if (!SameImageCreateInfo(physicalImage.imageCI, imageCI) || (physicalImage.lastPass != ~0u && physicalImage.lastPass >= firstPass)) {
+            continue;
+        }
+        if (physicalImage.lastPass != ~0u) {
+            statistics.transientImagesAliased++;
+        }
+        physicalImage.lastPass = lastPass;
+        return i;
+    }
+
+    PhysicalImage physicalImage{};
+    physicalImage.imageCI = imageCI;
+    physicalImage.image = graphicsAPI->CreateImage(imageCI);
+    GraphicsAPI::ImageViewCreateInfo imageViewCI{};
+    imageViewCI.image = physicalImage.image;
+    imageViewCI.type = imageCI.depthAttachment ? GraphicsAPI::ImageViewCreateInfo::Type::DSV : GraphicsAPI::ImageViewCreateInfo::Type::RTV;
+    imageViewCI.view = imageCI.arrayLayers > 1 ? GraphicsAPI::ImageViewCreateInfo::View::TYPE_2D_ARRAY : GraphicsAPI::ImageViewCreateInfo::View::TYPE_2D;
+    imageViewCI.format = imageCI.format;
+    imageViewCI.aspect = imageCI.depthAttachment ? GraphicsAPI::ImageViewCreateInfo::Aspect::DEPTH_BIT : GraphicsAPI::ImageViewCreateInfo::Aspect::COLOR_BIT;
+    imageViewCI.baseMipLevel = 0;
+    imageViewCI.levelCount = 1;
+    imageViewCI.baseArrayLayer = 0;
+    imageViewCI.layerCount = imageCI.arrayLayers;
+    physicalImage.imageView = graphicsAPI->CreateImageView(imageViewCI);
+    physicalImage.lastPass = lastPass;
+    physicalImages.push_back(physicalImage);
+    statistics.transientImagesCreated++;
+    return static_cast<uint32_t>(physicalImages.size() - 1);
+}
@@ -0,0 +1,139 @@
+// Copyright 2023, The Khronos Group Inc.
+//
+// SPDX-License-Identifier: MIT
+
+// OpenXR Tutorial for Khronos Group
+
+#pragma once
+#include <CommandBuffer.h>
+
+#include <functional>
+
+// Records the render passes of a frame into a CommandBuffer from what each pass declares it reads and writes, rather than from
+// hand-sequenced clears and SetRenderAttachments() calls. Each frame: Reset(), import the images the frame renders into and
+// declare the transient images it needs, AddPass() the passes in a valid order, then Compile() and Execute().
+//
+// Compile() culls the passes whose writes nothing uses, reorders the rest within their dependencies so that passes on the same
+// attachments run back to back and share one SetRenderAttachments(), turns the attachments' load operations into clears issued
+// just before the pass sets its attachments, which is where GraphicsAPI_Vulkan folds them into the render pass's load operations,
+// and places the transient images on as few GraphicsAPI images as their lifetimes allow. GraphicsAPI has no memory aliasing, so
+// transient images alias at the image level: images with the same ImageCreateInfo and non-overlapping lifetimes share one image.
+// These images are kept across frames and destroyed after they have not been used for a few frames.
+class FrameGraph {
+public:
+    typedef uint32_t Resource;
+    static constexpr Resource NullResource = ~0u;
+
+    enum class LoadOp : uint8_t {
+        LOAD,      // Keep what earlier passes wrote.
+        CLEAR,     // Clear to the attachment's clear value.
+        DONT_CARE  // The pass writes every pixel it keeps, so the earlier contents do not matter.
+    };
+
+    struct Statistics {
+        uint32_t passesDeclared;
+        uint32_t passesCulled;
+        uint32_t passesMerged;           // Passes that rendered into the previous pass's attachments without setting them again.
+        uint32_t clearsIssued;
+        uint32_t transientImages;        // Transient images used by the passes that were not culled.
+        uint32_t transientImagesAliased; // Of those, the ones placed on an image an earlier one used in the same frame.
+        uint32_t transientImagesCreated; // GraphicsAPI images created because no existing one was free.
+    };
+
+    // Records the pass's commands, after the graph has set its attachments. The callback sets its own viewports and scissors.
+    typedef std::function<void(CommandBuffer& commandBuffer)> ExecuteFunction;
+
+    // Declares what a pass reads and writes. Returned by AddPass().
+    class PassBuilder {
+    public:
+        PassBuilder& SetColorAttachment(Resource resource, LoadOp loadOp, float r = 0.0f, float g = 0.0f, float b = 0.0f, float a = 0.0f);
+        PassBuilder& SetDepthAttachment(Resource resource, LoadOp loadOp, float d = 1.0f);
+        // A resource sampled or otherwise read by the pass. It has to be written by an earlier pass or imported.
+        PassBuilder& Read(Resource resource);
+        // The pass does work the graph does not see, such as writing a buffer, so it is never culled.
+        PassBuilder& SetSideEffects();
+
+    private:
+        friend class FrameGraph;
+        PassBuilder(FrameGraph& frameGraph, uint32_t passIndex)
+            : frameGraph(frameGraph), passIndex(passIndex) {}
+
+        FrameGraph& frameGraph;
+        uint32_t passIndex;
+    };
+
+public:
+    FrameGraph(GraphicsAPI* graphicsAPI);
+    ~FrameGraph();
+
+    // Starts a new frame. The transient images are kept for the next Compile() to reuse.
+    void Reset();
+
+    // An image view the graph renders into but does not own, such as a swapchain image. The image outlives the frame, so passes
+    // that write it are never culled.
+    Resource ImportImage(const char* name, void* imageView, uint32_t width, uint32_t height);
+    // An image that only lives within the frame. Its contents start undefined and are lost after the last pass that uses it.
+    Resource CreateTransientImage(const char* name, const GraphicsAPI::ImageCreateInfo& imageCI);
+
+    // The name must outlive the GraphicsAPI, as it names the pass's GPU zone.
+    PassBuilder AddPass(const char* name, ExecuteFunction execute);
+
+    void Compile();
+    // Records the compiled passes into commandBuffer, between one BeginRendering() and EndRendering().
+    void Execute(CommandBuffer& commandBuffer);
+
+    // Valid after Compile(); nullptr for transient images used by no remaining pass. GetImage() is nullptr for imported images.
+    void* GetImage(Resource resource) const;
+    void* GetImageView(Resource resource) const;
+
+    const Statistics& GetStatistics() const { return statistics; }
+
+private:
+    struct ImageResource {
+        const char* name;
+        bool imported;
+        GraphicsAPI::ImageCreateInfo imageCI;  // For transient images.
+        uint32_t width;
+        uint32_t height;
+        uint32_t physicalImage;  // Index into physicalImages, for transient images.
+        void* imageView;         // For imported images.
+        uint32_t firstPass;      // Positions in the compiled pass order.
+        uint32_t lastPass;
+    };
+    struct Attachment {
+        Resource resource;
+        LoadOp loadOp;
+        bool depth;
+        float clearValue[4];  // The depth is in clearValue[0].
+    };
+    struct Pass {
+        const char* name;
+        ExecuteFunction execute;
+        std::vector<Attachment> attachments;  // The color attachments in order, then the depth attachment if any.
+        std::vector<Resource> reads;
+        bool sideEffects;
+    };
+    // A GraphicsAPI image, and its attachment view, backing transient images with non-overlapping lifetimes.
+    struct PhysicalImage {
+        GraphicsAPI::ImageCreateInfo imageCI;
+        void* image;
+        void* imageView;
+        uint32_t lastPass;  // Of the transient images placed on it in the current frame; ~0u when unused this frame.
+        uint32_t unusedFrames;
+    };
+    // Frames a transient image may go unused before it is destroyed.
+    static constexpr uint32_t maxUnusedFrames = 8;
+
+    bool Writes(const Pass& pass, Resource resource) const;
+    bool Touches(const Pass& pass, Resource resource) const;
+    bool SameAttachments(const Pass& a, const Pass& b) const;
+    uint32_t GetPhysicalImage(const GraphicsAPI::ImageCreateInfo& imageCI, uint32_t firstPass, uint32_t lastPass);
+
+    GraphicsAPI* graphicsAPI = nullptr;
+    std::vector<ImageResource> images;
+    std::vector<Pass> passes;
+    std::vector<uint32_t> compiledPasses;  // Indices into passes, in execution order.
+    std::vector<PhysicalImage> physicalImages;
+    std::vector<void*> colorViews;  // Scratch for Execute().
+    Statistics statistics{};
+};
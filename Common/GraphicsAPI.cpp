@@ -6,6 +6,8 @@
 
 #include <GraphicsAPI.h>
 
+#include <CommandBuffer.h>
+
 bool CheckGraphicsAPI_TypeIsValidForPlatform(GraphicsAPI_Type type) {
 #if defined(XR_USE_PLATFORM_WIN32)
     return (type == D3D11) || (type == D3D12) || (type == OPENGL) || (type == VULKAN);
@@ -79,3 +81,7 @@ int64_t GraphicsAPI::SelectDepthSwapchainFormat(const std::vector<int64_t> &form
     return *swapchainFormatIt;
 }
 // XR_DOCS_TAG_END_GraphicsAPI_SelectSwapchainFormats
+
+void GraphicsAPI::Submit(const CommandBuffer &commandBuffer) {
+    commandBuffer.Replay(*this);
+}
@@ -117,6 +117,8 @@ bool CheckGraphicsAPI_TypeIsValidForPlatform(GraphicsAPI_Type type);
 
 const char* GetGraphicsAPIInstanceExtensionString(GraphicsAPI_Type type);
 
+class CommandBuffer;
+
 class GraphicsAPI {
 public:
 // Pipeline Helpers
@@ -365,6 +367,8 @@ public:
             VERTEX,
             INDEX,
             UNIFORM,
+            STORAGE,
+            INDIRECT,
         } type;
         size_t stride;
         size_t size;
@@ -463,6 +467,55 @@ public:
         Extent2D extent;
     };
 
+    // Layout of one command in an INDIRECT buffer. Matches DrawElementsIndirectCommand and VkDrawIndexedIndirectCommand.
+    struct DrawIndexedIndirectCommand {
+        uint32_t indexCount;
+        uint32_t instanceCount;
+        uint32_t firstIndex;
+        int32_t vertexOffset;
+        uint32_t firstInstance;
+    };
+
+    // A sub-allocation from the current frame's part of a transient buffer. 'data' points into persistently mapped memory and
+    // can be written directly until the end of the frame. Bind it with 'buffer' and 'offset'.
+    struct TransientAllocation {
+        void* buffer;
+        size_t offset;
+        size_t size;
+        void* data;
+    };
+
+    struct FrameStatistics {
+        uint32_t stateCallsIssued;
+        uint32_t stateCallsSkipped;
+        size_t transientBytesAllocated;
+        uint32_t drawCalls;       // Each draw of a MultiDrawIndexedIndirect() counts.
+        size_t bytesUploaded;     // Through SetBufferData().
+        uint32_t commandsIssued;  // Every call from BeginRendering() to Draw*(). Only counted by GraphicsAPI_Null.
+        // Descriptor, vertex buffer and index buffer bindings sent to the driver, those dropped because they were already in
+        // place, and the driver calls the sent ones took. Only counted by GraphicsAPI_OpenGL.
+        uint32_t bindsIssued;
+        uint32_t bindsElided;
+        uint32_t bindCalls;
+    };
+    // GPU time of the named zone over its most recent results.
+    struct GpuZoneStatistics {
+        const char* name;
+        uint32_t sampleCount;
+        float averageMilliseconds;
+        float p50Milliseconds;
+        float p90Milliseconds;
+        float p99Milliseconds;
+    };
+    // Counted across every CreatePipeline() call. A miss includes a cached binary that the driver rejected. A duplicate is a
+    // call that returned an existing pipeline created from identical state, and is neither a hit nor a miss.
+    struct PipelineCacheStatistics {
+        uint32_t hits;
+        uint32_t misses;
+        uint32_t duplicates;
+        float millisecondsSaved;
+    };
+
 public:
     virtual ~GraphicsAPI() = default;
 
@@ -477,6 +530,14 @@ public:
 
     virtual int64_t GetDepthFormat() = 0;
 
+    // Whether a TYPE_2D_ARRAY ImageView can be rendered to in a single multiview pass, one layer per view.
+    virtual bool SupportsMultiview() { return false; }
+
+    // The thread that renders must hold the graphics context. Only one thread may hold it at a time, so release it on one thread
+    // before making it current on another. These do nothing for APIs whose context is not bound to a thread.
+    virtual void MakeContextCurrent() {}
+    virtual void ReleaseContext() {}
+
     virtual void* GetGraphicsBinding() = 0;
     virtual XrSwapchainImageBaseHeader* AllocateSwapchainImageData(XrSwapchain swapchain, SwapchainType type, uint32_t count) = 0;
     virtual void FreeSwapchainImageData(XrSwapchain swapchain) = 0;
@@ -498,13 +559,34 @@ public:
     virtual void* CreateShader(const ShaderCreateInfo& shaderCI) = 0;
     virtual void DestroyShader(void*& shader) = 0;
 
+    // May return the same handle for identical create infos. Call DestroyPipeline() once for every CreatePipeline().
     virtual void* CreatePipeline(const PipelineCreateInfo& pipelineCI) = 0;
+    // A pipeline may finish building in the background. Setting one that is not ready yet waits for it, so check first and skip
+    // the draw or substitute another pipeline. A pipeline that failed to build is never ready.
+    virtual bool IsPipelineReady(void* pipeline) { return true; }
+    const PipelineCacheStatistics& GetPipelineCacheStatistics() const { return pipelineCacheStatistics; }
     virtual void DestroyPipeline(void*& pipeline) = 0;
 
+    // Brackets all rendering for one XR frame. FrameStatistics are reset in BeginFrame() and published in EndFrame().
+    virtual void BeginFrame() { frameStatistics = {}; }
+    virtual void EndFrame() { lastFrameStatistics = frameStatistics; }
+    const FrameStatistics& GetFrameStatistics() const { return lastFrameStatistics; }
+
+    // Measures the GPU time of the work between BeginGpuZone() and EndGpuZone(). Zones may nest, but must end in the frame they
+    // began in. 'name' identifies the zone across frames and must outlive the GraphicsAPI, e.g. a string literal.
+    // Results arrive a few frames late, as they are read back without waiting for the GPU.
+    virtual void BeginGpuZone(const char* name) {}
+    virtual void EndGpuZone() {}
+    virtual std::vector<GpuZoneStatistics> GetGpuZoneStatistics() const { return {}; }
+    // The most recent result of a zone, or a negative value if it has none yet. Cheap enough to call every frame.
+    virtual float GetLatestGpuZoneMilliseconds(const char* name) const { return -1.0f; }
+
     virtual void BeginRendering() = 0;
     virtual void EndRendering() = 0;
 
     virtual void SetBufferData(void* buffer, size_t offset, size_t size, void* data) = 0;
+    // Returns a zeroed TransientAllocation if the frame's transient buffer is exhausted.
+    virtual TransientAllocation AllocateTransientBuffer(BufferCreateInfo::Type type, size_t size) = 0;
 
     virtual void ClearColor(void* imageView, float r, float g, float b, float a) = 0;
     virtual void ClearDepth(void* imageView, float d) = 0;
@@ -520,9 +602,19 @@ public:
     virtual void SetIndexBuffer(void* indexBuffer) = 0;
     virtual void DrawIndexed(uint32_t indexCount, uint32_t instanceCount = 1, uint32_t firstIndex = 0, int32_t vertexOffset = 0, uint32_t firstInstance = 0) = 0;
     virtual void Draw(uint32_t vertexCount, uint32_t instanceCount = 1, uint32_t firstVertex = 0, uint32_t firstInstance = 0) = 0;
+    // Draws using DrawIndexedIndirectCommands read from an INDIRECT buffer, starting 'offset' bytes in.
+    virtual void DrawIndexedIndirect(void* indirectBuffer, size_t offset) = 0;
+    virtual void MultiDrawIndexedIndirect(void* indirectBuffer, size_t offset, uint32_t drawCount, uint32_t stride = sizeof(DrawIndexedIndirectCommand)) = 0;
+
+    // Replays a CommandBuffer recorded on any thread. Must be called on the thread that owns the graphics context.
+    virtual void Submit(const CommandBuffer& commandBuffer);
 
 protected:
     virtual const std::vector<int64_t> GetSupportedColorSwapchainFormats() = 0;
     virtual const std::vector<int64_t> GetSupportedDepthSwapchainFormats() = 0;
     bool debugAPI = false;
+
+    FrameStatistics frameStatistics{};
+    FrameStatistics lastFrameStatistics{};
+    PipelineCacheStatistics pipelineCacheStatistics{};
 };
@@ -0,0 +1,379 @@
+// Copyright 2023, The Khronos Group Inc.
+//
+// SPDX-License-Identifier: MIT
+
+// OpenXR Tutorial for Khronos Group
+
+#include <GraphicsAPI_Null.h>
+
+GraphicsAPI_Null::GraphicsAPI_Null() {
+}
+
+GraphicsAPI_Null::~GraphicsAPI_Null() {
+    for (TransientBuffer &transientBuffer : transientBuffers) {
+        buffers.Free(transientBuffer.buffer);
+    }
+}
+
+template <typename T>
+void GraphicsAPI_Null::UpdateState(T &current, const T &value) {
+    if (current == value) {
+        frameStatistics.stateCallsSkipped++;
+        return;
+    }
+    current = value;
+    frameStatistics.stateCallsIssued++;
+}
+
+void *GraphicsAPI_Null::CreateDesktopSwapchain(const SwapchainCreateInfo &swapchainCI) {
+    DesktopSwapchain desktopSwapchain{swapchainCI, {}, 0};
+    for (uint32_t i = 0; i < swapchainCI.count; i++) {
+        ImageCreateInfo imageCI{2, swapchainCI.width, swapchainCI.height, 1, 1, 1, 1, swapchainCI.format, false, true, false, false};
+        desktopSwapchain.images.push_back(images.Allocate({imageCI}));
+    }
+    return HandlePool<DesktopSwapchain>::ToPointer(desktopSwapchains.Allocate(desktopSwapchain));
+}
+
+void GraphicsAPI_Null::DestroyDesktopSwapchain(void *&swapchain) {
+    HandlePool<DesktopSwapchain>::Handle handle = HandlePool<DesktopSwapchain>::FromPointer(swapchain);
+    const DesktopSwapchain *desktopSwapchain = desktopSwapchains.Get(handle);
+    if (!desktopSwapchain) {
+        DEBUG_BREAK;
+        std::cout << "ERROR: NULL: DestroyDesktopSwapchain() called with an invalid or destroyed Swapchain." << std::endl;
+        swapchain = nullptr;
+        return;
+    }
+    for (HandlePool<Image>::Handle image : desktopSwapchain->images) {
+        images.Free(image);
+    }
+    desktopSwapchains.Free(handle);
+    swapchain = nullptr;
+}
+
+void *GraphicsAPI_Null::GetDesktopSwapchainImage(void *swapchain, uint32_t index) {
+    const DesktopSwapchain *desktopSwapchain = desktopSwapchains.Get(HandlePool<DesktopSwapchain>::FromPointer(swapchain));
+    if (!desktopSwapchain || index >= desktopSwapchain->images.size()) {
+        DEBUG_BREAK;
+        std::cout << "ERROR: NULL: GetDesktopSwapchainImage() called with an invalid Swapchain or index." << std::endl;
+        return nullptr;
+    }
+    return HandlePool<Image>::ToPointer(desktopSwapchain->images[index]);
+}
+
+void GraphicsAPI_Null::AcquireDesktopSwapchanImage(void *swapchain, uint32_t &index) {
+    DesktopSwapchain *desktopSwapchain = desktopSwapchains.Get(HandlePool<DesktopSwapchain>::FromPointer(swapchain));
+    if (!desktopSwapchain || desktopSwapchain->images.empty()) {
+        DEBUG_BREAK;
+        std::cout << "ERROR: NULL: AcquireDesktopSwapchanImage() called with an invalid Swapchain." << std::endl;
+        return;
+    }
+    index = desktopSwapchain->currentImage;
+    desktopSwapchain->currentImage = (desktopSwapchain->currentImage + 1) % (uint32_t)desktopSwapchain->images.size();
+}
+
+void GraphicsAPI_Null::PresentDesktopSwapchainImage(void *swapchain, uint32_t index) {
+}
+
+XrSwapchainImageBaseHeader *GraphicsAPI_Null::AllocateSwapchainImageData(XrSwapchain swapchain, SwapchainType type, uint32_t count) {
+    std::cout << "ERROR: NULL: There are no OpenXR swapchains without a graphics binding." << std::endl;
+    DEBUG_BREAK;
+    return nullptr;
+}
+
+void *GraphicsAPI_Null::CreateImage(const ImageCreateInfo &imageCI) {
+    return HandlePool<Image>::ToPointer(images.Allocate({imageCI}));
+}
+
+void GraphicsAPI_Null::DestroyImage(void *&image) {
+    if (!images.Free(HandlePool<Image>::FromPointer(image))) {
+        DEBUG_BREAK;
+        std::cout << "ERROR: NULL: DestroyImage() called with an invalid or destroyed Image." << std::endl;
+    }
+    image = nullptr;
+}
+
+void *GraphicsAPI_Null::CreateImageView(const ImageViewCreateInfo &imageViewCI) {
+    if (!images.IsValid(HandlePool<Image>::FromPointer(imageViewCI.image))) {
+        DEBUG_BREAK;
+        std::cout << "ERROR: NULL: CreateImageView() called with an invalid or destroyed Image." << std::endl;
+        return nullptr;
+    }
+    return HandlePool<ImageView>::ToPointer(imageViews.Allocate({imageViewCI}));
+}
+
+void GraphicsAPI_Null::DestroyImageView(void *&imageView) {
+    if (!imageViews.Free(HandlePool<ImageView>::FromPointer(imageView))) {
+        DEBUG_BREAK;
+        std::cout << "ERROR: NULL: DestroyImageView() called with an invalid or destroyed ImageView." << std::endl;
+    }
+    imageView = nullptr;
+}
+
+void *GraphicsAPI_Null::CreateSampler(const SamplerCreateInfo &samplerCI) {
+    return HandlePool<Sampler>::ToPointer(samplers.Allocate({samplerCI}));
+}
+
+void GraphicsAPI_Null::DestroySampler(void *&sampler) {
+    if (!samplers.Free(HandlePool<Sampler>::FromPointer(sampler))) {
+        DEBUG_BREAK;
+        std::cout << "ERROR: NULL: DestroySampler() called with an invalid or destroyed Sampler." << std::endl;
+    }
+    sampler = nullptr;
+}
+
+void *GraphicsAPI_Null::CreateBuffer(const BufferCreateInfo &bufferCI) {
+    Buffer buffer{bufferCI, std::vector<uint8_t>(bufferCI.size)};
+    if (bufferCI.data) {
+        memcpy(buffer.data.data(), bufferCI.data, bufferCI.size);
+    }
+    return HandlePool<Buffer>::ToPointer(buffers.Allocate(buffer));
+}
+
+void GraphicsAPI_Null::DestroyBuffer(void *&buffer) {
+    if (!buffers.Free(HandlePool<Buffer>::FromPointer(buffer))) {
+        DEBUG_BREAK;
+        std::cout << "ERROR: NULL: DestroyBuffer() called with an invalid or destroyed Buffer." << std::endl;
+    }
+    buffer = nullptr;
+}
+
+void *GraphicsAPI_Null::CreateShader(const ShaderCreateInfo &shaderCI) {
+    std::string source = shaderCI.sourceSize ? std::string(shaderCI.sourceData, shaderCI.sourceSize) : std::string(shaderCI.sourceData);
+    return HandlePool<Shader>::ToPointer(shaders.Allocate({shaderCI.type, source}));
+}
+
+void GraphicsAPI_Null::DestroyShader(void *&shader) {
+    if (!shaders.Free(HandlePool<Shader>::FromPointer(shader))) {
+        DEBUG_BREAK;
+        std::cout << "ERROR: NULL: DestroyShader() called with an invalid or destroyed Shader." << std::endl;
+    }
+    shader = nullptr;
+}
+
+void *GraphicsAPI_Null::CreatePipeline(const PipelineCreateInfo &pipelineCI) {
+    for (void *shader : pipelineCI.shaders) {
+        if (!shaders.IsValid(HandlePool<Shader>::FromPointer(shader))) {
+            DEBUG_BREAK;
+            std::cout << "ERROR: NULL: CreatePipeline() called with an invalid or destroyed Shader." << std::endl;
+            return nullptr;
+        }
+    }
+    return HandlePool<Pipeline>::ToPointer(pipelines.Allocate({pipelineCI}));
+}
+
+void GraphicsAPI_Null::DestroyPipeline(void *&pipeline) {
+    if (!pipelines.Free(HandlePool<Pipeline>::FromPointer(pipeline))) {
+        DEBUG_BREAK;
+        std::cout << "ERROR: NULL: DestroyPipeline() called with an invalid or destroyed Pipeline." << std::endl;
+    }
+    if (setPipeline == pipeline) {
+        setPipeline = nullptr;
+    }
+    pipeline = nullptr;
+}
+
+void GraphicsAPI_Null::BeginFrame() {
+    GraphicsAPI::BeginFrame();
+    for (TransientBuffer &transientBuffer : transientBuffers) {
+        transientBuffer.offset = 0;
+    }
+}
+
+void GraphicsAPI_Null::BeginRendering() {
+    frameStatistics.commandsIssued++;
+}
+
+void GraphicsAPI_Null::EndRendering() {
+    frameStatistics.commandsIssued++;
+    setColorViews.clear();
+    setDepthStencilView = nullptr;
+}
+
+void GraphicsAPI_Null::SetBufferData(void *buffer, size_t offset, size_t size, void *data) {
+    frameStatistics.commandsIssued++;
+    Buffer *nullBuffer = buffers.Get(HandlePool<Buffer>::FromPointer(buffer));
+    if (!nullBuffer) {
+        DEBUG_BREAK;
+        std::cout << "ERROR: NULL: SetBufferData() called with an invalid or destroyed Buffer." << std::endl;
+        return;
+    }
+    if (offset + size > nullBuffer->data.size()) {
+        DEBUG_BREAK;
+        std::cout << "ERROR: NULL: SetBufferData() called with a range outside of the Buffer." << std::endl;
+        return;
+    }
+    if (data) {
+        memcpy(nullBuffer->data.data() + offset, data, size);
+        frameStatistics.bytesUploaded += size;
+    }
+}
+
+GraphicsAPI::TransientAllocation GraphicsAPI_Null::AllocateTransientBuffer(BufferCreateInfo::Type type, size_t size) {
+    if ((size_t)type >= transientBuffers.size()) {
+        DEBUG_BREAK;
+        std::cout << "ERROR: NULL: Unknown Buffer Type." << std::endl;
+        return {};
+    }
+    TransientBuffer &transientBuffer = transientBuffers[(size_t)type];
+    if (!transientBuffer.buffer) {
+        transientBuffer.buffer = buffers.Allocate({{type, 0, transientBufferSize, nullptr}, std::vector<uint8_t>(transientBufferSize)});
+    }
+
+    size_t offset = Align<size_t>(transientBuffer.offset, transientBufferAlignment);
+    if (offset + size > transientBufferSize) {
+        DEBUG_BREAK;
+        std::cout << "ERROR: NULL: Transient Buffer is exhausted for this frame. Increase transientBufferSize." << std::endl;
+        return {};
+    }
+    transientBuffer.offset = offset + size;
+    frameStatistics.transientBytesAllocated += size;
+
+    Buffer *nullBuffer = buffers.Get(transientBuffer.buffer);
+    return {HandlePool<Buffer>::ToPointer(transientBuffer.buffer), offset, size, nullBuffer->data.data() + offset};
+}
+
+void GraphicsAPI_Null::ClearColor(void *imageView, float r, float g, float b, float a) {
+    frameStatistics.commandsIssued++;
+    if (!imageViews.IsValid(HandlePool<ImageView>::FromPointer(imageView))) {
+        DEBUG_BREAK;
+        std::cout << "ERROR: NULL: ClearColor() called with an invalid or destroyed ImageView." << std::endl;
+    }
+}
+
+void GraphicsAPI_Null::ClearDepth(void *imageView, float d) {
+    frameStatistics.commandsIssued++;
+    if (!imageViews.IsValid(HandlePool<ImageView>::FromPointer(imageView))) {
+        DEBUG_BREAK;
+        std::cout << "ERROR: NULL: ClearDepth() called with an invalid or destroyed ImageView." << std::endl;
+    }
+}
+
+void GraphicsAPI_Null::SetRenderAttachments(void **colorViews, size_t colorViewCount, void *depthStencilView, uint32_t width, uint32_t height, void *pipeline) {
+    frameStatistics.commandsIssued++;
+    for (size_t i = 0; i < colorViewCount; i++) {
+        if (!imageViews.IsValid(HandlePool<ImageView>::FromPointer(colorViews[i]))) {
+            DEBUG_BREAK;
+            std::cout << "ERROR: NULL: SetRenderAttachments() called with an invalid or destroyed color ImageView." << std::endl;
+            return;
+        }
+    }
+    if (depthStencilView && !imageViews.IsValid(HandlePool<ImageView>::FromPointer(depthStencilView))) {
+        DEBUG_BREAK;
+        std::cout << "ERROR: NULL: SetRenderAttachments() called with an invalid or destroyed depth ImageView." << std::endl;
+        return;
+    }
+    std::vector<void *> colorViewList(colorViews, colorViews + colorViewCount);
+    UpdateState(setColorViews, colorViewList);
+    UpdateState(setDepthStencilView, depthStencilView);
+}
+
+void GraphicsAPI_Null::SetViewports(Viewport *viewports, size_t count) {
+    frameStatistics.commandsIssued++;
+}
+
+void GraphicsAPI_Null::SetScissors(Rect2D *scissors, size_t count) {
+    frameStatistics.commandsIssued++;
+}
+
+void GraphicsAPI_Null::SetPipeline(void *pipeline) {
+    frameStatistics.commandsIssued++;
+    if (!pipelines.IsValid(HandlePool<Pipeline>::FromPointer(pipeline))) {
+        DEBUG_BREAK;
+        std::cout << "ERROR: NULL: SetPipeline() called with an invalid or destroyed Pipeline." << std::endl;
+        return;
+    }
+    UpdateState(setPipeline, pipeline);
+}
+
+void GraphicsAPI_Null::SetDescriptor(const DescriptorInfo &descriptorInfo) {
+    frameStatistics.commandsIssued++;
+    bool valid = false;
+    if (descriptorInfo.type == DescriptorInfo::Type::BUFFER) {
+        valid = buffers.IsValid(HandlePool<Buffer>::FromPointer(descriptorInfo.resource));
+    } else if (descriptorInfo.type == DescriptorInfo::Type::IMAGE) {
+        valid = images.IsValid(HandlePool<Image>::FromPointer(descriptorInfo.resource));
+    } else if (descriptorInfo.type == DescriptorInfo::Type::SAMPLER) {
+        valid = samplers.IsValid(HandlePool<Sampler>::FromPointer(descriptorInfo.resource));
+    }
+    if (!valid) {
+        DEBUG_BREAK;
+        std::cout << "ERROR: NULL: SetDescriptor() called with an invalid or destroyed resource." << std::endl;
+        return;
+    }
+
+    if (descriptorInfo.bindingIndex >= setDescriptors.size()) {
+        setDescriptors.resize(descriptorInfo.bindingIndex + 1, DescriptorInfo{});
+    }
+    DescriptorInfo &setDescriptor = setDescriptors[descriptorInfo.bindingIndex];
+    if (setDescriptor.resource == descriptorInfo.resource && setDescriptor.type == descriptorInfo.type && setDescriptor.bufferOffset == descriptorInfo.bufferOffset && setDescriptor.bufferSize == descriptorInfo.bufferSize) {
+        frameStatistics.stateCallsSkipped++;
+        return;
+    }
+    setDescriptor = descriptorInfo;
+    frameStatistics.stateCallsIssued++;
+}
+
+void GraphicsAPI_Null::UpdateDescriptors() {
+    frameStatistics.commandsIssued++;
+}
+
+void GraphicsAPI_Null::SetVertexBuffers(void **vertexBuffers, size_t count) {
+    frameStatistics.commandsIssued++;
+    for (size_t i = 0; i < count; i++) {
+        if (!buffers.IsValid(HandlePool<Buffer>::FromPointer(vertexBuffers[i]))) {
+            DEBUG_BREAK;
+            std::cout << "ERROR: NULL: SetVertexBuffers() called with an invalid or destroyed Buffer." << std::endl;
+            return;
+        }
+    }
+    std::vector<void *> vertexBufferList(vertexBuffers, vertexBuffers + count);
+    UpdateState(setVertexBuffers, vertexBufferList);
+}
+
+void GraphicsAPI_Null::SetIndexBuffer(void *indexBuffer) {
+    frameStatistics.commandsIssued++;
+    if (!buffers.IsValid(HandlePool<Buffer>::FromPointer(indexBuffer))) {
+        DEBUG_BREAK;
+        std::cout << "ERROR: NULL: SetIndexBuffer() called with an invalid or destroyed Buffer." << std::endl;
+        return;
+    }
+    UpdateState(setIndexBuffer, indexBuffer);
+}
+
+void GraphicsAPI_Null::DrawIndexed(uint32_t indexCount, uint32_t instanceCount, uint32_t firstIndex, int32_t vertexOffset, uint32_t firstInstance) {
+    frameStatistics.commandsIssued++;
+    frameStatistics.drawCalls++;
+    if (!setPipeline || !setIndexBuffer) {
+        DEBUG_BREAK;
+        std::cout << "ERROR: NULL: DrawIndexed() called without a Pipeline and an index Buffer set." << std::endl;
+    }
+}
+
+void GraphicsAPI_Null::Draw(uint32_t vertexCount, uint32_t instanceCount, uint32_t firstVertex, uint32_t firstInstance) {
+    frameStatistics.commandsIssued++;
+    frameStatistics.drawCalls++;
+    if (!setPipeline) {
+        DEBUG_BREAK;
+        std::cout << "ERROR: NULL: Draw() called without a Pipeline set." << std::endl;
+    }
+}
+
+void GraphicsAPI_Null::DrawIndexedIndirect(void *indirectBuffer, size_t offset) {
+    MultiDrawIndexedIndirect(indirectBuffer, offset, 1, sizeof(DrawIndexedIndirectCommand));
+}
+
+void GraphicsAPI_Null::MultiDrawIndexedIndirect(void *indirectBuffer, size_t offset, uint32_t drawCount, uint32_t stride) {
+    frameStatistics.commandsIssued++;
+    const Buffer *nullIndirectBuffer = buffers.Get(HandlePool<Buffer>::FromPointer(indirectBuffer));
+    if (!nullIndirectBuffer || nullIndirectBuffer->bufferCI.type != BufferCreateInfo::Type::INDIRECT) {
+        DEBUG_BREAK;
+        std::cout << "ERROR: NULL: MultiDrawIndexedIndirect() called with an invalid, destroyed or non INDIRECT Buffer." << std::endl;
+        return;
+    }
+    if (drawCount && offset + (size_t)stride * (drawCount - 1) + sizeof(DrawIndexedIndirectCommand) > nullIndirectBuffer->data.size()) {
+        DEBUG_BREAK;
+        std::cout << "ERROR: NULL: MultiDrawIndexedIndirect() reads past the end of the Buffer." << std::endl;
+        return;
+    }
+    frameStatistics.drawCalls += drawCount;
+}
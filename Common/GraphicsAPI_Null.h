@@ -0,0 +1,143 @@
+// Copyright 2023, The Khronos Group Inc.
+//
+// SPDX-License-Identifier: MIT
+
+// OpenXR Tutorial for Khronos Group
+
+#pragma once
+#include <GraphicsAPI.h>
+#include <HandlePool.h>
+
+// A GraphicsAPI that makes no driver calls, for measuring the CPU cost of the renderer on machines without a GPU or display.
+// Resources are HandlePool handles with their metadata, as in GraphicsAPI_OpenGL, and buffers keep their contents in CPU
+// memory. Every command is validated against its handles and counted in the FrameStatistics; a state change the GL backend
+// would skip is counted as skipped. There is no graphics binding, so it cannot be used to create an XrSession.
+class GraphicsAPI_Null : public GraphicsAPI {
+public:
+    GraphicsAPI_Null();
+    ~GraphicsAPI_Null();
+
+    virtual void* CreateDesktopSwapchain(const SwapchainCreateInfo& swapchainCI) override;
+    virtual void DestroyDesktopSwapchain(void*& swapchain) override;
+    virtual void* GetDesktopSwapchainImage(void* swapchain, uint32_t index) override;
+    virtual void AcquireDesktopSwapchanImage(void* swapchain, uint32_t& index) override;
+    virtual void PresentDesktopSwapchainImage(void* swapchain, uint32_t index) override;
+
+    // Formats are not interpreted; these stand in for an RGBA8 color format and a 32-bit float depth format.
+    enum Format : int64_t {
+        COLOR_FORMAT = 1,
+        DEPTH_FORMAT = 2
+    };
+    virtual int64_t GetDepthFormat() override { return DEPTH_FORMAT; }
+
+    virtual void* GetGraphicsBinding() override { return nullptr; }
+    virtual XrSwapchainImageBaseHeader* AllocateSwapchainImageData(XrSwapchain swapchain, SwapchainType type, uint32_t count) override;
+    virtual void FreeSwapchainImageData(XrSwapchain swapchain) override {}
+    virtual XrSwapchainImageBaseHeader* GetSwapchainImageData(XrSwapchain swapchain, uint32_t index) override { return nullptr; }
+    virtual void* GetSwapchainImage(XrSwapchain swapchain, uint32_t index) override { return nullptr; }
+
+    virtual void* CreateImage(const ImageCreateInfo& imageCI) override;
+    virtual void DestroyImage(void*& image) override;
+
+    virtual void* CreateImageView(const ImageViewCreateInfo& imageViewCI) override;
+    virtual void DestroyImageView(void*& imageView) override;
+
+    virtual void* CreateSampler(const SamplerCreateInfo& samplerCI) override;
+    virtual void DestroySampler(void*& sampler) override;
+
+    virtual void* CreateBuffer(const BufferCreateInfo& bufferCI) override;
+    virtual void DestroyBuffer(void*& buffer) override;
+
+    virtual void* CreateShader(const ShaderCreateInfo& shaderCI) override;
+    virtual void DestroyShader(void*& shader) override;
+
+    virtual void* CreatePipeline(const PipelineCreateInfo& pipelineCI) override;
+    virtual void DestroyPipeline(void*& pipeline) override;
+
+    virtual void BeginFrame() override;
+
+    virtual void BeginRendering() override;
+    virtual void EndRendering() override;
+
+    virtual void SetBufferData(void* buffer, size_t offset, size_t size, void* data) override;
+    virtual TransientAllocation AllocateTransientBuffer(BufferCreateInfo::Type type, size_t size) override;
+
+    virtual void ClearColor(void* imageView, float r, float g, float b, float a) override;
+    virtual void ClearDepth(void* imageView, float d) override;
+
+    virtual void SetRenderAttachments(void** colorViews, size_t colorViewCount, void* depthStencilView, uint32_t width, uint32_t height, void* pipeline) override;
+    virtual void SetViewports(Viewport* viewports, size_t count) override;
+    virtual void SetScissors(Rect2D* scissors, size_t count) override;
+
+    virtual void SetPipeline(void* pipeline) override;
+    virtual void SetDescriptor(const DescriptorInfo& descriptorInfo) override;
+    virtual void UpdateDescriptors() override;
+    virtual void SetVertexBuffers(void** vertexBuffers, size_t count) override;
+    virtual void SetIndexBuffer(void* indexBuffer) override;
+    virtual void DrawIndexed(uint32_t indexCount, uint32_t instanceCount = 1, uint32_t firstIndex = 0, int32_t vertexOffset = 0, uint32_t firstInstance = 0) override;
+    virtual void Draw(uint32_t vertexCount, uint32_t instanceCount = 1, uint32_t firstVertex = 0, uint32_t firstInstance = 0) override;
+    virtual void DrawIndexedIndirect(void* indirectBuffer, size_t offset) override;
+    virtual void MultiDrawIndexedIndirect(void* indirectBuffer, size_t offset, uint32_t drawCount, uint32_t stride = sizeof(DrawIndexedIndirectCommand)) override;
+
+private:
+    virtual const std::vector<int64_t> GetSupportedColorSwapchainFormats() override { return {COLOR_FORMAT}; }
+    virtual const std::vector<int64_t> GetSupportedDepthSwapchainFormats() override { return {DEPTH_FORMAT}; }
+
+private:
+    struct Buffer {
+        BufferCreateInfo bufferCI;
+        std::vector<uint8_t> data;
+    };
+    struct Image {
+        ImageCreateInfo imageCI;
+    };
+    struct ImageView {
+        ImageViewCreateInfo imageViewCI;
+    };
+    struct Sampler {
+        SamplerCreateInfo samplerCI;
+    };
+    struct Shader {
+        ShaderCreateInfo::Type type;
+        std::string source;
+    };
+    struct Pipeline {
+        PipelineCreateInfo pipelineCI;
+    };
+    struct DesktopSwapchain {
+        SwapchainCreateInfo swapchainCI;
+        std::vector<HandlePool<Image>::Handle> images;
+        uint32_t currentImage;
+    };
+
+    // One CPU buffer per BufferCreateInfo::Type, created on first use. Nothing reads them behind the CPU's back, so they are
+    // simply rewound in BeginFrame().
+    static constexpr size_t transientBufferSize = 4 * 1024 * 1024;
+    static constexpr size_t transientBufferAlignment = 256;
+    struct TransientBuffer {
+        HandlePool<Buffer>::Handle buffer;
+        size_t offset;
+    };
+
+    // Counts a state change as issued if the value differs from the last one set, and as skipped otherwise.
+    template <typename T>
+    void UpdateState(T& current, const T& value);
+
+private:
+    HandlePool<Buffer> buffers{};
+    HandlePool<Image> images{};
+    HandlePool<ImageView> imageViews{};
+    HandlePool<Sampler> samplers{};
+    HandlePool<Shader> shaders{};
+    HandlePool<Pipeline> pipelines{};
+    HandlePool<DesktopSwapchain> desktopSwapchains{};
+
+    std::array<TransientBuffer, (size_t)BufferCreateInfo::Type::INDIRECT + 1> transientBuffers{};  // Indexed by BufferCreateInfo::Type.
+
+    std::vector<void*> setColorViews{};
+    void* setDepthStencilView = nullptr;
+    void* setPipeline = nullptr;
+    std::vector<void*> setVertexBuffers{};
+    void* setIndexBuffer = nullptr;
+    std::vector<DescriptorInfo> setDescriptors{};  // Indexed by binding index.
+};
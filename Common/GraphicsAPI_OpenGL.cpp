@@ -6,6 +6,8 @@
 
 #include <GraphicsAPI_OpenGL.h>
 
+#include <iomanip>
+
 #if defined(XR_USE_GRAPHICS_API_OPENGL)
 
 #if defined(OS_WINDOWS)
@@ -108,6 +110,23 @@ GLint ToGLAddressMode(GraphicsAPI::SamplerCreateInfo::AddressMode mode) {
     }
 };
 
+inline GLenum ToGLBufferTarget(GraphicsAPI::BufferCreateInfo::Type type) {
+    switch (type) {
+    case GraphicsAPI::BufferCreateInfo::Type::VERTEX:
+        return GL_ARRAY_BUFFER;
+    case GraphicsAPI::BufferCreateInfo::Type::INDEX:
+        return GL_ELEMENT_ARRAY_BUFFER;
+    case GraphicsAPI::BufferCreateInfo::Type::UNIFORM:
+        return GL_UNIFORM_BUFFER;
+    case GraphicsAPI::BufferCreateInfo::Type::STORAGE:
+        return GL_SHADER_STORAGE_BUFFER;
+    case GraphicsAPI::BufferCreateInfo::Type::INDIRECT:
+        return GL_DRAW_INDIRECT_BUFFER;
+    default:
+        return 0;
+    }
+};
+
 inline GLenum ToGLTopology(GraphicsAPI::PrimitiveTopology topology) {
     switch (topology) {
     case GraphicsAPI::PrimitiveTopology::POINT_LIST:
@@ -355,28 +374,45 @@ void GLDebugCallback(GLenum source, GLenum type, GLuint id, GLenum severity, GLs
         DEBUG_BREAK;
 }
 
-GraphicsAPI_OpenGL::GraphicsAPI_OpenGL() {
-    // https://github.com/KhronosGroup/OpenXR-SDK-Source/blob/f122f9f1fc729e2dc82e12c3ce73efa875182854/src/tests/hello_xr/graphicsplugin_opengl.cpp#L103-L121
-    // Initialize the gl extensions. Note we have to open a window.
-    ksDriverInstance driverInstance{};
-    ksGpuQueueInfo queueInfo{};
-    ksGpuSurfaceColorFormat colorFormat{KS_GPU_SURFACE_COLOR_FORMAT_B8G8R8A8};
-    ksGpuSurfaceDepthFormat depthFormat{KS_GPU_SURFACE_DEPTH_FORMAT_D24};
-    ksGpuSampleCount sampleCount{KS_GPU_SAMPLE_COUNT_1};
-    if (!ksGpuWindow_Create(&window, &driverInstance, &queueInfo, 0, colorFormat, depthFormat, sampleCount, 640, 480, false)) {
-        std::cerr << "ERROR: OPENGL: Failed to create Context." << std::endl;
+GraphicsAPI_OpenGL::GraphicsAPI_OpenGL(Context context) {
+    if (context == Context::SURFACELESS) {
+#if defined(XR_TUTORIAL_USE_OPENGL_SURFACELESS)
+        if (!CreateSurfacelessContext()) {
+            std::cerr << "ERROR: OPENGL: Failed to create surfaceless Context." << std::endl;
+            DEBUG_BREAK;
+            valid = false;
+            return;
+        }
+#else
+        std::cerr << "ERROR: OPENGL: This build has no surfaceless Context support. Build with XR_TUTORIAL_USE_OPENGL_SURFACELESS." << std::endl;
+        DEBUG_BREAK;
+        valid = false;
+        return;
+#endif
+    } else {
+        // https://github.com/KhronosGroup/OpenXR-SDK-Source/blob/f122f9f1fc729e2dc82e12c3ce73efa875182854/src/tests/hello_xr/graphicsplugin_opengl.cpp#L103-L121
+        // Initialize the gl extensions. Note we have to open a window.
+        ksDriverInstance driverInstance{};
+        ksGpuQueueInfo queueInfo{};
+        ksGpuSurfaceColorFormat colorFormat{KS_GPU_SURFACE_COLOR_FORMAT_B8G8R8A8};
+        ksGpuSurfaceDepthFormat depthFormat{KS_GPU_SURFACE_DEPTH_FORMAT_D24};
+        ksGpuSampleCount sampleCount{KS_GPU_SAMPLE_COUNT_1};
+        if (!ksGpuWindow_Create(&window, &driverInstance, &queueInfo, 0, colorFormat, depthFormat, sampleCount, 640, 480, false)) {
+            std::cerr << "ERROR: OPENGL: Failed to create Context." << std::endl;
+        }
     }
+    LoadDispatchTable();
 
     GLint glMajorVersion = 0;
     GLint glMinorVersion = 0;
-    glGetIntegerv(GL_MAJOR_VERSION, &glMajorVersion);
-    glGetIntegerv(GL_MINOR_VERSION, &glMinorVersion);
-
-    glEnable(GL_DEBUG_OUTPUT);
-    glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
-    glDebugMessageCallback(GLDebugCallback, nullptr);
-    glDebugMessageControl(GL_DONT_CARE, GL_DONT_CARE, GL_DONT_CARE, 0, nullptr, GL_FALSE);
-    glDebugMessageControl(GL_DONT_CARE, GL_DEBUG_TYPE_ERROR, GL_DONT_CARE, 0, nullptr, GL_TRUE);
+    gl.GetIntegerv(GL_MAJOR_VERSION, &glMajorVersion);
+    gl.GetIntegerv(GL_MINOR_VERSION, &glMinorVersion);
+
+    gl.Enable(GL_DEBUG_OUTPUT);
+    gl.Enable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+    gl.DebugMessageCallback(GLDebugCallback, nullptr);
+    gl.DebugMessageControl(GL_DONT_CARE, GL_DONT_CARE, GL_DONT_CARE, 0, nullptr, GL_FALSE);
+    gl.DebugMessageControl(GL_DONT_CARE, GL_DEBUG_TYPE_ERROR, GL_DONT_CARE, 0, nullptr, GL_TRUE);
 }
 
 // XR_DOCS_TAG_BEGIN_GraphicsAPI_OpenGL
@@ -395,11 +431,12 @@ GraphicsAPI_OpenGL::GraphicsAPI_OpenGL(XrInstance m_xrInstance, XrSystemId syste
     if (!ksGpuWindow_Create(&window, &driverInstance, &queueInfo, 0, colorFormat, depthFormat, sampleCount, 640, 480, false)) {
         std::cerr << "ERROR: OPENGL: Failed to create Context." << std::endl;
     }
+    LoadDispatchTable();
 
     GLint glMajorVersion = 0;
     GLint glMinorVersion = 0;
-    glGetIntegerv(GL_MAJOR_VERSION, &glMajorVersion);
-    glGetIntegerv(GL_MINOR_VERSION, &glMinorVersion);
+    gl.GetIntegerv(GL_MAJOR_VERSION, &glMajorVersion);
+    gl.GetIntegerv(GL_MINOR_VERSION, &glMinorVersion);
 
     const XrVersion glApiVersion = XR_MAKE_VERSION(glMajorVersion, glMinorVersion, 0);
     if (graphicsRequirements.minApiVersionSupported > glApiVersion) {
@@ -408,18 +445,349 @@ GraphicsAPI_OpenGL::GraphicsAPI_OpenGL(XrInstance m_xrInstance, XrSystemId syste
         std::cerr << "ERROR: OPENGL: The created OpenGL version " << glMajorVersion << "." << glMinorVersion << " doesn't meet the minimum required API version " << requiredMajorVersion << "." << requiredMinorVersion << " for OpenXR." << std::endl;
     }
 
-    glEnable(GL_DEBUG_OUTPUT);
-    glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
-    glDebugMessageCallback(GLDebugCallback, nullptr);
-    glDebugMessageControl(GL_DONT_CARE, GL_DONT_CARE, GL_DONT_CARE, 0, nullptr, GL_FALSE);
-    glDebugMessageControl(GL_DONT_CARE, GL_DEBUG_TYPE_ERROR, GL_DONT_CARE, 0, nullptr, GL_TRUE);
+    gl.Enable(GL_DEBUG_OUTPUT);
+    gl.Enable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+    gl.DebugMessageCallback(GLDebugCallback, nullptr);
+    gl.DebugMessageControl(GL_DONT_CARE, GL_DONT_CARE, GL_DONT_CARE, 0, nullptr, GL_FALSE);
+    gl.DebugMessageControl(GL_DONT_CARE, GL_DEBUG_TYPE_ERROR, GL_DONT_CARE, 0, nullptr, GL_TRUE);
 }
 
 GraphicsAPI_OpenGL::~GraphicsAPI_OpenGL() {
+    if (!valid) {
+        return;  // There is no context, and nothing was created.
+    }
+    for (GLsync &fence : frameFences) {
+        if (fence) {
+            gl.DeleteSync(fence);
+        }
+    }
+    for (TransientBuffer &transientBuffer : transientBuffers) {
+        DestroyTransientBuffer(transientBuffer);
+    }
+    for (GpuZoneFrame &gpuZoneFrame : gpuZoneFrames) {
+        if (!gpuZoneFrame.queries.empty()) {
+            gl.DeleteQueries((GLsizei)gpuZoneFrame.queries.size(), gpuZoneFrame.queries.data());
+        }
+    }
+    for (const Framebuffer &framebuffer : framebuffers) {
+        gl.DeleteFramebuffers(1, &framebuffer.framebuffer);
+    }
+#if defined(XR_TUTORIAL_USE_OPENGL_SURFACELESS)
+    if (eglContext != EGL_NO_CONTEXT) {
+        DestroySurfacelessContext();
+        return;
+    }
+#endif
     ksGpuWindow_Destroy(&window);
 }
 // XR_DOCS_TAG_END_GraphicsAPI_OpenGL
 
+#if defined(XR_TUTORIAL_USE_OPENGL_SURFACELESS)
+bool GraphicsAPI_OpenGL::CreateSurfacelessContext() {
+    // Prefer Mesa's surfaceless platform, which needs no display server at all. Otherwise, fall back to the default display,
+    // which still works without a window if it has EGL_KHR_surfaceless_context.
+    const char *clientExtensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+    auto eglGetPlatformDisplayEXT = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+    if (clientExtensions && strstr(clientExtensions, "EGL_MESA_platform_surfaceless") && eglGetPlatformDisplayEXT) {
+        eglDisplay = eglGetPlatformDisplayEXT(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+    }
+    if (eglDisplay == EGL_NO_DISPLAY) {
+        eglDisplay = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    }
+    EGLint eglMajorVersion = 0;
+    EGLint eglMinorVersion = 0;
+    if (eglDisplay == EGL_NO_DISPLAY || !eglInitialize(eglDisplay, &eglMajorVersion, &eglMinorVersion)) {
+        std::cerr << "ERROR: OPENGL: Failed to initialize an EGL Display." << std::endl;
+        eglDisplay = EGL_NO_DISPLAY;
+        return false;
+    }
+    const char *displayExtensions = eglQueryString(eglDisplay, EGL_EXTENSIONS);
+    if (!displayExtensions || !strstr(displayExtensions, "EGL_KHR_surfaceless_context") || !strstr(displayExtensions, "EGL_KHR_create_context")) {
+        std::cerr << "ERROR: OPENGL: The EGL Display lacks EGL_KHR_surfaceless_context or EGL_KHR_create_context." << std::endl;
+        DestroySurfacelessContext();
+        return false;
+    }
+    if (!eglBindAPI(EGL_OPENGL_API)) {
+        std::cerr << "ERROR: OPENGL: The EGL Display does not support desktop OpenGL." << std::endl;
+        DestroySurfacelessContext();
+        return false;
+    }
+
+    // No surface will ever be bound, so any config that renders OpenGL will do, or none at all with EGL_KHR_no_config_context.
+    EGLConfig eglConfig = (EGLConfig)0;
+    if (!strstr(displayExtensions, "EGL_KHR_no_config_context")) {
+        const EGLint configAttributes[] = {EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT, EGL_SURFACE_TYPE, 0, EGL_NONE};
+        EGLint configCount = 0;
+        if (!eglChooseConfig(eglDisplay, configAttributes, &eglConfig, 1, &configCount) || configCount == 0) {
+            std::cerr << "ERROR: OPENGL: Failed to find an EGL Config for desktop OpenGL." << std::endl;
+            DestroySurfacelessContext();
+            return false;
+        }
+    }
+
+    // The shaders are GLSL 4.50.
+    const EGLint glMajorVersion = 4;
+    const EGLint glMinorVersion = 5;
+    const EGLint contextAttributes[] = {
+        EGL_CONTEXT_MAJOR_VERSION_KHR, glMajorVersion,
+        EGL_CONTEXT_MINOR_VERSION_KHR, glMinorVersion,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK_KHR, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT_KHR,
+        EGL_NONE};
+    eglContext = eglCreateContext(eglDisplay, eglConfig, EGL_NO_CONTEXT, contextAttributes);
+    if (eglContext == EGL_NO_CONTEXT) {
+        std::cerr << "ERROR: OPENGL: Failed to create an EGL Context for OpenGL " << glMajorVersion << "." << glMinorVersion << " core." << std::endl;
+        DestroySurfacelessContext();
+        return false;
+    }
+    if (!eglMakeCurrent(eglDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, eglContext)) {
+        std::cerr << "ERROR: OPENGL: Failed to make the surfaceless EGL Context current." << std::endl;
+        DestroySurfacelessContext();
+        return false;
+    }
+    return true;
+}
+
+void GraphicsAPI_OpenGL::DestroySurfacelessContext() {
+    if (eglDisplay == EGL_NO_DISPLAY) {
+        return;
+    }
+    eglMakeCurrent(eglDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    if (eglContext != EGL_NO_CONTEXT) {
+        eglDestroyContext(eglDisplay, eglContext);
+    }
+    eglTerminate(eglDisplay);
+    eglContext = EGL_NO_CONTEXT;
+    eglDisplay = EGL_NO_DISPLAY;
+}
+#endif
+
+void GraphicsAPI_OpenGL::LoadDispatchTable() {
+    // Resolve every entry point once, up front, so that no call site has to look up or null check a function pointer.
+#if defined(OS_WINDOWS)
+    // wglGetProcAddress() only returns entry points above OpenGL 1.1; those are exported directly from opengl32.dll.
+    HMODULE openGL32 = GetModuleHandleA("opengl32.dll");
+    auto GetProcAddressGL = [openGL32](const char *functionName) -> PROC {
+        PROC proc = GetExtension(functionName);
+        if (proc == nullptr || proc == (PROC)1 || proc == (PROC)2 || proc == (PROC)3 || proc == (PROC)-1) {
+            proc = openGL32 ? GetProcAddress(openGL32, functionName) : nullptr;
+        }
+        return proc;
+    };
+#elif defined(XR_TUTORIAL_USE_OPENGL_SURFACELESS)
+    // A surfaceless context is an EGL context, whatever the window system of the build.
+    auto GetProcAddressGL = [this](const char *functionName) -> void (*)() {
+        if (eglContext != EGL_NO_CONTEXT) {
+            return (void (*)())eglGetProcAddress(functionName);
+        }
+        return GetExtension(functionName);
+    };
+#else
+    auto GetProcAddressGL = [](const char *functionName) { return GetExtension(functionName); };
+#endif
+
+    features = 0;
+    features |= (uint32_t)Feature::DEPTH_BOUNDS;
+    features |= (uint32_t)Feature::MULTIVIEW;
+    features |= (uint32_t)Feature::MULTI_BIND;
+    features |= (uint32_t)Feature::PROGRAM_BINARY;
+    features |= (uint32_t)Feature::PARALLEL_SHADER_COMPILE;
+
+#define GRAPHICS_API_OPENGL_LOAD_ENTRY_POINT(type, name, feature)                                            \
+    gl.name.proc = (type)GetProcAddressGL("gl" #name);                                                    \
+    gl.name.calls = 0;                                                                                    \
+    if (!gl.name.proc) {                                                                                  \
+        if (Feature::feature == Feature::CORE) {                                                          \
+            std::cout << "ERROR: OPENGL: Failed to load entry point gl" #name "." << std::endl;           \
+            DEBUG_BREAK;                                                                                  \
+        } else {                                                                                          \
+            features &= ~(uint32_t)Feature::feature;                                                      \
+        }                                                                                                 \
+    }
+    GRAPHICS_API_OPENGL_ENTRY_POINTS(GRAPHICS_API_OPENGL_LOAD_ENTRY_POINT)
+#undef GRAPHICS_API_OPENGL_LOAD_ENTRY_POINT
+
+    // Some loaders return a pointer for any name, so an optional feature also needs its extension to be advertised.
+    GLint extensionCount = 0;
+    gl.GetIntegerv(GL_NUM_EXTENSIONS, &extensionCount);
+    auto HasExtension = [&](const char *extensionName) -> bool {
+        for (GLint i = 0; i < extensionCount; i++) {
+            if (strcmp((const char *)gl.GetStringi(GL_EXTENSIONS, (GLuint)i), extensionName) == 0) {
+                return true;
+            }
+        }
+        return false;
+    };
+    GLint glMajorVersion = 0;
+    GLint glMinorVersion = 0;
+    gl.GetIntegerv(GL_MAJOR_VERSION, &glMajorVersion);
+    gl.GetIntegerv(GL_MINOR_VERSION, &glMinorVersion);
+
+    if (!HasExtension("GL_EXT_depth_bounds_test")) {
+        features &= ~(uint32_t)Feature::DEPTH_BOUNDS;
+    }
+    if (!HasExtension("GL_OVR_multiview2")) {
+        features &= ~(uint32_t)Feature::MULTIVIEW;
+    }
+    if (XR_MAKE_VERSION(glMajorVersion, glMinorVersion, 0) < XR_MAKE_VERSION(4, 4, 0) && !HasExtension("GL_ARB_multi_bind")) {
+        features &= ~(uint32_t)Feature::MULTI_BIND;
+    }
+    if (!HasExtension("GL_KHR_parallel_shader_compile")) {
+        features &= ~(uint32_t)Feature::PARALLEL_SHADER_COMPILE;
+    }
+    GLint programBinaryFormatCount = 0;
+    gl.GetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &programBinaryFormatCount);
+    if (programBinaryFormatCount == 0) {
+        features &= ~(uint32_t)Feature::PROGRAM_BINARY;
+    }
+
+    // Let the driver use as many compiler threads as it likes.
+    if (HasFeature(Feature::PARALLEL_SHADER_COMPILE)) {
+        gl.MaxShaderCompilerThreadsKHR(0xFFFFFFFF);
+    }
+
+    // Program binaries are only valid for the driver that produced them.
+    driverHash = HashFNV1a(nullptr, 0);
+    for (GLenum name : {GL_VENDOR, GL_RENDERER, GL_VERSION}) {
+        const char *string = (const char *)gl.GetString(name);
+        driverHash = HashFNV1a(string, string ? strlen(string) : 0, driverHash);
+    }
+}
+
+void GraphicsAPI_OpenGL::BeginFrame() {
+    GraphicsAPI::BeginFrame();
+
+    // Move on to the next part of the transient buffers, waiting for the GPU to finish the frame that last used it.
+    frameInFlightIndex = (frameInFlightIndex + 1) % framesInFlight;
+    GLsync &fence = frameFences[frameInFlightIndex];
+    if (fence) {
+        GLenum result = GL_TIMEOUT_EXPIRED;
+        while (result == GL_TIMEOUT_EXPIRED) {
+            result = gl.ClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+        }
+        if (result == GL_WAIT_FAILED) {
+            DEBUG_BREAK;
+            std::cout << "ERROR: OPENGL: Failed to wait for the frame fence." << std::endl;
+        }
+        gl.DeleteSync(fence);
+        fence = nullptr;
+    }
+    for (TransientBuffer &transientBuffer : transientBuffers) {
+        transientBuffer.offset = frameInFlightIndex * transientBufferPartSize;
+    }
+    ReadGpuZoneQueries(gpuZoneFrames[frameInFlightIndex]);
+}
+
+void GraphicsAPI_OpenGL::EndFrame() {
+    if (!openGpuZoneQueries.empty()) {
+        DEBUG_BREAK;
+        std::cout << "ERROR: OPENGL: " << openGpuZoneQueries.size() << " GPU zone(s) were not ended within the frame." << std::endl;
+        openGpuZoneQueries.clear();
+    }
+    frameFences[frameInFlightIndex] = gl.FenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+    GraphicsAPI::EndFrame();
+
+#if defined(XR_TUTORIAL_OPENGL_CALL_COUNTERS)
+    entryPointCallCounts.clear();
+#define GRAPHICS_API_OPENGL_COLLECT_CALL_COUNT(type, name, feature)  \
+    if (gl.name.calls) {                                          \
+        entryPointCallCounts.push_back({"gl" #name, gl.name.calls}); \
+        gl.name.calls = 0;                                        \
+    }
+    GRAPHICS_API_OPENGL_ENTRY_POINTS(GRAPHICS_API_OPENGL_COLLECT_CALL_COUNT)
+#undef GRAPHICS_API_OPENGL_COLLECT_CALL_COUNT
+#endif
+}
+
+void GraphicsAPI_OpenGL::BeginGpuZone(const char *name) {
+    size_t zoneIndex = 0;
+    while (zoneIndex < gpuZones.size() && gpuZones[zoneIndex].name != name && strcmp(gpuZones[zoneIndex].name, name) != 0) {
+        zoneIndex++;
+    }
+    if (zoneIndex == gpuZones.size()) {
+        gpuZones.push_back({name, {}, 0, 0});
+    }
+
+    GpuZoneFrame &gpuZoneFrame = gpuZoneFrames[frameInFlightIndex];
+    GLuint query = AllocateGpuZoneQuery();
+    gl.QueryCounter(query, GL_TIMESTAMP);
+    openGpuZoneQueries.push_back(gpuZoneFrame.zoneQueries.size());
+    gpuZoneFrame.zoneQueries.push_back({zoneIndex, query, 0});
+}
+
+void GraphicsAPI_OpenGL::EndGpuZone() {
+    if (openGpuZoneQueries.empty()) {
+        DEBUG_BREAK;
+        std::cout << "ERROR: OPENGL: EndGpuZone() called without a matching BeginGpuZone()." << std::endl;
+        return;
+    }
+    GpuZoneFrame &gpuZoneFrame = gpuZoneFrames[frameInFlightIndex];
+    GLuint query = AllocateGpuZoneQuery();
+    gl.QueryCounter(query, GL_TIMESTAMP);
+    gpuZoneFrame.zoneQueries[openGpuZoneQueries.back()].endQuery = query;
+    openGpuZoneQueries.pop_back();
+}
+
+std::vector<GraphicsAPI::GpuZoneStatistics> GraphicsAPI_OpenGL::GetGpuZoneStatistics() const {
+    std::vector<GpuZoneStatistics> gpuZoneStatistics;
+    for (const GpuZone &gpuZone : gpuZones) {
+        if (gpuZone.count == 0) {
+            continue;
+        }
+        std::vector<float> milliseconds(gpuZone.milliseconds.begin(), gpuZone.milliseconds.begin() + gpuZone.count);
+        std::sort(milliseconds.begin(), milliseconds.end());
+        auto Percentile = [&milliseconds](float percentile) {
+            return milliseconds[(size_t)(percentile * (float)(milliseconds.size() - 1) + 0.5f)];
+        };
+        float total = 0.0f;
+        for (float value : milliseconds) {
+            total += value;
+        }
+        gpuZoneStatistics.push_back({gpuZone.name, (uint32_t)gpuZone.count, total / (float)gpuZone.count, Percentile(0.5f), Percentile(0.9f), Percentile(0.99f)});
+    }
+    return gpuZoneStatistics;
+}
+
+float GraphicsAPI_OpenGL::GetLatestGpuZoneMilliseconds(const char *name) const {
+    for (const GpuZone &gpuZone : gpuZones) {
+        if (gpuZone.name != name && strcmp(gpuZone.name, name) != 0) {
+            continue;
+        }
+        return gpuZone.count ? gpuZone.milliseconds[(gpuZone.next + gpuZoneHistorySize - 1) % gpuZoneHistorySize] : -1.0f;
+    }
+    return -1.0f;
+}
+
+GLuint GraphicsAPI_OpenGL::AllocateGpuZoneQuery() {
+    GpuZoneFrame &gpuZoneFrame = gpuZoneFrames[frameInFlightIndex];
+    if (gpuZoneFrame.usedQueryCount == gpuZoneFrame.queries.size()) {
+        GLuint query = 0;
+        gl.GenQueries(1, &query);
+        gpuZoneFrame.queries.push_back(query);
+    }
+    return gpuZoneFrame.queries[gpuZoneFrame.usedQueryCount++];
+}
+
+void GraphicsAPI_OpenGL::ReadGpuZoneQueries(GpuZoneFrame &gpuZoneFrame) {
+    // The fence of the frame that wrote these queries has signalled, so their results are available.
+    for (const GpuZoneQuery &zoneQuery : gpuZoneFrame.zoneQueries) {
+        if (!zoneQuery.endQuery) {
+            continue;
+        }
+        GLuint64 beginTime = 0;
+        GLuint64 endTime = 0;
+        gl.GetQueryObjectui64v(zoneQuery.beginQuery, GL_QUERY_RESULT, &beginTime);
+        gl.GetQueryObjectui64v(zoneQuery.endQuery, GL_QUERY_RESULT, &endTime);
+
+        GpuZone &gpuZone = gpuZones[zoneQuery.zoneIndex];
+        gpuZone.milliseconds[gpuZone.next] = (float)(endTime - beginTime) / 1000000.0f;
+        gpuZone.next = (gpuZone.next + 1) % gpuZoneHistorySize;
+        gpuZone.count = std::min(gpuZone.count + 1, gpuZoneHistorySize);
+    }
+    gpuZoneFrame.zoneQueries.clear();
+    gpuZoneFrame.usedQueryCount = 0;
+}
+
 void *GraphicsAPI_OpenGL::CreateDesktopSwapchain(const SwapchainCreateInfo &swapchainCI) { return nullptr; }
 void GraphicsAPI_OpenGL::DestroyDesktopSwapchain(void *&swapchain) {}
 void *GraphicsAPI_OpenGL::GetDesktopSwapchainImage(void *swapchain, uint32_t index) { return nullptr; }
@@ -432,6 +800,26 @@ void GraphicsAPI_OpenGL::PresentDesktopSwapchainImage(void *swapchain, uint32_t
 #endif
 }
 
+void GraphicsAPI_OpenGL::MakeContextCurrent() {
+#if defined(XR_TUTORIAL_USE_OPENGL_SURFACELESS)
+    if (eglContext != EGL_NO_CONTEXT) {
+        eglMakeCurrent(eglDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, eglContext);
+        return;
+    }
+#endif
+    ksGpuContext_SetCurrent(&window.context);
+}
+
+void GraphicsAPI_OpenGL::ReleaseContext() {
+#if defined(XR_TUTORIAL_USE_OPENGL_SURFACELESS)
+    if (eglContext != EGL_NO_CONTEXT) {
+        eglMakeCurrent(eglDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        return;
+    }
+#endif
+    ksGpuContext_UnsetCurrent(&window.context);
+}
+
 // XR_DOCS_TAG_BEGIN_GraphicsAPI_OpenGL_GetGraphicsBinding
 void *GraphicsAPI_OpenGL::GetGraphicsBinding() {
     // https://github.com/KhronosGroup/OpenXR-SDK-Source/blob/f122f9f1fc729e2dc82e12c3ce73efa875182854/src/tests/hello_xr/graphicsplugin_opengl.cpp#L123-L144
@@ -467,160 +855,253 @@ void *GraphicsAPI_OpenGL::GetGraphicsBinding() {
 
 // XR_DOCS_TAG_BEGIN_GraphicsAPI_OpenGL_AllocateSwapchainImageData
 XrSwapchainImageBaseHeader *GraphicsAPI_OpenGL::AllocateSwapchainImageData(XrSwapchain swapchain, SwapchainType type, uint32_t count) {
-    swapchainImagesMap[swapchain].first = type;
-    swapchainImagesMap[swapchain].second.resize(count, {XR_TYPE_SWAPCHAIN_IMAGE_OPENGL_KHR});
-    return reinterpret_cast<XrSwapchainImageBaseHeader *>(swapchainImagesMap[swapchain].second.data());
+    Swapchain *glSwapchain = FindSwapchain(swapchain);
+    if (!glSwapchain) {
+        swapchains.push_back({swapchain});
+        glSwapchain = &swapchains.back();
+    }
+    glSwapchain->type = type;
+    glSwapchain->swapchainImages.resize(count, {XR_TYPE_SWAPCHAIN_IMAGE_OPENGL_KHR});
+    glSwapchain->images.resize(count, HandlePool<Image>::NullHandle);
+    return reinterpret_cast<XrSwapchainImageBaseHeader *>(glSwapchain->swapchainImages.data());
 }
 // XR_DOCS_TAG_END_GraphicsAPI_OpenGL_AllocateSwapchainImageData
 
+void GraphicsAPI_OpenGL::FreeSwapchainImageData(XrSwapchain swapchain) {
+    for (size_t i = 0; i < swapchains.size(); i++) {
+        if (swapchains[i].swapchain == swapchain) {
+            // The runtime deletes the swapchain textures, so drop every framebuffer that uses them.
+            for (const XrSwapchainImageOpenGLKHR &swapchainImage : swapchains[i].swapchainImages) {
+                InvalidateFramebuffers(swapchainImage.image);
+            }
+            for (HandlePool<Image>::Handle &image : swapchains[i].images) {
+                images.Free(image);
+            }
+            swapchains.erase(swapchains.begin() + i);
+            return;
+        }
+    }
+}
+
+XrSwapchainImageBaseHeader *GraphicsAPI_OpenGL::GetSwapchainImageData(XrSwapchain swapchain, uint32_t index) {
+    Swapchain *glSwapchain = FindSwapchain(swapchain);
+    return glSwapchain ? (XrSwapchainImageBaseHeader *)&glSwapchain->swapchainImages[index] : nullptr;
+}
+
+void *GraphicsAPI_OpenGL::GetSwapchainImage(XrSwapchain swapchain, uint32_t index) {
+    Swapchain *glSwapchain = FindSwapchain(swapchain);
+    if (!glSwapchain) {
+        std::cout << "ERROR: OPENGL: Unknown Swapchain." << std::endl;
+        return nullptr;
+    }
+
+    // The texture names are only known after xrEnumerateSwapchainImages(), so register them the first time they are asked for.
+    HandlePool<Image>::Handle &image = glSwapchain->images[index];
+    if (!images.IsValid(image)) {
+        ImageCreateInfo imageCI{};
+        imageCI.dimension = 2;
+        imageCI.mipLevels = 1;
+        imageCI.arrayLayers = 1;
+        imageCI.sampleCount = 1;
+        imageCI.colorAttachment = glSwapchain->type == SwapchainType::COLOR;
+        imageCI.depthAttachment = glSwapchain->type == SwapchainType::DEPTH;
+        image = images.Allocate({glSwapchain->swapchainImages[index].image, GL_TEXTURE_2D, false, imageCI});
+    }
+    return HandlePool<Image>::ToPointer(image);
+}
+
+GraphicsAPI_OpenGL::Swapchain *GraphicsAPI_OpenGL::FindSwapchain(XrSwapchain swapchain) {
+    for (Swapchain &glSwapchain : swapchains) {
+        if (glSwapchain.swapchain == swapchain) {
+            return &glSwapchain;
+        }
+    }
+    return nullptr;
+}
+
 void *GraphicsAPI_OpenGL::CreateImage(const ImageCreateInfo &imageCI) {
     GLuint texture = 0;
-    glGenTextures(1, &texture);
+    gl.GenTextures(1, &texture);
 
     GLenum target = GetGLTextureTarget(imageCI);
-    glBindTexture(target, texture);
+    gl.BindTexture(target, texture);
 
     if (target == GL_TEXTURE_1D) {
-        // glTexStorage1D() is not available - Poor work around.
-        glBindTexture(GL_TEXTURE_2D, texture);
-        glTexStorage2D(GL_TEXTURE_2D, imageCI.mipLevels, imageCI.format, imageCI.width, 1);
-        glBindTexture(GL_TEXTURE_2D, 0);
+        // gl.TexStorage1D() is not available - Poor work around.
+        gl.BindTexture(GL_TEXTURE_2D, texture);
+        gl.TexStorage2D(GL_TEXTURE_2D, imageCI.mipLevels, imageCI.format, imageCI.width, 1);
+        gl.BindTexture(GL_TEXTURE_2D, 0);
     } else if (target == GL_TEXTURE_2D) {
-        glTexStorage2D(target, imageCI.mipLevels, imageCI.format, imageCI.width, imageCI.height);
+        gl.TexStorage2D(target, imageCI.mipLevels, imageCI.format, imageCI.width, imageCI.height);
     } else if (target == GL_TEXTURE_2D_MULTISAMPLE) {
-        glTexStorage2DMultisample(target, imageCI.sampleCount, imageCI.format, imageCI.width, imageCI.height, GL_TRUE);
+        gl.TexStorage2DMultisample(target, imageCI.sampleCount, imageCI.format, imageCI.width, imageCI.height, GL_TRUE);
     } else if (target == GL_TEXTURE_3D) {
-        glTexStorage3D(target, imageCI.mipLevels, imageCI.format, imageCI.width, imageCI.height, imageCI.depth);
+        gl.TexStorage3D(target, imageCI.mipLevels, imageCI.format, imageCI.width, imageCI.height, imageCI.depth);
     } else if (target == GL_TEXTURE_CUBE_MAP) {
-        glTexStorage2D(target, imageCI.mipLevels, imageCI.format, imageCI.width, imageCI.height);
+        gl.TexStorage2D(target, imageCI.mipLevels, imageCI.format, imageCI.width, imageCI.height);
     } else if (target == GL_TEXTURE_1D_ARRAY) {
-        glTexStorage2D(target, imageCI.mipLevels, imageCI.format, imageCI.width, imageCI.arrayLayers);
+        gl.TexStorage2D(target, imageCI.mipLevels, imageCI.format, imageCI.width, imageCI.arrayLayers);
     } else if (target == GL_TEXTURE_2D_ARRAY) {
-        glTexStorage3D(target, imageCI.mipLevels, imageCI.format, imageCI.width, imageCI.height, imageCI.arrayLayers);
+        gl.TexStorage3D(target, imageCI.mipLevels, imageCI.format, imageCI.width, imageCI.height, imageCI.arrayLayers);
     } else if (target == GL_TEXTURE_2D_MULTISAMPLE_ARRAY) {
-        glTexStorage3DMultisample(target, imageCI.sampleCount, imageCI.format, imageCI.width, imageCI.height, imageCI.arrayLayers, GL_TRUE);
+        gl.TexStorage3DMultisample(target, imageCI.sampleCount, imageCI.format, imageCI.width, imageCI.height, imageCI.arrayLayers, GL_TRUE);
     } else if (target == GL_TEXTURE_CUBE_MAP_ARRAY) {
-        glTexStorage3D(target, imageCI.mipLevels, imageCI.format, imageCI.width, imageCI.height, imageCI.arrayLayers);
+        gl.TexStorage3D(target, imageCI.mipLevels, imageCI.format, imageCI.width, imageCI.height, imageCI.arrayLayers);
     }
 
-    glBindTexture(target, 0);
+    gl.BindTexture(target, 0);
+    // That replaced whatever SetDescriptor() had bound to the active texture unit.
+    if (activeTextureUnit < maxDescriptorBindings) {
+        boundDescriptors.textures[activeTextureUnit] = {};
+    }
 
-    images[texture] = imageCI;
-    return (void *)(uint64_t)texture;
+    return HandlePool<Image>::ToPointer(images.Allocate({texture, target, true, imageCI}));
 }
 
 void GraphicsAPI_OpenGL::DestroyImage(void *&image) {
-    GLuint texture = (GLuint)(uint64_t)image;
-    images.erase(texture);
-    glDeleteTextures(1, &texture);
+    HandlePool<Image>::Handle handle = HandlePool<Image>::FromPointer(image);
+    const Image *glImage = images.Get(handle);
+    if (!glImage) {
+        DEBUG_BREAK;
+        std::cout << "ERROR: OPENGL: DestroyImage() called with an invalid or destroyed Image." << std::endl;
+        image = nullptr;
+        return;
+    }
+    GLuint texture = glImage->texture;
+    InvalidateFramebuffers(texture);
+    InvalidateBindings(0, texture, 0);
+    if (glImage->owned) {
+        gl.DeleteTextures(1, &texture);
+    }
+    images.Free(handle);
     image = nullptr;
 }
 
 void *GraphicsAPI_OpenGL::CreateImageView(const ImageViewCreateInfo &imageViewCI) {
+    const Image *glImage = images.Get(HandlePool<Image>::FromPointer(imageViewCI.image));
+    if (!glImage) {
+        DEBUG_BREAK;
+        std::cout << "ERROR: OPENGL: CreateImageView() called with an invalid or destroyed Image." << std::endl;
+        return nullptr;
+    }
+    GLuint texture = glImage->texture;
+
     GLuint framebuffer = 0;
-    glGenFramebuffers(1, &framebuffer);
+    gl.GenFramebuffers(1, &framebuffer);
 
     GLenum attachment = imageViewCI.aspect == ImageViewCreateInfo::Aspect::COLOR_BIT ? GL_COLOR_ATTACHMENT0 : GL_DEPTH_ATTACHMENT;
 
-    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
-    if (imageViewCI.view == ImageViewCreateInfo::View::TYPE_2D_ARRAY) {
-        glFramebufferTextureMultiviewOVR(GL_DRAW_FRAMEBUFFER, attachment, (GLuint)(uint64_t)imageViewCI.image, imageViewCI.baseMipLevel, imageViewCI.baseArrayLayer, imageViewCI.layerCount);
+    gl.BindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    if (imageViewCI.view == ImageViewCreateInfo::View::TYPE_2D_ARRAY && HasFeature(Feature::MULTIVIEW)) {
+        gl.FramebufferTextureMultiviewOVR(GL_DRAW_FRAMEBUFFER, attachment, texture, imageViewCI.baseMipLevel, imageViewCI.baseArrayLayer, imageViewCI.layerCount);
     } else if (imageViewCI.view == ImageViewCreateInfo::View::TYPE_2D) {
-        glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, attachment, GL_TEXTURE_2D, (GLuint)(uint64_t)imageViewCI.image, imageViewCI.baseMipLevel);
+        gl.FramebufferTexture2D(GL_DRAW_FRAMEBUFFER, attachment, GL_TEXTURE_2D, texture, imageViewCI.baseMipLevel);
     } else {
         DEBUG_BREAK;
         std::cout << "ERROR: OPENGL: Unknown ImageView View type." << std::endl;
     }
 
-    GLenum result = glCheckFramebufferStatus(GL_DRAW_FRAMEBUFFER);
+    GLenum result = gl.CheckFramebufferStatus(GL_DRAW_FRAMEBUFFER);
     if (result != GL_FRAMEBUFFER_COMPLETE) {
         DEBUG_BREAK;
         std::cout << "ERROR: OPENGL: Framebuffer is not complete." << std::endl;
     }
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    gl.BindFramebuffer(GL_FRAMEBUFFER, 0);
 
-    imageViews[framebuffer] = imageViewCI;
-    return (void *)(uint64_t)framebuffer;
+    return HandlePool<ImageView>::ToPointer(imageViews.Allocate({framebuffer, texture, imageViewCI}));
 }
 
 void GraphicsAPI_OpenGL::DestroyImageView(void *&imageView) {
-    GLuint framebuffer = (GLuint)(uint64_t)imageView;
-    imageViews.erase(framebuffer);
-    glDeleteFramebuffers(1, &framebuffer);
+    HandlePool<ImageView>::Handle handle = HandlePool<ImageView>::FromPointer(imageView);
+    const ImageView *glImageView = imageViews.Get(handle);
+    if (!glImageView) {
+        DEBUG_BREAK;
+        std::cout << "ERROR: OPENGL: DestroyImageView() called with an invalid or destroyed ImageView." << std::endl;
+        imageView = nullptr;
+        return;
+    }
+    GLuint framebuffer = glImageView->framebuffer;
+    InvalidateFramebuffers(glImageView->texture);
+    gl.DeleteFramebuffers(1, &framebuffer);
+    imageViews.Free(handle);
     imageView = nullptr;
 }
 
 void *GraphicsAPI_OpenGL::CreateSampler(const SamplerCreateInfo &samplerCI) {
     GLuint sampler = 0;
-    PFNGLGENSAMPLERSPROC glGenSamplers = (PFNGLGENSAMPLERSPROC)GetExtension("glGenSamplers");  // 3.2+
-    glGenSamplers(1, &sampler);
-
-    PFNGLSAMPLERPARAMETERIPROC glSamplerParameteri = (PFNGLSAMPLERPARAMETERIPROC)GetExtension("glSamplerParameteri");      // 3.2+
-    PFNGLSAMPLERPARAMETERFPROC glSamplerParameterf = (PFNGLSAMPLERPARAMETERFPROC)GetExtension("glSamplerParameterf");      // 3.2+
-    PFNGLSAMPLERPARAMETERFVPROC glSamplerParameterfv = (PFNGLSAMPLERPARAMETERFVPROC)GetExtension("glSamplerParameterfv");  // 3.2+
+    gl.GenSamplers(1, &sampler);
 
     // Filter
-    glSamplerParameteri(sampler, GL_TEXTURE_MAG_FILTER, ToGLFilter(samplerCI.magFilter));
-    glSamplerParameteri(sampler, GL_TEXTURE_MIN_FILTER, ToGLFilterMipmap(samplerCI.minFilter, samplerCI.mipmapMode));
+    gl.SamplerParameteri(sampler, GL_TEXTURE_MAG_FILTER, ToGLFilter(samplerCI.magFilter));
+    gl.SamplerParameteri(sampler, GL_TEXTURE_MIN_FILTER, ToGLFilterMipmap(samplerCI.minFilter, samplerCI.mipmapMode));
 
     // AddressMode
 
-    glSamplerParameteri(sampler, GL_TEXTURE_WRAP_S, ToGLAddressMode(samplerCI.addressModeS));
-    glSamplerParameteri(sampler, GL_TEXTURE_WRAP_T, ToGLAddressMode(samplerCI.addressModeT));
-    glSamplerParameteri(sampler, GL_TEXTURE_WRAP_R, ToGLAddressMode(samplerCI.addressModeR));
+    gl.SamplerParameteri(sampler, GL_TEXTURE_WRAP_S, ToGLAddressMode(samplerCI.addressModeS));
+    gl.SamplerParameteri(sampler, GL_TEXTURE_WRAP_T, ToGLAddressMode(samplerCI.addressModeT));
+    gl.SamplerParameteri(sampler, GL_TEXTURE_WRAP_R, ToGLAddressMode(samplerCI.addressModeR));
 
     // Lod Bias
-    glSamplerParameterf(sampler, GL_TEXTURE_LOD_BIAS, samplerCI.mipLodBias);
+    gl.SamplerParameterf(sampler, GL_TEXTURE_LOD_BIAS, samplerCI.mipLodBias);
 
     // Compare
-    glSamplerParameteri(sampler, GL_TEXTURE_COMPARE_MODE, samplerCI.compareEnable ? GL_COMPARE_REF_TO_TEXTURE : GL_NONE);
-    glSamplerParameteri(sampler, GL_TEXTURE_COMPARE_FUNC, ToGLCompareOp(samplerCI.compareOp));
+    gl.SamplerParameteri(sampler, GL_TEXTURE_COMPARE_MODE, samplerCI.compareEnable ? GL_COMPARE_REF_TO_TEXTURE : GL_NONE);
+    gl.SamplerParameteri(sampler, GL_TEXTURE_COMPARE_FUNC, ToGLCompareOp(samplerCI.compareOp));
 
     // Lod
-    glSamplerParameterf(sampler, GL_TEXTURE_MIN_LOD, samplerCI.minLod);
-    glSamplerParameterf(sampler, GL_TEXTURE_MAX_LOD, samplerCI.maxLod);
+    gl.SamplerParameterf(sampler, GL_TEXTURE_MIN_LOD, samplerCI.minLod);
+    gl.SamplerParameterf(sampler, GL_TEXTURE_MAX_LOD, samplerCI.maxLod);
 
     // BorderColor
-    glSamplerParameterfv(sampler, GL_TEXTURE_BORDER_COLOR, samplerCI.borderColor);
+    gl.SamplerParameterfv(sampler, GL_TEXTURE_BORDER_COLOR, samplerCI.borderColor);
 
     return (void *)(uint64_t)sampler;
 }
 
 void GraphicsAPI_OpenGL::DestroySampler(void *&sampler) {
     GLuint glsampler = (GLuint)(uint64_t)sampler;
-    PFNGLDELETESAMPLERSPROC glDeleteSamplers = (PFNGLDELETESAMPLERSPROC)GetExtension("glDeleteSamplers");  // 3.2+
-    glDeleteSamplers(1, &glsampler);
+    InvalidateBindings(0, 0, glsampler);
+    gl.DeleteSamplers(1, &glsampler);
     sampler = nullptr;
 }
 
 void *GraphicsAPI_OpenGL::CreateBuffer(const BufferCreateInfo &bufferCI) {
     GLuint buffer = 0;
-    glGenBuffers(1, &buffer);
+    gl.GenBuffers(1, &buffer);
 
-    GLenum target = 0;
-    if (bufferCI.type == BufferCreateInfo::Type::VERTEX) {
-        target = GL_ARRAY_BUFFER;
-    } else if (bufferCI.type == BufferCreateInfo::Type::INDEX) {
-        target = GL_ELEMENT_ARRAY_BUFFER;
-    } else if (bufferCI.type == BufferCreateInfo::Type::UNIFORM) {
-        target = GL_UNIFORM_BUFFER;
-    } else {
+    GLenum target = ToGLBufferTarget(bufferCI.type);
+    if (!target) {
         DEBUG_BREAK;
         std::cout << "ERROR: OPENGL: Unknown Buffer Type." << std::endl;
     }
 
-    glBindBuffer(target, buffer);
-    glBufferData(target, (GLsizeiptr)bufferCI.size, bufferCI.data, GL_STATIC_DRAW);
-    glBindBuffer(target, 0);
+    // Upload through GL_COPY_WRITE_BUFFER: binding GL_ELEMENT_ARRAY_BUFFER would change the bound VAO.
+    gl.BindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+    gl.BufferData(GL_COPY_WRITE_BUFFER, (GLsizeiptr)bufferCI.size, bufferCI.data, GL_STATIC_DRAW);
+    gl.BindBuffer(GL_COPY_WRITE_BUFFER, 0);
 
-    buffers[buffer] = bufferCI;
-    return (void *)(uint64_t)buffer;
+    return HandlePool<Buffer>::ToPointer(buffers.Allocate({buffer, target, bufferCI}));
 }
 
 void GraphicsAPI_OpenGL::DestroyBuffer(void *&buffer) {
-    GLuint glBuffer = (GLuint)(uint64_t)buffer;
-    buffers.erase(glBuffer);
-    glDeleteBuffers(1, &glBuffer);
+    HandlePool<Buffer>::Handle handle = HandlePool<Buffer>::FromPointer(buffer);
+    const Buffer *glBuffer = buffers.Get(handle);
+    if (!glBuffer) {
+        DEBUG_BREAK;
+        std::cout << "ERROR: OPENGL: DestroyBuffer() called with an invalid or destroyed Buffer." << std::endl;
+        buffer = nullptr;
+        return;
+    }
+    GLuint glBufferID = glBuffer->buffer;
+    if (setIndexBuffer == glBufferID) {
+        setIndexBuffer = 0;
+    }
+    if (setIndirectBuffer == glBufferID) {
+        setIndirectBuffer = 0;
+    }
+    InvalidateBindings(glBufferID, 0, 0);
+    gl.DeleteBuffers(1, &glBufferID);
+    buffers.Free(handle);
     buffer = nullptr;
 }
 
@@ -654,465 +1135,1198 @@ void *GraphicsAPI_OpenGL::CreateShader(const ShaderCreateInfo &shaderCI) {
     default:
         std::cout << "ERROR: OPENGL: Unknown Shader Type." << std::endl;
     }
-    GLuint shader = glCreateShader(type);
-
-    glShaderSource(shader, 1, &shaderCI.sourceData, nullptr);
-    glCompileShader(shader);
-
-    GLint isCompiled = 0;
-    glGetShaderiv(shader, GL_COMPILE_STATUS, &isCompiled);
-    if (isCompiled == GL_FALSE) {
-        GLint maxLength = 0;
-        glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &maxLength);
 
-        std::vector<GLchar> infoLog(maxLength);
-        glGetShaderInfoLog(shader, maxLength, &maxLength, &infoLog[0]);
-        std::cout << infoLog.data() << std::endl;
-        DEBUG_BREAK;
+    // Compilation is deferred to CreatePipeline(), which skips it if the linked program is in the pipeline cache.
+    std::string source = shaderCI.sourceSize ? std::string(shaderCI.sourceData, shaderCI.sourceSize) : std::string(shaderCI.sourceData);
+    uint64_t sourceHash = HashFNV1a(source.data(), source.size(), HashFNV1a(&type, sizeof(type)));
+    return HandlePool<Shader>::ToPointer(shaders.Allocate({0, type, source, sourceHash}));
+}
 
-        glDeleteShader(shader);
-        shader = 0;
+GLuint GraphicsAPI_OpenGL::GetCompiledShader(Shader &glShader) {
+    if (glShader.shader) {
+        return glShader.shader;
     }
+    GLuint shader = gl.CreateShader(glShader.type);
+
+    // The compile status is not checked here, as that would wait for the compile to finish. Errors are reported by
+    // FinishPipeline() if the program fails to link.
+    const char *sourceData = glShader.source.c_str();
+    gl.ShaderSource(shader, 1, &sourceData, nullptr);
+    gl.CompileShader(shader);
 
-    return (void *)(uint64_t)shader;
+    glShader.shader = shader;
+    return shader;
 }
 
 void GraphicsAPI_OpenGL::DestroyShader(void *&shader) {
-    GLuint glShader = (GLuint)(uint64_t)shader;
-    glDeleteShader(glShader);
+    HandlePool<Shader>::Handle handle = HandlePool<Shader>::FromPointer(shader);
+    const Shader *glShader = shaders.Get(handle);
+    if (!glShader) {
+        DEBUG_BREAK;
+        std::cout << "ERROR: OPENGL: DestroyShader() called with an invalid or destroyed Shader." << std::endl;
+        shader = nullptr;
+        return;
+    }
+    if (glShader->shader) {
+        gl.DeleteShader(glShader->shader);
+    }
+    shaders.Free(handle);
     shader = nullptr;
 }
 
 void *GraphicsAPI_OpenGL::CreatePipeline(const PipelineCreateInfo &pipelineCI) {
-    GLuint program = glCreateProgram();
+    // Return the existing pipeline if one was built from an identical key.
+    PipelineKey key;
+    std::memset(&key, 0, sizeof(key));
+    ToPipelineKey(pipelineCI, key);
+    const uint64_t keyHash = HashFNV1a(&key, sizeof(key));
+    const auto matches = pipelineLookup.equal_range(keyHash);
+    for (auto it = matches.first; it != matches.second; ++it) {
+        Pipeline *glPipeline = pipelines.Get(it->second);
+        if (glPipeline && std::memcmp(&glPipeline->key, &key, sizeof(key)) == 0) {
+            glPipeline->referenceCount++;
+            pipelineCacheStatistics.duplicates++;
+            return HandlePool<Pipeline>::ToPointer(it->second);
+        }
+    }
 
-    for (const void *const &shader : pipelineCI.shaders)
-        glAttachShader(program, (GLuint)(uint64_t)shader);
+    GLuint program = gl.CreateProgram();
+
+    const uint64_t pipelineCacheKey = GetPipelineCacheKey(key);
+    float linkMilliseconds = 0.0f;
+    bool ready = false;
+    std::chrono::steady_clock::time_point linkStart = std::chrono::steady_clock::now();
+    if (LoadProgramBinary(program, pipelineCacheKey, linkMilliseconds)) {
+        std::chrono::duration<float, std::milli> loadMilliseconds = std::chrono::steady_clock::now() - linkStart;
+        pipelineCacheStatistics.hits++;
+        pipelineCacheStatistics.millisecondsSaved += std::max(linkMilliseconds - loadMilliseconds.count(), 0.0f);
+        ready = true;
+    } else {
+        pipelineCacheStatistics.misses++;
+        linkStart = std::chrono::steady_clock::now();
+
+        std::vector<GLuint> glShaders;
+        for (void *shader : pipelineCI.shaders) {
+            Shader *glShader = shaders.Get(HandlePool<Shader>::FromPointer(shader));
+            if (!glShader) {
+                continue;  // Reported by ToPipelineKey().
+            }
+            glShaders.push_back(GetCompiledShader(*glShader));
+        }
+
+        for (GLuint shader : glShaders)
+            gl.AttachShader(program, shader);
 
-    glLinkProgram(program);
+        if (HasFeature(Feature::PROGRAM_BINARY)) {
+            gl.ProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+        }
+        // The link status is left for FinishPipeline(), so that the driver's compiler threads can work on this program while
+        // more pipelines are created.
+        gl.LinkProgram(program);
 
-    PFNGLVALIDATEPROGRAMPROC glValidateProgram = (PFNGLVALIDATEPROGRAMPROC)GetExtension("glValidateProgram");  // 2.0+
-    glValidateProgram(program);
+        for (GLuint shader : glShaders)
+            gl.DetachShader(program, shader);
+    }
 
+    Pipeline glPipeline{};
+    glPipeline.program = program;
+    glPipeline.referenceCount = 1;
+    glPipeline.keyHash = keyHash;
+    for (size_t i = 0; i < std::min(pipelineCI.shaders.size(), maxPipelineShaders); i++) {
+        glPipeline.shaders[i] = HandlePool<Shader>::FromPointer(pipelineCI.shaders[i]);
+    }
+    glPipeline.ready = ready;
+    glPipeline.cacheKey = pipelineCacheKey;
+    glPipeline.linkStart = linkStart;
+
+    // Bake the vertex input layout into a VAO using the separate attribute format API.
+    gl.GenVertexArrays(1, &glPipeline.vertexArray);
+    gl.BindVertexArray(glPipeline.vertexArray);
+    for (const VertexInputAttribute &vertexAttribute : pipelineCI.vertexInputState.attributes) {
+        GLuint attribIndex = vertexAttribute.attribIndex;
+        GLint size = ((GLint)vertexAttribute.vertexType % 4) + 1;
+        gl.EnableVertexAttribArray(attribIndex);
+        if (vertexAttribute.vertexType >= VertexType::UINT) {
+            gl.VertexAttribIFormat(attribIndex, size, GL_UNSIGNED_INT, (GLuint)vertexAttribute.offset);
+        } else if (vertexAttribute.vertexType >= VertexType::INT) {
+            gl.VertexAttribIFormat(attribIndex, size, GL_INT, (GLuint)vertexAttribute.offset);
+        } else {
+            gl.VertexAttribFormat(attribIndex, size, GL_FLOAT, GL_FALSE, (GLuint)vertexAttribute.offset);
+        }
+        gl.VertexAttribBinding(attribIndex, vertexAttribute.bindingIndex);
+    }
+    for (const VertexInputBinding &vertexBinding : pipelineCI.vertexInputState.bindings) {
+        if (vertexBinding.bindingIndex >= maxVertexBindings) {
+            DEBUG_BREAK;
+            std::cout << "ERROR: OPENGL: VertexInputBinding bindingIndex " << vertexBinding.bindingIndex << " is out of range." << std::endl;
+            continue;
+        }
+        glPipeline.vertexBindingCount = std::max(glPipeline.vertexBindingCount, (size_t)vertexBinding.bindingIndex + 1);
+        glPipeline.vertexBindingOffsets[vertexBinding.bindingIndex] = (GLintptr)vertexBinding.offset;
+        glPipeline.vertexBindingStrides[vertexBinding.bindingIndex] = (GLsizei)vertexBinding.stride;
+    }
+    gl.BindVertexArray(stateCache.vertexArray);
+
+    HandlePool<Pipeline>::Handle handle = pipelines.Allocate(glPipeline);
+    // Copy the key as bytes, so that its padding stays zero for memcmp().
+    std::memcpy(&pipelines.Get(handle)->key, &key, sizeof(key));
+    pipelineLookup.emplace(keyHash, handle);
+    return HandlePool<Pipeline>::ToPointer(handle);
+}
+
+bool GraphicsAPI_OpenGL::IsPipelineReady(void *pipeline) {
+    Pipeline *glPipeline = pipelines.Get(HandlePool<Pipeline>::FromPointer(pipeline));
+    if (!glPipeline) {
+        DEBUG_BREAK;
+        std::cout << "ERROR: OPENGL: IsPipelineReady() called with an invalid or destroyed Pipeline." << std::endl;
+        return false;
+    }
+    if (glPipeline->ready) {
+        return !glPipeline->failed;
+    }
+    // Without GL_KHR_parallel_shader_compile there is no way to ask without waiting, so the pipeline is finished here.
+    if (HasFeature(Feature::PARALLEL_SHADER_COMPILE)) {
+        GLint completionStatus = GL_FALSE;
+        gl.GetProgramiv(glPipeline->program, GL_COMPLETION_STATUS_KHR, &completionStatus);
+        if (completionStatus == GL_FALSE) {
+            return false;
+        }
+    }
+    FinishPipeline(*glPipeline);
+    return !glPipeline->failed;
+}
+
+void GraphicsAPI_OpenGL::FinishPipeline(Pipeline &glPipeline) {
     GLint isLinked = 0;
-    glGetProgramiv(program, GL_LINK_STATUS, &isLinked);
+    gl.GetProgramiv(glPipeline.program, GL_LINK_STATUS, &isLinked);
     if (isLinked == GL_FALSE) {
+        for (HandlePool<Shader>::Handle shader : glPipeline.shaders) {
+            const Shader *glShader = shaders.Get(shader);
+            GLint isCompiled = GL_TRUE;
+            if (glShader && glShader->shader) {
+                gl.GetShaderiv(glShader->shader, GL_COMPILE_STATUS, &isCompiled);
+            }
+            if (isCompiled == GL_FALSE) {
+                GLint maxLength = 0;
+                gl.GetShaderiv(glShader->shader, GL_INFO_LOG_LENGTH, &maxLength);
+
+                std::vector<GLchar> infoLog(maxLength);
+                gl.GetShaderInfoLog(glShader->shader, maxLength, &maxLength, &infoLog[0]);
+                std::cout << infoLog.data() << std::endl;
+            }
+        }
         GLint maxLength = 0;
-        glGetProgramiv(program, GL_INFO_LOG_LENGTH, &maxLength);
+        gl.GetProgramiv(glPipeline.program, GL_INFO_LOG_LENGTH, &maxLength);
 
         std::vector<GLchar> infoLog(maxLength);
-        glGetProgramInfoLog(program, maxLength, &maxLength, &infoLog[0]);
+        gl.GetProgramInfoLog(glPipeline.program, maxLength, &maxLength, &infoLog[0]);
+        std::cout << infoLog.data() << std::endl;
+        DEBUG_BREAK;
 
-        glDeleteProgram(program);
+        gl.DeleteProgram(glPipeline.program);
+        glPipeline.program = 0;
+        glPipeline.failed = true;
+    } else {
+        // Measured up to when the link was found to be complete, so this overestimates it when the pipeline is polled late.
+        std::chrono::duration<float, std::milli> linkMilliseconds = std::chrono::steady_clock::now() - glPipeline.linkStart;
+        StoreProgramBinary(glPipeline.program, glPipeline.cacheKey, linkMilliseconds.count());
     }
+    glPipeline.ready = true;
+}
+
+uint64_t GraphicsAPI_OpenGL::GetPipelineCacheKey(const PipelineKey &key) {
+    // Only the parts of the key that the program binary depends on; the rest of the state is applied by SetPipeline().
+    uint64_t cacheKey = driverHash;
+    cacheKey = HashFNV1a(key.shaderHashes.data(), key.shaderCount * sizeof(key.shaderHashes[0]), cacheKey);
+    cacheKey = HashFNV1a(key.vertexAttributes.data(), key.vertexAttributeCount * sizeof(key.vertexAttributes[0]), cacheKey);
+    cacheKey = HashFNV1a(key.vertexBindings.data(), key.vertexBindingCount * sizeof(key.vertexBindings[0]), cacheKey);
+    return cacheKey;
+}
+
+std::string GraphicsAPI_OpenGL::GetPipelineCacheDirectory() const {
+    return pipelineCacheDirectory.empty() ? std::string("PipelineCache") : pipelineCacheDirectory;
+}
+
+std::string GraphicsAPI_OpenGL::GetPipelineCachePath(uint64_t key) {
+    std::stringstream path;
+    path << GetPipelineCacheDirectory() << "/";
+    path << "PipelineCache_" << std::hex << std::setw(16) << std::setfill('0') << key << ".bin";
+    return path.str();
+}
 
-    PFNGLDETACHSHADERPROC glDetachShader = (PFNGLDETACHSHADERPROC)GetExtension("glDetachShader");  // 2.0+
-    for (const void *const &shader : pipelineCI.shaders)
-        glDetachShader(program, (GLuint)(uint64_t)shader);
+bool GraphicsAPI_OpenGL::LoadProgramBinary(GLuint program, uint64_t key, float &linkMilliseconds) {
+    if (!HasFeature(Feature::PROGRAM_BINARY)) {
+        return false;
+    }
+    std::ifstream stream(GetPipelineCachePath(key), std::fstream::in | std::fstream::binary);
+    if (!stream.is_open()) {
+        return false;
+    }
+    ProgramBinaryHeader header{};
+    stream.read((char *)&header, sizeof(ProgramBinaryHeader));
+    if (!stream || header.magic != programBinaryMagic) {
+        return false;
+    }
+    std::vector<char> binary(header.binarySize);
+    stream.read(binary.data(), header.binarySize);
+    if (!stream) {
+        return false;
+    }
 
-    pipelines[program] = pipelineCI;
+    // The driver may reject a binary it produced, e.g. after an update that kept the version string.
+    gl.ProgramBinary(program, (GLenum)header.binaryFormat, binary.data(), (GLsizei)header.binarySize);
+    GLint isLinked = 0;
+    gl.GetProgramiv(program, GL_LINK_STATUS, &isLinked);
+    if (isLinked == GL_FALSE) {
+        std::cout << "WARNING: OPENGL: Cached program binary " << GetPipelineCachePath(key) << " was rejected. Rebuilding it from source." << std::endl;
+        return false;
+    }
+    linkMilliseconds = header.linkMilliseconds;
+    return true;
+}
 
-    return (void *)(uint64_t)program;
+void GraphicsAPI_OpenGL::StoreProgramBinary(GLuint program, uint64_t key, float linkMilliseconds) {
+    if (!HasFeature(Feature::PROGRAM_BINARY)) {
+        return;
+    }
+    GLint binaryLength = 0;
+    gl.GetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &binaryLength);
+    if (binaryLength <= 0) {
+        return;
+    }
+    std::vector<char> binary(binaryLength);
+    GLenum binaryFormat = 0;
+    gl.GetProgramBinary(program, binaryLength, &binaryLength, &binaryFormat, binary.data());
+
+    if (!pipelineCacheDirectoryCreated) {
+        pipelineCacheDirectoryCreated = CreateDirectories(GetPipelineCacheDirectory());
+        if (!pipelineCacheDirectoryCreated) {
+            std::cout << "WARNING: OPENGL: Could not create the pipeline cache directory " << GetPipelineCacheDirectory() << "." << std::endl;
+            return;
+        }
+    }
+    std::ofstream stream(GetPipelineCachePath(key), std::fstream::out | std::fstream::binary | std::fstream::trunc);
+    if (!stream.is_open()) {
+        std::cout << "WARNING: OPENGL: Could not write program binary " << GetPipelineCachePath(key) << "." << std::endl;
+        return;
+    }
+    ProgramBinaryHeader header{programBinaryMagic, (uint32_t)binaryFormat, (uint32_t)binaryLength, linkMilliseconds};
+    stream.write((const char *)&header, sizeof(ProgramBinaryHeader));
+    stream.write(binary.data(), binaryLength);
 }
 
 void GraphicsAPI_OpenGL::DestroyPipeline(void *&pipeline) {
-    GLint program = (GLuint)(uint64_t)pipeline;
-    pipelines.erase(program);
-    glDeleteProgram(program);
+    HandlePool<Pipeline>::Handle handle = HandlePool<Pipeline>::FromPointer(pipeline);
+    Pipeline *glPipeline = pipelines.Get(handle);
+    if (!glPipeline) {
+        DEBUG_BREAK;
+        std::cout << "ERROR: OPENGL: DestroyPipeline() called with an invalid or destroyed Pipeline." << std::endl;
+        pipeline = nullptr;
+        return;
+    }
+    // Other CreatePipeline() calls still hold the pipeline.
+    if (--glPipeline->referenceCount > 0) {
+        pipeline = nullptr;
+        return;
+    }
+    const auto matches = pipelineLookup.equal_range(glPipeline->keyHash);
+    for (auto it = matches.first; it != matches.second; ++it) {
+        if (it->second == handle) {
+            pipelineLookup.erase(it);
+            break;
+        }
+    }
+
+    GLuint program = glPipeline->program;
+    gl.DeleteProgram(program);
+    if (stateCache.program == program) {
+        stateCache.program = 0;
+    }
+    GLuint vertexArray = glPipeline->vertexArray;
+    if (stateCache.vertexArray == vertexArray) {
+        gl.BindVertexArray(0);
+        stateCache.vertexArray = 0;
+    }
+    gl.DeleteVertexArrays(1, &vertexArray);
+    if (setPipeline == handle) {
+        setPipeline = HandlePool<Pipeline>::NullHandle;
+    }
+    pipelines.Free(handle);
     pipeline = nullptr;
 }
 
 void GraphicsAPI_OpenGL::BeginRendering() {
-    glGenVertexArrays(1, &vertexArray);
-    glBindVertexArray(vertexArray);
-
-    glGenFramebuffers(1, &setFramebuffer);
-    glBindFramebuffer(GL_FRAMEBUFFER, setFramebuffer);
 }
 
 void GraphicsAPI_OpenGL::EndRendering() {
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
-    glDeleteFramebuffers(1, &setFramebuffer);
+    gl.BindFramebuffer(GL_FRAMEBUFFER, 0);
     setFramebuffer = 0;
-
-    glBindVertexArray(0);
-    glDeleteVertexArrays(1, &vertexArray);
-    vertexArray = 0;
 }
 
 void GraphicsAPI_OpenGL::SetBufferData(void *buffer, size_t offset, size_t size, void *data) {
-    GLuint glBuffer = (GLuint)(uint64_t)buffer;
-    const BufferCreateInfo &bufferCI = buffers[glBuffer];
+    const Buffer *glBuffer = buffers.Get(HandlePool<Buffer>::FromPointer(buffer));
+    if (!glBuffer) {
+        DEBUG_BREAK;
+        std::cout << "ERROR: OPENGL: SetBufferData() called with an invalid or destroyed Buffer." << std::endl;
+        return;
+    }
 
-    GLenum target = 0;
-    if (bufferCI.type == BufferCreateInfo::Type::VERTEX) {
-        target = GL_ARRAY_BUFFER;
-    } else if (bufferCI.type == BufferCreateInfo::Type::INDEX) {
-        target = GL_ELEMENT_ARRAY_BUFFER;
-    } else if (bufferCI.type == BufferCreateInfo::Type::UNIFORM) {
-        target = GL_UNIFORM_BUFFER;
-    } else {
+    if (data) {
+        frameStatistics.bytesUploaded += size;
+        gl.BindBuffer(GL_COPY_WRITE_BUFFER, glBuffer->buffer);
+        gl.BufferSubData(GL_COPY_WRITE_BUFFER, (GLintptr)offset, (GLsizeiptr)size, data);
+        gl.BindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    }
+}
+
+GraphicsAPI::TransientAllocation GraphicsAPI_OpenGL::AllocateTransientBuffer(BufferCreateInfo::Type type, size_t size) {
+    if ((size_t)type >= transientBuffers.size()) {
         DEBUG_BREAK;
         std::cout << "ERROR: OPENGL: Unknown Buffer Type." << std::endl;
+        return {};
+    }
+    TransientBuffer &transientBuffer = transientBuffers[(size_t)type];
+    if (!transientBuffer.mappedData && !CreateTransientBuffer(type, transientBuffer)) {
+        return {};
     }
 
-    if (data) {
-        glBindBuffer(target, glBuffer);
-        glBufferSubData(target, (GLintptr)offset, (GLsizeiptr)size, data);
-        glBindBuffer(target, 0);
+    size_t offset = Align<size_t>(transientBuffer.offset, transientBuffer.alignment);
+    if (offset + size > (frameInFlightIndex + 1) * transientBufferPartSize) {
+        DEBUG_BREAK;
+        std::cout << "ERROR: OPENGL: Transient Buffer is exhausted for this frame. Increase transientBufferPartSize." << std::endl;
+        return {};
     }
+    transientBuffer.offset = offset + size;
+    frameStatistics.transientBytesAllocated += size;
+
+    return {HandlePool<Buffer>::ToPointer(transientBuffer.buffer), offset, size, transientBuffer.mappedData + offset};
+}
+
+bool GraphicsAPI_OpenGL::CreateTransientBuffer(BufferCreateInfo::Type type, TransientBuffer &transientBuffer) {
+    GLint alignment = 16;
+    if (type == BufferCreateInfo::Type::UNIFORM) {
+        gl.GetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+    } else if (type == BufferCreateInfo::Type::STORAGE) {
+        gl.GetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &alignment);
+    }
+
+    BufferCreateInfo bufferCI{type, 0, transientBufferPartSize * framesInFlight, nullptr};
+    GLuint buffer = 0;
+    gl.GenBuffers(1, &buffer);
+
+    // Coherent and persistently mapped: writes through the pointer need no flush or unmap before the GPU reads them.
+    const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    gl.BindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+    gl.BufferStorage(GL_COPY_WRITE_BUFFER, (GLsizeiptr)bufferCI.size, nullptr, flags);
+    void *mappedData = gl.MapBufferRange(GL_COPY_WRITE_BUFFER, 0, (GLsizeiptr)bufferCI.size, flags);
+    gl.BindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    if (!mappedData) {
+        DEBUG_BREAK;
+        std::cout << "ERROR: OPENGL: Failed to map Transient Buffer." << std::endl;
+        gl.DeleteBuffers(1, &buffer);
+        return false;
+    }
+
+    transientBuffer.buffer = buffers.Allocate({buffer, ToGLBufferTarget(type), bufferCI});
+    transientBuffer.mappedData = reinterpret_cast<uint8_t *>(mappedData);
+    transientBuffer.alignment = (size_t)alignment;
+    transientBuffer.offset = frameInFlightIndex * transientBufferPartSize;
+    return true;
+}
+
+void GraphicsAPI_OpenGL::DestroyTransientBuffer(TransientBuffer &transientBuffer) {
+    if (const Buffer *glBuffer = buffers.Get(transientBuffer.buffer)) {
+        GLuint glBufferID = glBuffer->buffer;
+        gl.BindBuffer(GL_COPY_WRITE_BUFFER, glBufferID);
+        gl.UnmapBuffer(GL_COPY_WRITE_BUFFER);
+        gl.BindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        gl.DeleteBuffers(1, &glBufferID);
+        buffers.Free(transientBuffer.buffer);
+    }
+    transientBuffer = {};
 }
 
 void GraphicsAPI_OpenGL::ClearColor(void *imageView, float r, float g, float b, float a) {
-    glBindFramebuffer(GL_FRAMEBUFFER, (GLuint)(uint64_t)imageView);
-    glClearColor(r, g, b, a);
-    glClear(GL_COLOR_BUFFER_BIT);
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    // gl.Clear() respects the color write mask, so make sure the cached mask allows writes.
+    if (UpdateStateCache(stateCache.pipeline.attachments[0].colorMask, {GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE})) {
+        gl.ColorMaski(0, GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+    }
+    // As in Vulkan, a clear covers the whole image whatever the scissors.
+    SetCapability(GL_SCISSOR_TEST, stateCache.scissorTestEnable, false);
+
+    const ImageView *glImageView = imageViews.Get(HandlePool<ImageView>::FromPointer(imageView));
+    if (!glImageView) {
+        DEBUG_BREAK;
+        std::cout << "ERROR: OPENGL: Clear called with an invalid or destroyed ImageView." << std::endl;
+        return;
+    }
+    gl.BindFramebuffer(GL_FRAMEBUFFER, glImageView->framebuffer);
+    gl.ClearColor(r, g, b, a);
+    gl.Clear(GL_COLOR_BUFFER_BIT);
+    gl.BindFramebuffer(GL_FRAMEBUFFER, setFramebuffer);
 }
 
 void GraphicsAPI_OpenGL::ClearDepth(void *imageView, float d) {
-    glBindFramebuffer(GL_FRAMEBUFFER, (GLuint)(uint64_t)imageView);
-    glClearDepth(d);
-    glClear(GL_DEPTH_BUFFER_BIT);
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    // gl.Clear() respects the depth write mask, so make sure the cached mask allows writes.
+    if (UpdateStateCache(stateCache.pipeline.depthMask, (GLboolean)GL_TRUE)) {
+        gl.DepthMask(GL_TRUE);
+    }
+    SetCapability(GL_SCISSOR_TEST, stateCache.scissorTestEnable, false);
+
+    const ImageView *glImageView = imageViews.Get(HandlePool<ImageView>::FromPointer(imageView));
+    if (!glImageView) {
+        DEBUG_BREAK;
+        std::cout << "ERROR: OPENGL: Clear called with an invalid or destroyed ImageView." << std::endl;
+        return;
+    }
+    gl.BindFramebuffer(GL_FRAMEBUFFER, glImageView->framebuffer);
+    gl.ClearDepth(d);
+    gl.Clear(GL_DEPTH_BUFFER_BIT);
+    gl.BindFramebuffer(GL_FRAMEBUFFER, setFramebuffer);
 }
 
 void GraphicsAPI_OpenGL::SetRenderAttachments(void **colorViews, size_t colorViewCount, void *depthStencilView, uint32_t width, uint32_t height, void *pipeline) {
-    // Reset Framebuffer
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
-    glDeleteFramebuffers(1, &setFramebuffer);
-    setFramebuffer = 0;
-
-    glGenFramebuffers(1, &setFramebuffer);
-    glBindFramebuffer(GL_FRAMEBUFFER, setFramebuffer);
+    Framebuffer key{};
+    if (colorViewCount > maxColorAttachments) {
+        DEBUG_BREAK;
+        std::cout << "ERROR: OPENGL: SetRenderAttachments() called with more than " << maxColorAttachments << " color ImageViews." << std::endl;
+        colorViewCount = maxColorAttachments;
+    }
 
     // Color
     for (size_t i = 0; i < colorViewCount; i++) {
-        GLenum attachment = GL_COLOR_ATTACHMENT0;
-
-        GLuint glColorView = (GLuint)(uint64_t)colorViews[i];
-        const ImageViewCreateInfo &imageViewCI = imageViews[glColorView];
-
-        if (imageViewCI.view == ImageViewCreateInfo::View::TYPE_2D_ARRAY) {
-            glFramebufferTextureMultiviewOVR(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, (GLuint)(uint64_t)imageViewCI.image, imageViewCI.baseMipLevel, imageViewCI.baseArrayLayer, imageViewCI.layerCount);
-        } else if (imageViewCI.view == ImageViewCreateInfo::View::TYPE_2D) {
-            glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, (GLuint)(uint64_t)imageViewCI.image, imageViewCI.baseMipLevel);
-        } else {
+        const ImageView *glColorView = imageViews.Get(HandlePool<ImageView>::FromPointer(colorViews[i]));
+        if (!glColorView) {
             DEBUG_BREAK;
-            std::cout << "ERROR: OPENGL: Unknown ImageView View type." << std::endl;
+            std::cout << "ERROR: OPENGL: SetRenderAttachments() called with an invalid or destroyed color ImageView." << std::endl;
+            continue;
         }
+        key.colorAttachments[key.colorAttachmentCount++] = ToFramebufferAttachment(glColorView);
     }
     // DepthStencil
-    if (depthStencilView) {
-        GLuint glDepthView = (GLuint)(uint64_t)depthStencilView;
-        const ImageViewCreateInfo &imageViewCI = imageViews[glDepthView];
-
-        if (imageViewCI.view == ImageViewCreateInfo::View::TYPE_2D_ARRAY) {
-            glFramebufferTextureMultiviewOVR(GL_DRAW_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, (GLuint)(uint64_t)imageViewCI.image, imageViewCI.baseMipLevel, imageViewCI.baseArrayLayer, imageViewCI.layerCount);
-        } else if (imageViewCI.view == ImageViewCreateInfo::View::TYPE_2D) {
-            glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, (GLuint)(uint64_t)imageViewCI.image, imageViewCI.baseMipLevel);
+    const ImageView *glDepthView = imageViews.Get(HandlePool<ImageView>::FromPointer(depthStencilView));
+    if (depthStencilView && !glDepthView) {
+        DEBUG_BREAK;
+        std::cout << "ERROR: OPENGL: SetRenderAttachments() called with an invalid or destroyed depth ImageView." << std::endl;
+    }
+    if (glDepthView) {
+        key.depthStencilAttachment = ToFramebufferAttachment(glDepthView);
+    }
+
+    setFramebuffer = GetFramebuffer(key);
+    gl.BindFramebuffer(GL_FRAMEBUFFER, setFramebuffer);
+}
+
+GraphicsAPI_OpenGL::FramebufferAttachment GraphicsAPI_OpenGL::ToFramebufferAttachment(const ImageView *imageView) {
+    const ImageViewCreateInfo &imageViewCI = imageView->imageViewCI;
+    return {imageView->texture, imageViewCI.view, imageViewCI.baseMipLevel, imageViewCI.baseArrayLayer, imageViewCI.layerCount};
+}
+
+GLuint GraphicsAPI_OpenGL::GetFramebuffer(const Framebuffer &key) {
+    for (const Framebuffer &framebuffer : framebuffers) {
+        if (framebuffer.colorAttachmentCount != key.colorAttachmentCount || !(framebuffer.depthStencilAttachment == key.depthStencilAttachment)) {
+            continue;
+        }
+        if (std::equal(key.colorAttachments.begin(), key.colorAttachments.begin() + key.colorAttachmentCount, framebuffer.colorAttachments.begin())) {
+            return framebuffer.framebuffer;
+        }
+    }
+
+    // Not seen before: create the framebuffer and check its completeness once.
+    Framebuffer framebuffer = key;
+    gl.GenFramebuffers(1, &framebuffer.framebuffer);
+    gl.BindFramebuffer(GL_FRAMEBUFFER, framebuffer.framebuffer);
+
+    auto Attach = [this](GLenum attachment, const FramebufferAttachment &framebufferAttachment) {
+        if (framebufferAttachment.view == ImageViewCreateInfo::View::TYPE_2D_ARRAY && HasFeature(Feature::MULTIVIEW)) {
+            gl.FramebufferTextureMultiviewOVR(GL_DRAW_FRAMEBUFFER, attachment, framebufferAttachment.texture, framebufferAttachment.mipLevel, framebufferAttachment.baseArrayLayer, framebufferAttachment.layerCount);
+        } else if (framebufferAttachment.view == ImageViewCreateInfo::View::TYPE_2D) {
+            gl.FramebufferTexture2D(GL_DRAW_FRAMEBUFFER, attachment, GL_TEXTURE_2D, framebufferAttachment.texture, framebufferAttachment.mipLevel);
         } else {
             DEBUG_BREAK;
             std::cout << "ERROR: OPENGL: Unknown ImageView View type." << std::endl;
         }
+    };
+    std::array<GLenum, maxColorAttachments> drawBuffers{};
+    for (size_t i = 0; i < framebuffer.colorAttachmentCount; i++) {
+        drawBuffers[i] = GL_COLOR_ATTACHMENT0 + (GLenum)i;
+        Attach(drawBuffers[i], framebuffer.colorAttachments[i]);
     }
+    if (framebuffer.depthStencilAttachment.texture) {
+        Attach(GL_DEPTH_ATTACHMENT, framebuffer.depthStencilAttachment);
+    }
+    // Part of the framebuffer's state, so it is set once here rather than each time the framebuffer is bound.
+    gl.DrawBuffers((GLsizei)framebuffer.colorAttachmentCount, drawBuffers.data());
 
-    GLenum result = glCheckFramebufferStatus(GL_DRAW_FRAMEBUFFER);
+    GLenum result = gl.CheckFramebufferStatus(GL_DRAW_FRAMEBUFFER);
     if (result != GL_FRAMEBUFFER_COMPLETE) {
         DEBUG_BREAK;
         std::cout << "ERROR: OPENGL: Framebuffer is not complete." << std::endl;
     }
+
+    framebuffers.push_back(framebuffer);
+    return framebuffer.framebuffer;
+}
+
+void GraphicsAPI_OpenGL::InvalidateFramebuffers(GLuint texture) {
+    for (size_t i = 0; i < framebuffers.size();) {
+        const Framebuffer &framebuffer = framebuffers[i];
+        bool usesTexture = framebuffer.depthStencilAttachment.texture == texture;
+        for (size_t j = 0; j < framebuffer.colorAttachmentCount; j++) {
+            usesTexture |= framebuffer.colorAttachments[j].texture == texture;
+        }
+        if (usesTexture) {
+            if (setFramebuffer == framebuffer.framebuffer) {
+                gl.BindFramebuffer(GL_FRAMEBUFFER, 0);
+                setFramebuffer = 0;
+            }
+            gl.DeleteFramebuffers(1, &framebuffer.framebuffer);
+            framebuffers.erase(framebuffers.begin() + i);
+        } else {
+            i++;
+        }
+    }
 }
 
 void GraphicsAPI_OpenGL::SetViewports(Viewport *viewports, size_t count) {
-    PFNGLVIEWPORTINDEXEDFPROC glViewportIndexedf = (PFNGLVIEWPORTINDEXEDFPROC)GetExtension("glViewportIndexedf");      // 4.1+
-    PFNGLDEPTHRANGEINDEXEDPROC glDepthRangeIndexed = (PFNGLDEPTHRANGEINDEXEDPROC)GetExtension("glDepthRangeIndexed");  // 4.1+
 
     for (size_t i = 0; i < count; i++) {
         Viewport viewport = viewports[i];
-        glViewportIndexedf((GLuint)i, viewport.x, viewport.y, viewport.width, viewport.height);
-        glDepthRangeIndexed((GLuint)i, (GLdouble)viewport.minDepth, (GLdouble)viewport.maxDepth);
+        gl.ViewportIndexedf((GLuint)i, viewport.x, viewport.y, viewport.width, viewport.height);
+        gl.DepthRangeIndexed((GLuint)i, (GLdouble)viewport.minDepth, (GLdouble)viewport.maxDepth);
     }
 }
 
 void GraphicsAPI_OpenGL::SetScissors(Rect2D *scissors, size_t count) {
-    PFNGLSCISSORINDEXEDPROC glScissorIndexed = (PFNGLSCISSORINDEXEDPROC)GetExtension("glScissorIndexed");  // 4.1+
-
+    // Enables the test for all viewports; the scissors of the viewports not given here keep their last values.
+    SetCapability(GL_SCISSOR_TEST, stateCache.scissorTestEnable, true);
     for (size_t i = 0; i < count; i++) {
         Rect2D scissor = scissors[i];
-        glScissorIndexed((GLuint)i, (GLint)scissor.offset.x, (GLint)scissor.offset.y, (GLsizei)scissor.extent.width, (GLsizei)scissor.extent.height);
+        gl.ScissorIndexed((GLuint)i, (GLint)scissor.offset.x, (GLint)scissor.offset.y, (GLsizei)scissor.extent.width, (GLsizei)scissor.extent.height);
     }
 }
 
-void GraphicsAPI_OpenGL::SetPipeline(void *pipeline) {
-    GLuint program = (GLuint)(uint64_t)pipeline;
-    glUseProgram(program);
-    setPipeline = program;
-
-    const PipelineCreateInfo &pipelineCI = pipelines[program];
-
+void GraphicsAPI_OpenGL::ToPipelineState(const PipelineCreateInfo &pipelineCI, PipelineState &PS) {
     // InputAssemblyState
     const InputAssemblyState &IAS = pipelineCI.inputAssemblyState;
-    if (IAS.primitiveRestartEnable) {
-        glEnable(GL_PRIMITIVE_RESTART);
-    } else {
-        glDisable(GL_PRIMITIVE_RESTART);
-    }
+    PS.primitiveRestartEnable = IAS.primitiveRestartEnable;
 
     // RasterisationState
     const RasterisationState &RS = pipelineCI.rasterisationState;
+    PS.depthClampEnable = RS.depthClampEnable;
+    PS.rasteriserDiscardEnable = RS.rasteriserDiscardEnable;
+    PS.polygonMode = RS.cullMode == CullMode::FRONT_AND_BACK ? ToGLPolygonMode(RS.polygonMode) : 0;
+    PS.cullFaceEnable = RS.cullMode > CullMode::NONE;
+    PS.cullFace = PS.cullFaceEnable ? ToGLCullMode(RS.cullMode) : GL_BACK;
+    PS.frontFace = RS.frontFace == FrontFace::COUNTER_CLOCKWISE ? GL_CCW : GL_CW;
+    PS.polygonOffsetIndex = RS.polygonMode == PolygonMode::LINE ? 1 : RS.polygonMode == PolygonMode::POINT ? 2 : 0;
+    PS.polygonOffsetEnable = RS.depthBiasEnable;
+    PS.polygonOffset = RS.depthBiasEnable ? std::array<GLfloat, 2>{RS.depthBiasSlopeFactor, RS.depthBiasConstantFactor} : std::array<GLfloat, 2>{0.0f, 0.0f};
+    PS.lineWidth = RS.lineWidth;
 
-    if (RS.depthClampEnable) {
-        glEnable(GL_DEPTH_CLAMP);
-    } else {
-        glDisable(GL_DEPTH_CLAMP);
+    // MultisampleState
+    const MultisampleState &MS = pipelineCI.multisampleState;
+    PS.multisampleEnable = MS.rasterisationSamples > 1;
+    PS.sampleShadingEnable = MS.sampleShadingEnable;
+    PS.minSampleShading = MS.sampleShadingEnable ? MS.minSampleShading : 0.0f;
+    PS.sampleMaskEnable = MS.sampleMask > 0;
+    PS.sampleMask = MS.sampleMask;
+    PS.alphaToCoverageEnable = MS.alphaToCoverageEnable;
+    PS.alphaToOneEnable = MS.alphaToOneEnable;
+
+    // DepthStencilState
+    const DepthStencilState &DSS = pipelineCI.depthStencilState;
+    PS.depthTestEnable = DSS.depthTestEnable;
+    PS.depthMask = DSS.depthWriteEnable ? GL_TRUE : GL_FALSE;
+    PS.depthFunc = ToGLCompareOp(DSS.depthCompareOp);
+    PS.depthBoundsTestEnable = DSS.depthBoundsTestEnable;
+    PS.depthBounds = DSS.depthBoundsTestEnable ? std::array<GLdouble, 2>{(GLdouble)DSS.minDepthBounds, (GLdouble)DSS.maxDepthBounds} : std::array<GLdouble, 2>{0.0, 1.0};
+    PS.stencilTestEnable = DSS.stencilTestEnable;
+    auto ToStencilFaceState = [&](const StencilOpState &SOS) -> StencilFaceState {
+        if (!DSS.stencilTestEnable) {
+            return {{GL_KEEP, GL_KEEP, GL_KEEP}, {GL_ALWAYS, 0, ~0u}, ~0u};  // The GL defaults.
+        }
+        return {{ToGLStencilCompareOp(SOS.failOp), ToGLStencilCompareOp(SOS.depthFailOp), ToGLStencilCompareOp(SOS.passOp)},
+                {ToGLCompareOp(SOS.compareOp), SOS.reference, SOS.compareMask},
+                SOS.writeMask};
+    };
+    PS.front = ToStencilFaceState(DSS.front);
+    PS.back = ToStencilFaceState(DSS.back);
+
+    // ColorBlendState
+    const ColorBlendState &CBS = pipelineCI.colorBlendState;
+    PS.logicOpEnable = CBS.logicOpEnable;
+    PS.logicOp = CBS.logicOpEnable ? ToGLLogicOp(CBS.logicOp) : GL_COPY;
+    if (CBS.attachments.size() > maxColorAttachments) {
+        std::cout << "ERROR: OPENGL: Too many ColorBlendAttachmentStates: " << CBS.attachments.size() << std::endl;
     }
+    PS.attachmentCount = std::min(CBS.attachments.size(), maxColorAttachments);
+    for (size_t i = 0; i < PS.attachmentCount; i++) {
+        const ColorBlendAttachmentState &CBA = CBS.attachments[i];
+        BlendAttachmentState &BAS = PS.attachments[i];
+        BAS.blendEnable = CBA.blendEnable;
+        if (CBA.blendEnable) {
+            BAS.equation = {ToGLBlendOp(CBA.colorBlendOp), ToGLBlendOp(CBA.alphaBlendOp)};
+            BAS.func = {ToGLBlendFactor(CBA.srcColorBlendFactor),
+                        ToGLBlendFactor(CBA.dstColorBlendFactor),
+                        ToGLBlendFactor(CBA.srcAlphaBlendFactor),
+                        ToGLBlendFactor(CBA.dstAlphaBlendFactor)};
+        } else {
+            BAS.equation = {GL_FUNC_ADD, GL_FUNC_ADD};
+            BAS.func = {GL_ONE, GL_ZERO, GL_ONE, GL_ZERO};
+        }
+        BAS.colorMask = {(GLboolean)BitwiseCheck((uint32_t)CBA.colorWriteMask, (uint32_t)ColorComponentBit::R_BIT),
+                         (GLboolean)BitwiseCheck((uint32_t)CBA.colorWriteMask, (uint32_t)ColorComponentBit::G_BIT),
+                         (GLboolean)BitwiseCheck((uint32_t)CBA.colorWriteMask, (uint32_t)ColorComponentBit::B_BIT),
+                         (GLboolean)BitwiseCheck((uint32_t)CBA.colorWriteMask, (uint32_t)ColorComponentBit::A_BIT)};
+    }
+    PS.blendConstants = {CBS.blendConstants[0], CBS.blendConstants[1], CBS.blendConstants[2], CBS.blendConstants[3]};
+}
 
-    if (RS.rasteriserDiscardEnable) {
-        glEnable(GL_RASTERIZER_DISCARD);
-    } else {
-        glDisable(GL_RASTERIZER_DISCARD);
+GraphicsAPI_OpenGL::PipelineState GraphicsAPI_OpenGL::GetDefaultPipelineState() {
+    PipelineState PS{};
+    PS.primitiveRestartEnable = false;
+    PS.depthClampEnable = false;
+    PS.rasteriserDiscardEnable = false;
+    PS.polygonMode = GL_FILL;
+    PS.cullFaceEnable = false;
+    PS.cullFace = GL_BACK;
+    PS.frontFace = GL_CCW;
+    PS.polygonOffsetIndex = 0;
+    PS.polygonOffsetEnable = false;
+    PS.polygonOffset = {0.0f, 0.0f};
+    PS.lineWidth = 1.0f;
+    PS.multisampleEnable = true;
+    PS.sampleShadingEnable = false;
+    PS.minSampleShading = 0.0f;
+    PS.sampleMaskEnable = false;
+    PS.sampleMask = ~0u;
+    PS.alphaToCoverageEnable = false;
+    PS.alphaToOneEnable = false;
+    PS.depthTestEnable = false;
+    PS.depthMask = GL_TRUE;
+    PS.depthFunc = GL_LESS;
+    PS.depthBoundsTestEnable = false;
+    PS.depthBounds = {0.0, 1.0};
+    PS.stencilTestEnable = false;
+    PS.front = {{GL_KEEP, GL_KEEP, GL_KEEP}, {GL_ALWAYS, 0, ~0u}, ~0u};
+    PS.back = PS.front;
+    PS.logicOpEnable = false;
+    PS.logicOp = GL_COPY;
+    PS.attachmentCount = maxColorAttachments;
+    for (BlendAttachmentState &BAS : PS.attachments) {
+        BAS = {false, {GL_FUNC_ADD, GL_FUNC_ADD}, {GL_ONE, GL_ZERO, GL_ONE, GL_ZERO}, {GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE}};
     }
+    PS.blendConstants = {0.0f, 0.0f, 0.0f, 0.0f};
+    return PS;
+}
 
-    if (RS.cullMode == CullMode::FRONT_AND_BACK) {
-        glPolygonMode(GL_FRONT_AND_BACK, ToGLPolygonMode(RS.polygonMode));
+void GraphicsAPI_OpenGL::ToPipelineKey(const PipelineCreateInfo &pipelineCI, PipelineKey &key) {
+    // Shaders, by content. GL links the same program whatever order they are attached in.
+    for (void *shader : pipelineCI.shaders) {
+        const Shader *glShader = shaders.Get(HandlePool<Shader>::FromPointer(shader));
+        if (!glShader) {
+            DEBUG_BREAK;
+            std::cout << "ERROR: OPENGL: CreatePipeline() called with an invalid or destroyed Shader." << std::endl;
+            continue;
+        }
+        if (key.shaderCount == maxPipelineShaders) {
+            std::cout << "ERROR: OPENGL: Too many Shaders: " << pipelineCI.shaders.size() << std::endl;
+            break;
+        }
+        key.shaderHashes[key.shaderCount++] = glShader->sourceHash;
     }
+    std::sort(key.shaderHashes.begin(), key.shaderHashes.begin() + key.shaderCount);
 
-    if (RS.cullMode > CullMode::NONE) {
-        glEnable(GL_CULL_FACE);
-        glCullFace(ToGLCullMode(RS.cullMode));
-    } else {
-        glDisable(GL_CULL_FACE);
+    // Vertex input layout, sorted by index.
+    const VertexInputState &VIS = pipelineCI.vertexInputState;
+    if (VIS.attributes.size() > maxVertexAttributes || VIS.bindings.size() > maxVertexBindings) {
+        std::cout << "ERROR: OPENGL: Too many VertexInputAttributes or VertexInputBindings: " << VIS.attributes.size() << ", " << VIS.bindings.size() << std::endl;
+    }
+    key.vertexAttributeCount = std::min(VIS.attributes.size(), maxVertexAttributes);
+    for (size_t i = 0; i < key.vertexAttributeCount; i++) {
+        const VertexInputAttribute &vertexAttribute = VIS.attributes[i];
+        VertexAttributeKey &VAK = key.vertexAttributes[i];
+        VAK.attribIndex = vertexAttribute.attribIndex;
+        VAK.bindingIndex = vertexAttribute.bindingIndex;
+        VAK.vertexType = vertexAttribute.vertexType;
+        VAK.offset = vertexAttribute.offset;
+    }
+    std::sort(key.vertexAttributes.begin(), key.vertexAttributes.begin() + key.vertexAttributeCount, [](const VertexAttributeKey &a, const VertexAttributeKey &b) { return a.attribIndex < b.attribIndex; });
+    key.vertexBindingCount = std::min(VIS.bindings.size(), maxVertexBindings);
+    for (size_t i = 0; i < key.vertexBindingCount; i++) {
+        const VertexInputBinding &vertexBinding = VIS.bindings[i];
+        VertexBindingKey &VBK = key.vertexBindings[i];
+        VBK.bindingIndex = vertexBinding.bindingIndex;
+        VBK.offset = vertexBinding.offset;
+        VBK.stride = vertexBinding.stride;
     }
+    std::sort(key.vertexBindings.begin(), key.vertexBindings.begin() + key.vertexBindingCount, [](const VertexBindingKey &a, const VertexBindingKey &b) { return a.bindingIndex < b.bindingIndex; });
 
-    glFrontFace(RS.frontFace == FrontFace::COUNTER_CLOCKWISE ? GL_CCW : GL_CW);
+    key.topology = ToGLTopology(pipelineCI.inputAssemblyState.topology);
+    ToPipelineState(pipelineCI, key.pipelineState);
+}
 
-    GLenum polygonOffsetMode = 0;
-    switch (RS.polygonMode) {
-    default:
-    case PolygonMode::FILL: {
-        polygonOffsetMode = GL_POLYGON_OFFSET_FILL;
-        break;
+template <typename T>
+bool GraphicsAPI_OpenGL::UpdateStateCache(T &cached, const T &value) {
+    if (cached == value) {
+        frameStatistics.stateCallsSkipped++;
+        return false;
     }
-    case PolygonMode::LINE: {
-        polygonOffsetMode = GL_POLYGON_OFFSET_LINE;
-        break;
+    cached = value;
+    frameStatistics.stateCallsIssued++;
+    return true;
+}
+
+void GraphicsAPI_OpenGL::SetCapability(GLenum capability, bool &cached, bool enable) {
+    if (UpdateStateCache(cached, enable)) {
+        if (enable) {
+            gl.Enable(capability);
+        } else {
+            gl.Disable(capability);
+        }
     }
-    case PolygonMode::POINT: {
-        polygonOffsetMode = GL_POLYGON_OFFSET_POINT;
-        break;
+}
+
+void GraphicsAPI_OpenGL::SetPipeline(void *pipeline) {
+    HandlePool<Pipeline>::Handle handle = HandlePool<Pipeline>::FromPointer(pipeline);
+    Pipeline *glPipeline = pipelines.Get(handle);
+    if (!glPipeline) {
+        DEBUG_BREAK;
+        std::cout << "ERROR: OPENGL: SetPipeline() called with an invalid or destroyed Pipeline." << std::endl;
+        return;
     }
+    if (!glPipeline->ready) {
+        // Wait for the link to complete. Check IsPipelineReady() first to avoid this.
+        FinishPipeline(*glPipeline);
     }
-    if (RS.depthBiasEnable) {
-        glEnable(polygonOffsetMode);
-        // glPolygonOffsetClamp
-        glPolygonOffset(RS.depthBiasSlopeFactor, RS.depthBiasConstantFactor);
-    } else {
-        glDisable(polygonOffsetMode);
+    if (glPipeline->failed) {
+        DEBUG_BREAK;
+        std::cout << "ERROR: OPENGL: SetPipeline() called with a Pipeline that failed to link." << std::endl;
+        return;
+    }
+    if (UpdateStateCache(stateCache.program, glPipeline->program)) {
+        gl.UseProgram(glPipeline->program);
     }
+    if (UpdateStateCache(stateCache.vertexArray, glPipeline->vertexArray)) {
+        gl.BindVertexArray(glPipeline->vertexArray);
+    }
+    // Carry an index buffer set before the pipeline over to its VAO.
+    if (setIndexBuffer && glPipeline->indexBuffer != setIndexBuffer) {
+        gl.BindBuffer(GL_ELEMENT_ARRAY_BUFFER, setIndexBuffer);
+        glPipeline->indexBuffer = setIndexBuffer;
+        frameStatistics.bindsIssued++;
+        frameStatistics.bindCalls++;
+    }
+    setPipeline = handle;
+    setTopology = glPipeline->key.topology;
 
-    glLineWidth(RS.lineWidth);
+    const PipelineState &PS = glPipeline->key.pipelineState;
+    PipelineState &cache = stateCache.pipeline;
 
-    // MultisampleState
-    const MultisampleState &MS = pipelineCI.multisampleState;
+    // InputAssemblyState
+    SetCapability(GL_PRIMITIVE_RESTART, cache.primitiveRestartEnable, PS.primitiveRestartEnable);
 
-    if (MS.rasterisationSamples > 1) {
-        glEnable(GL_MULTISAMPLE);
-    } else {
-        glDisable(GL_MULTISAMPLE);
+    // RasterisationState
+    SetCapability(GL_DEPTH_CLAMP, cache.depthClampEnable, PS.depthClampEnable);
+    SetCapability(GL_RASTERIZER_DISCARD, cache.rasteriserDiscardEnable, PS.rasteriserDiscardEnable);
+
+    if (PS.polygonMode != 0 && UpdateStateCache(cache.polygonMode, PS.polygonMode)) {
+        gl.PolygonMode(GL_FRONT_AND_BACK, PS.polygonMode);
     }
 
-    if (MS.sampleShadingEnable) {
-        glEnable(GL_SAMPLE_SHADING);
-        PFNGLMINSAMPLESHADINGPROC glMinSampleShading = (PFNGLMINSAMPLESHADINGPROC)GetExtension("glMinSampleShading");  // 4.0+
-        glMinSampleShading(MS.minSampleShading);
-    } else {
-        glDisable(GL_SAMPLE_SHADING);
+    SetCapability(GL_CULL_FACE, cache.cullFaceEnable, PS.cullFaceEnable);
+    if (PS.cullFaceEnable && UpdateStateCache(cache.cullFace, PS.cullFace)) {
+        gl.CullFace(PS.cullFace);
     }
 
-    if (MS.sampleMask > 0) {
-        glEnable(GL_SAMPLE_MASK);
-        PFNGLSAMPLEMASKIPROC glSampleMaski = (PFNGLSAMPLEMASKIPROC)GetExtension("glSampleMaski");  // 3.2+
-        glSampleMaski(0, MS.sampleMask);
-    } else {
-        glDisable(GL_SAMPLE_MASK);
+    if (UpdateStateCache(cache.frontFace, PS.frontFace)) {
+        gl.FrontFace(PS.frontFace);
     }
 
-    if (MS.alphaToCoverageEnable) {
-        glEnable(GL_SAMPLE_ALPHA_TO_COVERAGE);
-    } else {
-        glDisable(GL_SAMPLE_ALPHA_TO_COVERAGE);
+    static constexpr GLenum polygonOffsetModes[3] = {GL_POLYGON_OFFSET_FILL, GL_POLYGON_OFFSET_LINE, GL_POLYGON_OFFSET_POINT};
+    SetCapability(polygonOffsetModes[PS.polygonOffsetIndex], stateCache.polygonOffsetEnable[PS.polygonOffsetIndex], PS.polygonOffsetEnable);
+    if (PS.polygonOffsetEnable && UpdateStateCache(cache.polygonOffset, PS.polygonOffset)) {
+        // glPolygonOffsetClamp
+        gl.PolygonOffset(PS.polygonOffset[0], PS.polygonOffset[1]);
     }
 
-    if (MS.alphaToOneEnable) {
-        glEnable(GL_SAMPLE_ALPHA_TO_ONE);
-    } else {
-        glDisable(GL_SAMPLE_ALPHA_TO_ONE);
+    if (UpdateStateCache(cache.lineWidth, PS.lineWidth)) {
+        gl.LineWidth(PS.lineWidth);
     }
 
-    // DepthStencilState
-    const DepthStencilState &DSS = pipelineCI.depthStencilState;
+    // MultisampleState
+    SetCapability(GL_MULTISAMPLE, cache.multisampleEnable, PS.multisampleEnable);
 
-    if (DSS.depthTestEnable) {
-        glEnable(GL_DEPTH_TEST);
-    } else {
-        glDisable(GL_DEPTH_TEST);
+    SetCapability(GL_SAMPLE_SHADING, cache.sampleShadingEnable, PS.sampleShadingEnable);
+    if (PS.sampleShadingEnable && UpdateStateCache(cache.minSampleShading, PS.minSampleShading)) {
+        gl.MinSampleShading(PS.minSampleShading);
     }
 
-    glDepthMask(DSS.depthWriteEnable ? GL_TRUE : GL_FALSE);
+    SetCapability(GL_SAMPLE_MASK, cache.sampleMaskEnable, PS.sampleMaskEnable);
+    if (PS.sampleMaskEnable && UpdateStateCache(cache.sampleMask, PS.sampleMask)) {
+        gl.SampleMaski(0, PS.sampleMask);
+    }
 
-    glDepthFunc(ToGLCompareOp(DSS.depthCompareOp));
+    SetCapability(GL_SAMPLE_ALPHA_TO_COVERAGE, cache.alphaToCoverageEnable, PS.alphaToCoverageEnable);
+    SetCapability(GL_SAMPLE_ALPHA_TO_ONE, cache.alphaToOneEnable, PS.alphaToOneEnable);
 
-    PFNGLDEPTHBOUNDSEXTPROC glDepthBoundsEXT = (PFNGLDEPTHBOUNDSEXTPROC)GetExtension("glDepthBoundsEXT");  // EXT
-    if (glDepthBoundsEXT) {
-        if (DSS.depthBoundsTestEnable) {
-            glEnable(GL_DEPTH_BOUNDS_TEST_EXT);
-            glDepthBoundsEXT(DSS.minDepthBounds, DSS.maxDepthBounds);
-        } else {
-            glDisable(GL_DEPTH_BOUNDS_TEST_EXT);
-        }
+    // DepthStencilState
+    SetCapability(GL_DEPTH_TEST, cache.depthTestEnable, PS.depthTestEnable);
+
+    if (UpdateStateCache(cache.depthMask, PS.depthMask)) {
+        gl.DepthMask(PS.depthMask);
     }
 
-    if (DSS.stencilTestEnable) {
-        glEnable(GL_STENCIL_TEST);
-    } else {
-        glDisable(GL_STENCIL_TEST);
-    }
-
-    PFNGLSTENCILOPSEPARATEPROC glStencilOpSeparate = (PFNGLSTENCILOPSEPARATEPROC)GetExtension("glStencilOpSeparate");          // 2.0+
-    PFNGLSTENCILFUNCSEPARATEPROC glStencilFuncSeparate = (PFNGLSTENCILFUNCSEPARATEPROC)GetExtension("glStencilFuncSeparate");  // 2.0+
-    PFNGLSTENCILMASKSEPARATEPROC glStencilMaskSeparate = (PFNGLSTENCILMASKSEPARATEPROC)GetExtension("glStencilMaskSeparate");  // 2.0+
-
-    glStencilOpSeparate(GL_FRONT,
-                        ToGLStencilCompareOp(DSS.front.failOp),
-                        ToGLStencilCompareOp(DSS.front.depthFailOp),
-                        ToGLStencilCompareOp(DSS.front.passOp));
-    glStencilFuncSeparate(GL_FRONT,
-                          ToGLCompareOp(DSS.front.compareOp),
-                          DSS.front.reference,
-                          DSS.front.compareMask);
-    glStencilMaskSeparate(GL_FRONT, DSS.front.writeMask);
-
-    glStencilOpSeparate(GL_BACK,
-                        ToGLStencilCompareOp(DSS.back.failOp),
-                        ToGLStencilCompareOp(DSS.back.depthFailOp),
-                        ToGLStencilCompareOp(DSS.back.passOp));
-    glStencilFuncSeparate(GL_BACK,
-                          ToGLCompareOp(DSS.back.compareOp),
-                          DSS.back.reference,
-                          DSS.back.compareMask);
-    glStencilMaskSeparate(GL_BACK, DSS.back.writeMask);
+    if (UpdateStateCache(cache.depthFunc, PS.depthFunc)) {
+        gl.DepthFunc(PS.depthFunc);
+    }
 
-    // ColorBlendState
-    const ColorBlendState &CBS = pipelineCI.colorBlendState;
+    if (HasFeature(Feature::DEPTH_BOUNDS)) {
+        SetCapability(GL_DEPTH_BOUNDS_TEST_EXT, cache.depthBoundsTestEnable, PS.depthBoundsTestEnable);
+        if (PS.depthBoundsTestEnable && UpdateStateCache(cache.depthBounds, PS.depthBounds)) {
+            gl.DepthBoundsEXT(PS.depthBounds[0], PS.depthBounds[1]);
+        }
+    }
 
-    if (CBS.logicOpEnable) {
-        glEnable(GL_COLOR_LOGIC_OP);
-        glLogicOp(ToGLLogicOp(CBS.logicOp));
-    } else {
-        glDisable(GL_COLOR_LOGIC_OP);
+    SetCapability(GL_STENCIL_TEST, cache.stencilTestEnable, PS.stencilTestEnable);
+
+    const std::pair<GLenum, const StencilFaceState *> stencilFaces[2] = {{GL_FRONT, &PS.front}, {GL_BACK, &PS.back}};
+    for (const std::pair<GLenum, const StencilFaceState *> &stencilFace : stencilFaces) {
+        const StencilFaceState &SFS = *stencilFace.second;
+        StencilFaceState &cachedSFS = stencilFace.first == GL_FRONT ? cache.front : cache.back;
+        if (UpdateStateCache(cachedSFS.op, SFS.op)) {
+            gl.StencilOpSeparate(stencilFace.first, SFS.op[0], SFS.op[1], SFS.op[2]);
+        }
+        if (UpdateStateCache(cachedSFS.func, SFS.func)) {
+            gl.StencilFuncSeparate(stencilFace.first, SFS.func[0], (GLint)SFS.func[1], SFS.func[2]);
+        }
+        if (UpdateStateCache(cachedSFS.writeMask, SFS.writeMask)) {
+            gl.StencilMaskSeparate(stencilFace.first, SFS.writeMask);
+        }
     }
 
-    for (int i = 0; i < (int)CBS.attachments.size(); i++) {
-        const ColorBlendAttachmentState &CBA = CBS.attachments[i];
+    // ColorBlendState
+    SetCapability(GL_COLOR_LOGIC_OP, cache.logicOpEnable, PS.logicOpEnable);
+    if (PS.logicOpEnable && UpdateStateCache(cache.logicOp, PS.logicOp)) {
+        gl.LogicOp(PS.logicOp);
+    }
 
-        PFNGLENABLEIPROC glEnablei = (PFNGLENABLEIPROC)GetExtension("glEnablei");                                                              // 3.0+
-        PFNGLDISABLEIPROC glDisablei = (PFNGLDISABLEIPROC)GetExtension("glDisablei");                                                          // 3.0+
-        PFNGLBLENDEQUATIONSEPARATEIPROC glBlendEquationSeparatei = (PFNGLBLENDEQUATIONSEPARATEIPROC)GetExtension("glBlendEquationSeparatei");  // 4.0+
-        PFNGLBLENDFUNCSEPARATEIPROC glBlendFuncSeparatei = (PFNGLBLENDFUNCSEPARATEIPROC)GetExtension("glBlendFuncSeparatei");                  // 4.0+
-        PFNGLCOLORMASKIPROC glColorMaski = (PFNGLCOLORMASKIPROC)GetExtension("glColorMaski");                                                  // 3.0+
+    for (GLuint i = 0; i < (GLuint)PS.attachmentCount; i++) {
+        const BlendAttachmentState &BAS = PS.attachments[i];
+        BlendAttachmentState &cachedBAS = cache.attachments[i];
 
-        if (CBA.blendEnable) {
-            glEnablei(GL_BLEND, i);
-        } else {
-            glDisablei(GL_BLEND, i);
+        if (UpdateStateCache(cachedBAS.blendEnable, BAS.blendEnable)) {
+            if (BAS.blendEnable) {
+                gl.Enablei(GL_BLEND, i);
+            } else {
+                gl.Disablei(GL_BLEND, i);
+            }
+        }
+        if (UpdateStateCache(cachedBAS.equation, BAS.equation)) {
+            gl.BlendEquationSeparatei(i, BAS.equation[0], BAS.equation[1]);
+        }
+        if (UpdateStateCache(cachedBAS.func, BAS.func)) {
+            gl.BlendFuncSeparatei(i, BAS.func[0], BAS.func[1], BAS.func[2], BAS.func[3]);
+        }
+        if (UpdateStateCache(cachedBAS.colorMask, BAS.colorMask)) {
+            gl.ColorMaski(i, BAS.colorMask[0], BAS.colorMask[1], BAS.colorMask[2], BAS.colorMask[3]);
         }
+    }
+    if (UpdateStateCache(cache.blendConstants, PS.blendConstants)) {
+        gl.BlendColor(PS.blendConstants[0], PS.blendConstants[1], PS.blendConstants[2], PS.blendConstants[3]);
+    }
+}
 
-        glBlendEquationSeparatei(i, ToGLBlendOp(CBA.colorBlendOp), ToGLBlendOp(CBA.alphaBlendOp));
+template <typename T, size_t N, typename BindFunction>
+void GraphicsAPI_OpenGL::UpdateBindings(const std::array<T, N> &set, std::array<T, N> &bound, uint32_t slots, BindFunction bind) {
+    uint32_t first = 0;
+    uint32_t count = 0;
+    // One step past the last slot, to send a run that reaches it.
+    for (uint32_t slot = 0; slot <= N; slot++) {
+        const bool recorded = slot < N && (slots & (1u << slot));
+        if (recorded && !(set[slot] == bound[slot])) {
+            bound[slot] = set[slot];
+            frameStatistics.bindsIssued++;
+            if (count == 0) {
+                first = slot;
+            }
+            count++;
+            continue;
+        }
+        if (recorded) {
+            frameStatistics.bindsElided++;
+        }
+        if (count > 0) {
+            bind(first, count);
+            count = 0;
+        }
+    }
+}
 
-        glBlendFuncSeparatei(i,
-                             ToGLBlendFactor(CBA.srcColorBlendFactor),
-                             ToGLBlendFactor(CBA.dstColorBlendFactor),
-                             ToGLBlendFactor(CBA.srcAlphaBlendFactor),
-                             ToGLBlendFactor(CBA.dstAlphaBlendFactor));
+void GraphicsAPI_OpenGL::BindBufferRanges(GLenum target, const std::array<BufferBinding, maxDescriptorBindings> &bindings, uint32_t first, uint32_t count) {
+    if (HasFeature(Feature::MULTI_BIND)) {
+        std::array<GLuint, maxDescriptorBindings> glBuffers;
+        std::array<GLintptr, maxDescriptorBindings> offsets;
+        std::array<GLsizeiptr, maxDescriptorBindings> sizes;
+        for (uint32_t i = 0; i < count; i++) {
+            const BufferBinding &binding = bindings[first + i];
+            glBuffers[i] = binding.buffer;
+            offsets[i] = binding.offset;
+            sizes[i] = binding.size;
+        }
+        gl.BindBuffersRange(target, first, (GLsizei)count, glBuffers.data(), offsets.data(), sizes.data());
+        frameStatistics.bindCalls++;
+        return;
+    }
+    for (uint32_t slot = first; slot < first + count; slot++) {
+        const BufferBinding &binding = bindings[slot];
+        gl.BindBufferRange(target, slot, binding.buffer, binding.offset, binding.size);
+        frameStatistics.bindCalls++;
+    }
+}
 
-        glColorMaski(i,
-                     (((uint32_t)CBA.colorWriteMask & (uint32_t)ColorComponentBit::R_BIT) == (uint32_t)ColorComponentBit::R_BIT),
-                     (((uint32_t)CBA.colorWriteMask & (uint32_t)ColorComponentBit::G_BIT) == (uint32_t)ColorComponentBit::G_BIT),
-                     (((uint32_t)CBA.colorWriteMask & (uint32_t)ColorComponentBit::B_BIT) == (uint32_t)ColorComponentBit::B_BIT),
-                     (((uint32_t)CBA.colorWriteMask & (uint32_t)ColorComponentBit::A_BIT) == (uint32_t)ColorComponentBit::A_BIT));
+void GraphicsAPI_OpenGL::InvalidateBindings(GLuint buffer, GLuint texture, GLuint sampler) {
+    if (buffer) {
+        for (BufferBinding &binding : boundDescriptors.uniformBuffers) {
+            if (binding.buffer == buffer) {
+                binding = {};
+            }
+        }
+        for (BufferBinding &binding : boundDescriptors.storageBuffers) {
+            if (binding.buffer == buffer) {
+                binding = {};
+            }
+        }
+        // Deleting a buffer only detaches it from the bound VAO; the other VAOs keep the deleted buffer.
+        pipelines.ForEach([buffer](Pipeline &glPipeline) {
+            for (GLuint &vertexBuffer : glPipeline.vertexBuffers) {
+                if (vertexBuffer == buffer) {
+                    vertexBuffer = 0;
+                }
+            }
+            if (glPipeline.indexBuffer == buffer) {
+                glPipeline.indexBuffer = 0;
+            }
+        });
+    }
+    if (texture) {
+        for (TextureBinding &binding : boundDescriptors.textures) {
+            if (binding.texture == texture) {
+                binding = {};
+            }
+        }
+    }
+    if (sampler) {
+        for (GLuint &binding : boundDescriptors.samplers) {
+            if (binding == sampler) {
+                binding = 0;
+            }
+        }
     }
-    glBlendColor(CBS.blendConstants[0], CBS.blendConstants[1], CBS.blendConstants[2], CBS.blendConstants[3]);
 }
 
 void GraphicsAPI_OpenGL::SetDescriptor(const DescriptorInfo &descriptorInfo) {
-    GLuint glResource = (GLuint)(uint64_t)descriptorInfo.resource;
     const GLuint &bindingIndex = descriptorInfo.bindingIndex;
+    const bool tracked = bindingIndex < maxDescriptorBindings;
     if (descriptorInfo.type == DescriptorInfo::Type::BUFFER) {
-        PFNGLBINDBUFFERRANGEPROC glBindBufferRange = (PFNGLBINDBUFFERRANGEPROC)GetExtension("glBindBufferRange");  // 3.0+
-        glBindBufferRange(GL_UNIFORM_BUFFER, bindingIndex, glResource, (GLintptr)descriptorInfo.bufferOffset, (GLsizeiptr)descriptorInfo.bufferSize);
+        const Buffer *glBuffer = buffers.Get(HandlePool<Buffer>::FromPointer(descriptorInfo.resource));
+        if (!glBuffer) {
+            DEBUG_BREAK;
+            std::cout << "ERROR: OPENGL: SetDescriptor() called with an invalid or destroyed Buffer." << std::endl;
+            return;
+        }
+        // STORAGE buffers bind as shader storage blocks; every other buffer binds as a uniform block.
+        GLenum target = glBuffer->bufferCI.type == BufferCreateInfo::Type::STORAGE ? GL_SHADER_STORAGE_BUFFER : GL_UNIFORM_BUFFER;
+        const BufferBinding binding{glBuffer->buffer, (GLintptr)descriptorInfo.bufferOffset, (GLsizeiptr)descriptorInfo.bufferSize};
+        if (!tracked) {
+            gl.BindBufferRange(target, bindingIndex, binding.buffer, binding.offset, binding.size);
+            frameStatistics.bindsIssued++;
+            frameStatistics.bindCalls++;
+        } else if (target == GL_SHADER_STORAGE_BUFFER) {
+            setDescriptors.storageBuffers[bindingIndex] = binding;
+            setDescriptorSlots.storageBuffers |= 1u << bindingIndex;
+        } else {
+            setDescriptors.uniformBuffers[bindingIndex] = binding;
+            setDescriptorSlots.uniformBuffers |= 1u << bindingIndex;
+        }
     } else if (descriptorInfo.type == DescriptorInfo::Type::IMAGE) {
-        glActiveTexture(GL_TEXTURE0 + bindingIndex);
-        glBindTexture(GetGLTextureTarget(images[glResource]), glResource);
+        const Image *glImage = images.Get(HandlePool<Image>::FromPointer(descriptorInfo.resource));
+        if (!glImage) {
+            DEBUG_BREAK;
+            std::cout << "ERROR: OPENGL: SetDescriptor() called with an invalid or destroyed Image." << std::endl;
+            return;
+        }
+        if (!tracked) {
+            gl.ActiveTexture(GL_TEXTURE0 + bindingIndex);
+            activeTextureUnit = bindingIndex;
+            gl.BindTexture(glImage->target, glImage->texture);
+            frameStatistics.bindsIssued++;
+            frameStatistics.bindCalls++;
+        } else {
+            setDescriptors.textures[bindingIndex] = {glImage->texture, glImage->target};
+            setDescriptorSlots.textures |= 1u << bindingIndex;
+        }
     } else if (descriptorInfo.type == DescriptorInfo::Type::SAMPLER) {
-        PFNGLBINDSAMPLERPROC glBindSampler = (PFNGLBINDSAMPLERPROC)GetExtension("glBindSampler");  // 3.0+
-        glBindSampler(bindingIndex, glResource);
+        GLuint sampler = (GLuint)(uint64_t)descriptorInfo.resource;
+        if (!tracked) {
+            gl.BindSampler(bindingIndex, sampler);
+            frameStatistics.bindsIssued++;
+            frameStatistics.bindCalls++;
+        } else {
+            setDescriptors.samplers[bindingIndex] = sampler;
+            setDescriptorSlots.samplers |= 1u << bindingIndex;
+        }
     } else {
         std::cout << "ERROR: OPENGL: Unknown Descriptor Type." << std::endl;
     }
 }
 
 void GraphicsAPI_OpenGL::UpdateDescriptors() {
+    UpdateBindings(setDescriptors.uniformBuffers, boundDescriptors.uniformBuffers, setDescriptorSlots.uniformBuffers, [this](uint32_t first, uint32_t count) {
+        BindBufferRanges(GL_UNIFORM_BUFFER, boundDescriptors.uniformBuffers, first, count);
+    });
+    UpdateBindings(setDescriptors.storageBuffers, boundDescriptors.storageBuffers, setDescriptorSlots.storageBuffers, [this](uint32_t first, uint32_t count) {
+        BindBufferRanges(GL_SHADER_STORAGE_BUFFER, boundDescriptors.storageBuffers, first, count);
+    });
+    UpdateBindings(setDescriptors.textures, boundDescriptors.textures, setDescriptorSlots.textures, [this](uint32_t first, uint32_t count) {
+        // glBindTextures() takes each texture's target from the texture and leaves the active texture unit alone.
+        if (HasFeature(Feature::MULTI_BIND)) {
+            std::array<GLuint, maxDescriptorBindings> textures;
+            for (uint32_t i = 0; i < count; i++) {
+                textures[i] = boundDescriptors.textures[first + i].texture;
+            }
+            gl.BindTextures(first, (GLsizei)count, textures.data());
+            frameStatistics.bindCalls++;
+            return;
+        }
+        for (uint32_t unit = first; unit < first + count; unit++) {
+            if (activeTextureUnit != unit) {
+                gl.ActiveTexture(GL_TEXTURE0 + unit);
+                activeTextureUnit = unit;
+            }
+            gl.BindTexture(boundDescriptors.textures[unit].target, boundDescriptors.textures[unit].texture);
+            frameStatistics.bindCalls++;
+        }
+    });
+    UpdateBindings(setDescriptors.samplers, boundDescriptors.samplers, setDescriptorSlots.samplers, [this](uint32_t first, uint32_t count) {
+        if (HasFeature(Feature::MULTI_BIND)) {
+            gl.BindSamplers(first, (GLsizei)count, &boundDescriptors.samplers[first]);
+            frameStatistics.bindCalls++;
+            return;
+        }
+        for (uint32_t unit = first; unit < first + count; unit++) {
+            gl.BindSampler(unit, boundDescriptors.samplers[unit]);
+            frameStatistics.bindCalls++;
+        }
+    });
+    setDescriptorSlots = {};
 }
 
 void GraphicsAPI_OpenGL::SetVertexBuffers(void **vertexBuffers, size_t count) {
-    const VertexInputState &vertexInputState = pipelines[setPipeline].vertexInputState;
+    Pipeline *glPipeline = pipelines.Get(setPipeline);
+    if (!glPipeline) {
+        DEBUG_BREAK;
+        std::cout << "ERROR: OPENGL: SetVertexBuffers() called without a valid Pipeline set." << std::endl;
+        return;
+    }
+    if (count > glPipeline->vertexBindingCount) {
+        DEBUG_BREAK;
+        std::cout << "ERROR: OPENGL: SetVertexBuffers() called with more buffers than the Pipeline has VertexInputBindings." << std::endl;
+        count = glPipeline->vertexBindingCount;
+    }
+
+    std::array<GLuint, maxVertexBindings> glVertexBufferIDs{};
     for (size_t i = 0; i < count; i++) {
-        GLuint glVertexBufferID = (GLuint)(uint64_t)vertexBuffers[i];
-        if (buffers[glVertexBufferID].type != BufferCreateInfo::Type::VERTEX) {
+        const Buffer *glVertexBuffer = buffers.Get(HandlePool<Buffer>::FromPointer(vertexBuffers[i]));
+        if (!glVertexBuffer) {
+            DEBUG_BREAK;
+            std::cout << "ERROR: OPENGL: SetVertexBuffers() called with an invalid or destroyed Buffer." << std::endl;
+            continue;
+        }
+        if (glVertexBuffer->bufferCI.type != BufferCreateInfo::Type::VERTEX) {
             std::cout << "ERROR: OpenGL: Provided buffer is not type: VERTEX." << std::endl;
         }
+        glVertexBufferIDs[i] = glVertexBuffer->buffer;
+    }
 
-        glBindBuffer(GL_ARRAY_BUFFER, (GLuint)(uint64_t)vertexBuffers[i]);
-
-        // https://i.redd.it/fyxp5ah06a661.png
-        for (const VertexInputBinding &vertexBinding : vertexInputState.bindings) {
-            if (vertexBinding.bindingIndex == (uint32_t)i) {
-                for (const VertexInputAttribute &vertexAttribute : vertexInputState.attributes) {
-                    if (vertexAttribute.bindingIndex == (uint32_t)i) {
-                        GLuint attribIndex = vertexAttribute.attribIndex;
-                        GLint size = ((GLint)vertexAttribute.vertexType % 4) + 1;
-                        GLenum type = (GLenum)vertexAttribute.vertexType >= (GLenum)VertexType::UINT ? GL_UNSIGNED_INT : (GLenum)vertexAttribute.vertexType >= (GLenum)VertexType::INT ? GL_INT
-                                                                                                                                                                                       : GL_FLOAT;
-                        GLsizei stride = vertexBinding.stride;
-                        const void *offset = (const void *)vertexAttribute.offset;
-                        glEnableVertexAttribArray(attribIndex);
-                        glVertexAttribPointer(attribIndex, size, type, false, stride, offset);
-                    }
-                }
-            }
+    // Vertex buffer bindings are VAO state, so they are compared against what the pipeline's VAO already holds.
+    const uint32_t slots = (uint32_t)((1ull << count) - 1);
+    UpdateBindings(glVertexBufferIDs, glPipeline->vertexBuffers, slots, [&](uint32_t first, uint32_t bindingCount) {
+        if (HasFeature(Feature::MULTI_BIND)) {
+            gl.BindVertexBuffers(first, (GLsizei)bindingCount, &glVertexBufferIDs[first], &glPipeline->vertexBindingOffsets[first], &glPipeline->vertexBindingStrides[first]);
+            frameStatistics.bindCalls++;
+            return;
         }
-    }
+        for (uint32_t i = first; i < first + bindingCount; i++) {
+            gl.BindVertexBuffer(i, glVertexBufferIDs[i], glPipeline->vertexBindingOffsets[i], glPipeline->vertexBindingStrides[i]);
+            frameStatistics.bindCalls++;
+        }
+    });
 }
 
 void GraphicsAPI_OpenGL::SetIndexBuffer(void *indexBuffer) {
-    GLuint glIndexBufferID = (GLuint)(uint64_t)indexBuffer;
-    if (buffers[glIndexBufferID].type != BufferCreateInfo::Type::INDEX) {
+    const Buffer *glIndexBuffer = buffers.Get(HandlePool<Buffer>::FromPointer(indexBuffer));
+    if (!glIndexBuffer) {
+        DEBUG_BREAK;
+        std::cout << "ERROR: OPENGL: SetIndexBuffer() called with an invalid or destroyed Buffer." << std::endl;
+        return;
+    }
+    if (glIndexBuffer->bufferCI.type != BufferCreateInfo::Type::INDEX) {
         std::cout << "ERROR: OpenGL: Provided buffer is not type: INDEX." << std::endl;
     }
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, glIndexBufferID);
-    setIndexBuffer = glIndexBufferID;
+    setIndexBuffer = glIndexBuffer->buffer;
+    setIndexType = glIndexBuffer->bufferCI.stride == 4 ? GL_UNSIGNED_INT : GL_UNSIGNED_SHORT;
+    Pipeline *glPipeline = pipelines.Get(setPipeline);
+    if (glPipeline && glPipeline->indexBuffer == setIndexBuffer) {
+        frameStatistics.bindsElided++;
+        return;
+    }
+    gl.BindBuffer(GL_ELEMENT_ARRAY_BUFFER, setIndexBuffer);
+    frameStatistics.bindsIssued++;
+    frameStatistics.bindCalls++;
+    if (glPipeline) {
+        glPipeline->indexBuffer = setIndexBuffer;
+    }
 }
 
 void GraphicsAPI_OpenGL::DrawIndexed(uint32_t indexCount, uint32_t instanceCount, uint32_t firstIndex, int32_t vertexOffset, uint32_t firstInstance) {
-    PFNGLDRAWELEMENTSINSTANCEDBASEVERTEXBASEINSTANCEPROC glDrawElementsInstancedBaseVertexBaseInstance = (PFNGLDRAWELEMENTSINSTANCEDBASEVERTEXBASEINSTANCEPROC)GetExtension("glDrawElementsInstancedBaseVertexBaseInstance");  // 4.2+
-    GLenum indexType = buffers[setIndexBuffer].stride == 4 ? GL_UNSIGNED_INT : GL_UNSIGNED_SHORT;
-    glDrawElementsInstancedBaseVertexBaseInstance(ToGLTopology(pipelines[setPipeline].inputAssemblyState.topology), indexCount, indexType, nullptr, instanceCount, vertexOffset, firstInstance);
+    frameStatistics.drawCalls++;
+    gl.DrawElementsInstancedBaseVertexBaseInstance(setTopology, indexCount, setIndexType, nullptr, instanceCount, vertexOffset, firstInstance);
 }
 
 void GraphicsAPI_OpenGL::Draw(uint32_t vertexCount, uint32_t instanceCount, uint32_t firstVertex, uint32_t firstInstance) {
-    PFNGLDRAWARRAYSINSTANCEDBASEINSTANCEPROC glDrawArraysInstancedBaseInstance = (PFNGLDRAWARRAYSINSTANCEDBASEINSTANCEPROC)GetExtension("glDrawArraysInstancedBaseInstance");  // 4.2+
-    glDrawArraysInstancedBaseInstance(ToGLTopology(pipelines[setPipeline].inputAssemblyState.topology), firstVertex, vertexCount, instanceCount, firstInstance);
+    frameStatistics.drawCalls++;
+    gl.DrawArraysInstancedBaseInstance(setTopology, firstVertex, vertexCount, instanceCount, firstInstance);
+}
+
+void GraphicsAPI_OpenGL::DrawIndexedIndirect(void *indirectBuffer, size_t offset) {
+    MultiDrawIndexedIndirect(indirectBuffer, offset, 1, sizeof(DrawIndexedIndirectCommand));
+}
+
+void GraphicsAPI_OpenGL::MultiDrawIndexedIndirect(void *indirectBuffer, size_t offset, uint32_t drawCount, uint32_t stride) {
+    const Buffer *glIndirectBuffer = buffers.Get(HandlePool<Buffer>::FromPointer(indirectBuffer));
+    if (!glIndirectBuffer) {
+        DEBUG_BREAK;
+        std::cout << "ERROR: OPENGL: MultiDrawIndexedIndirect() called with an invalid or destroyed Buffer." << std::endl;
+        return;
+    }
+    if (glIndirectBuffer->bufferCI.type != BufferCreateInfo::Type::INDIRECT) {
+        std::cout << "ERROR: OpenGL: Provided buffer is not type: INDIRECT." << std::endl;
+    }
+    frameStatistics.drawCalls += drawCount;
+
+    // GL_DRAW_INDIRECT_BUFFER is not VAO state, so it only needs binding when the buffer changes.
+    if (setIndirectBuffer != glIndirectBuffer->buffer) {
+        gl.BindBuffer(GL_DRAW_INDIRECT_BUFFER, glIndirectBuffer->buffer);
+        setIndirectBuffer = glIndirectBuffer->buffer;
+    }
+
+    if (drawCount == 1) {
+        gl.DrawElementsIndirect(setTopology, setIndexType, (const void *)offset);
+    } else {
+        gl.MultiDrawElementsIndirect(setTopology, setIndexType, (const void *)offset, (GLsizei)drawCount, (GLsizei)stride);
+    }
 }
 
 // XR_DOCS_TAG_BEGIN_GraphicsAPI_OpenGL_GetSupportedSwapchainFormats
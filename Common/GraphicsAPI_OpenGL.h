@@ -6,14 +6,189 @@
 
 #pragma once
 #include <GraphicsAPI.h>
+#include <HandlePool.h>
+
+// C/C++ Headers
+#include <chrono>
+
+#if defined(XR_TUTORIAL_USE_OPENGL_SURFACELESS)
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
 
 #if defined(XR_USE_GRAPHICS_API_OPENGL)
+// Every GL entry point used by GraphicsAPI_OpenGL: X(type, name, feature).
+// Entry points are resolved once when the context is created. A missing CORE entry point is an error; a missing optional
+// entry point clears its Feature bit instead.
+#define GRAPHICS_API_OPENGL_ENTRY_POINTS(X)                                                                      \
+    /* 1.0 - 1.1 */                                                                                              \
+    X(decltype(&glBindTexture), BindTexture, CORE)                                                               \
+    X(decltype(&glClear), Clear, CORE)                                                                           \
+    X(decltype(&glClearColor), ClearColor, CORE)                                                                 \
+    X(decltype(&glClearDepth), ClearDepth, CORE)                                                                 \
+    X(decltype(&glCullFace), CullFace, CORE)                                                                     \
+    X(decltype(&glDeleteTextures), DeleteTextures, CORE)                                                         \
+    X(decltype(&glDepthFunc), DepthFunc, CORE)                                                                   \
+    X(decltype(&glDepthMask), DepthMask, CORE)                                                                   \
+    X(decltype(&glDisable), Disable, CORE)                                                                       \
+    X(decltype(&glEnable), Enable, CORE)                                                                         \
+    X(decltype(&glFrontFace), FrontFace, CORE)                                                                   \
+    X(decltype(&glGenTextures), GenTextures, CORE)                                                               \
+    X(decltype(&glGetIntegerv), GetIntegerv, CORE)                                                               \
+    X(decltype(&glGetString), GetString, CORE)                                                                   \
+    X(decltype(&glLineWidth), LineWidth, CORE)                                                                   \
+    X(decltype(&glLogicOp), LogicOp, CORE)                                                                       \
+    X(decltype(&glPolygonMode), PolygonMode, CORE)                                                               \
+    X(decltype(&glPolygonOffset), PolygonOffset, CORE)                                                           \
+    /* 1.2 - 2.0 */                                                                                              \
+    X(PFNGLACTIVETEXTUREPROC, ActiveTexture, CORE)                                                               \
+    X(PFNGLATTACHSHADERPROC, AttachShader, CORE)                                                                 \
+    X(PFNGLBINDBUFFERPROC, BindBuffer, CORE)                                                                     \
+    X(PFNGLBLENDCOLORPROC, BlendColor, CORE)                                                                     \
+    X(PFNGLBUFFERDATAPROC, BufferData, CORE)                                                                     \
+    X(PFNGLBUFFERSUBDATAPROC, BufferSubData, CORE)                                                               \
+    X(PFNGLCOMPILESHADERPROC, CompileShader, CORE)                                                               \
+    X(PFNGLCREATEPROGRAMPROC, CreateProgram, CORE)                                                               \
+    X(PFNGLCREATESHADERPROC, CreateShader, CORE)                                                                 \
+    X(PFNGLDELETEBUFFERSPROC, DeleteBuffers, CORE)                                                               \
+    X(PFNGLDELETEPROGRAMPROC, DeleteProgram, CORE)                                                               \
+    X(PFNGLDELETEQUERIESPROC, DeleteQueries, CORE)                                                               \
+    X(PFNGLDELETESHADERPROC, DeleteShader, CORE)                                                                 \
+    X(PFNGLDETACHSHADERPROC, DetachShader, CORE)                                                                 \
+    X(PFNGLDRAWBUFFERSPROC, DrawBuffers, CORE)                                                                   \
+    X(PFNGLENABLEVERTEXATTRIBARRAYPROC, EnableVertexAttribArray, CORE)                                           \
+    X(PFNGLGENBUFFERSPROC, GenBuffers, CORE)                                                                     \
+    X(PFNGLGENQUERIESPROC, GenQueries, CORE)                                                                     \
+    X(PFNGLGETPROGRAMINFOLOGPROC, GetProgramInfoLog, CORE)                                                       \
+    X(PFNGLGETPROGRAMIVPROC, GetProgramiv, CORE)                                                                 \
+    X(PFNGLGETSHADERINFOLOGPROC, GetShaderInfoLog, CORE)                                                         \
+    X(PFNGLGETSHADERIVPROC, GetShaderiv, CORE)                                                                   \
+    X(PFNGLLINKPROGRAMPROC, LinkProgram, CORE)                                                                   \
+    X(PFNGLSHADERSOURCEPROC, ShaderSource, CORE)                                                                 \
+    X(PFNGLSTENCILFUNCSEPARATEPROC, StencilFuncSeparate, CORE)                                                   \
+    X(PFNGLSTENCILMASKSEPARATEPROC, StencilMaskSeparate, CORE)                                                   \
+    X(PFNGLSTENCILOPSEPARATEPROC, StencilOpSeparate, CORE)                                                       \
+    X(PFNGLUSEPROGRAMPROC, UseProgram, CORE)                                                                     \
+    /* 3.0 - 3.3 */                                                                                              \
+    X(PFNGLBINDBUFFERRANGEPROC, BindBufferRange, CORE)                                                           \
+    X(PFNGLBINDFRAMEBUFFERPROC, BindFramebuffer, CORE)                                                           \
+    X(PFNGLBINDSAMPLERPROC, BindSampler, CORE)                                                                   \
+    X(PFNGLBINDVERTEXARRAYPROC, BindVertexArray, CORE)                                                           \
+    X(PFNGLCHECKFRAMEBUFFERSTATUSPROC, CheckFramebufferStatus, CORE)                                             \
+    X(PFNGLCLIENTWAITSYNCPROC, ClientWaitSync, CORE)                                                             \
+    X(PFNGLCOLORMASKIPROC, ColorMaski, CORE)                                                                     \
+    X(PFNGLDELETEFRAMEBUFFERSPROC, DeleteFramebuffers, CORE)                                                     \
+    X(PFNGLDELETESAMPLERSPROC, DeleteSamplers, CORE)                                                             \
+    X(PFNGLDELETESYNCPROC, DeleteSync, CORE)                                                                     \
+    X(PFNGLDELETEVERTEXARRAYSPROC, DeleteVertexArrays, CORE)                                                     \
+    X(PFNGLDISABLEIPROC, Disablei, CORE)                                                                         \
+    X(PFNGLENABLEIPROC, Enablei, CORE)                                                                           \
+    X(PFNGLFENCESYNCPROC, FenceSync, CORE)                                                                       \
+    X(PFNGLFRAMEBUFFERTEXTURE2DPROC, FramebufferTexture2D, CORE)                                                 \
+    X(PFNGLGENFRAMEBUFFERSPROC, GenFramebuffers, CORE)                                                           \
+    X(PFNGLGENSAMPLERSPROC, GenSamplers, CORE)                                                                   \
+    X(PFNGLGENVERTEXARRAYSPROC, GenVertexArrays, CORE)                                                           \
+    X(PFNGLGETQUERYOBJECTUI64VPROC, GetQueryObjectui64v, CORE)                                                   \
+    X(PFNGLGETSTRINGIPROC, GetStringi, CORE)                                                                     \
+    X(PFNGLMAPBUFFERRANGEPROC, MapBufferRange, CORE)                                                             \
+    X(PFNGLQUERYCOUNTERPROC, QueryCounter, CORE)                                                                 \
+    X(PFNGLSAMPLEMASKIPROC, SampleMaski, CORE)                                                                   \
+    X(PFNGLSAMPLERPARAMETERFPROC, SamplerParameterf, CORE)                                                       \
+    X(PFNGLSAMPLERPARAMETERFVPROC, SamplerParameterfv, CORE)                                                     \
+    X(PFNGLSAMPLERPARAMETERIPROC, SamplerParameteri, CORE)                                                       \
+    X(PFNGLTEXSTORAGE2DMULTISAMPLEPROC, TexStorage2DMultisample, CORE)                                           \
+    X(PFNGLTEXSTORAGE3DMULTISAMPLEPROC, TexStorage3DMultisample, CORE)                                           \
+    X(PFNGLUNMAPBUFFERPROC, UnmapBuffer, CORE)                                                                   \
+    /* 4.0 - 4.3 */                                                                                              \
+    X(PFNGLBLENDEQUATIONSEPARATEIPROC, BlendEquationSeparatei, CORE)                                             \
+    X(PFNGLBLENDFUNCSEPARATEIPROC, BlendFuncSeparatei, CORE)                                                     \
+    X(PFNGLDEBUGMESSAGECALLBACKPROC, DebugMessageCallback, CORE)                                                 \
+    X(PFNGLDEBUGMESSAGECONTROLPROC, DebugMessageControl, CORE)                                                   \
+    X(PFNGLBUFFERSTORAGEPROC, BufferStorage, CORE)                                                               \
+    X(PFNGLDEPTHRANGEINDEXEDPROC, DepthRangeIndexed, CORE)                                                       \
+    X(PFNGLDRAWARRAYSINSTANCEDBASEINSTANCEPROC, DrawArraysInstancedBaseInstance, CORE)                           \
+    X(PFNGLDRAWELEMENTSINSTANCEDBASEVERTEXBASEINSTANCEPROC, DrawElementsInstancedBaseVertexBaseInstance, CORE)   \
+    X(PFNGLDRAWELEMENTSINDIRECTPROC, DrawElementsIndirect, CORE)                                                 \
+    X(PFNGLGETPROGRAMBINARYPROC, GetProgramBinary, PROGRAM_BINARY)                                               \
+    X(PFNGLMULTIDRAWELEMENTSINDIRECTPROC, MultiDrawElementsIndirect, CORE)                                       \
+    X(PFNGLMINSAMPLESHADINGPROC, MinSampleShading, CORE)                                                         \
+    X(PFNGLPROGRAMBINARYPROC, ProgramBinary, PROGRAM_BINARY)                                                     \
+    X(PFNGLPROGRAMPARAMETERIPROC, ProgramParameteri, PROGRAM_BINARY)                                             \
+    X(PFNGLSCISSORINDEXEDPROC, ScissorIndexed, CORE)                                                             \
+    X(PFNGLTEXSTORAGE2DPROC, TexStorage2D, CORE)                                                                 \
+    X(PFNGLTEXSTORAGE3DPROC, TexStorage3D, CORE)                                                                 \
+    X(PFNGLBINDVERTEXBUFFERPROC, BindVertexBuffer, CORE)                                                         \
+    X(PFNGLVERTEXATTRIBBINDINGPROC, VertexAttribBinding, CORE)                                                   \
+    X(PFNGLVERTEXATTRIBFORMATPROC, VertexAttribFormat, CORE)                                                     \
+    X(PFNGLVERTEXATTRIBIFORMATPROC, VertexAttribIFormat, CORE)                                                   \
+    X(PFNGLVIEWPORTINDEXEDFPROC, ViewportIndexedf, CORE)                                                         \
+    /* 4.4 */                                                                                                    \
+    X(PFNGLBINDBUFFERSRANGEPROC, BindBuffersRange, MULTI_BIND)                                                   \
+    X(PFNGLBINDSAMPLERSPROC, BindSamplers, MULTI_BIND)                                                           \
+    X(PFNGLBINDTEXTURESPROC, BindTextures, MULTI_BIND)                                                           \
+    X(PFNGLBINDVERTEXBUFFERSPROC, BindVertexBuffers, MULTI_BIND)                                                 \
+    /* Extensions */                                                                                             \
+    X(PFNGLDEPTHBOUNDSEXTPROC, DepthBoundsEXT, DEPTH_BOUNDS)                                                     \
+    X(PFNGLFRAMEBUFFERTEXTUREMULTIVIEWOVRPROC, FramebufferTextureMultiviewOVR, MULTIVIEW)                         \
+    X(PFNGLMAXSHADERCOMPILERTHREADSKHRPROC, MaxShaderCompilerThreadsKHR, PARALLEL_SHADER_COMPILE)
+
+// A resolved GL entry point. Calls go through operator() so that builds with XR_TUTORIAL_OPENGL_CALL_COUNTERS can count them.
+template <typename PFN>
+struct GLEntryPoint;
+template <typename R, typename... Args>
+struct GLEntryPoint<R(APIENTRY *)(Args...)> {
+    R(APIENTRY *proc)(Args...) = nullptr;
+    uint32_t calls = 0;
+
+    R operator()(Args... args) {
+#if defined(XR_TUTORIAL_OPENGL_CALL_COUNTERS)
+        calls++;
+#endif
+        return proc(args...);
+    }
+};
+
 class GraphicsAPI_OpenGL : public GraphicsAPI {
 public:
-    GraphicsAPI_OpenGL();
+    enum class Feature : uint32_t {
+        CORE = 0x00000000,
+        DEPTH_BOUNDS = 0x00000001,  // GL_EXT_depth_bounds_test
+        MULTIVIEW = 0x00000002,     // GL_OVR_multiview2
+        MULTI_BIND = 0x00000004,    // OpenGL 4.4 or GL_ARB_multi_bind
+        PROGRAM_BINARY = 0x00000008,  // OpenGL 4.1, with at least one program binary format
+        PARALLEL_SHADER_COMPILE = 0x00000010,  // GL_KHR_parallel_shader_compile
+    };
+
+    // How the constructor without an XrInstance obtains its context. WINDOW opens a ksGpuWindow. SURFACELESS creates an EGL
+    // context with no window, surface or default framebuffer (EGL_MESA_platform_surfaceless and EGL_KHR_surfaceless_context),
+    // so it needs no display server and runs under Mesa llvmpipe in a container. All rendering then goes to FBOs, which is
+    // all GraphicsAPI_OpenGL ever renders to. Only available in builds with XR_TUTORIAL_USE_OPENGL_SURFACELESS.
+    enum class Context : uint8_t {
+        WINDOW,
+        SURFACELESS
+    };
+
+public:
+    explicit GraphicsAPI_OpenGL(Context context = Context::WINDOW);
+    // The OpenXR OpenGL graphics bindings name a window system drawable, so this always opens a ksGpuWindow.
     GraphicsAPI_OpenGL(XrInstance m_xrInstance, XrSystemId systemId);
     ~GraphicsAPI_OpenGL();
 
+    // False if a SURFACELESS context could not be created, or the build has no support for one. Nothing else may be called on
+    // the GraphicsAPI then.
+    bool IsValid() const { return valid; }
+
+    bool HasFeature(Feature feature) const { return BitwiseCheck(features, (uint32_t)feature); }
+    virtual bool SupportsMultiview() override { return HasFeature(Feature::MULTIVIEW); }
+    // Per entry point call counts from the last completed frame. Only populated in builds with XR_TUTORIAL_OPENGL_CALL_COUNTERS.
+    const std::vector<std::pair<const char*, uint32_t>>& GetEntryPointCallCounts() const { return entryPointCallCounts; }
+    // Where linked program binaries are cached, created when the first one is stored. Defaults to the XR_TUTORIAL_PIPELINE_CACHE_DIR
+    // environment variable, or to "PipelineCache" in the working directory without it.
+    void SetPipelineCacheDirectory(const std::string& directory) {
+        pipelineCacheDirectory = directory;
+        pipelineCacheDirectoryCreated = false;
+    }
+
     virtual void* CreateDesktopSwapchain(const SwapchainCreateInfo& swapchainCI) override;
     virtual void DestroyDesktopSwapchain(void*& swapchain) override;
     virtual void* GetDesktopSwapchainImage(void* swapchain, uint32_t index) override;
@@ -24,15 +199,15 @@ public:
     virtual int64_t GetDepthFormat() override { return (int64_t)GL_DEPTH_COMPONENT32F; }
     // XR_DOCS_TAG_END_GetDepthFormat_OpenGL
 
+    virtual void MakeContextCurrent() override;
+    virtual void ReleaseContext() override;
+
     virtual void* GetGraphicsBinding() override;
     virtual XrSwapchainImageBaseHeader* AllocateSwapchainImageData(XrSwapchain swapchain, SwapchainType type, uint32_t count) override;
-    virtual void FreeSwapchainImageData(XrSwapchain swapchain) override {
-        swapchainImagesMap[swapchain].second.clear();
-        swapchainImagesMap.erase(swapchain);
-    }
-    virtual XrSwapchainImageBaseHeader* GetSwapchainImageData(XrSwapchain swapchain, uint32_t index) override { return (XrSwapchainImageBaseHeader*)&swapchainImagesMap[swapchain].second[index]; }
+    virtual void FreeSwapchainImageData(XrSwapchain swapchain) override;
+    virtual XrSwapchainImageBaseHeader* GetSwapchainImageData(XrSwapchain swapchain, uint32_t index) override;
     // XR_DOCS_TAG_BEGIN_GetSwapchainImage_OpenGL
-    virtual void* GetSwapchainImage(XrSwapchain swapchain, uint32_t index) override { return (void*)(uint64_t)swapchainImagesMap[swapchain].second[index].image; }
+    virtual void* GetSwapchainImage(XrSwapchain swapchain, uint32_t index) override;
     // XR_DOCS_TAG_END_GetSwapchainImage_OpenGL
 
     virtual void* CreateImage(const ImageCreateInfo& imageCI) override;
@@ -51,12 +226,22 @@ public:
     virtual void DestroyShader(void*& shader) override;
 
     virtual void* CreatePipeline(const PipelineCreateInfo& pipelineCI) override;
+    virtual bool IsPipelineReady(void* pipeline) override;
     virtual void DestroyPipeline(void*& pipeline) override;
 
+    virtual void BeginFrame() override;
+    virtual void EndFrame() override;
+
+    virtual void BeginGpuZone(const char* name) override;
+    virtual void EndGpuZone() override;
+    virtual std::vector<GpuZoneStatistics> GetGpuZoneStatistics() const override;
+    virtual float GetLatestGpuZoneMilliseconds(const char* name) const override;
+
     virtual void BeginRendering() override;
     virtual void EndRendering() override;
 
     virtual void SetBufferData(void* buffer, size_t offset, size_t size, void* data) override;
+    virtual TransientAllocation AllocateTransientBuffer(BufferCreateInfo::Type type, size_t size) override;
 
     virtual void ClearColor(void* imageView, float r, float g, float b, float a) override;
     virtual void ClearDepth(void* imageView, float d) override;
@@ -72,13 +257,297 @@ public:
     virtual void SetIndexBuffer(void* indexBuffer) override;
     virtual void DrawIndexed(uint32_t indexCount, uint32_t instanceCount = 1, uint32_t firstIndex = 0, int32_t vertexOffset = 0, uint32_t firstInstance = 0) override;
     virtual void Draw(uint32_t vertexCount, uint32_t instanceCount = 1, uint32_t firstVertex = 0, uint32_t firstInstance = 0) override;
+    virtual void DrawIndexedIndirect(void* indirectBuffer, size_t offset) override;
+    virtual void MultiDrawIndexedIndirect(void* indirectBuffer, size_t offset, uint32_t drawCount, uint32_t stride = sizeof(DrawIndexedIndirectCommand)) override;
 
 private:
     virtual const std::vector<int64_t> GetSupportedColorSwapchainFormats() override;
     virtual const std::vector<int64_t> GetSupportedDepthSwapchainFormats() override;
 
 private:
+    // Fixed-function state derived from a PipelineCreateInfo, stored as the GL values that SetPipeline() applies.
+    struct StencilFaceState {
+        std::array<GLenum, 3> op;    // sfail, dpfail, dppass
+        std::array<GLuint, 3> func;  // func, ref, mask
+        GLuint writeMask;
+    };
+    struct BlendAttachmentState {
+        bool blendEnable;
+        std::array<GLenum, 2> equation;  // modeRGB, modeAlpha
+        std::array<GLenum, 4> func;      // srcRGB, dstRGB, srcAlpha, dstAlpha
+        std::array<GLboolean, 4> colorMask;
+    };
+    static constexpr size_t maxColorAttachments = 8;
+    struct PipelineState {
+        bool primitiveRestartEnable;
+        bool depthClampEnable;
+        bool rasteriserDiscardEnable;
+        GLenum polygonMode;  // 0 leaves the current polygon mode untouched.
+        bool cullFaceEnable;
+        GLenum cullFace;
+        GLenum frontFace;
+        size_t polygonOffsetIndex;  // Index of GL_POLYGON_OFFSET_FILL/LINE/POINT matching the polygon mode.
+        bool polygonOffsetEnable;
+        std::array<GLfloat, 2> polygonOffset;  // factor, units
+        GLfloat lineWidth;
+        bool multisampleEnable;
+        bool sampleShadingEnable;
+        GLfloat minSampleShading;
+        bool sampleMaskEnable;
+        GLbitfield sampleMask;
+        bool alphaToCoverageEnable;
+        bool alphaToOneEnable;
+        bool depthTestEnable;
+        GLboolean depthMask;
+        GLenum depthFunc;
+        bool depthBoundsTestEnable;
+        std::array<GLdouble, 2> depthBounds;
+        bool stencilTestEnable;
+        StencilFaceState front;
+        StencilFaceState back;
+        bool logicOpEnable;
+        GLenum logicOp;
+        size_t attachmentCount;
+        std::array<BlendAttachmentState, maxColorAttachments> attachments;
+        std::array<GLfloat, 4> blendConstants;
+    };
+    // Fills PS in place without clearing it first, so that a PipelineState zeroed with memset() keeps zero padding.
+    static void ToPipelineState(const PipelineCreateInfo& pipelineCI, PipelineState& PS);
+    // The state of a new context, as the GL specification sets it.
+    static PipelineState GetDefaultPipelineState();
+
+    // Shadow copy of the state last sent to the driver. SetPipeline() diffs against it and only emits the calls whose
+    // values differ. It starts out as the state of a new context, so that every value in it matches the driver's, including
+    // those SetPipeline() leaves untouched while their capability is disabled.
+    struct StateCache {
+        GLuint program = 0;
+        PipelineState pipeline = GetDefaultPipelineState();
+        std::array<bool, 3> polygonOffsetEnable{};
+        bool scissorTestEnable = false;  // Enabled by SetScissors(), disabled for clears, which ignore the scissors elsewhere.
+        GLuint vertexArray = 0;
+    };
+    template <typename T>
+    bool UpdateStateCache(T& cached, const T& value);
+    void SetCapability(GLenum capability, bool& cached, bool enable);
+
+    // Resource bindings last sent to the driver, per binding slot. SetDescriptor() only records a binding; UpdateDescriptors()
+    // drops the recorded bindings that are already in place and sends the rest, each run of consecutive changed slots in one
+    // multi-bind call when MULTI_BIND is available. Uniform and shader storage blocks have separate slots. Binding indices from
+    // maxDescriptorBindings up are bound directly, without tracking. A zeroed binding matches the context's initial state.
+    static constexpr size_t maxDescriptorBindings = 16;
+    struct BufferBinding {
+        GLuint buffer;
+        GLintptr offset;
+        GLsizeiptr size;
+
+        bool operator==(const BufferBinding& other) const { return buffer == other.buffer && offset == other.offset && size == other.size; }
+    };
+    struct TextureBinding {
+        GLuint texture;
+        GLenum target;
+
+        bool operator==(const TextureBinding& other) const { return texture == other.texture && target == other.target; }
+    };
+    struct DescriptorBindings {
+        std::array<BufferBinding, maxDescriptorBindings> uniformBuffers;
+        std::array<BufferBinding, maxDescriptorBindings> storageBuffers;
+        std::array<TextureBinding, maxDescriptorBindings> textures;
+        std::array<GLuint, maxDescriptorBindings> samplers;
+    };
+    // Bit masks of the slots SetDescriptor() has recorded since the last UpdateDescriptors().
+    struct DescriptorSlots {
+        uint32_t uniformBuffers;
+        uint32_t storageBuffers;
+        uint32_t textures;
+        uint32_t samplers;
+    };
+    // Copies the bindings of the slots in 'slots' that differ from 'bound' into it and calls bind(first, count) once for each run
+    // of consecutive changed slots. Counts the issued and elided bindings.
+    template <typename T, size_t N, typename BindFunction>
+    void UpdateBindings(const std::array<T, N>& set, std::array<T, N>& bound, uint32_t slots, BindFunction bind);
+    void BindBufferRanges(GLenum target, const std::array<BufferBinding, maxDescriptorBindings>& bindings, uint32_t first, uint32_t count);
+    // Forgets the bindings of a GL object that is being deleted, as its name may be reused.
+    void InvalidateBindings(GLuint buffer, GLuint texture, GLuint sampler);
+
+    void LoadDispatchTable();
+
+    // Resource metadata, stored in HandlePools. The void* handles returned by the Create*() functions are HandlePool handles.
+    struct Buffer {
+        GLuint buffer;
+        GLenum target;
+        BufferCreateInfo bufferCI;
+    };
+    struct Image {
+        GLuint texture;
+        GLenum target;
+        bool owned;  // Swapchain images belong to the OpenXR runtime.
+        ImageCreateInfo imageCI;
+    };
+    struct ImageView {
+        GLuint framebuffer;
+        GLuint texture;
+        ImageViewCreateInfo imageViewCI;
+    };
+    struct Shader {
+        GLuint shader;  // Compiled on first use, as a pipeline loaded from the pipeline cache never needs it.
+        GLenum type;
+        std::string source;
+        uint64_t sourceHash;  // Of the type and source, so that pipelines compare shaders by content.
+    };
+    GLuint GetCompiledShader(Shader& shader);
+    static constexpr size_t maxVertexBindings = 16;    // GL_MAX_VERTEX_ATTRIB_BINDINGS is at least 16.
+    static constexpr size_t maxVertexAttributes = 16;  // GL_MAX_VERTEX_ATTRIBS is at least 16.
+    static constexpr size_t maxPipelineShaders = 6;    // One per ShaderCreateInfo::Type.
+    // Everything a GL pipeline is built from, canonicalized into fixed-size POD blocks: shaders by content and in sorted order,
+    // vertex attributes and bindings sorted by index, and state that has no effect while disabled reset to its default. The
+    // color and depth formats and the descriptor layout change neither the program nor the VAO, so they are left out. Keys are
+    // zeroed with memset() before they are filled and only copied as bytes, so equal pipelines have equal bytes, padding
+    // included, and keys hash and compare with HashFNV1a() and memcmp().
+    struct VertexAttributeKey {
+        uint32_t attribIndex;
+        uint32_t bindingIndex;
+        VertexType vertexType;
+        size_t offset;
+    };
+    struct VertexBindingKey {
+        uint32_t bindingIndex;
+        size_t offset;
+        size_t stride;
+    };
+    struct PipelineKey {
+        size_t shaderCount;
+        std::array<uint64_t, maxPipelineShaders> shaderHashes;
+        size_t vertexAttributeCount;
+        std::array<VertexAttributeKey, maxVertexAttributes> vertexAttributes;
+        size_t vertexBindingCount;
+        std::array<VertexBindingKey, maxVertexBindings> vertexBindings;
+        GLenum topology;
+        PipelineState pipelineState;
+    };
+    void ToPipelineKey(const PipelineCreateInfo& pipelineCI, PipelineKey& key);
+    struct Pipeline {
+        GLuint program;
+        PipelineKey key;
+        std::array<HandlePool<Shader>::Handle, maxPipelineShaders> shaders;  // For FinishPipeline() to report compile errors.
+        uint32_t referenceCount;  // CreatePipeline() calls that returned this pipeline, less the DestroyPipeline() calls.
+        uint64_t keyHash;
+        // The vertex input layout is baked into the VAO when the pipeline is created; draws only bind buffers to it.
+        GLuint vertexArray;
+        size_t vertexBindingCount;
+        std::array<GLintptr, maxVertexBindings> vertexBindingOffsets;
+        std::array<GLsizei, maxVertexBindings> vertexBindingStrides;
+        std::array<GLuint, maxVertexBindings> vertexBuffers;  // Bound to the VAO.
+        GLuint indexBuffer;  // GL_ELEMENT_ARRAY_BUFFER is VAO state.
+        // Programs built from source link in the background; until FinishPipeline() has checked the result, the pipeline is
+        // not ready. If linking failed, 'failed' is set, 'program' is 0 and the pipeline is never ready.
+        bool ready;
+        bool failed;
+        uint64_t cacheKey;
+        std::chrono::steady_clock::time_point linkStart;
+    };
+    void FinishPipeline(Pipeline& glPipeline);
+    struct Swapchain {
+        XrSwapchain swapchain;
+        SwapchainType type;
+        std::vector<XrSwapchainImageOpenGLKHR> swapchainImages;
+        std::vector<HandlePool<Image>::Handle> images;
+    };
+    Swapchain* FindSwapchain(XrSwapchain swapchain);
+
+    // Linked programs are stored on disk with glGetProgramBinary(), one file per pipeline, and loaded with glProgramBinary() on
+    // later launches. The key hashes the shader sources, the vertex input layout and the driver; a binary the driver rejects is
+    // rebuilt from source and overwritten.
+    struct ProgramBinaryHeader {
+        uint32_t magic;
+        uint32_t binaryFormat;
+        uint32_t binarySize;
+        float linkMilliseconds;  // How long compiling and linking from source took, to report the time saved by a cache hit.
+    };
+    static constexpr uint32_t programBinaryMagic = 0x50425258;  // "XRBP"
+    uint64_t GetPipelineCacheKey(const PipelineKey& key);
+    std::string GetPipelineCacheDirectory() const;
+    std::string GetPipelineCachePath(uint64_t key);
+    bool LoadProgramBinary(GLuint program, uint64_t key, float& linkMilliseconds);
+    void StoreProgramBinary(GLuint program, uint64_t key, float linkMilliseconds);
+    std::string pipelineCacheDirectory = GetEnv("XR_TUTORIAL_PIPELINE_CACHE_DIR");
+    bool pipelineCacheDirectoryCreated = false;
+
+    // Persistently mapped buffers for data written once per frame, one per BufferCreateInfo::Type and created on first use.
+    // Each is split into framesInFlight parts; a part is reused only once the fence from the frame that last used it has
+    // signalled.
+    static constexpr size_t framesInFlight = 3;
+    static constexpr size_t transientBufferPartSize = 4 * 1024 * 1024;
+    struct TransientBuffer {
+        HandlePool<Buffer>::Handle buffer;
+        uint8_t* mappedData;
+        size_t alignment;
+        size_t offset;  // Next free byte in the current frame's part.
+    };
+    bool CreateTransientBuffer(BufferCreateInfo::Type type, TransientBuffer& transientBuffer);
+    void DestroyTransientBuffer(TransientBuffer& transientBuffer);
+
+    // Each GPU zone writes a GL_TIMESTAMP query at its begin and end into the current frame's part of the query ring. A part is
+    // read back in BeginFrame() once its frame fence has signalled, framesInFlight frames later, so reading never waits.
+    static constexpr size_t gpuZoneHistorySize = 128;
+    struct GpuZone {
+        const char* name;
+        std::array<float, gpuZoneHistorySize> milliseconds;  // A ring of the most recent results.
+        size_t count;
+        size_t next;
+    };
+    struct GpuZoneQuery {
+        size_t zoneIndex;
+        GLuint beginQuery;
+        GLuint endQuery;  // 0 if the zone was not ended within the frame.
+    };
+    struct GpuZoneFrame {
+        std::vector<GLuint> queries;  // Created on first use and reused.
+        size_t usedQueryCount;
+        std::vector<GpuZoneQuery> zoneQueries;
+    };
+    GLuint AllocateGpuZoneQuery();
+    void ReadGpuZoneQueries(GpuZoneFrame& gpuZoneFrame);
+
+    // Framebuffers built by SetRenderAttachments(), keyed by the textures and subresources attached to them. They are reused
+    // across frames and swapchain images, and deleted when one of their textures is destroyed.
+    struct FramebufferAttachment {
+        GLuint texture;
+        ImageViewCreateInfo::View view;
+        uint32_t mipLevel;
+        uint32_t baseArrayLayer;
+        uint32_t layerCount;
+
+        bool operator==(const FramebufferAttachment& other) const {
+            return texture == other.texture && view == other.view && mipLevel == other.mipLevel && baseArrayLayer == other.baseArrayLayer && layerCount == other.layerCount;
+        }
+    };
+    struct Framebuffer {
+        std::array<FramebufferAttachment, maxColorAttachments> colorAttachments;
+        size_t colorAttachmentCount;
+        FramebufferAttachment depthStencilAttachment;
+        GLuint framebuffer;
+    };
+    static FramebufferAttachment ToFramebufferAttachment(const ImageView* imageView);
+    GLuint GetFramebuffer(const Framebuffer& key);
+    void InvalidateFramebuffers(GLuint texture);
+
+private:
+    bool valid = true;
     ksGpuWindow window{};
+#if defined(XR_TUTORIAL_USE_OPENGL_SURFACELESS)
+    bool CreateSurfacelessContext();
+    void DestroySurfacelessContext();
+    EGLDisplay eglDisplay = EGL_NO_DISPLAY;
+    EGLContext eglContext = EGL_NO_CONTEXT;  // Not EGL_NO_CONTEXT only in SURFACELESS mode.
+#endif
+
+    struct DispatchTable {
+#define GRAPHICS_API_OPENGL_DECLARE_ENTRY_POINT(type, name, feature) GLEntryPoint<type> name;
+        GRAPHICS_API_OPENGL_ENTRY_POINTS(GRAPHICS_API_OPENGL_DECLARE_ENTRY_POINT)
+#undef GRAPHICS_API_OPENGL_DECLARE_ENTRY_POINT
+    } gl;
+    uint32_t features = 0;
+    std::vector<std::pair<const char*, uint32_t>> entryPointCallCounts{};
 
     PFN_xrGetOpenGLGraphicsRequirementsKHR xrGetOpenGLGraphicsRequirementsKHR = nullptr;
 #if defined(XR_USE_PLATFORM_WIN32)
@@ -91,16 +560,35 @@ private:
     XrGraphicsBindingOpenGLWaylandKHR graphicsBinding{};
 #endif
 
-    std::unordered_map<XrSwapchain, std::pair<SwapchainType, std::vector<XrSwapchainImageOpenGLKHR>>> swapchainImagesMap{};
+    // There are only ever a handful of swapchains, so these are searched linearly.
+    std::vector<Swapchain> swapchains{};
 
-    std::unordered_map<GLuint, BufferCreateInfo> buffers{};
-    std::unordered_map<GLuint, ImageCreateInfo> images{};
-    std::unordered_map<GLuint, ImageViewCreateInfo> imageViews{};
+    HandlePool<Buffer> buffers{};
+    HandlePool<Image> images{};
+    HandlePool<ImageView> imageViews{};
+    HandlePool<Shader> shaders{};
+    HandlePool<Pipeline> pipelines{};
+    // CreatePipeline() returns the existing pipeline for a key it has seen, rather than linking another program.
+    std::unordered_multimap<uint64_t, HandlePool<Pipeline>::Handle> pipelineLookup{};
+    uint64_t driverHash = 0;  // Of GL_VENDOR, GL_RENDERER and GL_VERSION; part of every pipeline cache key.
 
+    std::vector<Framebuffer> framebuffers{};
+    std::array<TransientBuffer, (size_t)BufferCreateInfo::Type::INDIRECT + 1> transientBuffers{};  // Indexed by BufferCreateInfo::Type.
+    std::array<GLsync, framesInFlight> frameFences{};
+    size_t frameInFlightIndex = 0;
+    std::vector<GpuZone> gpuZones{};
+    std::array<GpuZoneFrame, framesInFlight> gpuZoneFrames{};
+    std::vector<size_t> openGpuZoneQueries{};  // Indices into the current GpuZoneFrame's zoneQueries, innermost last.
     GLuint setFramebuffer = 0;
-    std::unordered_map<GLuint, PipelineCreateInfo> pipelines{};
-    GLuint setPipeline = 0;
-    GLuint vertexArray = 0;
+    HandlePool<Pipeline>::Handle setPipeline = HandlePool<Pipeline>::NullHandle;
+    GLenum setTopology = 0;
+    StateCache stateCache{};
+    DescriptorBindings setDescriptors{};
+    DescriptorSlots setDescriptorSlots{};
+    DescriptorBindings boundDescriptors{};
+    GLuint activeTextureUnit = 0;
     GLuint setIndexBuffer = 0;
+    GLuint setIndirectBuffer = 0;
+    GLenum setIndexType = 0;
 };
 #endif
\ No newline at end of file
@@ -0,0 +1,2113 @@
+// Copyright 2023, The Khronos Group Inc.
+//
+// SPDX-License-Identifier: MIT
+
+// OpenXR Tutorial for Khronos Group
+
+#include <GraphicsAPI_Vulkan.h>
+
+#include <CommandBuffer.h>
+
+#if defined(XR_USE_GRAPHICS_API_VULKAN)
+
+#pragma region PiplineHelpers
+// The GraphicsAPI pipeline enums share their values with the Vulkan ones, so most of them convert with a cast.
+
+VkBufferUsageFlags ToVkBufferUsage(GraphicsAPI::BufferCreateInfo::Type type) {
+    switch (type) {
+    case GraphicsAPI::BufferCreateInfo::Type::VERTEX:
+        return VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
+    case GraphicsAPI::BufferCreateInfo::Type::INDEX:
+        return VK_BUFFER_USAGE_INDEX_BUFFER_BIT;
+    case GraphicsAPI::BufferCreateInfo::Type::UNIFORM:
+        return VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
+    case GraphicsAPI::BufferCreateInfo::Type::STORAGE:
+        return VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+    case GraphicsAPI::BufferCreateInfo::Type::INDIRECT:
+        return VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT;
+    default:
+        DEBUG_BREAK;
+        std::cout << "ERROR: VULKAN: Unknown Buffer Type." << std::endl;
+        return 0;
+    }
+}
+
+VkShaderStageFlagBits ToVkShaderStage(GraphicsAPI::ShaderCreateInfo::Type type) {
+    switch (type) {
+    case GraphicsAPI::ShaderCreateInfo::Type::VERTEX:
+        return VK_SHADER_STAGE_VERTEX_BIT;
+    case GraphicsAPI::ShaderCreateInfo::Type::TESSELLATION_CONTROL:
+        return VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT;
+    case GraphicsAPI::ShaderCreateInfo::Type::TESSELLATION_EVALUATION:
+        return VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT;
+    case GraphicsAPI::ShaderCreateInfo::Type::GEOMETRY:
+        return VK_SHADER_STAGE_GEOMETRY_BIT;
+    case GraphicsAPI::ShaderCreateInfo::Type::FRAGMENT:
+        return VK_SHADER_STAGE_FRAGMENT_BIT;
+    case GraphicsAPI::ShaderCreateInfo::Type::COMPUTE:
+        return VK_SHADER_STAGE_COMPUTE_BIT;
+    default:
+        DEBUG_BREAK;
+        std::cout << "ERROR: VULKAN: Unknown Shader Type." << std::endl;
+        return VK_SHADER_STAGE_ALL;
+    }
+}
+
+VkShaderStageFlagBits ToVkShaderStage(GraphicsAPI::DescriptorInfo::Stage stage) {
+    // DescriptorInfo::Stage lists the stages in the same order as ShaderCreateInfo::Type.
+    return ToVkShaderStage(static_cast<GraphicsAPI::ShaderCreateInfo::Type>(stage));
+}
+
+VkDescriptorType ToVkDescriptorType(const GraphicsAPI::DescriptorInfo &descriptorInfo) {
+    switch (descriptorInfo.type) {
+    case GraphicsAPI::DescriptorInfo::Type::BUFFER:
+        return descriptorInfo.readWrite ? VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC : VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+    case GraphicsAPI::DescriptorInfo::Type::IMAGE:
+        return descriptorInfo.readWrite ? VK_DESCRIPTOR_TYPE_STORAGE_IMAGE : VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+    case GraphicsAPI::DescriptorInfo::Type::SAMPLER:
+        return VK_DESCRIPTOR_TYPE_SAMPLER;
+    default:
+        DEBUG_BREAK;
+        std::cout << "ERROR: VULKAN: Unknown Descriptor Type." << std::endl;
+        return VK_DESCRIPTOR_TYPE_MAX_ENUM;
+    }
+}
+
+VkFormat ToVkVertexFormat(GraphicsAPI::VertexType vertexType) {
+    static const std::array<VkFormat, 12> formats = {
+        VK_FORMAT_R32_SFLOAT, VK_FORMAT_R32G32_SFLOAT, VK_FORMAT_R32G32B32_SFLOAT, VK_FORMAT_R32G32B32A32_SFLOAT,
+        VK_FORMAT_R32_SINT, VK_FORMAT_R32G32_SINT, VK_FORMAT_R32G32B32_SINT, VK_FORMAT_R32G32B32A32_SINT,
+        VK_FORMAT_R32_UINT, VK_FORMAT_R32G32_UINT, VK_FORMAT_R32G32B32_UINT, VK_FORMAT_R32G32B32A32_UINT};
+    return formats[(size_t)vertexType];
+}
+
+VkFrontFace ToVkFrontFace(GraphicsAPI::FrontFace frontFace) {
+    // XrMatrix4x4f_CreateProjectionFov() flips Y for Vulkan, which reverses the winding the rasteriser sees. Flip the front face
+    // too, so that a PipelineCreateInfo culls the same faces on every API.
+    return frontFace == GraphicsAPI::FrontFace::COUNTER_CLOCKWISE ? VK_FRONT_FACE_CLOCKWISE : VK_FRONT_FACE_COUNTER_CLOCKWISE;
+}
+
+VkBorderColor ToVkBorderColor(const float borderColor[4]) {
+    // Vulkan 1.0 only has fixed border colors.
+    if (borderColor[0] == 0.0f && borderColor[1] == 0.0f && borderColor[2] == 0.0f) {
+        return borderColor[3] == 0.0f ? VK_BORDER_COLOR_FLOAT_TRANSPARENT_BLACK : VK_BORDER_COLOR_FLOAT_OPAQUE_BLACK;
+    }
+    return VK_BORDER_COLOR_FLOAT_OPAQUE_WHITE;
+}
+
+bool HasStencil(VkFormat format) {
+    return format == VK_FORMAT_S8_UINT || format == VK_FORMAT_D16_UNORM_S8_UINT || format == VK_FORMAT_D24_UNORM_S8_UINT || format == VK_FORMAT_D32_SFLOAT_S8_UINT;
+}
+
+VkImageAspectFlags GetDepthAspectFlags(VkFormat format) {
+    if (format == VK_FORMAT_S8_UINT) {
+        return VK_IMAGE_ASPECT_STENCIL_BIT;
+    }
+    return HasStencil(format) ? VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT : VK_IMAGE_ASPECT_DEPTH_BIT;
+}
+
+// OpenXR returns the required Vulkan extensions as one space separated string.
+std::vector<std::string> SplitExtensionString(const std::string &extensionString) {
+    std::vector<std::string> extensions;
+    std::stringstream stream(extensionString);
+    std::string extension;
+    while (stream >> extension) {
+        extensions.push_back(extension);
+    }
+    return extensions;
+}
+#pragma endregion
+
+GraphicsAPI_Vulkan::GraphicsAPI_Vulkan() {
+    CreateInstance({});
+    if (!instance) {
+        return;  // Reported by CreateInstance().
+    }
+
+    uint32_t physicalDeviceCount = 0;
+    VULKAN_CHECK(vkEnumeratePhysicalDevices(instance, &physicalDeviceCount, nullptr), "Failed to enumerate PhysicalDevices.");
+    std::vector<VkPhysicalDevice> physicalDevices(physicalDeviceCount);
+    VULKAN_CHECK(vkEnumeratePhysicalDevices(instance, &physicalDeviceCount, physicalDevices.data()), "Failed to enumerate PhysicalDevices.");
+
+    // Without OpenXR to choose, prefer a discrete GPU, then an integrated or virtual one, then a CPU implementation.
+    auto Rank = [](VkPhysicalDeviceType type) {
+        switch (type) {
+        case VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU:
+            return 0;
+        case VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU:
+            return 1;
+        case VK_PHYSICAL_DEVICE_TYPE_VIRTUAL_GPU:
+            return 2;
+        case VK_PHYSICAL_DEVICE_TYPE_CPU:
+            return 3;
+        default:
+            return 4;
+        }
+    };
+    int bestRank = 5;
+    for (VkPhysicalDevice candidate : physicalDevices) {
+        VkPhysicalDeviceProperties properties;
+        vkGetPhysicalDeviceProperties(candidate, &properties);
+        if (Rank(properties.deviceType) < bestRank && FindGraphicsQueueFamily(candidate) != UINT32_MAX) {
+            bestRank = Rank(properties.deviceType);
+            physicalDevice = candidate;
+        }
+    }
+    if (!physicalDevice) {
+        DEBUG_BREAK;
+        std::cout << "ERROR: VULKAN: Failed to find a PhysicalDevice with a graphics queue." << std::endl;
+        return;
+    }
+    CreateDevice({});
+}
+
+// XR_DOCS_TAG_BEGIN_GraphicsAPI_Vulkan
+GraphicsAPI_Vulkan::GraphicsAPI_Vulkan(XrInstance m_xrInstance, XrSystemId systemId) {
+    OPENXR_CHECK(xrGetInstanceProcAddr(m_xrInstance, "xrGetVulkanGraphicsRequirementsKHR", (PFN_xrVoidFunction *)&xrGetVulkanGraphicsRequirementsKHR), "Failed to get InstanceProcAddr for xrGetVulkanGraphicsRequirementsKHR.");
+    OPENXR_CHECK(xrGetInstanceProcAddr(m_xrInstance, "xrGetVulkanInstanceExtensionsKHR", (PFN_xrVoidFunction *)&xrGetVulkanInstanceExtensionsKHR), "Failed to get InstanceProcAddr for xrGetVulkanInstanceExtensionsKHR.");
+    OPENXR_CHECK(xrGetInstanceProcAddr(m_xrInstance, "xrGetVulkanDeviceExtensionsKHR", (PFN_xrVoidFunction *)&xrGetVulkanDeviceExtensionsKHR), "Failed to get InstanceProcAddr for xrGetVulkanDeviceExtensionsKHR.");
+    OPENXR_CHECK(xrGetInstanceProcAddr(m_xrInstance, "xrGetVulkanGraphicsDeviceKHR", (PFN_xrVoidFunction *)&xrGetVulkanGraphicsDeviceKHR), "Failed to get InstanceProcAddr for xrGetVulkanGraphicsDeviceKHR.");
+
+    XrGraphicsRequirementsVulkanKHR graphicsRequirements{XR_TYPE_GRAPHICS_REQUIREMENTS_VULKAN_KHR};
+    OPENXR_CHECK(xrGetVulkanGraphicsRequirementsKHR(m_xrInstance, systemId, &graphicsRequirements), "Failed to get Graphics Requirements for Vulkan.");
+
+    // The runtime names the instance extensions it needs, and then the physical device it is connected to.
+    uint32_t extensionStringSize = 0;
+    OPENXR_CHECK(xrGetVulkanInstanceExtensionsKHR(m_xrInstance, systemId, 0, &extensionStringSize, nullptr), "Failed to get Vulkan Instance Extensions.");
+    std::string extensionString(extensionStringSize, '\0');
+    OPENXR_CHECK(xrGetVulkanInstanceExtensionsKHR(m_xrInstance, systemId, extensionStringSize, &extensionStringSize, &extensionString[0]), "Failed to get Vulkan Instance Extensions.");
+    CreateInstance(SplitExtensionString(extensionString.c_str()));
+
+    OPENXR_CHECK(xrGetVulkanGraphicsDeviceKHR(m_xrInstance, systemId, instance, &physicalDevice), "Failed to get Graphics Device for Vulkan.");
+
+    extensionStringSize = 0;
+    OPENXR_CHECK(xrGetVulkanDeviceExtensionsKHR(m_xrInstance, systemId, 0, &extensionStringSize, nullptr), "Failed to get Vulkan Device Extensions.");
+    extensionString.assign(extensionStringSize, '\0');
+    OPENXR_CHECK(xrGetVulkanDeviceExtensionsKHR(m_xrInstance, systemId, extensionStringSize, &extensionStringSize, &extensionString[0]), "Failed to get Vulkan Device Extensions.");
+    CreateDevice(SplitExtensionString(extensionString.c_str()));
+
+    const uint32_t apiVersion = physicalDeviceProperties.apiVersion;
+    const XrVersion vulkanApiVersion = XR_MAKE_VERSION(VK_VERSION_MAJOR(apiVersion), VK_VERSION_MINOR(apiVersion), 0);
+    if (graphicsRequirements.minApiVersionSupported > vulkanApiVersion) {
+        int requiredMajorVersion = XR_VERSION_MAJOR(graphicsRequirements.minApiVersionSupported);
+        int requiredMinorVersion = XR_VERSION_MINOR(graphicsRequirements.minApiVersionSupported);
+        std::cerr << "ERROR: VULKAN: The PhysicalDevice's Vulkan version " << VK_VERSION_MAJOR(apiVersion) << "." << VK_VERSION_MINOR(apiVersion) << " doesn't meet the minimum required API version " << requiredMajorVersion << "." << requiredMinorVersion << " for OpenXR." << std::endl;
+    }
+}
+
+GraphicsAPI_Vulkan::~GraphicsAPI_Vulkan() {
+    if (device) {
+        VULKAN_CHECK(vkDeviceWaitIdle(device), "Failed to wait for Device Idle.");
+
+        FlushRecordedPasses();
+        FreeRecordedPass(uncachedPass);
+        for (FrameResources &frame : frames) {
+            for (std::function<void()> &destroy : frame.deferredDestroys) {
+                destroy();
+            }
+            vkDestroyQueryPool(device, frame.queryPool, nullptr);
+            vkDestroyFence(device, frame.fence, nullptr);
+            vkDestroyCommandPool(device, frame.commandPool, nullptr);
+        }
+        for (TransientBuffer &transientBuffer : transientBuffers) {
+            DestroyTransientBuffer(transientBuffer);
+        }
+        DestroyTransientBuffer(stagingBuffer);
+        for (const Framebuffer &framebuffer : framebuffers) {
+            vkDestroyFramebuffer(device, framebuffer.framebuffer, nullptr);
+        }
+        for (const RenderPass &renderPass : renderPasses) {
+            vkDestroyRenderPass(device, renderPass.renderPass, nullptr);
+        }
+        vkDestroyQueryPool(device, recordedPassQueryPool, nullptr);
+        vkDestroyCommandPool(device, secondaryCommandPool, nullptr);
+        vkDestroyCommandPool(device, immediateCommandPool, nullptr);
+        vkDestroyDevice(device, nullptr);
+    }
+    if (instance) {
+        vkDestroyInstance(instance, nullptr);
+    }
+}
+// XR_DOCS_TAG_END_GraphicsAPI_Vulkan
+
+void GraphicsAPI_Vulkan::CreateInstance(const std::vector<std::string> &instanceExtensions) {
+    std::vector<const char *> extensionNames;
+    for (const std::string &extension : instanceExtensions) {
+        extensionNames.push_back(extension.c_str());
+    }
+    std::vector<const char *> layerNames;
+    if (debugAPI) {
+        uint32_t layerCount = 0;
+        VULKAN_CHECK(vkEnumerateInstanceLayerProperties(&layerCount, nullptr), "Failed to enumerate InstanceLayerProperties.");
+        std::vector<VkLayerProperties> layers(layerCount);
+        VULKAN_CHECK(vkEnumerateInstanceLayerProperties(&layerCount, layers.data()), "Failed to enumerate InstanceLayerProperties.");
+        for (const VkLayerProperties &layer : layers) {
+            if (strcmp(layer.layerName, "VK_LAYER_KHRONOS_validation") == 0) {
+                layerNames.push_back("VK_LAYER_KHRONOS_validation");
+            }
+        }
+    }
+
+    VkApplicationInfo applicationInfo{VK_STRUCTURE_TYPE_APPLICATION_INFO};
+    applicationInfo.pApplicationName = "OpenXR Tutorial - Vulkan";
+    applicationInfo.applicationVersion = 1;
+    applicationInfo.pEngineName = "OpenXR Tutorial - Vulkan Engine";
+    applicationInfo.engineVersion = 1;
+    applicationInfo.apiVersion = VK_API_VERSION_1_0;
+
+    VkInstanceCreateInfo instanceCI{VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO};
+    instanceCI.pApplicationInfo = &applicationInfo;
+    instanceCI.enabledLayerCount = (uint32_t)layerNames.size();
+    instanceCI.ppEnabledLayerNames = layerNames.data();
+    instanceCI.enabledExtensionCount = (uint32_t)extensionNames.size();
+    instanceCI.ppEnabledExtensionNames = extensionNames.data();
+    VULKAN_CHECK(vkCreateInstance(&instanceCI, nullptr, &instance), "Failed to create Instance.");
+}
+
+uint32_t GraphicsAPI_Vulkan::FindGraphicsQueueFamily(VkPhysicalDevice candidate) const {
+    uint32_t queueFamilyCount = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(candidate, &queueFamilyCount, nullptr);
+    std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+    vkGetPhysicalDeviceQueueFamilyProperties(candidate, &queueFamilyCount, queueFamilies.data());
+    for (uint32_t i = 0; i < queueFamilyCount; i++) {
+        if (queueFamilies[i].queueFlags & VK_QUEUE_GRAPHICS_BIT) {
+            return i;
+        }
+    }
+    return UINT32_MAX;
+}
+
+void GraphicsAPI_Vulkan::CreateDevice(const std::vector<std::string> &deviceExtensions) {
+    queueFamilyIndex = FindGraphicsQueueFamily(physicalDevice);
+    if (queueFamilyIndex == UINT32_MAX) {
+        DEBUG_BREAK;
+        std::cout << "ERROR: VULKAN: The PhysicalDevice has no graphics queue." << std::endl;
+        return;
+    }
+    vkGetPhysicalDeviceProperties(physicalDevice, &physicalDeviceProperties);
+    vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
+
+    // Only the optional features that a PipelineCreateInfo or MultiDrawIndexedIndirect() can use, where supported.
+    VkPhysicalDeviceFeatures supportedFeatures{};
+    vkGetPhysicalDeviceFeatures(physicalDevice, &supportedFeatures);
+    enabledFeatures.independentBlend = supportedFeatures.independentBlend;
+    enabledFeatures.sampleRateShading = supportedFeatures.sampleRateShading;
+    enabledFeatures.logicOp = supportedFeatures.logicOp;
+    enabledFeatures.multiDrawIndirect = supportedFeatures.multiDrawIndirect;
+    enabledFeatures.drawIndirectFirstInstance = supportedFeatures.drawIndirectFirstInstance;
+    enabledFeatures.depthClamp = supportedFeatures.depthClamp;
+    enabledFeatures.fillModeNonSolid = supportedFeatures.fillModeNonSolid;
+    enabledFeatures.depthBounds = supportedFeatures.depthBounds;
+    enabledFeatures.wideLines = supportedFeatures.wideLines;
+
+    std::vector<const char *> extensionNames;
+    for (const std::string &extension : deviceExtensions) {
+        extensionNames.push_back(extension.c_str());
+    }
+
+    float queuePriority = 1.0f;
+    VkDeviceQueueCreateInfo queueCI{VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO};
+    queueCI.queueFamilyIndex = queueFamilyIndex;
+    queueCI.queueCount = 1;
+    queueCI.pQueuePriorities = &queuePriority;
+
+    VkDeviceCreateInfo deviceCI{VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO};
+    deviceCI.queueCreateInfoCount = 1;
+    deviceCI.pQueueCreateInfos = &queueCI;
+    deviceCI.enabledExtensionCount = (uint32_t)extensionNames.size();
+    deviceCI.ppEnabledExtensionNames = extensionNames.data();
+    deviceCI.pEnabledFeatures = &enabledFeatures;
+    VULKAN_CHECK(vkCreateDevice(physicalDevice, &deviceCI, nullptr, &device), "Failed to create Device.");
+    if (!device) {
+        return;
+    }
+    vkGetDeviceQueue(device, queueFamilyIndex, 0, &queue);
+
+    uint32_t queueFamilyCount = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, nullptr);
+    std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+    vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, queueFamilies.data());
+    const uint32_t timestampValidBits = queueFamilies[queueFamilyIndex].timestampValidBits;
+    timestampMask = timestampValidBits >= 64 ? ~0ull : (1ull << timestampValidBits) - 1;
+
+    VkCommandPoolCreateInfo commandPoolCI{VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO};
+    commandPoolCI.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+    commandPoolCI.queueFamilyIndex = queueFamilyIndex;
+    VULKAN_CHECK(vkCreateCommandPool(device, &commandPoolCI, nullptr, &immediateCommandPool), "Failed to create CommandPool.");
+    commandPoolCI.flags = 0;
+    VULKAN_CHECK(vkCreateCommandPool(device, &commandPoolCI, nullptr, &secondaryCommandPool), "Failed to create CommandPool.");
+
+    VkQueryPoolCreateInfo queryPoolCI{VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO};
+    queryPoolCI.queryType = VK_QUERY_TYPE_TIMESTAMP;
+    for (FrameResources &frame : frames) {
+        commandPoolCI.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+        VULKAN_CHECK(vkCreateCommandPool(device, &commandPoolCI, nullptr, &frame.commandPool), "Failed to create CommandPool.");
+        VkFenceCreateInfo fenceCI{VK_STRUCTURE_TYPE_FENCE_CREATE_INFO};
+        VULKAN_CHECK(vkCreateFence(device, &fenceCI, nullptr, &frame.fence), "Failed to create Fence.");
+        if (timestampMask) {
+            queryPoolCI.queryCount = gpuZoneQueriesPerFrame;
+            VULKAN_CHECK(vkCreateQueryPool(device, &queryPoolCI, nullptr, &frame.queryPool), "Failed to create QueryPool.");
+        }
+    }
+    if (timestampMask) {
+        queryPoolCI.queryCount = recordedPassQueryBlockCount * maxGpuZonesPerPass * 2;
+        VULKAN_CHECK(vkCreateQueryPool(device, &queryPoolCI, nullptr, &recordedPassQueryPool), "Failed to create QueryPool.");
+        for (uint32_t block = recordedPassQueryBlockCount; block > 0; block--) {
+            freeRecordedPassQueryBlocks.push_back(block - 1);
+        }
+    }
+}
+
+bool GraphicsAPI_Vulkan::AllocateMemory(const VkMemoryRequirements &memoryRequirements, VkMemoryPropertyFlags required, VkMemoryPropertyFlags preferred, VkDeviceMemory &memory) {
+    // Try for the preferred properties first, then settle for the required ones.
+    for (VkMemoryPropertyFlags flags : {required | preferred, required}) {
+        for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++) {
+            if ((memoryRequirements.memoryTypeBits & (1u << i)) && BitwiseCheck(memoryProperties.memoryTypes[i].propertyFlags, flags)) {
+                VkMemoryAllocateInfo allocateInfo{VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO};
+                allocateInfo.allocationSize = memoryRequirements.size;
+                allocateInfo.memoryTypeIndex = i;
+                VULKAN_CHECK(vkAllocateMemory(device, &allocateInfo, nullptr, &memory), "Failed to allocate Memory.");
+                return memory != VK_NULL_HANDLE;
+            }
+        }
+    }
+    DEBUG_BREAK;
+    std::cout << "ERROR: VULKAN: Failed to find a suitable Memory Type." << std::endl;
+    return false;
+}
+
+void GraphicsAPI_Vulkan::ImmediateSubmit(const std::function<void(VkCommandBuffer)> &record) {
+    VkCommandBufferAllocateInfo allocateInfo{VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO};
+    allocateInfo.commandPool = immediateCommandPool;
+    allocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    allocateInfo.commandBufferCount = 1;
+    VkCommandBuffer immediateCommandBuffer = VK_NULL_HANDLE;
+    VULKAN_CHECK(vkAllocateCommandBuffers(device, &allocateInfo, &immediateCommandBuffer), "Failed to allocate CommandBuffer.");
+
+    VkCommandBufferBeginInfo beginInfo{VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO};
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    VULKAN_CHECK(vkBeginCommandBuffer(immediateCommandBuffer, &beginInfo), "Failed to begin CommandBuffer.");
+    record(immediateCommandBuffer);
+    // Make the writes available to everything submitted afterwards.
+    VkMemoryBarrier memoryBarrier{VK_STRUCTURE_TYPE_MEMORY_BARRIER};
+    memoryBarrier.srcAccessMask = VK_ACCESS_MEMORY_WRITE_BIT;
+    memoryBarrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+    vkCmdPipelineBarrier(immediateCommandBuffer, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 1, &memoryBarrier, 0, nullptr, 0, nullptr);
+    VULKAN_CHECK(vkEndCommandBuffer(immediateCommandBuffer), "Failed to end CommandBuffer.");
+
+    VkSubmitInfo submitInfo{VK_STRUCTURE_TYPE_SUBMIT_INFO};
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &immediateCommandBuffer;
+    VULKAN_CHECK(vkQueueSubmit(queue, 1, &submitInfo, VK_NULL_HANDLE), "Failed to submit to Queue.");
+    VULKAN_CHECK(vkQueueWaitIdle(queue), "Failed to wait for Queue Idle.");
+    vkFreeCommandBuffers(device, immediateCommandPool, 1, &immediateCommandBuffer);
+}
+
+void GraphicsAPI_Vulkan::ImmediateUpload(VkBuffer buffer, size_t offset, size_t size, const void *data) {
+    VkBufferCreateInfo stagingBufferCI{VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO};
+    stagingBufferCI.size = size;
+    stagingBufferCI.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+    stagingBufferCI.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    VkBuffer staging = VK_NULL_HANDLE;
+    VULKAN_CHECK(vkCreateBuffer(device, &stagingBufferCI, nullptr, &staging), "Failed to create staging Buffer.");
+
+    VkMemoryRequirements memoryRequirements{};
+    vkGetBufferMemoryRequirements(device, staging, &memoryRequirements);
+    VkDeviceMemory stagingMemory = VK_NULL_HANDLE;
+    if (AllocateMemory(memoryRequirements, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, 0, stagingMemory)) {
+        VULKAN_CHECK(vkBindBufferMemory(device, staging, stagingMemory, 0), "Failed to bind Memory to staging Buffer.");
+        void *mappedData = nullptr;
+        VULKAN_CHECK(vkMapMemory(device, stagingMemory, 0, VK_WHOLE_SIZE, 0, &mappedData), "Failed to map staging Buffer.");
+        memcpy(mappedData, data, size);
+        vkUnmapMemory(device, stagingMemory);
+
+        ImmediateSubmit([&](VkCommandBuffer immediateCommandBuffer) {
+            VkBufferCopy region{0, offset, size};
+            vkCmdCopyBuffer(immediateCommandBuffer, staging, buffer, 1, &region);
+        });
+    }
+    vkDestroyBuffer(device, staging, nullptr);
+    vkFreeMemory(device, stagingMemory, nullptr);
+}
+
+void GraphicsAPI_Vulkan::DeferDestroy(std::function<void()> destroy) {
+    frames[frameInFlightIndex].deferredDestroys.push_back(std::move(destroy));
+}
+
+void GraphicsAPI_Vulkan::BeginFrame() {
+    GraphicsAPI::BeginFrame();
+
+    // Move on to the next frame in flight, waiting for the GPU to finish the frame that last used it.
+    frameInFlightIndex = (frameInFlightIndex + 1) % framesInFlight;
+    FrameResources &frame = frames[frameInFlightIndex];
+    if (frame.fenceSubmitted) {
+        VkResult result = VK_TIMEOUT;
+        while (result == VK_TIMEOUT) {
+            result = vkWaitForFences(device, 1, &frame.fence, VK_TRUE, 1000000000);
+        }
+        if (result != VK_SUCCESS) {
+            DEBUG_BREAK;
+            std::cout << "ERROR: VULKAN: Failed to wait for the frame fence." << std::endl;
+        }
+        VULKAN_CHECK(vkResetFences(device, 1, &frame.fence), "Failed to reset Fence.");
+        frame.fenceSubmitted = false;
+    }
+    ReadGpuZoneQueries(frame);
+    std::vector<std::function<void()>> deferredDestroys;
+    deferredDestroys.swap(frame.deferredDestroys);
+    for (std::function<void()> &destroy : deferredDestroys) {
+        destroy();
+    }
+    VULKAN_CHECK(vkResetCommandPool(device, frame.commandPool, 0), "Failed to reset CommandPool.");
+    frame.usedCommandBufferCount = 0;
+
+    for (TransientBuffer &transientBuffer : transientBuffers) {
+        transientBuffer.offset = frameInFlightIndex * transientBufferPartSize;
+    }
+    stagingBuffer.offset = frameInFlightIndex * transientBufferPartSize;
+
+    // Caches that only grow would eventually hold every pass ever seen; start them over instead.
+    if (recordedPassesInvalid || recordedPasses.size() > maxRecordedPasses || descriptorSets.size() > maxCachedDescriptorSets) {
+        FlushRecordedPasses();
+    }
+
+    frameActive = true;
+    if (timestampMask) {
+        vkCmdResetQueryPool(GetCommandBuffer(), frame.queryPool, 0, gpuZoneQueriesPerFrame);
+    }
+}
+
+void GraphicsAPI_Vulkan::EndFrame() {
+    if (passMode != PassMode::NONE) {
+        DEBUG_BREAK;
+        std::cout << "ERROR: VULKAN: EndFrame() called before EndRendering()." << std::endl;
+        EndRenderPass();
+    }
+    if (!openGpuZoneQueries.empty()) {
+        DEBUG_BREAK;
+        std::cout << "ERROR: VULKAN: " << openGpuZoneQueries.size() << " GPU zone(s) were not ended within the frame." << std::endl;
+        openGpuZoneQueries.clear();
+    }
+    FlushPendingClears();
+
+    // The fence signals once everything submitted so far has completed.
+    FrameResources &frame = frames[frameInFlightIndex];
+    if (commandBuffer) {
+        SubmitCommandBuffer(frame.fence);
+    } else {
+        VULKAN_CHECK(vkQueueSubmit(queue, 0, nullptr, frame.fence), "Failed to submit to Queue.");
+    }
+    frame.fenceSubmitted = true;
+    frameActive = false;
+
+    GraphicsAPI::EndFrame();
+}
+
+VkCommandBuffer GraphicsAPI_Vulkan::GetCommandBuffer() {
+    if (commandBuffer) {
+        return commandBuffer;
+    }
+    if (!frameActive) {
+        DEBUG_BREAK;
+        std::cout << "ERROR: VULKAN: Commands can only be recorded between BeginFrame() and EndFrame()." << std::endl;
+        return VK_NULL_HANDLE;
+    }
+
+    FrameResources &frame = frames[frameInFlightIndex];
+    if (frame.usedCommandBufferCount == frame.commandBuffers.size()) {
+        VkCommandBufferAllocateInfo allocateInfo{VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO};
+        allocateInfo.commandPool = frame.commandPool;
+        allocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        allocateInfo.commandBufferCount = 1;
+        VkCommandBuffer newCommandBuffer = VK_NULL_HANDLE;
+        VULKAN_CHECK(vkAllocateCommandBuffers(device, &allocateInfo, &newCommandBuffer), "Failed to allocate CommandBuffer.");
+        frame.commandBuffers.push_back(newCommandBuffer);
+    }
+    commandBuffer = frame.commandBuffers[frame.usedCommandBufferCount++];
+
+    VkCommandBufferBeginInfo beginInfo{VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO};
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    VULKAN_CHECK(vkBeginCommandBuffer(commandBuffer, &beginInfo), "Failed to begin CommandBuffer.");
+    return commandBuffer;
+}
+
+void GraphicsAPI_Vulkan::SubmitCommandBuffer(VkFence fence) {
+    VULKAN_CHECK(vkEndCommandBuffer(commandBuffer), "Failed to end CommandBuffer.");
+    VkSubmitInfo submitInfo{VK_STRUCTURE_TYPE_SUBMIT_INFO};
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &commandBuffer;
+    VULKAN_CHECK(vkQueueSubmit(queue, 1, &submitInfo, fence), "Failed to submit to Queue.");
+    commandBuffer = VK_NULL_HANDLE;
+}
+
+size_t GraphicsAPI_Vulkan::FindGpuZone(const char *name) {
+    size_t zoneIndex = 0;
+    while (zoneIndex < gpuZones.size() && gpuZones[zoneIndex].name != name && strcmp(gpuZones[zoneIndex].name, name) != 0) {
+        zoneIndex++;
+    }
+    if (zoneIndex == gpuZones.size()) {
+        gpuZones.push_back({name, {}, 0, 0});
+    }
+    return zoneIndex;
+}
+
+void GraphicsAPI_Vulkan::BeginGpuZone(const char *name) {
+    if (!timestampMask || !frameActive) {
+        return;
+    }
+    // SIZE_MAX marks a zone that is not measured, so that EndGpuZone() still pairs up.
+    if (passMode != PassMode::NONE) {
+        size_t passZoneIndex = SIZE_MAX;
+        if (passMode == PassMode::RECORD && recordedPass->queryBlock != UINT32_MAX && recordedPass->gpuZones.size() < maxGpuZonesPerPass) {
+            const uint32_t query = (recordedPass->queryBlock * maxGpuZonesPerPass + (uint32_t)recordedPass->gpuZones.size()) * 2;
+            vkCmdWriteTimestamp(recordedPass->commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, recordedPassQueryPool, query);
+            passZoneIndex = recordedPass->gpuZones.size();
+            recordedPass->gpuZones.push_back({FindGpuZone(name), query, query + 1, false});
+        }
+        openPassGpuZones.push_back(passZoneIndex);
+        return;
+    }
+
+    FrameResources &frame = frames[frameInFlightIndex];
+    if (frame.usedQueryCount + 2 > gpuZoneQueriesPerFrame) {
+        openGpuZoneQueries.push_back(SIZE_MAX);
+        return;
+    }
+    const uint32_t query = frame.usedQueryCount;
+    frame.usedQueryCount += 2;
+    vkCmdWriteTimestamp(GetCommandBuffer(), VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, frame.queryPool, query);
+    openGpuZoneQueries.push_back(frame.zoneQueries.size());
+    frame.zoneQueries.push_back({FindGpuZone(name), frame.queryPool, query, query + 1, false});
+}
+
+void GraphicsAPI_Vulkan::EndGpuZone() {
+    if (!timestampMask || !frameActive) {
+        return;
+    }
+    if (passMode != PassMode::NONE && !openPassGpuZones.empty()) {
+        const size_t passZoneIndex = openPassGpuZones.back();
+        openPassGpuZones.pop_back();
+        if (passMode == PassMode::RECORD && passZoneIndex != SIZE_MAX) {
+            PassGpuZone &passGpuZone = recordedPass->gpuZones[passZoneIndex];
+            vkCmdWriteTimestamp(recordedPass->commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, recordedPassQueryPool, passGpuZone.endQuery);
+            passGpuZone.ended = true;
+        }
+        return;
+    }
+    if (openGpuZoneQueries.empty()) {
+        DEBUG_BREAK;
+        std::cout << "ERROR: VULKAN: EndGpuZone() called without a matching BeginGpuZone()." << std::endl;
+        return;
+    }
+    const size_t zoneQueryIndex = openGpuZoneQueries.back();
+    openGpuZoneQueries.pop_back();
+    if (zoneQueryIndex == SIZE_MAX) {
+        return;
+    }
+    if (passMode != PassMode::NONE) {
+        DEBUG_BREAK;
+        std::cout << "ERROR: VULKAN: A GPU zone begun outside a render pass must end outside it." << std::endl;
+        return;
+    }
+    GpuZoneQuery &zoneQuery = frames[frameInFlightIndex].zoneQueries[zoneQueryIndex];
+    vkCmdWriteTimestamp(GetCommandBuffer(), VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, zoneQuery.queryPool, zoneQuery.endQuery);
+    zoneQuery.ended = true;
+}
+
+std::vector<GraphicsAPI::GpuZoneStatistics> GraphicsAPI_Vulkan::GetGpuZoneStatistics() const {
+    std::vector<GpuZoneStatistics> gpuZoneStatistics;
+    for (const GpuZone &gpuZone : gpuZones) {
+        if (gpuZone.count == 0) {
+            continue;
+        }
+        std::vector<float> milliseconds(gpuZone.milliseconds.begin(), gpuZone.milliseconds.begin() + gpuZone.count);
+        std::sort(milliseconds.begin(), milliseconds.end());
+        auto Percentile = [&milliseconds](float percentile) {
+            return milliseconds[(size_t)(percentile * (float)(milliseconds.size() - 1) + 0.5f)];
+        };
+        float total = 0.0f;
+        for (float value : milliseconds) {
+            total += value;
+        }
+        gpuZoneStatistics.push_back({gpuZone.name, (uint32_t)gpuZone.count, total / (float)gpuZone.count, Percentile(0.5f), Percentile(0.9f), Percentile(0.99f)});
+    }
+    return gpuZoneStatistics;
+}
+
+float GraphicsAPI_Vulkan::GetLatestGpuZoneMilliseconds(const char *name) const {
+    for (const GpuZone &gpuZone : gpuZones) {
+        if (gpuZone.name != name && strcmp(gpuZone.name, name) != 0) {
+            continue;
+        }
+        return gpuZone.count ? gpuZone.milliseconds[(gpuZone.next + gpuZoneHistorySize - 1) % gpuZoneHistorySize] : -1.0f;
+    }
+    return -1.0f;
+}
+
+void GraphicsAPI_Vulkan::ReadGpuZoneQueries(FrameResources &frame) {
+    // The fence of the frame that wrote these queries has signalled, so their results are available.
+    for (const GpuZoneQuery &zoneQuery : frame.zoneQueries) {
+        if (!zoneQuery.ended) {
+            continue;
+        }
+        std::array<uint64_t, 2> timestamps{};
+        VkResult result = vkGetQueryPoolResults(device, zoneQuery.queryPool, zoneQuery.beginQuery, 2, sizeof(timestamps), timestamps.data(), sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+        if (result != VK_SUCCESS) {
+            continue;
+        }
+        const uint64_t ticks = (timestamps[1] - timestamps[0]) & timestampMask;
+
+        GpuZone &gpuZone = gpuZones[zoneQuery.zoneIndex];
+        gpuZone.milliseconds[gpuZone.next] = (float)((double)ticks * physicalDeviceProperties.limits.timestampPeriod / 1000000.0);
+        gpuZone.next = (gpuZone.next + 1) % gpuZoneHistorySize;
+        gpuZone.count = std::min(gpuZone.count + 1, gpuZoneHistorySize);
+    }
+    frame.zoneQueries.clear();
+    frame.usedQueryCount = 0;
+}
+
+void *GraphicsAPI_Vulkan::CreateDesktopSwapchain(const SwapchainCreateInfo &swapchainCI) { return nullptr; }
+void GraphicsAPI_Vulkan::DestroyDesktopSwapchain(void *&swapchain) {}
+void *GraphicsAPI_Vulkan::GetDesktopSwapchainImage(void *swapchain, uint32_t index) { return nullptr; }
+void GraphicsAPI_Vulkan::AcquireDesktopSwapchanImage(void *swapchain, uint32_t &index) {}
+void GraphicsAPI_Vulkan::PresentDesktopSwapchainImage(void *swapchain, uint32_t index) {}
+
+// XR_DOCS_TAG_BEGIN_GraphicsAPI_Vulkan_GetGraphicsBinding
+void *GraphicsAPI_Vulkan::GetGraphicsBinding() {
+    graphicsBinding = {XR_TYPE_GRAPHICS_BINDING_VULKAN_KHR};
+    graphicsBinding.instance = instance;
+    graphicsBinding.physicalDevice = physicalDevice;
+    graphicsBinding.device = device;
+    graphicsBinding.queueFamilyIndex = queueFamilyIndex;
+    graphicsBinding.queueIndex = 0;
+    return &graphicsBinding;
+}
+// XR_DOCS_TAG_END_GraphicsAPI_Vulkan_GetGraphicsBinding
+
+// XR_DOCS_TAG_BEGIN_GraphicsAPI_Vulkan_AllocateSwapchainImageData
+XrSwapchainImageBaseHeader *GraphicsAPI_Vulkan::AllocateSwapchainImageData(XrSwapchain swapchain, SwapchainType type, uint32_t count) {
+    Swapchain *vkSwapchain = FindSwapchain(swapchain);
+    if (!vkSwapchain) {
+        swapchains.push_back({swapchain});
+        vkSwapchain = &swapchains.back();
+    }
+    vkSwapchain->type = type;
+    vkSwapchain->swapchainImages.resize(count, {XR_TYPE_SWAPCHAIN_IMAGE_VULKAN_KHR});
+    vkSwapchain->images.resize(count, HandlePool<Image>::NullHandle);
+    return reinterpret_cast<XrSwapchainImageBaseHeader *>(vkSwapchain->swapchainImages.data());
+}
+// XR_DOCS_TAG_END_GraphicsAPI_Vulkan_AllocateSwapchainImageData
+
+void GraphicsAPI_Vulkan::FreeSwapchainImageData(XrSwapchain swapchain) {
+    for (size_t i = 0; i < swapchains.size(); i++) {
+        if (swapchains[i].swapchain == swapchain) {
+            for (HandlePool<Image>::Handle &image : swapchains[i].images) {
+                images.Free(image);
+            }
+            swapchains.erase(swapchains.begin() + i);
+            return;
+        }
+    }
+}
+
+XrSwapchainImageBaseHeader *GraphicsAPI_Vulkan::GetSwapchainImageData(XrSwapchain swapchain, uint32_t index) {
+    Swapchain *vkSwapchain = FindSwapchain(swapchain);
+    return vkSwapchain ? (XrSwapchainImageBaseHeader *)&vkSwapchain->swapchainImages[index] : nullptr;
+}
+
+void *GraphicsAPI_Vulkan::GetSwapchainImage(XrSwapchain swapchain, uint32_t index) {
+    Swapchain *vkSwapchain = FindSwapchain(swapchain);
+    if (!vkSwapchain) {
+        std::cout << "ERROR: VULKAN: Unknown Swapchain." << std::endl;
+        return nullptr;
+    }
+
+    // The images are only known after xrEnumerateSwapchainImages(), so register them the first time they are asked for.
+    HandlePool<Image>::Handle &image = vkSwapchain->images[index];
+    if (!images.IsValid(image)) {
+        ImageCreateInfo imageCI{};
+        imageCI.dimension = 2;
+        imageCI.mipLevels = 1;
+        imageCI.arrayLayers = 1;
+        imageCI.sampleCount = 1;
+        imageCI.colorAttachment = vkSwapchain->type == SwapchainType::COLOR;
+        imageCI.depthAttachment = vkSwapchain->type == SwapchainType::DEPTH;
+        image = images.Allocate({vkSwapchain->swapchainImages[index].image, VK_NULL_HANDLE, VK_NULL_HANDLE, GetRestingLayout(imageCI), false, imageCI});
+    }
+    return HandlePool<Image>::ToPointer(image);
+}
+
+GraphicsAPI_Vulkan::Swapchain *GraphicsAPI_Vulkan::FindSwapchain(XrSwapchain swapchain) {
+    for (Swapchain &vkSwapchain : swapchains) {
+        if (vkSwapchain.swapchain == swapchain) {
+            return &vkSwapchain;
+        }
+    }
+    return nullptr;
+}
+
+VkImageLayout GraphicsAPI_Vulkan::GetRestingLayout(const ImageCreateInfo &imageCI) {
+    if (imageCI.sampled && (imageCI.colorAttachment || imageCI.depthAttachment)) {
+        return VK_IMAGE_LAYOUT_GENERAL;
+    } else if (imageCI.colorAttachment) {
+        return VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+    } else if (imageCI.depthAttachment) {
+        return VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+    } else if (imageCI.sampled) {
+        return VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    }
+    return VK_IMAGE_LAYOUT_GENERAL;
+}
+
+void *GraphicsAPI_Vulkan::CreateImage(const ImageCreateInfo &imageCI) {
+    const VkFormat format = (VkFormat)imageCI.format;
+
+    VkImageCreateInfo vkImageCI{VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO};
+    vkImageCI.flags = imageCI.cubemap ? VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT : 0;
+    vkImageCI.imageType = imageCI.dimension == 1 ? VK_IMAGE_TYPE_1D : imageCI.dimension == 3 ? VK_IMAGE_TYPE_3D : VK_IMAGE_TYPE_2D;
+    vkImageCI.format = format;
+    vkImageCI.extent = {imageCI.width, std::max(imageCI.height, 1u), std::max(imageCI.depth, 1u)};
+    vkImageCI.mipLevels = std::max(imageCI.mipLevels, 1u);
+    vkImageCI.arrayLayers = std::max(imageCI.arrayLayers, 1u);
+    vkImageCI.samples = (VkSampleCountFlagBits)std::max(imageCI.sampleCount, 1u);
+    vkImageCI.tiling = VK_IMAGE_TILING_OPTIMAL;
+    vkImageCI.usage = VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+    vkImageCI.usage |= imageCI.colorAttachment ? VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT : 0;
+    vkImageCI.usage |= imageCI.depthAttachment ? VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT : 0;
+    vkImageCI.usage |= imageCI.sampled ? VK_IMAGE_USAGE_SAMPLED_BIT : 0;
+    vkImageCI.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    vkImageCI.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    VkImage image = VK_NULL_HANDLE;
+    VULKAN_CHECK(vkCreateImage(device, &vkImageCI, nullptr, &image), "Failed to create Image.");
+
+    VkMemoryRequirements memoryRequirements{};
+    vkGetImageMemoryRequirements(device, image, &memoryRequirements);
+    VkDeviceMemory memory = VK_NULL_HANDLE;
+    if (AllocateMemory(memoryRequirements, 0, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, memory)) {
+        VULKAN_CHECK(vkBindImageMemory(device, image, memory, 0), "Failed to bind Memory to Image.");
+    }
+
+    const VkImageAspectFlags aspect = imageCI.depthAttachment ? GetDepthAspectFlags(format) : (VkImageAspectFlags)VK_IMAGE_ASPECT_COLOR_BIT;
+    VkImageView sampledView = VK_NULL_HANDLE;
+    if (imageCI.sampled) {
+        VkImageViewCreateInfo imageViewCI{VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO};
+        imageViewCI.image = image;
+        if (imageCI.cubemap) {
+            imageViewCI.viewType = vkImageCI.arrayLayers > 6 ? VK_IMAGE_VIEW_TYPE_CUBE_ARRAY : VK_IMAGE_VIEW_TYPE_CUBE;
+        } else if (imageCI.dimension == 1) {
+            imageViewCI.viewType = vkImageCI.arrayLayers > 1 ? VK_IMAGE_VIEW_TYPE_1D_ARRAY : VK_IMAGE_VIEW_TYPE_1D;
+        } else if (imageCI.dimension == 3) {
+            imageViewCI.viewType = VK_IMAGE_VIEW_TYPE_3D;
+        } else {
+            imageViewCI.viewType = vkImageCI.arrayLayers > 1 ? VK_IMAGE_VIEW_TYPE_2D_ARRAY : VK_IMAGE_VIEW_TYPE_2D;
+        }
+        imageViewCI.format = format;
+        // Samplers read depth, not stencil.
+        imageViewCI.subresourceRange = {imageCI.depthAttachment ? (VkImageAspectFlags)VK_IMAGE_ASPECT_DEPTH_BIT : aspect, 0, vkImageCI.mipLevels, 0, vkImageCI.arrayLayers};
+        VULKAN_CHECK(vkCreateImageView(device, &imageViewCI, nullptr, &sampledView), "Failed to create sampled ImageView.");
+    }
+
+    // Move the whole image into its resting layout once, so that render passes and descriptors can rely on it.
+    const VkImageLayout layout = GetRestingLayout(imageCI);
+    ImmediateSubmit([&](VkCommandBuffer immediateCommandBuffer) {
+        VkImageMemoryBarrier imageBarrier{VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER};
+        imageBarrier.srcAccessMask = 0;
+        imageBarrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+        imageBarrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        imageBarrier.newLayout = layout;
+        imageBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        imageBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        imageBarrier.image = image;
+        imageBarrier.subresourceRange = {aspect, 0, vkImageCI.mipLevels, 0, vkImageCI.arrayLayers};
+        vkCmdPipelineBarrier(immediateCommandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 0, nullptr, 0, nullptr, 1, &imageBarrier);
+    });
+
+    return HandlePool<Image>::ToPointer(images.Allocate({image, memory, sampledView, layout, true, imageCI}));
+}
+
+void GraphicsAPI_Vulkan::DestroyImage(void *&image) {
+    HandlePool<Image>::Handle handle = HandlePool<Image>::FromPointer(image);
+    const Image *vkImage = images.Get(handle);
+    if (!vkImage) {
+        DEBUG_BREAK;
+        std::cout << "ERROR: VULKAN: DestroyImage() called with an invalid or destroyed Image." << std::endl;
+        image = nullptr;
+        return;
+    }
+    if (vkImage->owned) {
+        VkImage vkImageHandle = vkImage->image;
+        VkDeviceMemory memory = vkImage->memory;
+        VkImageView sampledView = vkImage->sampledView;
+        DeferDestroy([this, vkImageHandle, memory, sampledView]() {
+            vkDestroyImageView(device, sampledView, nullptr);
+            vkDestroyImage(device, vkImageHandle, nullptr);
+            vkFreeMemory(device, memory, nullptr);
+        });
+    }
+    // Cached descriptor sets may refer to its sampled view.
+    recordedPassesInvalid = true;
+    images.Free(handle);
+    image = nullptr;
+}
+
+void *GraphicsAPI_Vulkan::CreateImageView(const ImageViewCreateInfo &imageViewCI) {
+    const Image *vkImage = images.Get(HandlePool<Image>::FromPointer(imageViewCI.image));
+    if (!vkImage) {
+        DEBUG_BREAK;
+        std::cout << "ERROR: VULKAN: CreateImageView() called with an invalid or destroyed Image." << std::endl;
+        return nullptr;
+    }
+
+    VkImageViewCreateInfo vkImageViewCI{VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO};
+    vkImageViewCI.image = vkImage->image;
+    vkImageViewCI.viewType = static_cast<VkImageViewType>(imageViewCI.view);
+    vkImageViewCI.format = (VkFormat)imageViewCI.format;
+    vkImageViewCI.components = {VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY};
+    vkImageViewCI.subresourceRange = {(VkImageAspectFlags)imageViewCI.aspect, imageViewCI.baseMipLevel, imageViewCI.levelCount, imageViewCI.baseArrayLayer, imageViewCI.layerCount};
+    VkImageView imageView = VK_NULL_HANDLE;
+    VULKAN_CHECK(vkCreateImageView(device, &vkImageViewCI, nullptr, &imageView), "Failed to create ImageView.");
+
+    // The size of a swapchain image is not known here; SetRenderAttachments() fills it in.
+    VkExtent2D extent{};
+    if (vkImage->owned) {
+        extent = {std::max(vkImage->imageCI.width >> imageViewCI.baseMipLevel, 1u), std::max(vkImage->imageCI.height >> imageViewCI.baseMipLevel, 1u)};
+    }
+    const VkSampleCountFlagBits samples = (VkSampleCountFlagBits)std::max(vkImage->imageCI.sampleCount, 1u);
+    return HandlePool<ImageView>::ToPointer(imageViews.Allocate({imageView, HandlePool<Image>::FromPointer(imageViewCI.image), samples, extent, imageViewCI}));
+}
+
+void GraphicsAPI_Vulkan::DestroyImageView(void *&imageView) {
+    HandlePool<ImageView>::Handle handle = HandlePool<ImageView>::FromPointer(imageView);
+    const ImageView *vkImageView = imageViews.Get(handle);
+    if (!vkImageView) {
+        DEBUG_BREAK;
+        std::cout << "ERROR: VULKAN: DestroyImageView() called with an invalid or destroyed ImageView." << std::endl;
+        imageView = nullptr;
+        return;
+    }
+    VkImageView vkImageViewHandle = vkImageView->imageView;
+    InvalidateFramebuffers(vkImageViewHandle);
+    DeferDestroy([this, vkImageViewHandle]() { vkDestroyImageView(device, vkImageViewHandle, nullptr); });
+    for (size_t i = 0; i < pendingClears.size();) {
+        if (pendingClears[i].imageView == handle) {
+            pendingClears.erase(pendingClears.begin() + i);
+        } else {
+            i++;
+        }
+    }
+    recordedPassesInvalid = true;
+    imageViews.Free(handle);
+    imageView = nullptr;
+}
+
+void *GraphicsAPI_Vulkan::CreateSampler(const SamplerCreateInfo &samplerCI) {
+    VkSamplerCreateInfo vkSamplerCI{VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO};
+    vkSamplerCI.magFilter = static_cast<VkFilter>(samplerCI.magFilter);
+    vkSamplerCI.minFilter = static_cast<VkFilter>(samplerCI.minFilter);
+    // Vulkan has no mipmap mode that ignores the mip chain; clamping the LOD to the base level does the same.
+    const bool noMipmaps = samplerCI.mipmapMode == SamplerCreateInfo::MipmapMode::NOOP;
+    vkSamplerCI.mipmapMode = noMipmaps ? VK_SAMPLER_MIPMAP_MODE_NEAREST : static_cast<VkSamplerMipmapMode>(samplerCI.mipmapMode);
+    vkSamplerCI.addressModeU = static_cast<VkSamplerAddressMode>(samplerCI.addressModeS);
+    vkSamplerCI.addressModeV = static_cast<VkSamplerAddressMode>(samplerCI.addressModeT);
+    vkSamplerCI.addressModeW = static_cast<VkSamplerAddressMode>(samplerCI.addressModeR);
+    vkSamplerCI.mipLodBias = samplerCI.mipLodBias;
+    vkSamplerCI.compareEnable = samplerCI.compareEnable;
+    vkSamplerCI.compareOp = static_cast<VkCompareOp>(samplerCI.compareOp);
+    vkSamplerCI.minLod = noMipmaps ? 0.0f : samplerCI.minLod;
+    vkSamplerCI.maxLod = noMipmaps ? 0.0f : samplerCI.maxLod;
+    vkSamplerCI.borderColor = ToVkBorderColor(samplerCI.borderColor);
+    VkSampler sampler = VK_NULL_HANDLE;
+    VULKAN_CHECK(vkCreateSampler(device, &vkSamplerCI, nullptr, &sampler), "Failed to create Sampler.");
+    return HandlePool<Sampler>::ToPointer(samplers.Allocate({sampler}));
+}
+
+void GraphicsAPI_Vulkan::DestroySampler(void *&sampler) {
+    HandlePool<Sampler>::Handle handle = HandlePool<Sampler>::FromPointer(sampler);
+    const Sampler *vkSampler = samplers.Get(handle);
+    if (!vkSampler) {
+        DEBUG_BREAK;
+        std::cout << "ERROR: VULKAN: DestroySampler() called with an invalid or destroyed Sampler." << std::endl;
+        sampler = nullptr;
+        return;
+    }
+    VkSampler vkSamplerHandle = vkSampler->sampler;
+    DeferDestroy([this, vkSamplerHandle]() { vkDestroySampler(device, vkSamplerHandle, nullptr); });
+    recordedPassesInvalid = true;
+    samplers.Free(handle);
+    sampler = nullptr;
+}
+
+void *GraphicsAPI_Vulkan::CreateBuffer(const BufferCreateInfo &bufferCI) {
+    if (bufferCI.size == 0) {
+        DEBUG_BREAK;
+        std::cout << "ERROR: VULKAN: CreateBuffer() called with a size of 0." << std::endl;
+        return nullptr;
+    }
+    VkBufferCreateInfo vkBufferCI{VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO};
+    vkBufferCI.size = bufferCI.size;
+    vkBufferCI.usage = ToVkBufferUsage(bufferCI.type) | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+    vkBufferCI.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    VkBuffer buffer = VK_NULL_HANDLE;
+    VULKAN_CHECK(vkCreateBuffer(device, &vkBufferCI, nullptr, &buffer), "Failed to create Buffer.");
+
+    VkMemoryRequirements memoryRequirements{};
+    vkGetBufferMemoryRequirements(device, buffer, &memoryRequirements);
+    VkDeviceMemory memory = VK_NULL_HANDLE;
+    if (AllocateMemory(memoryRequirements, 0, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, memory)) {
+        VULKAN_CHECK(vkBindBufferMemory(device, buffer, memory, 0), "Failed to bind Memory to Buffer.");
+    }
+    if (bufferCI.data) {
+        ImmediateUpload(buffer, 0, bufferCI.size, bufferCI.data);
+    }
+
+    return HandlePool<Buffer>::ToPointer(buffers.Allocate({buffer, memory, bufferCI}));
+}
+
+void GraphicsAPI_Vulkan::DestroyBuffer(void *&buffer) {
+    HandlePool<Buffer>::Handle handle = HandlePool<Buffer>::FromPointer(buffer);
+    const Buffer *vkBuffer = buffers.Get(handle);
+    if (!vkBuffer) {
+        DEBUG_BREAK;
+        std::cout << "ERROR: VULKAN: DestroyBuffer() called with an invalid or destroyed Buffer." << std::endl;
+        buffer = nullptr;
+        return;
+    }
+    VkBuffer vkBufferHandle = vkBuffer->buffer;
+    VkDeviceMemory memory = vkBuffer->memory;
+    DeferDestroy([this, vkBufferHandle, memory]() {
+        vkDestroyBuffer(device, vkBufferHandle, nullptr);
+        vkFreeMemory(device, memory, nullptr);
+    });
+    recordedPassesInvalid = true;
+    buffers.Free(handle);
+    buffer = nullptr;
+}
+
+void *GraphicsAPI_Vulkan::CreateShader(const ShaderCreateInfo &shaderCI) {
+    static constexpr uint32_t spirvMagic = 0x07230203;
+    uint32_t magic = 0;
+    if (shaderCI.sourceSize >= sizeof(magic)) {
+        memcpy(&magic, shaderCI.sourceData, sizeof(magic));
+    }
+    if (magic != spirvMagic || shaderCI.sourceSize % sizeof(uint32_t) != 0) {
+        DEBUG_BREAK;
+        std::cout << "ERROR: VULKAN: CreateShader() requires SPIR-V." << std::endl;
+        return nullptr;
+    }
+    // Copied, as pCode must be 4 byte aligned.
+    std::vector<uint32_t> code(shaderCI.sourceSize / sizeof(uint32_t));
+    memcpy(code.data(), shaderCI.sourceData, shaderCI.sourceSize);
+
+    VkShaderModuleCreateInfo shaderModuleCI{VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO};
+    shaderModuleCI.codeSize = shaderCI.sourceSize;
+    shaderModuleCI.pCode = code.data();
+    VkShaderModule shaderModule = VK_NULL_HANDLE;
+    VULKAN_CHECK(vkCreateShaderModule(device, &shaderModuleCI, nullptr, &shaderModule), "Failed to create ShaderModule.");
+    return HandlePool<Shader>::ToPointer(shaders.Allocate({shaderModule, shaderCI.type}));
+}
+
+void GraphicsAPI_Vulkan::DestroyShader(void *&shader) {
+    HandlePool<Shader>::Handle handle = HandlePool<Shader>::FromPointer(shader);
+    const Shader *vkShader = shaders.Get(handle);
+    if (!vkShader) {
+        DEBUG_BREAK;
+        std::cout << "ERROR: VULKAN: DestroyShader() called with an invalid or destroyed Shader." << std::endl;
+        shader = nullptr;
+        return;
+    }
+    // Pipelines keep what they need from a shader module, so it can go immediately.
+    vkDestroyShaderModule(device, vkShader->shaderModule, nullptr);
+    shaders.Free(handle);
+    shader = nullptr;
+}
+
+void *GraphicsAPI_Vulkan::CreatePipeline(const PipelineCreateInfo &pipelineCI) {
+    Pipeline vkPipeline{};
+    vkPipeline.pipelineCI = pipelineCI;
+
+    // Descriptor Set Layout
+    vkPipeline.layout = pipelineCI.layout;
+    std::sort(vkPipeline.layout.begin(), vkPipeline.layout.end(), [](const DescriptorInfo &a, const DescriptorInfo &b) { return a.bindingIndex < b.bindingIndex; });
+    if (vkPipeline.layout.size() > maxDescriptorBindings) {
+        DEBUG_BREAK;
+        std::cout << "ERROR: VULKAN: CreatePipeline() called with more than " << maxDescriptorBindings << " descriptors in the layout." << std::endl;
+        vkPipeline.layout.resize(maxDescriptorBindings);
+    }
+    std::vector<VkDescriptorSetLayoutBinding> descriptorSetLayoutBindings;
+    for (const DescriptorInfo &descriptorInfo : vkPipeline.layout) {
+        descriptorSetLayoutBindings.push_back({descriptorInfo.bindingIndex, ToVkDescriptorType(descriptorInfo), 1, (VkShaderStageFlags)ToVkShaderStage(descriptorInfo.stage), nullptr});
+    }
+    VkDescriptorSetLayoutCreateInfo descriptorSetLayoutCI{VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO};
+    descriptorSetLayoutCI.bindingCount = (uint32_t)descriptorSetLayoutBindings.size();
+    descriptorSetLayoutCI.pBindings = descriptorSetLayoutBindings.data();
+    VULKAN_CHECK(vkCreateDescriptorSetLayout(device, &descriptorSetLayoutCI, nullptr, &vkPipeline.descriptorSetLayout), "Failed to create DescriptorSetLayout.");
+
+    VkPipelineLayoutCreateInfo pipelineLayoutCI{VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO};
+    pipelineLayoutCI.setLayoutCount = 1;
+    pipelineLayoutCI.pSetLayouts = &vkPipeline.descriptorSetLayout;
+    VULKAN_CHECK(vkCreatePipelineLayout(device, &pipelineLayoutCI, nullptr, &vkPipeline.pipelineLayout), "Failed to create PipelineLayout.");
+
+    // Shaders
+    std::vector<VkPipelineShaderStageCreateInfo> shaderStages;
+    for (void *shader : pipelineCI.shaders) {
+        const Shader *vkShader = shaders.Get(HandlePool<Shader>::FromPointer(shader));
+        if (!vkShader) {
+            DEBUG_BREAK;
+            std::cout << "ERROR: VULKAN: CreatePipeline() called with an invalid or destroyed Shader." << std::endl;
+            continue;
+        }
+        VkPipelineShaderStageCreateInfo shaderStageCI{VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO};
+        shaderStageCI.stage = ToVkShaderStage(vkShader->type);
+        shaderStageCI.module = vkShader->shaderModule;
+        shaderStageCI.pName = "main";
+        shaderStages.push_back(shaderStageCI);
+    }
+
+    // VertexInputState
+    std::vector<VkVertexInputBindingDescription> vertexBindings;
+    for (const VertexInputBinding &vertexBinding : pipelineCI.vertexInputState.bindings) {
+        if (vertexBinding.bindingIndex >= maxVertexBindings) {
+            DEBUG_BREAK;
+            std::cout << "ERROR: VULKAN: VertexInputBinding bindingIndex " << vertexBinding.bindingIndex << " is out of range." << std::endl;
+            continue;
+        }
+        vertexBindings.push_back({vertexBinding.bindingIndex, (uint32_t)vertexBinding.stride, VK_VERTEX_INPUT_RATE_VERTEX});
+        vkPipeline.vertexBindingCount = std::max(vkPipeline.vertexBindingCount, (size_t)vertexBinding.bindingIndex + 1);
+        vkPipeline.vertexBindingOffsets[vertexBinding.bindingIndex] = (VkDeviceSize)vertexBinding.offset;
+    }
+    std::vector<VkVertexInputAttributeDescription> vertexAttributes;
+    for (const VertexInputAttribute &vertexAttribute : pipelineCI.vertexInputState.attributes) {
+        vertexAttributes.push_back({vertexAttribute.attribIndex, vertexAttribute.bindingIndex, ToVkVertexFormat(vertexAttribute.vertexType), (uint32_t)vertexAttribute.offset});
+    }
+    VkPipelineVertexInputStateCreateInfo vertexInputState{VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO};
+    vertexInputState.vertexBindingDescriptionCount = (uint32_t)vertexBindings.size();
+    vertexInputState.pVertexBindingDescriptions = vertexBindings.data();
+    vertexInputState.vertexAttributeDescriptionCount = (uint32_t)vertexAttributes.size();
+    vertexInputState.pVertexAttributeDescriptions = vertexAttributes.data();
+
+    // InputAssemblyState
+    VkPipelineInputAssemblyStateCreateInfo inputAssemblyState{VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO};
+    inputAssemblyState.topology = static_cast<VkPrimitiveTopology>(pipelineCI.inputAssemblyState.topology);
+    inputAssemblyState.primitiveRestartEnable = pipelineCI.inputAssemblyState.primitiveRestartEnable;
+
+    // ViewportState: the viewport and scissor are dynamic.
+    VkPipelineViewportStateCreateInfo viewportState{VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO};
+    viewportState.viewportCount = 1;
+    viewportState.scissorCount = 1;
+
+    // RasterisationState
+    const RasterisationState &RS = pipelineCI.rasterisationState;
+    VkPipelineRasterizationStateCreateInfo rasterizationState{VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO};
+    rasterizationState.depthClampEnable = RS.depthClampEnable && enabledFeatures.depthClamp;
+    rasterizationState.rasterizerDiscardEnable = RS.rasteriserDiscardEnable;
+    rasterizationState.polygonMode = enabledFeatures.fillModeNonSolid ? static_cast<VkPolygonMode>(RS.polygonMode) : VK_POLYGON_MODE_FILL;
+    rasterizationState.cullMode = static_cast<VkCullModeFlags>(RS.cullMode);
+    rasterizationState.frontFace = ToVkFrontFace(RS.frontFace);
+    rasterizationState.depthBiasEnable = RS.depthBiasEnable;
+    rasterizationState.depthBiasConstantFactor = RS.depthBiasConstantFactor;
+    rasterizationState.depthBiasClamp = RS.depthBiasClamp;
+    rasterizationState.depthBiasSlopeFactor = RS.depthBiasSlopeFactor;
+    rasterizationState.lineWidth = enabledFeatures.wideLines ? RS.lineWidth : 1.0f;
+
+    // MultisampleState
+    const MultisampleState &MS = pipelineCI.multisampleState;
+    const VkSampleMask sampleMask = MS.sampleMask;
+    VkPipelineMultisampleStateCreateInfo multisampleState{VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO};
+    multisampleState.rasterizationSamples = (VkSampleCountFlagBits)std::max(MS.rasterisationSamples, 1u);
+    multisampleState.sampleShadingEnable = MS.sampleShadingEnable && enabledFeatures.sampleRateShading;
+    multisampleState.minSampleShading = MS.minSampleShading;
+    multisampleState.pSampleMask = &sampleMask;
+    multisampleState.alphaToCoverageEnable = MS.alphaToCoverageEnable;
+    multisampleState.alphaToOneEnable = false;
+
+    // DepthStencilState
+    const DepthStencilState &DSS = pipelineCI.depthStencilState;
+    auto ToVkStencilOpState = [](const StencilOpState &stencil) -> VkStencilOpState {
+        return {static_cast<VkStencilOp>(stencil.failOp), static_cast<VkStencilOp>(stencil.passOp), static_cast<VkStencilOp>(stencil.depthFailOp), static_cast<VkCompareOp>(stencil.compareOp), stencil.compareMask, stencil.writeMask, stencil.reference};
+    };
+    VkPipelineDepthStencilStateCreateInfo depthStencilState{VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO};
+    depthStencilState.depthTestEnable = DSS.depthTestEnable;
+    depthStencilState.depthWriteEnable = DSS.depthWriteEnable;
+    depthStencilState.depthCompareOp = static_cast<VkCompareOp>(DSS.depthCompareOp);
+    depthStencilState.depthBoundsTestEnable = DSS.depthBoundsTestEnable && enabledFeatures.depthBounds;
+    depthStencilState.stencilTestEnable = DSS.stencilTestEnable;
+    depthStencilState.front = ToVkStencilOpState(DSS.front);
+    depthStencilState.back = ToVkStencilOpState(DSS.back);
+    depthStencilState.minDepthBounds = DSS.minDepthBounds;
+    depthStencilState.maxDepthBounds = DSS.maxDepthBounds;
+
+    // ColorBlendState
+    const ColorBlendState &CBS = pipelineCI.colorBlendState;
+    std::vector<VkPipelineColorBlendAttachmentState> colorBlendAttachments;
+    for (const ColorBlendAttachmentState &attachment : CBS.attachments) {
+        colorBlendAttachments.push_back({attachment.blendEnable,
+                                         static_cast<VkBlendFactor>(attachment.srcColorBlendFactor), static_cast<VkBlendFactor>(attachment.dstColorBlendFactor), static_cast<VkBlendOp>(attachment.colorBlendOp),
+                                         static_cast<VkBlendFactor>(attachment.srcAlphaBlendFactor), static_cast<VkBlendFactor>(attachment.dstAlphaBlendFactor), static_cast<VkBlendOp>(attachment.alphaBlendOp),
+                                         static_cast<VkColorComponentFlags>(attachment.colorWriteMask)});
+    }
+    VkPipelineColorBlendStateCreateInfo colorBlendState{VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO};
+    colorBlendState.logicOpEnable = CBS.logicOpEnable && enabledFeatures.logicOp;
+    colorBlendState.logicOp = static_cast<VkLogicOp>(CBS.logicOp);
+    colorBlendState.attachmentCount = (uint32_t)colorBlendAttachments.size();
+    colorBlendState.pAttachments = colorBlendAttachments.data();
+    for (size_t i = 0; i < 4; i++) {
+        colorBlendState.blendConstants[i] = CBS.blendConstants[i];
+    }
+
+    const std::array<VkDynamicState, 2> dynamicStates = {VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR};
+    VkPipelineDynamicStateCreateInfo dynamicState{VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO};
+    dynamicState.dynamicStateCount = (uint32_t)dynamicStates.size();
+    dynamicState.pDynamicStates = dynamicStates.data();
+
+    // The pipeline is compatible with every render pass that has the same attachment formats, whatever their load operations.
+    RenderPassKey renderPassKey{};
+    for (int64_t colorFormat : pipelineCI.colorFormats) {
+        if (renderPassKey.colorAttachmentCount < maxColorAttachments) {
+            renderPassKey.colorFormats[renderPassKey.colorAttachmentCount++] = (VkFormat)colorFormat;
+        }
+    }
+    renderPassKey.depthFormat = (VkFormat)pipelineCI.depthFormat;
+    renderPassKey.samples = multisampleState.rasterizationSamples;
+
+    VkGraphicsPipelineCreateInfo graphicsPipelineCI{VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO};
+    graphicsPipelineCI.stageCount = (uint32_t)shaderStages.size();
+    graphicsPipelineCI.pStages = shaderStages.data();
+    graphicsPipelineCI.pVertexInputState = &vertexInputState;
+    graphicsPipelineCI.pInputAssemblyState = &inputAssemblyState;
+    graphicsPipelineCI.pViewportState = &viewportState;
+    graphicsPipelineCI.pRasterizationState = &rasterizationState;
+    graphicsPipelineCI.pMultisampleState = &multisampleState;
+    graphicsPipelineCI.pDepthStencilState = &depthStencilState;
+    graphicsPipelineCI.pColorBlendState = &colorBlendState;
+    graphicsPipelineCI.pDynamicState = &dynamicState;
+    graphicsPipelineCI.layout = vkPipeline.pipelineLayout;
+    graphicsPipelineCI.renderPass = GetRenderPass(renderPassKey);
+    graphicsPipelineCI.subpass = 0;
+    VULKAN_CHECK(vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &graphicsPipelineCI, nullptr, &vkPipeline.pipeline), "Failed to create Graphics Pipeline.");
+
+    return HandlePool<Pipeline>::ToPointer(pipelines.Allocate(vkPipeline));
+}
+
+void GraphicsAPI_Vulkan::DestroyPipeline(void *&pipeline) {
+    HandlePool<Pipeline>::Handle handle = HandlePool<Pipeline>::FromPointer(pipeline);
+    const Pipeline *vkPipeline = pipelines.Get(handle);
+    if (!vkPipeline) {
+        DEBUG_BREAK;
+        std::cout << "ERROR: VULKAN: DestroyPipeline() called with an invalid or destroyed Pipeline." << std::endl;
+        pipeline = nullptr;
+        return;
+    }
+    VkPipeline vkPipelineHandle = vkPipeline->pipeline;
+    VkPipelineLayout pipelineLayout = vkPipeline->pipelineLayout;
+    VkDescriptorSetLayout descriptorSetLayout = vkPipeline->descriptorSetLayout;
+    DeferDestroy([this, vkPipelineHandle, pipelineLayout, descriptorSetLayout]() {
+        vkDestroyPipeline(device, vkPipelineHandle, nullptr);
+        vkDestroyPipelineLayout(device, pipelineLayout, nullptr);
+        vkDestroyDescriptorSetLayout(device, descriptorSetLayout, nullptr);
+    });
+    if (setPipeline == handle) {
+        setPipeline = HandlePool<Pipeline>::NullHandle;
+    }
+    recordedPassesInvalid = true;
+    pipelines.Free(handle);
+    pipeline = nullptr;
+}
+
+void GraphicsAPI_Vulkan::BeginRendering() {
+}
+
+void GraphicsAPI_Vulkan::EndRendering() {
+    if (passMode != PassMode::NONE) {
+        EndRenderPass();
+    }
+    if (!frameActive) {
+        return;
+    }
+    FlushPendingClears();
+    // OpenXR requires the rendering to a swapchain image to be submitted before xrReleaseSwapchainImage().
+    if (commandBuffer) {
+        SubmitCommandBuffer(VK_NULL_HANDLE);
+    }
+}
+
+void GraphicsAPI_Vulkan::SetBufferData(void *buffer, size_t offset, size_t size, void *data) {
+    const Buffer *vkBuffer = buffers.Get(HandlePool<Buffer>::FromPointer(buffer));
+    if (!vkBuffer) {
+        DEBUG_BREAK;
+        std::cout << "ERROR: VULKAN: SetBufferData() called with an invalid or destroyed Buffer." << std::endl;
+        return;
+    }
+    if (!data) {
+        return;
+    }
+    if (offset + size > vkBuffer->bufferCI.size) {
+        DEBUG_BREAK;
+        std::cout << "ERROR: VULKAN: SetBufferData() called with a range outside the Buffer." << std::endl;
+        return;
+    }
+    frameStatistics.bytesUploaded += size;
+    if (!frameActive) {
+        ImmediateUpload(vkBuffer->buffer, offset, size, data);
+        return;
+    }
+    if (passMode != PassMode::NONE) {
+        DEBUG_BREAK;
+        std::cout << "ERROR: VULKAN: SetBufferData() cannot be called between SetRenderAttachments() and EndRendering()." << std::endl;
+        return;
+    }
+
+    // Stage the data in this frame's part of the staging buffer and copy it on the GPU, in order with the draws around it.
+    if (!stagingBuffer.mappedData && !CreateTransientBuffer(VK_BUFFER_USAGE_TRANSFER_SRC_BIT, 16, stagingBuffer)) {
+        return;
+    }
+    const size_t stagingOffset = Align<size_t>(stagingBuffer.offset, stagingBuffer.alignment);
+    if (stagingOffset + size > (frameInFlightIndex + 1) * transientBufferPartSize) {
+        DEBUG_BREAK;
+        std::cout << "ERROR: VULKAN: Staging Buffer is exhausted for this frame. Increase transientBufferPartSize." << std::endl;
+        return;
+    }
+    stagingBuffer.offset = stagingOffset + size;
+    memcpy(stagingBuffer.mappedData + stagingOffset, data, size);
+
+    VkCommandBuffer cmd = GetCommandBuffer();
+    const VkPipelineStageFlags readStages = VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+    const VkAccessFlags readAccess = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_INDEX_READ_BIT | VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_UNIFORM_READ_BIT | VK_ACCESS_SHADER_READ_BIT;
+    // Earlier draws must have finished reading, and earlier copies writing, before the copy overwrites the buffer.
+    VkMemoryBarrier beforeCopy{VK_STRUCTURE_TYPE_MEMORY_BARRIER};
+    beforeCopy.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    beforeCopy.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    vkCmdPipelineBarrier(cmd, readStages | VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &beforeCopy, 0, nullptr, 0, nullptr);
+    VkBufferCopy region{stagingOffset, offset, size};
+    vkCmdCopyBuffer(cmd, stagingBuffer.buffer, vkBuffer->buffer, 1, &region);
+    VkMemoryBarrier afterCopy{VK_STRUCTURE_TYPE_MEMORY_BARRIER};
+    afterCopy.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    afterCopy.dstAccessMask = readAccess;
+    vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, readStages, 0, 1, &afterCopy, 0, nullptr, 0, nullptr);
+}
+
+GraphicsAPI::TransientAllocation GraphicsAPI_Vulkan::AllocateTransientBuffer(BufferCreateInfo::Type type, size_t size) {
+    if ((size_t)type >= transientBuffers.size()) {
+        DEBUG_BREAK;
+        std::cout << "ERROR: VULKAN: Unknown Buffer Type." << std::endl;
+        return {};
+    }
+    TransientBuffer &transientBuffer = transientBuffers[(size_t)type];
+    if (!transientBuffer.mappedData) {
+        const VkPhysicalDeviceLimits &limits = physicalDeviceProperties.limits;
+        size_t alignment = 16;
+        if (type == BufferCreateInfo::Type::UNIFORM) {
+            alignment = std::max(alignment, (size_t)limits.minUniformBufferOffsetAlignment);
+        } else if (type == BufferCreateInfo::Type::STORAGE) {
+            alignment = std::max(alignment, (size_t)limits.minStorageBufferOffsetAlignment);
+        }
+        if (!CreateTransientBuffer(ToVkBufferUsage(type), alignment, transientBuffer)) {
+            return {};
+        }
+        BufferCreateInfo bufferCI{type, 0, transientBufferPartSize * framesInFlight, nullptr};
+        transientBuffer.handle = buffers.Allocate({transientBuffer.buffer, VK_NULL_HANDLE, bufferCI});
+    }
+
+    size_t offset = Align<size_t>(transientBuffer.offset, transientBuffer.alignment);
+    if (offset + size > (frameInFlightIndex + 1) * transientBufferPartSize) {
+        DEBUG_BREAK;
+        std::cout << "ERROR: VULKAN: Transient Buffer is exhausted for this frame. Increase transientBufferPartSize." << std::endl;
+        return {};
+    }
+    transientBuffer.offset = offset + size;
+    frameStatistics.transientBytesAllocated += size;
+
+    return {HandlePool<Buffer>::ToPointer(transientBuffer.handle), offset, size, transientBuffer.mappedData + offset};
+}
+
+bool GraphicsAPI_Vulkan::CreateTransientBuffer(VkBufferUsageFlags usage, size_t alignment, TransientBuffer &transientBuffer) {
+    VkBufferCreateInfo bufferCI{VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO};
+    bufferCI.size = transientBufferPartSize * framesInFlight;
+    bufferCI.usage = usage;
+    bufferCI.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    VkBuffer buffer = VK_NULL_HANDLE;
+    VULKAN_CHECK(vkCreateBuffer(device, &bufferCI, nullptr, &buffer), "Failed to create Transient Buffer.");
+
+    // Coherent and persistently mapped: writes through the pointer need no flush before the frame is submitted.
+    VkMemoryRequirements memoryRequirements{};
+    vkGetBufferMemoryRequirements(device, buffer, &memoryRequirements);
+    VkDeviceMemory memory = VK_NULL_HANDLE;
+    void *mappedData = nullptr;
+    if (AllocateMemory(memoryRequirements, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, 0, memory)) {
+        VULKAN_CHECK(vkBindBufferMemory(device, buffer, memory, 0), "Failed to bind Memory to Transient Buffer.");
+        VULKAN_CHECK(vkMapMemory(device, memory, 0, VK_WHOLE_SIZE, 0, &mappedData), "Failed to map Transient Buffer.");
+    }
+    if (!mappedData) {
+        DEBUG_BREAK;
+        std::cout << "ERROR: VULKAN: Failed to map Transient Buffer." << std::endl;
+        vkDestroyBuffer(device, buffer, nullptr);
+        vkFreeMemory(device, memory, nullptr);
+        return false;
+    }
+
+    transientBuffer.buffer = buffer;
+    transientBuffer.memory = memory;
+    transientBuffer.mappedData = reinterpret_cast<uint8_t *>(mappedData);
+    transientBuffer.alignment = alignment;
+    transientBuffer.offset = frameInFlightIndex * transientBufferPartSize;
+    return true;
+}
+
+void GraphicsAPI_Vulkan::DestroyTransientBuffer(TransientBuffer &transientBuffer) {
+    if (transientBuffer.buffer) {
+        vkUnmapMemory(device, transientBuffer.memory);
+        vkDestroyBuffer(device, transientBuffer.buffer, nullptr);
+        vkFreeMemory(device, transientBuffer.memory, nullptr);
+        buffers.Free(transientBuffer.handle);
+    }
+    transientBuffer = {};
+}
+
+void GraphicsAPI_Vulkan::ClearColor(void *imageView, float r, float g, float b, float a) {
+    VkClearValue clearValue{};
+    clearValue.color.float32[0] = r;
+    clearValue.color.float32[1] = g;
+    clearValue.color.float32[2] = b;
+    clearValue.color.float32[3] = a;
+    Clear(imageView, clearValue, "ClearColor()");
+}
+
+void GraphicsAPI_Vulkan::ClearDepth(void *imageView, float d) {
+    VkClearValue clearValue{};
+    clearValue.depthStencil = {d, 0};
+    Clear(imageView, clearValue, "ClearDepth()");
+}
+
+void GraphicsAPI_Vulkan::Clear(void *imageView, const VkClearValue &clearValue, const char *function) {
+    HandlePool<ImageView>::Handle handle = HandlePool<ImageView>::FromPointer(imageView);
+    const ImageView *vkImageView = imageViews.Get(handle);
+    if (!vkImageView) {
+        DEBUG_BREAK;
+        std::cout << "ERROR: VULKAN: " << function << " called with an invalid or destroyed ImageView." << std::endl;
+        return;
+    }
+
+    if (passMode == PassMode::NONE) {
+        for (PendingClear &pendingClear : pendingClears) {
+            if (pendingClear.imageView == handle) {
+                pendingClear.clearValue = clearValue;
+                return;
+            }
+        }
+        pendingClears.push_back({handle, clearValue});
+        return;
+    }
+
+    // Inside a render pass, the ImageView must be one of its attachments.
+    VkClearAttachment clearAttachment{};
+    clearAttachment.clearValue = clearValue;
+    if (passAttachments[maxColorAttachments] == handle) {
+        clearAttachment.aspectMask = GetDepthAspectFlags((VkFormat)vkImageView->imageViewCI.format);
+    } else {
+        size_t colorAttachment = 0;
+        while (colorAttachment < passColorAttachmentCount && passAttachments[colorAttachment] != handle) {
+            colorAttachment++;
+        }
+        if (colorAttachment == passColorAttachmentCount) {
+            DEBUG_BREAK;
+            std::cout << "ERROR: VULKAN: " << function << " called inside a render pass with an ImageView that is not one of its attachments." << std::endl;
+            return;
+        }
+        clearAttachment.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        clearAttachment.colorAttachment = (uint32_t)colorAttachment;
+    }
+    if (passMode == PassMode::RECORD) {
+        VkClearRect clearRect{{{0, 0}, passExtent}, 0, passLayers};
+        vkCmdClearAttachments(recordedPass->commandBuffer, 1, &clearAttachment, 1, &clearRect);
+    }
+}
+
+void GraphicsAPI_Vulkan::FlushPendingClears() {
+    // Each clear that no render pass picked up becomes a render pass of its own that only clears.
+    for (const PendingClear &pendingClear : pendingClears) {
+        const ImageView *vkImageView = imageViews.Get(pendingClear.imageView);
+        if (!vkImageView) {
+            continue;
+        }
+        if (vkImageView->extent.width == 0) {
+            DEBUG_BREAK;
+            std::cout << "ERROR: VULKAN: A swapchain ImageView can only be cleared once it has been passed to SetRenderAttachments()." << std::endl;
+            continue;
+        }
+        const Image *vkImage = images.Get(vkImageView->image);
+        const VkFormat format = (VkFormat)vkImageView->imageViewCI.format;
+        const bool depth = vkImageView->imageViewCI.aspect != ImageViewCreateInfo::Aspect::COLOR_BIT;
+        const uint32_t attachmentBit = depth ? 1u << maxColorAttachments : 1u;
+
+        RenderPassKey key{};
+        if (depth) {
+            key.depthFormat = format;
+        } else {
+            key.colorFormats[0] = format;
+            key.colorAttachmentCount = 1;
+        }
+        key.samples = vkImageView->samples;
+        key.generalLayoutMask = vkImage && vkImage->layout == VK_IMAGE_LAYOUT_GENERAL ? attachmentBit : 0;
+
+        Framebuffer framebufferKey{};
+        framebufferKey.renderPass = GetRenderPass(key);
+        framebufferKey.attachments[0] = vkImageView->imageView;
+        framebufferKey.attachmentCount = 1;
+        framebufferKey.width = vkImageView->extent.width;
+        framebufferKey.height = vkImageView->extent.height;
+        framebufferKey.layers = std::max(vkImageView->imageViewCI.layerCount, 1u);
+        key.clearMask = attachmentBit;
+
+        VkRenderPassBeginInfo renderPassBeginInfo{VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO};
+        renderPassBeginInfo.renderPass = GetRenderPass(key);
+        renderPassBeginInfo.framebuffer = GetFramebuffer(framebufferKey);
+        renderPassBeginInfo.renderArea = {{0, 0}, vkImageView->extent};
+        renderPassBeginInfo.clearValueCount = 1;
+        renderPassBeginInfo.pClearValues = &pendingClear.clearValue;
+        VkCommandBuffer cmd = GetCommandBuffer();
+        vkCmdBeginRenderPass(cmd, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
+        vkCmdEndRenderPass(cmd);
+    }
+    pendingClears.clear();
+}
+
+void GraphicsAPI_Vulkan::SetRenderAttachments(void **colorViews, size_t colorViewCount, void *depthStencilView, uint32_t width, uint32_t height, void *pipeline) {
+    if (!frameActive) {
+        DEBUG_BREAK;
+        std::cout << "ERROR: VULKAN: SetRenderAttachments() called outside BeginFrame() and EndFrame()." << std::endl;
+        return;
+    }
+    // As with binding another framebuffer in GL, end the current render pass and begin a new one.
+    if (passMode != PassMode::NONE) {
+        EndRenderPass();
+    }
+    if (colorViewCount > maxColorAttachments) {
+        DEBUG_BREAK;
+        std::cout << "ERROR: VULKAN: SetRenderAttachments() called with more than " << maxColorAttachments << " color ImageViews." << std::endl;
+        colorViewCount = maxColorAttachments;
+    }
+
+    RenderPassKey key{};
+    key.samples = VK_SAMPLE_COUNT_1_BIT;
+    Framebuffer framebufferKey{};
+    std::array<VkClearValue, maxColorAttachments + 1> clearValues{};
+    passAttachments = {};
+    passLayers = UINT32_MAX;
+    auto AddAttachment = [&](void *view, bool depth) {
+        HandlePool<ImageView>::Handle handle = HandlePool<ImageView>::FromPointer(view);
+        ImageView *vkImageView = imageViews.Get(handle);
+        if (!vkImageView) {
+            DEBUG_BREAK;
+            std::cout << "ERROR: VULKAN: SetRenderAttachments() called with an invalid or destroyed " << (depth ? "depth" : "color") << " ImageView." << std::endl;
+            return;
+        }
+        const Image *vkImage = images.Get(vkImageView->image);
+        const size_t attachmentIndex = framebufferKey.attachmentCount;
+        const uint32_t attachmentBit = depth ? 1u << maxColorAttachments : 1u << key.colorAttachmentCount;
+        if (depth) {
+            key.depthFormat = (VkFormat)vkImageView->imageViewCI.format;
+            passAttachments[maxColorAttachments] = handle;
+        } else {
+            passAttachments[key.colorAttachmentCount] = handle;
+            key.colorFormats[key.colorAttachmentCount++] = (VkFormat)vkImageView->imageViewCI.format;
+        }
+        key.samples = vkImageView->samples;
+        if (vkImage && vkImage->layout == VK_IMAGE_LAYOUT_GENERAL) {
+            key.generalLayoutMask |= attachmentBit;
+        }
+        // A clear pending for this ImageView becomes the attachment's load operation.
+        for (size_t i = 0; i < pendingClears.size(); i++) {
+            if (pendingClears[i].imageView == handle) {
+                key.clearMask |= attachmentBit;
+                clearValues[attachmentIndex] = pendingClears[i].clearValue;
+                pendingClears.erase(pendingClears.begin() + i);
+                break;
+            }
+        }
+        if (vkImageView->extent.width == 0) {
+            vkImageView->extent = {width, height};
+        }
+        framebufferKey.attachments[framebufferKey.attachmentCount++] = vkImageView->imageView;
+        passLayers = std::min(passLayers, std::max(vkImageView->imageViewCI.layerCount, 1u));
+    };
+    for (size_t i = 0; i < colorViewCount; i++) {
+        AddAttachment(colorViews[i], false);
+    }
+    passColorAttachmentCount = key.colorAttachmentCount;
+    if (depthStencilView) {
+        AddAttachment(depthStencilView, true);
+    }
+    if (framebufferKey.attachmentCount == 0) {
+        return;
+    }
+
+    RenderPassKey loadKey = key;
+    loadKey.clearMask = 0;
+    framebufferKey.renderPass = GetRenderPass(loadKey);
+    framebufferKey.width = width;
+    framebufferKey.height = height;
+    framebufferKey.layers = passLayers;
+    VkFramebuffer framebuffer = GetFramebuffer(framebufferKey);
+    passExtent = {width, height};
+
+    // Passes begun by a Submit() are cached; others are recorded each time.
+    if (recordedPassesInvalid) {
+        FlushRecordedPasses();
+    }
+    if (submitting) {
+        uint64_t recordedPassKey = HashFNV1a(&submitPassIndex, sizeof(submitPassIndex), submitHash);
+        recordedPassKey = HashFNV1a(&frameInFlightIndex, sizeof(frameInFlightIndex), recordedPassKey);
+        recordedPassKey = HashFNV1a(&framebufferKey.renderPass, sizeof(VkRenderPass), recordedPassKey);
+        submitPassIndex++;
+        BeginRecordedPass(recordedPassKey, framebufferKey.renderPass);
+    } else {
+        uncachedPass = {};
+        recordedPass = &uncachedPass;
+        BeginRecordedPass(0, framebufferKey.renderPass);
+    }
+
+    VkRenderPassBeginInfo renderPassBeginInfo{VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO};
+    renderPassBeginInfo.renderPass = GetRenderPass(key);
+    renderPassBeginInfo.framebuffer = framebuffer;
+    renderPassBeginInfo.renderArea = {{0, 0}, passExtent};
+    renderPassBeginInfo.clearValueCount = (uint32_t)framebufferKey.attachmentCount;
+    renderPassBeginInfo.pClearValues = clearValues.data();
+    vkCmdBeginRenderPass(GetCommandBuffer(), &renderPassBeginInfo, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+}
+
+void GraphicsAPI_Vulkan::BeginRecordedPass(uint64_t key, VkRenderPass renderPass) {
+    if (recordedPass != &uncachedPass) {
+        auto it = recordedPasses.find(key);
+        if (it != recordedPasses.end()) {
+            recordedPass = &it->second;
+        } else {
+            recordedPass = &recordedPasses[key];
+            *recordedPass = {};
+        }
+    }
+    // The queries of the pass's GPU zones are reset outside the render pass, before each execution.
+    if (recordedPass->recorded) {
+        passMode = PassMode::EXECUTE;
+    } else {
+        recordedPass->queryBlock = UINT32_MAX;
+        if (timestampMask && !freeRecordedPassQueryBlocks.empty()) {
+            recordedPass->queryBlock = freeRecordedPassQueryBlocks.back();
+            freeRecordedPassQueryBlocks.pop_back();
+        }
+        passMode = PassMode::RECORD;
+    }
+    if (recordedPass->queryBlock != UINT32_MAX) {
+        vkCmdResetQueryPool(GetCommandBuffer(), recordedPassQueryPool, recordedPass->queryBlock * maxGpuZonesPerPass * 2, maxGpuZonesPerPass * 2);
+    }
+    if (passMode == PassMode::EXECUTE) {
+        return;
+    }
+
+    VkCommandBufferAllocateInfo allocateInfo{VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO};
+    allocateInfo.commandPool = secondaryCommandPool;
+    allocateInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+    allocateInfo.commandBufferCount = 1;
+    VULKAN_CHECK(vkAllocateCommandBuffers(device, &allocateInfo, &recordedPass->commandBuffer), "Failed to allocate secondary CommandBuffer.");
+
+    // Any render pass compatible with 'renderPass' can execute it, and it may be pending in several frames at once.
+    VkCommandBufferInheritanceInfo inheritanceInfo{VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO};
+    inheritanceInfo.renderPass = renderPass;
+    inheritanceInfo.subpass = 0;
+    inheritanceInfo.framebuffer = VK_NULL_HANDLE;
+    VkCommandBufferBeginInfo beginInfo{VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO};
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT | VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT;
+    beginInfo.pInheritanceInfo = &inheritanceInfo;
+    VULKAN_CHECK(vkBeginCommandBuffer(recordedPass->commandBuffer, &beginInfo), "Failed to begin secondary CommandBuffer.");
+
+    // A secondary command buffer inherits no state.
+    dirtyState = DIRTY_ALL;
+}
+
+void GraphicsAPI_Vulkan::EndRenderPass() {
+    if (!openPassGpuZones.empty()) {
+        DEBUG_BREAK;
+        std::cout << "ERROR: VULKAN: " << openPassGpuZones.size() << " GPU zone(s) begun inside a render pass were not ended in it." << std::endl;
+        openPassGpuZones.clear();
+    }
+    if (passMode == PassMode::RECORD) {
+        VULKAN_CHECK(vkEndCommandBuffer(recordedPass->commandBuffer), "Failed to end secondary CommandBuffer.");
+        recordedPass->recorded = true;
+    }
+    VkCommandBuffer cmd = GetCommandBuffer();
+    vkCmdExecuteCommands(cmd, 1, &recordedPass->commandBuffer);
+    vkCmdEndRenderPass(cmd);
+
+    FrameResources &frame = frames[frameInFlightIndex];
+    for (const PassGpuZone &passGpuZone : recordedPass->gpuZones) {
+        frame.zoneQueries.push_back({passGpuZone.zoneIndex, recordedPassQueryPool, passGpuZone.beginQuery, passGpuZone.endQuery, passGpuZone.ended});
+    }
+    if (recordedPass == &uncachedPass) {
+        FreeRecordedPass(uncachedPass);
+        uncachedPass = {};
+    }
+    recordedPass = nullptr;
+    passMode = PassMode::NONE;
+    passAttachments = {};
+    passColorAttachmentCount = 0;
+}
+
+void GraphicsAPI_Vulkan::FreeRecordedPass(RecordedPass &recordedPassToFree) {
+    VkCommandBuffer secondaryCommandBuffer = recordedPassToFree.commandBuffer;
+    uint32_t queryBlock = recordedPassToFree.queryBlock;
+    if (!secondaryCommandBuffer) {
+        return;
+    }
+    DeferDestroy([this, secondaryCommandBuffer, queryBlock]() {
+        vkFreeCommandBuffers(device, secondaryCommandPool, 1, &secondaryCommandBuffer);
+        if (queryBlock != UINT32_MAX) {
+            freeRecordedPassQueryBlocks.push_back(queryBlock);
+        }
+    });
+}
+
+void GraphicsAPI_Vulkan::FlushRecordedPasses() {
+    for (auto &entry : recordedPasses) {
+        FreeRecordedPass(entry.second);
+    }
+    recordedPasses.clear();
+    for (VkDescriptorPool descriptorPool : descriptorPools) {
+        DeferDestroy([this, descriptorPool]() { vkDestroyDescriptorPool(device, descriptorPool, nullptr); });
+    }
+    descriptorPools.clear();
+    descriptorSets.clear();
+    recordedPassesInvalid = false;
+}
+
+VkRenderPass GraphicsAPI_Vulkan::GetRenderPass(const RenderPassKey &key) {
+    for (const RenderPass &renderPass : renderPasses) {
+        if (renderPass.key == key) {
+            return renderPass.renderPass;
+        }
+    }
+
+    // Attachments are stored, and rest in the same layout before and after the pass. A cleared attachment's old contents are
+    // not needed, so it starts from an undefined layout.
+    std::vector<VkAttachmentDescription> attachments;
+    std::vector<VkAttachmentReference> colorReferences;
+    VkAttachmentReference depthReference{};
+    for (size_t i = 0; i < key.colorAttachmentCount; i++) {
+        const bool clear = key.clearMask & (1u << i);
+        const VkImageLayout layout = key.generalLayoutMask & (1u << i) ? VK_IMAGE_LAYOUT_GENERAL : VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+        const VkAttachmentLoadOp loadOp = clear ? VK_ATTACHMENT_LOAD_OP_CLEAR : VK_ATTACHMENT_LOAD_OP_LOAD;
+        attachments.push_back({0, key.colorFormats[i], key.samples, loadOp, VK_ATTACHMENT_STORE_OP_STORE, VK_ATTACHMENT_LOAD_OP_DONT_CARE, VK_ATTACHMENT_STORE_OP_DONT_CARE, clear ? VK_IMAGE_LAYOUT_UNDEFINED : layout, layout});
+        colorReferences.push_back({(uint32_t)i, layout});
+    }
+    if (key.depthFormat != VK_FORMAT_UNDEFINED) {
+        const bool clear = key.clearMask & (1u << maxColorAttachments);
+        const VkImageLayout layout = key.generalLayoutMask & (1u << maxColorAttachments) ? VK_IMAGE_LAYOUT_GENERAL : VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+        const VkAttachmentLoadOp loadOp = clear ? VK_ATTACHMENT_LOAD_OP_CLEAR : VK_ATTACHMENT_LOAD_OP_LOAD;
+        const bool stencil = HasStencil(key.depthFormat);
+        attachments.push_back({0, key.depthFormat, key.samples, loadOp, VK_ATTACHMENT_STORE_OP_STORE, stencil ? loadOp : VK_ATTACHMENT_LOAD_OP_DONT_CARE, stencil ? VK_ATTACHMENT_STORE_OP_STORE : VK_ATTACHMENT_STORE_OP_DONT_CARE, clear ? VK_IMAGE_LAYOUT_UNDEFINED : layout, layout});
+        depthReference = {(uint32_t)attachments.size() - 1, layout};
+    }
+
+    VkSubpassDescription subpass{};
+    subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+    subpass.colorAttachmentCount = (uint32_t)colorReferences.size();
+    subpass.pColorAttachments = colorReferences.data();
+    subpass.pDepthStencilAttachment = key.depthFormat != VK_FORMAT_UNDEFINED ? &depthReference : nullptr;
+
+    // Order the pass after earlier passes and copies that used its attachments, and later reads and copies after the pass.
+    const VkPipelineStageFlags attachmentStages = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+    const VkAccessFlags attachmentWrites = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+    const VkAccessFlags attachmentAccess = attachmentWrites | VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT;
+    std::array<VkSubpassDependency, 2> dependencies{};
+    dependencies[0] = {VK_SUBPASS_EXTERNAL, 0, attachmentStages | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT, attachmentStages, attachmentWrites | VK_ACCESS_TRANSFER_WRITE_BIT, attachmentAccess, 0};
+    dependencies[1] = {0, VK_SUBPASS_EXTERNAL, attachmentStages, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT, attachmentWrites, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT, 0};
+
+    VkRenderPassCreateInfo renderPassCI{VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO};
+    renderPassCI.attachmentCount = (uint32_t)attachments.size();
+    renderPassCI.pAttachments = attachments.data();
+    renderPassCI.subpassCount = 1;
+    renderPassCI.pSubpasses = &subpass;
+    renderPassCI.dependencyCount = (uint32_t)dependencies.size();
+    renderPassCI.pDependencies = dependencies.data();
+    VkRenderPass renderPass = VK_NULL_HANDLE;
+    VULKAN_CHECK(vkCreateRenderPass(device, &renderPassCI, nullptr, &renderPass), "Failed to create RenderPass.");
+
+    renderPasses.push_back({key, renderPass});
+    return renderPass;
+}
+
+VkFramebuffer GraphicsAPI_Vulkan::GetFramebuffer(const Framebuffer &key) {
+    for (const Framebuffer &framebuffer : framebuffers) {
+        if (framebuffer.renderPass == key.renderPass && framebuffer.attachmentCount == key.attachmentCount && framebuffer.width == key.width && framebuffer.height == key.height && framebuffer.layers == key.layers && std::equal(key.attachments.begin(), key.attachments.begin() + key.attachmentCount, framebuffer.attachments.begin())) {
+            return framebuffer.framebuffer;
+        }
+    }
+
+    Framebuffer framebuffer = key;
+    VkFramebufferCreateInfo framebufferCI{VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO};
+    framebufferCI.renderPass = key.renderPass;
+    framebufferCI.attachmentCount = (uint32_t)key.attachmentCount;
+    framebufferCI.pAttachments = key.attachments.data();
+    framebufferCI.width = key.width;
+    framebufferCI.height = key.height;
+    framebufferCI.layers = key.layers;
+    VULKAN_CHECK(vkCreateFramebuffer(device, &framebufferCI, nullptr, &framebuffer.framebuffer), "Failed to create Framebuffer.");
+
+    framebuffers.push_back(framebuffer);
+    return framebuffer.framebuffer;
+}
+
+void GraphicsAPI_Vulkan::InvalidateFramebuffers(VkImageView imageView) {
+    for (size_t i = 0; i < framebuffers.size();) {
+        const Framebuffer &framebuffer = framebuffers[i];
+        if (std::find(framebuffer.attachments.begin(), framebuffer.attachments.begin() + framebuffer.attachmentCount, imageView) != framebuffer.attachments.begin() + framebuffer.attachmentCount) {
+            VkFramebuffer vkFramebuffer = framebuffer.framebuffer;
+            DeferDestroy([this, vkFramebuffer]() { vkDestroyFramebuffer(device, vkFramebuffer, nullptr); });
+            framebuffers.erase(framebuffers.begin() + i);
+        } else {
+            i++;
+        }
+    }
+}
+
+void GraphicsAPI_Vulkan::SetViewports(Viewport *viewports, size_t count) {
+    // Pipelines are created with a single viewport.
+    if (count > 1) {
+        DEBUG_BREAK;
+        std::cout << "ERROR: VULKAN: SetViewports() only supports one Viewport." << std::endl;
+        count = 1;
+    }
+    setViewports.clear();
+    for (size_t i = 0; i < count; i++) {
+        const Viewport &viewport = viewports[i];
+        setViewports.push_back({viewport.x, viewport.y, viewport.width, viewport.height, viewport.minDepth, viewport.maxDepth});
+    }
+    dirtyState |= DIRTY_VIEWPORTS;
+}
+
+void GraphicsAPI_Vulkan::SetScissors(Rect2D *scissors, size_t count) {
+    if (count > 1) {
+        DEBUG_BREAK;
+        std::cout << "ERROR: VULKAN: SetScissors() only supports one Rect2D." << std::endl;
+        count = 1;
+    }
+    setScissors.clear();
+    for (size_t i = 0; i < count; i++) {
+        const Rect2D &scissor = scissors[i];
+        setScissors.push_back({{scissor.offset.x, scissor.offset.y}, {scissor.extent.width, scissor.extent.height}});
+    }
+    dirtyState |= DIRTY_SCISSORS;
+}
+
+void GraphicsAPI_Vulkan::SetPipeline(void *pipeline) {
+    HandlePool<Pipeline>::Handle handle = HandlePool<Pipeline>::FromPointer(pipeline);
+    if (!pipelines.IsValid(handle)) {
+        DEBUG_BREAK;
+        std::cout << "ERROR: VULKAN: SetPipeline() called with an invalid or destroyed Pipeline." << std::endl;
+        return;
+    }
+    if (handle == setPipeline) {
+        frameStatistics.stateCallsSkipped++;
+        return;
+    }
+    frameStatistics.stateCallsIssued++;
+    setPipeline = handle;
+    // Vertex buffer offsets and the pipeline layout come from the pipeline.
+    dirtyState |= DIRTY_PIPELINE | DIRTY_DESCRIPTORS | DIRTY_VERTEX_BUFFERS;
+}
+
+void GraphicsAPI_Vulkan::SetDescriptor(const DescriptorInfo &descriptorInfo) {
+    if (descriptorInfo.bindingIndex >= setDescriptors.size()) {
+        setDescriptors.resize(descriptorInfo.bindingIndex + 1);
+    }
+    setDescriptors[descriptorInfo.bindingIndex] = descriptorInfo;
+}
+
+void GraphicsAPI_Vulkan::UpdateDescriptors() {
+    dirtyState |= DIRTY_DESCRIPTORS;
+}
+
+void GraphicsAPI_Vulkan::SetVertexBuffers(void **vertexBuffers, size_t count) {
+    if (count > maxVertexBindings) {
+        DEBUG_BREAK;
+        std::cout << "ERROR: VULKAN: SetVertexBuffers() called with more than " << maxVertexBindings << " Buffers." << std::endl;
+        count = maxVertexBindings;
+    }
+    for (size_t i = 0; i < count; i++) {
+        setVertexBuffers[i] = HandlePool<Buffer>::FromPointer(vertexBuffers[i]);
+    }
+    setVertexBufferCount = count;
+    dirtyState |= DIRTY_VERTEX_BUFFERS;
+}
+
+void GraphicsAPI_Vulkan::SetIndexBuffer(void *indexBuffer) {
+    setIndexBuffer = HandlePool<Buffer>::FromPointer(indexBuffer);
+    dirtyState |= DIRTY_INDEX_BUFFER;
+}
+
+uint64_t GraphicsAPI_Vulkan::HashSetState(uint64_t hash) const {
+    hash = HashFNV1a(&setPipeline, sizeof(setPipeline), hash);
+    for (const DescriptorInfo &descriptorInfo : setDescriptors) {
+        // Member by member, as DescriptorInfo has padding.
+        hash = HashFNV1a(&descriptorInfo.resource, sizeof(descriptorInfo.resource), hash);
+        hash = HashFNV1a(&descriptorInfo.bufferOffset, sizeof(descriptorInfo.bufferOffset), hash);
+        hash = HashFNV1a(&descriptorInfo.bufferSize, sizeof(descriptorInfo.bufferSize), hash);
+    }
+    hash = HashFNV1a(setViewports.data(), setViewports.size() * sizeof(VkViewport), hash);
+    hash = HashFNV1a(setScissors.data(), setScissors.size() * sizeof(VkRect2D), hash);
+    hash = HashFNV1a(setVertexBuffers.data(), setVertexBufferCount * sizeof(HandlePool<Buffer>::Handle), hash);
+    hash = HashFNV1a(&setIndexBuffer, sizeof(setIndexBuffer), hash);
+    return hash;
+}
+
+bool GraphicsAPI_Vulkan::FlushState(const char *function) {
+    if (passMode == PassMode::NONE) {
+        DEBUG_BREAK;
+        std::cout << "ERROR: VULKAN: " << function << " called outside SetRenderAttachments() and EndRendering()." << std::endl;
+        return false;
+    }
+    if (passMode == PassMode::EXECUTE) {
+        return false;
+    }
+    const Pipeline *vkPipeline = pipelines.Get(setPipeline);
+    if (!vkPipeline) {
+        DEBUG_BREAK;
+        std::cout << "ERROR: VULKAN: " << function << " called without a valid Pipeline set." << std::endl;
+        return false;
+    }
+
+    VkCommandBuffer cmd = recordedPass->commandBuffer;
+    if (dirtyState & DIRTY_PIPELINE) {
+        vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, vkPipeline->pipeline);
+    }
+    if ((dirtyState & DIRTY_VIEWPORTS) && !setViewports.empty()) {
+        vkCmdSetViewport(cmd, 0, (uint32_t)setViewports.size(), setViewports.data());
+    }
+    if ((dirtyState & DIRTY_SCISSORS) && !setScissors.empty()) {
+        vkCmdSetScissor(cmd, 0, (uint32_t)setScissors.size(), setScissors.data());
+    }
+    if ((dirtyState & DIRTY_DESCRIPTORS) && !vkPipeline->layout.empty()) {
+        std::array<uint32_t, maxDescriptorBindings> dynamicOffsets{};
+        uint32_t dynamicOffsetCount = 0;
+        VkDescriptorSet descriptorSet = GetDescriptorSet(*vkPipeline, dynamicOffsets, dynamicOffsetCount);
+        if (descriptorSet) {
+            vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, vkPipeline->pipelineLayout, 0, 1, &descriptorSet, dynamicOffsetCount, dynamicOffsets.data());
+        }
+    }
+    if ((dirtyState & DIRTY_VERTEX_BUFFERS) && setVertexBufferCount) {
+        const size_t count = std::min(setVertexBufferCount, vkPipeline->vertexBindingCount);
+        std::array<VkBuffer, maxVertexBindings> vkVertexBuffers{};
+        for (size_t i = 0; i < count; i++) {
+            const Buffer *vkVertexBuffer = buffers.Get(setVertexBuffers[i]);
+            if (!vkVertexBuffer) {
+                DEBUG_BREAK;
+                std::cout << "ERROR: VULKAN: SetVertexBuffers() called with an invalid or destroyed Buffer." << std::endl;
+                return false;
+            }
+            vkVertexBuffers[i] = vkVertexBuffer->buffer;
+        }
+        if (count) {
+            vkCmdBindVertexBuffers(cmd, 0, (uint32_t)count, vkVertexBuffers.data(), vkPipeline->vertexBindingOffsets.data());
+        }
+    }
+    if ((dirtyState & DIRTY_INDEX_BUFFER) && setIndexBuffer) {
+        const Buffer *vkIndexBuffer = buffers.Get(setIndexBuffer);
+        if (!vkIndexBuffer) {
+            DEBUG_BREAK;
+            std::cout << "ERROR: VULKAN: SetIndexBuffer() called with an invalid or destroyed Buffer." << std::endl;
+            return false;
+        }
+        vkCmdBindIndexBuffer(cmd, vkIndexBuffer->buffer, 0, vkIndexBuffer->bufferCI.stride == 4 ? VK_INDEX_TYPE_UINT32 : VK_INDEX_TYPE_UINT16);
+    }
+    dirtyState = 0;
+    return true;
+}
+
+VkDescriptorSet GraphicsAPI_Vulkan::GetDescriptorSet(const Pipeline &vkPipeline, std::array<uint32_t, maxDescriptorBindings> &dynamicOffsets, uint32_t &dynamicOffsetCount) {
+    // Resolve every binding of the layout. Buffers are dynamic, so their offsets are not part of the set; a binding with nothing
+    // set is left unwritten, which is fine as long as the shaders do not use it.
+    std::array<VkDescriptorBufferInfo, maxDescriptorBindings> bufferInfos{};
+    std::array<VkDescriptorImageInfo, maxDescriptorBindings> imageInfos{};
+    std::array<bool, maxDescriptorBindings> written{};
+    uint64_t key = HashFNV1a(&vkPipeline.descriptorSetLayout, sizeof(VkDescriptorSetLayout));
+    dynamicOffsetCount = 0;
+    for (size_t i = 0; i < vkPipeline.layout.size(); i++) {
+        const DescriptorInfo &binding = vkPipeline.layout[i];
+        const DescriptorInfo *descriptorInfo = binding.bindingIndex < setDescriptors.size() && setDescriptors[binding.bindingIndex].resource ? &setDescriptors[binding.bindingIndex] : nullptr;
+        if (binding.type == DescriptorInfo::Type::BUFFER) {
+            uint32_t dynamicOffset = 0;
+            if (descriptorInfo) {
+                if (const Buffer *vkBuffer = buffers.Get(HandlePool<Buffer>::FromPointer(descriptorInfo->resource))) {
+                    bufferInfos[i] = {vkBuffer->buffer, 0, descriptorInfo->bufferSize ? (VkDeviceSize)descriptorInfo->bufferSize : VK_WHOLE_SIZE};
+                    dynamicOffset = (uint32_t)descriptorInfo->bufferOffset;
+                    written[i] = true;
+                } else {
+                    DEBUG_BREAK;
+                    std::cout << "ERROR: VULKAN: SetDescriptor() called with an invalid or destroyed Buffer." << std::endl;
+                }
+            }
+            dynamicOffsets[dynamicOffsetCount++] = dynamicOffset;
+            key = HashFNV1a(&bufferInfos[i].buffer, sizeof(VkBuffer), key);
+            key = HashFNV1a(&bufferInfos[i].range, sizeof(VkDeviceSize), key);
+        } else if (binding.type == DescriptorInfo::Type::IMAGE) {
+            if (descriptorInfo) {
+                if (const Image *vkImage = images.Get(HandlePool<Image>::FromPointer(descriptorInfo->resource))) {
+                    imageInfos[i] = {VK_NULL_HANDLE, vkImage->sampledView, vkImage->layout};
+                    written[i] = true;
+                } else {
+                    DEBUG_BREAK;
+                    std::cout << "ERROR: VULKAN: SetDescriptor() called with an invalid or destroyed Image." << std::endl;
+                }
+            }
+            key = HashFNV1a(&imageInfos[i].imageView, sizeof(VkImageView), key);
+        } else if (binding.type == DescriptorInfo::Type::SAMPLER) {
+            if (descriptorInfo) {
+                if (const Sampler *vkSampler = samplers.Get(HandlePool<Sampler>::FromPointer(descriptorInfo->resource))) {
+                    imageInfos[i] = {vkSampler->sampler, VK_NULL_HANDLE, VK_IMAGE_LAYOUT_UNDEFINED};
+                    written[i] = true;
+                } else {
+                    DEBUG_BREAK;
+                    std::cout << "ERROR: VULKAN: SetDescriptor() called with an invalid or destroyed Sampler." << std::endl;
+                }
+            }
+            key = HashFNV1a(&imageInfos[i].sampler, sizeof(VkSampler), key);
+        }
+    }
+
+    auto it = descriptorSets.find(key);
+    if (it != descriptorSets.end()) {
+        return it->second.descriptorSet;
+    }
+
+    VkDescriptorPool pool = VK_NULL_HANDLE;
+    VkDescriptorSet descriptorSet = AllocateDescriptorSet(vkPipeline.descriptorSetLayout, pool);
+    if (!descriptorSet) {
+        return VK_NULL_HANDLE;
+    }
+    std::vector<VkWriteDescriptorSet> writes;
+    for (size_t i = 0; i < vkPipeline.layout.size(); i++) {
+        if (!written[i]) {
+            continue;
+        }
+        const DescriptorInfo &binding = vkPipeline.layout[i];
+        VkWriteDescriptorSet write{VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET};
+        write.dstSet = descriptorSet;
+        write.dstBinding = binding.bindingIndex;
+        write.descriptorCount = 1;
+        write.descriptorType = ToVkDescriptorType(binding);
+        if (binding.type == DescriptorInfo::Type::BUFFER) {
+            write.pBufferInfo = &bufferInfos[i];
+        } else {
+            write.pImageInfo = &imageInfos[i];
+        }
+        writes.push_back(write);
+    }
+    vkUpdateDescriptorSets(device, (uint32_t)writes.size(), writes.data(), 0, nullptr);
+
+    descriptorSets[key] = {descriptorSet, pool};
+    return descriptorSet;
+}
+
+VkDescriptorSet GraphicsAPI_Vulkan::AllocateDescriptorSet(VkDescriptorSetLayout descriptorSetLayout, VkDescriptorPool &pool) {
+    VkDescriptorSetAllocateInfo allocateInfo{VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO};
+    allocateInfo.descriptorSetCount = 1;
+    allocateInfo.pSetLayouts = &descriptorSetLayout;
+    VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+    if (!descriptorPools.empty()) {
+        allocateInfo.descriptorPool = descriptorPools.back();
+        if (vkAllocateDescriptorSets(device, &allocateInfo, &descriptorSet) == VK_SUCCESS) {
+            pool = descriptorPools.back();
+            return descriptorSet;
+        }
+    }
+
+    // The current pool is full, or there is none yet.
+    const uint32_t descriptorCount = descriptorSetsPerPool * 4;
+    const std::array<VkDescriptorPoolSize, 5> poolSizes = {{{VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, descriptorCount},
+                                                            {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, descriptorCount},
+                                                            {VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, descriptorCount},
+                                                            {VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, descriptorCount},
+                                                            {VK_DESCRIPTOR_TYPE_SAMPLER, descriptorCount}}};
+    VkDescriptorPoolCreateInfo descriptorPoolCI{VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO};
+    descriptorPoolCI.maxSets = descriptorSetsPerPool;
+    descriptorPoolCI.poolSizeCount = (uint32_t)poolSizes.size();
+    descriptorPoolCI.pPoolSizes = poolSizes.data();
+    VkDescriptorPool descriptorPool = VK_NULL_HANDLE;
+    VULKAN_CHECK(vkCreateDescriptorPool(device, &descriptorPoolCI, nullptr, &descriptorPool), "Failed to create DescriptorPool.");
+    if (!descriptorPool) {
+        return VK_NULL_HANDLE;
+    }
+    descriptorPools.push_back(descriptorPool);
+
+    allocateInfo.descriptorPool = descriptorPool;
+    VULKAN_CHECK(vkAllocateDescriptorSets(device, &allocateInfo, &descriptorSet), "Failed to allocate DescriptorSet.");
+    pool = descriptorPool;
+    return descriptorSet;
+}
+
+void GraphicsAPI_Vulkan::DrawIndexed(uint32_t indexCount, uint32_t instanceCount, uint32_t firstIndex, int32_t vertexOffset, uint32_t firstInstance) {
+    frameStatistics.drawCalls++;
+    if (FlushState("DrawIndexed()")) {
+        vkCmdDrawIndexed(recordedPass->commandBuffer, indexCount, instanceCount, firstIndex, vertexOffset, firstInstance);
+    }
+}
+
+void GraphicsAPI_Vulkan::Draw(uint32_t vertexCount, uint32_t instanceCount, uint32_t firstVertex, uint32_t firstInstance) {
+    frameStatistics.drawCalls++;
+    if (FlushState("Draw()")) {
+        vkCmdDraw(recordedPass->commandBuffer, vertexCount, instanceCount, firstVertex, firstInstance);
+    }
+}
+
+void GraphicsAPI_Vulkan::DrawIndexedIndirect(void *indirectBuffer, size_t offset) {
+    MultiDrawIndexedIndirect(indirectBuffer, offset, 1, sizeof(DrawIndexedIndirectCommand));
+}
+
+void GraphicsAPI_Vulkan::MultiDrawIndexedIndirect(void *indirectBuffer, size_t offset, uint32_t drawCount, uint32_t stride) {
+    frameStatistics.drawCalls += drawCount;
+    if (!FlushState("MultiDrawIndexedIndirect()")) {
+        return;
+    }
+    const Buffer *vkIndirectBuffer = buffers.Get(HandlePool<Buffer>::FromPointer(indirectBuffer));
+    if (!vkIndirectBuffer) {
+        DEBUG_BREAK;
+        std::cout << "ERROR: VULKAN: MultiDrawIndexedIndirect() called with an invalid or destroyed Buffer." << std::endl;
+        return;
+    }
+    if (vkIndirectBuffer->bufferCI.type != BufferCreateInfo::Type::INDIRECT) {
+        std::cout << "ERROR: VULKAN: Provided buffer is not type: INDIRECT." << std::endl;
+    }
+
+    VkCommandBuffer cmd = recordedPass->commandBuffer;
+    if (drawCount <= 1 || enabledFeatures.multiDrawIndirect) {
+        vkCmdDrawIndexedIndirect(cmd, vkIndirectBuffer->buffer, offset, drawCount, stride);
+    } else {
+        for (uint32_t i = 0; i < drawCount; i++) {
+            vkCmdDrawIndexedIndirect(cmd, vkIndirectBuffer->buffer, offset + (size_t)i * stride, 1, stride);
+        }
+    }
+}
+
+void GraphicsAPI_Vulkan::Submit(const CommandBuffer &commandBuffer) {
+    // The render passes recorded from this CommandBuffer also depend on the state set before it.
+    submitHash = HashSetState(commandBuffer.GetHash());
+    submitPassIndex = 0;
+    submitting = true;
+    GraphicsAPI::Submit(commandBuffer);
+    submitting = false;
+}
+
+// XR_DOCS_TAG_BEGIN_GraphicsAPI_Vulkan_GetSupportedSwapchainFormats
+const std::vector<int64_t> GraphicsAPI_Vulkan::GetSupportedColorSwapchainFormats() {
+    return {
+        VK_FORMAT_B8G8R8A8_SRGB,
+        VK_FORMAT_R8G8B8A8_SRGB,
+        VK_FORMAT_B8G8R8A8_UNORM,
+        VK_FORMAT_R8G8B8A8_UNORM};
+}
+const std::vector<int64_t> GraphicsAPI_Vulkan::GetSupportedDepthSwapchainFormats() {
+    return {
+        VK_FORMAT_D32_SFLOAT,
+        VK_FORMAT_D32_SFLOAT_S8_UINT,
+        VK_FORMAT_D24_UNORM_S8_UINT,
+        VK_FORMAT_D16_UNORM};
+}
+// XR_DOCS_TAG_END_GraphicsAPI_Vulkan_GetSupportedSwapchainFormats
+#endif
@@ -0,0 +1,410 @@
+// Copyright 2023, The Khronos Group Inc.
+//
+// SPDX-License-Identifier: MIT
+
+// OpenXR Tutorial for Khronos Group
+
+#pragma once
+#include <GraphicsAPI.h>
+#include <HandlePool.h>
+
+// C/C++ Headers
+#include <functional>
+
+#if defined(XR_USE_GRAPHICS_API_VULKAN)
+#define VULKAN_CHECK(x, y)                                                                         \
+    {                                                                                              \
+        VkResult result = (x);                                                                     \
+        if (result < VK_SUCCESS) {                                                                 \
+            std::cout << "ERROR: VULKAN: " << int(result) << " " << y << std::endl;                \
+            DEBUG_BREAK;                                                                           \
+        }                                                                                          \
+    }
+
+// A GraphicsAPI on Vulkan 1.0. Pipelines are real VkPipelines, descriptors are bound as cached descriptor sets with dynamic
+// offsets, and all synchronization is explicit: a fence per frame in flight, a subpass dependency per render pass and a barrier
+// around each upload.
+//
+// Every render pass is recorded into a secondary command buffer. When Submit() replays a CommandBuffer whose bytes hash the same
+// as one submitted framesInFlight frames earlier, its render passes execute the secondary command buffers recorded then instead
+// of recording new ones, so a static scene costs one vkCmdExecuteCommands() per pass. Each pass's primary command buffer is
+// submitted in EndRendering(), so the work is queued before the swapchain image is released.
+//
+// Without an XrInstance, any device that can render is accepted, including CPU implementations such as lavapipe, so the
+// backend can be exercised on machines without a GPU.
+class GraphicsAPI_Vulkan : public GraphicsAPI {
+public:
+    GraphicsAPI_Vulkan();
+    GraphicsAPI_Vulkan(XrInstance m_xrInstance, XrSystemId systemId);
+    ~GraphicsAPI_Vulkan();
+
+    // False if no device could be created, for example because the constructor without an XrInstance found no device with a
+    // graphics queue. Nothing else may be called on the GraphicsAPI then.
+    bool IsValid() const { return device != VK_NULL_HANDLE; }
+
+    virtual void* CreateDesktopSwapchain(const SwapchainCreateInfo& swapchainCI) override;
+    virtual void DestroyDesktopSwapchain(void*& swapchain) override;
+    virtual void* GetDesktopSwapchainImage(void* swapchain, uint32_t index) override;
+    virtual void AcquireDesktopSwapchanImage(void* swapchain, uint32_t& index) override;
+    virtual void PresentDesktopSwapchainImage(void* swapchain, uint32_t index) override;
+
+    // XR_DOCS_TAG_BEGIN_GetDepthFormat_Vulkan
+    virtual int64_t GetDepthFormat() override { return (int64_t)VK_FORMAT_D32_SFLOAT; }
+    // XR_DOCS_TAG_END_GetDepthFormat_Vulkan
+
+    virtual void* GetGraphicsBinding() override;
+    virtual XrSwapchainImageBaseHeader* AllocateSwapchainImageData(XrSwapchain swapchain, SwapchainType type, uint32_t count) override;
+    virtual void FreeSwapchainImageData(XrSwapchain swapchain) override;
+    virtual XrSwapchainImageBaseHeader* GetSwapchainImageData(XrSwapchain swapchain, uint32_t index) override;
+    virtual void* GetSwapchainImage(XrSwapchain swapchain, uint32_t index) override;
+
+    virtual void* CreateImage(const ImageCreateInfo& imageCI) override;
+    virtual void DestroyImage(void*& image) override;
+
+    virtual void* CreateImageView(const ImageViewCreateInfo& imageViewCI) override;
+    virtual void DestroyImageView(void*& imageView) override;
+
+    virtual void* CreateSampler(const SamplerCreateInfo& samplerCI) override;
+    virtual void DestroySampler(void*& sampler) override;
+
+    virtual void* CreateBuffer(const BufferCreateInfo& bufferCI) override;
+    virtual void DestroyBuffer(void*& buffer) override;
+
+    // Takes SPIR-V, not GLSL.
+    virtual void* CreateShader(const ShaderCreateInfo& shaderCI) override;
+    virtual void DestroyShader(void*& shader) override;
+
+    // A BUFFER in the layout is a dynamic uniform buffer, or a dynamic storage buffer if 'readWrite' is set; an IMAGE is a
+    // sampled image, or a storage image if 'readWrite' is set. All bindings are in descriptor set 0.
+    virtual void* CreatePipeline(const PipelineCreateInfo& pipelineCI) override;
+    virtual void DestroyPipeline(void*& pipeline) override;
+
+    virtual void BeginFrame() override;
+    virtual void EndFrame() override;
+
+    // Zones that begin inside a render pass must also end inside it. They are written into the pass's secondary command buffer,
+    // at most maxGpuZonesPerPass of them.
+    virtual void BeginGpuZone(const char* name) override;
+    virtual void EndGpuZone() override;
+    virtual std::vector<GpuZoneStatistics> GetGpuZoneStatistics() const override;
+    virtual float GetLatestGpuZoneMilliseconds(const char* name) const override;
+
+    virtual void BeginRendering() override;
+    virtual void EndRendering() override;
+
+    // Within a frame, the data is staged and copied on the GPU, so this must not be called between SetRenderAttachments() and
+    // EndRendering(). Outside a frame, it waits for the copy.
+    virtual void SetBufferData(void* buffer, size_t offset, size_t size, void* data) override;
+    virtual TransientAllocation AllocateTransientBuffer(BufferCreateInfo::Type type, size_t size) override;
+
+    // Outside a render pass, the clear is deferred and becomes the load operation of the next render pass that uses the
+    // ImageView. Clears that no render pass picks up are done in EndRendering() and EndFrame().
+    virtual void ClearColor(void* imageView, float r, float g, float b, float a) override;
+    virtual void ClearDepth(void* imageView, float d) override;
+
+    // Begins a render pass. Until EndRendering(), only state, clear, draw and GPU zone calls are allowed.
+    virtual void SetRenderAttachments(void** colorViews, size_t colorViewCount, void* depthStencilView, uint32_t width, uint32_t height, void* pipeline) override;
+    virtual void SetViewports(Viewport* viewports, size_t count) override;
+    virtual void SetScissors(Rect2D* scissors, size_t count) override;
+
+    virtual void SetPipeline(void* pipeline) override;
+    virtual void SetDescriptor(const DescriptorInfo& descriptorInfo) override;
+    virtual void UpdateDescriptors() override;
+    virtual void SetVertexBuffers(void** vertexBuffers, size_t count) override;
+    virtual void SetIndexBuffer(void* indexBuffer) override;
+    virtual void DrawIndexed(uint32_t indexCount, uint32_t instanceCount = 1, uint32_t firstIndex = 0, int32_t vertexOffset = 0, uint32_t firstInstance = 0) override;
+    virtual void Draw(uint32_t vertexCount, uint32_t instanceCount = 1, uint32_t firstVertex = 0, uint32_t firstInstance = 0) override;
+    virtual void DrawIndexedIndirect(void* indirectBuffer, size_t offset) override;
+    virtual void MultiDrawIndexedIndirect(void* indirectBuffer, size_t offset, uint32_t drawCount, uint32_t stride = sizeof(DrawIndexedIndirectCommand)) override;
+
+    virtual void Submit(const CommandBuffer& commandBuffer) override;
+
+private:
+    virtual const std::vector<int64_t> GetSupportedColorSwapchainFormats() override;
+    virtual const std::vector<int64_t> GetSupportedDepthSwapchainFormats() override;
+
+private:
+    void CreateInstance(const std::vector<std::string>& instanceExtensions);
+    uint32_t FindGraphicsQueueFamily(VkPhysicalDevice candidate) const;
+    void CreateDevice(const std::vector<std::string>& deviceExtensions);
+    bool AllocateMemory(const VkMemoryRequirements& memoryRequirements, VkMemoryPropertyFlags required, VkMemoryPropertyFlags preferred, VkDeviceMemory& memory);
+
+    // Records with 'record' into a one-time command buffer, submits it and waits for the queue. Only for work outside frames or
+    // at resource creation.
+    void ImmediateSubmit(const std::function<void(VkCommandBuffer)>& record);
+    void ImmediateUpload(VkBuffer buffer, size_t offset, size_t size, const void* data);
+
+    // Vulkan objects that the GPU may still be using are destroyed in BeginFrame(), once the fence of the current frame has
+    // signalled, framesInFlight frames later.
+    void DeferDestroy(std::function<void()> destroy);
+
+    // Resource metadata, stored in HandlePools. The void* handles returned by the Create*() functions are HandlePool handles.
+    struct Buffer {
+        VkBuffer buffer;
+        VkDeviceMemory memory;
+        BufferCreateInfo bufferCI;
+    };
+    // Between render passes, an image rests in the layout of its use: attachment optimal for an attachment, shader read only
+    // for a sampled image and general for an attachment that is also sampled. OpenXR swapchain images are handed over in the
+    // attachment optimal layout.
+    struct Image {
+        VkImage image;
+        VkDeviceMemory memory;
+        VkImageView sampledView;  // For IMAGE descriptors, if the image is sampled.
+        VkImageLayout layout;
+        bool owned;  // Swapchain images belong to the OpenXR runtime.
+        ImageCreateInfo imageCI;
+    };
+    static VkImageLayout GetRestingLayout(const ImageCreateInfo& imageCI);
+    struct ImageView {
+        VkImageView imageView;
+        HandlePool<Image>::Handle image;
+        VkSampleCountFlagBits samples;
+        VkExtent2D extent;  // From the image, or from the last SetRenderAttachments() for swapchain images.
+        ImageViewCreateInfo imageViewCI;
+    };
+    struct Sampler {
+        VkSampler sampler;
+    };
+    struct Shader {
+        VkShaderModule shaderModule;
+        ShaderCreateInfo::Type type;
+    };
+    static constexpr size_t maxVertexBindings = 16;
+    struct Pipeline {
+        VkPipeline pipeline;
+        VkPipelineLayout pipelineLayout;
+        VkDescriptorSetLayout descriptorSetLayout;
+        std::vector<DescriptorInfo> layout;  // Sorted by binding index, which is also the order of the dynamic offsets.
+        size_t vertexBindingCount;
+        std::array<VkDeviceSize, maxVertexBindings> vertexBindingOffsets;
+        PipelineCreateInfo pipelineCI;
+    };
+    struct Swapchain {
+        XrSwapchain swapchain;
+        SwapchainType type;
+        std::vector<XrSwapchainImageVulkanKHR> swapchainImages;
+        std::vector<HandlePool<Image>::Handle> images;
+    };
+    Swapchain* FindSwapchain(XrSwapchain swapchain);
+
+    // Render passes are keyed by their attachment formats and which attachments are cleared on load. Passes that only differ in
+    // their clears are compatible, so pipelines and framebuffers are created against the variant that loads everything.
+    static constexpr size_t maxColorAttachments = 8;
+    struct RenderPassKey {
+        std::array<VkFormat, maxColorAttachments> colorFormats;
+        size_t colorAttachmentCount;
+        VkFormat depthFormat;  // VK_FORMAT_UNDEFINED without a depth attachment.
+        VkSampleCountFlagBits samples;
+        // Bit i is for color attachment i and bit maxColorAttachments for the depth attachment.
+        uint32_t clearMask;
+        uint32_t generalLayoutMask;  // Attachments that rest in VK_IMAGE_LAYOUT_GENERAL.
+
+        bool operator==(const RenderPassKey& other) const {
+            return colorAttachmentCount == other.colorAttachmentCount && depthFormat == other.depthFormat && samples == other.samples && clearMask == other.clearMask && generalLayoutMask == other.generalLayoutMask && std::equal(colorFormats.begin(), colorFormats.begin() + colorAttachmentCount, other.colorFormats.begin());
+        }
+    };
+    struct RenderPass {
+        RenderPassKey key;
+        VkRenderPass renderPass;
+    };
+    VkRenderPass GetRenderPass(const RenderPassKey& key);
+
+    // Framebuffers built by SetRenderAttachments(), keyed by their image views and size. They are reused across frames and
+    // swapchain images, and destroyed when one of their image views is.
+    struct Framebuffer {
+        VkRenderPass renderPass;
+        std::array<VkImageView, maxColorAttachments + 1> attachments;
+        size_t attachmentCount;
+        uint32_t width;
+        uint32_t height;
+        uint32_t layers;
+        VkFramebuffer framebuffer;
+    };
+    VkFramebuffer GetFramebuffer(const Framebuffer& key);
+    void InvalidateFramebuffers(VkImageView imageView);
+
+    struct PendingClear {
+        HandlePool<ImageView>::Handle imageView;
+        VkClearValue clearValue;
+    };
+    void Clear(void* imageView, const VkClearValue& clearValue, const char* function);
+    void FlushPendingClears();
+
+    // Each frame in flight has its own command pool, fence, timestamp queries and deferred destructions. Primary command buffers
+    // are allocated as needed and reused once the pool is reset.
+    static constexpr size_t framesInFlight = 3;
+    static constexpr uint32_t gpuZoneQueriesPerFrame = 256;
+    struct GpuZoneQuery {
+        size_t zoneIndex;
+        VkQueryPool queryPool;
+        uint32_t beginQuery;
+        uint32_t endQuery;
+        bool ended;
+    };
+    struct FrameResources {
+        VkCommandPool commandPool;
+        std::vector<VkCommandBuffer> commandBuffers;
+        size_t usedCommandBufferCount;
+        VkFence fence;
+        bool fenceSubmitted;
+        VkQueryPool queryPool;
+        uint32_t usedQueryCount;
+        std::vector<GpuZoneQuery> zoneQueries;
+        std::vector<std::function<void()>> deferredDestroys;
+    };
+    VkCommandBuffer GetCommandBuffer();  // The current primary command buffer, begun on first use.
+    void SubmitCommandBuffer(VkFence fence);
+    void ReadGpuZoneQueries(FrameResources& frame);
+
+    // A render pass recorded into a secondary command buffer. Recorded passes are keyed by the hash of the submitted
+    // CommandBuffer and of the state set before it, the index of the pass within it and the frame in flight, as the transient
+    // buffer offsets recorded into it belong to that frame. GPU zones inside the pass write into a block of queries that belongs
+    // to the recorded pass, reset before each execution.
+    static constexpr uint32_t maxGpuZonesPerPass = 4;
+    static constexpr uint32_t recordedPassQueryBlockCount = 128;
+    static constexpr size_t maxRecordedPasses = 256;
+    static constexpr size_t maxCachedDescriptorSets = 1024;
+    struct PassGpuZone {
+        size_t zoneIndex;
+        uint32_t beginQuery;
+        uint32_t endQuery;
+        bool ended;
+    };
+    struct RecordedPass {
+        VkCommandBuffer commandBuffer;
+        bool recorded;
+        uint32_t queryBlock;  // UINT32_MAX if no block was free; the pass's GPU zones are then not measured.
+        std::vector<PassGpuZone> gpuZones;
+    };
+    enum class PassMode : uint8_t {
+        NONE,     // Outside a render pass.
+        RECORD,   // Recording the secondary command buffer.
+        EXECUTE,  // Executing a recorded secondary command buffer; secondary level commands are skipped.
+    };
+    void BeginRecordedPass(uint64_t key, VkRenderPass renderPass);
+    void EndRenderPass();
+    void FreeRecordedPass(RecordedPass& recordedPass);
+    void FlushRecordedPasses();
+
+    // State set outside the secondary command buffer, and bound into it lazily before each draw.
+    enum DirtyBits : uint32_t {
+        DIRTY_PIPELINE = 0x01,
+        DIRTY_DESCRIPTORS = 0x02,
+        DIRTY_VIEWPORTS = 0x04,
+        DIRTY_SCISSORS = 0x08,
+        DIRTY_VERTEX_BUFFERS = 0x10,
+        DIRTY_INDEX_BUFFER = 0x20,
+        DIRTY_ALL = 0x3F
+    };
+    uint64_t HashSetState(uint64_t hash) const;
+    // Returns whether a draw should be recorded: false outside a render pass, when executing a recorded pass, or on error.
+    bool FlushState(const char* function);
+
+    // Descriptor sets are cached by their layout and contents, and are bound with the offsets of their dynamic buffers. They
+    // are only dropped together with the recorded passes that may use them.
+    static constexpr size_t maxDescriptorBindings = 32;
+    static constexpr uint32_t descriptorSetsPerPool = 256;
+    VkDescriptorSet GetDescriptorSet(const Pipeline& vkPipeline, std::array<uint32_t, maxDescriptorBindings>& dynamicOffsets, uint32_t& dynamicOffsetCount);
+    VkDescriptorSet AllocateDescriptorSet(VkDescriptorSetLayout descriptorSetLayout, VkDescriptorPool& pool);
+
+    // Host visible and coherent, persistently mapped buffers for data written once per frame, one per BufferCreateInfo::Type
+    // and one to stage SetBufferData(). Each is split into framesInFlight parts, as in GraphicsAPI_OpenGL.
+    static constexpr size_t transientBufferPartSize = 4 * 1024 * 1024;
+    struct TransientBuffer {
+        VkBuffer buffer;
+        VkDeviceMemory memory;
+        HandlePool<Buffer>::Handle handle;  // Null for the staging buffer, which is never bound.
+        uint8_t* mappedData;
+        size_t alignment;
+        size_t offset;  // Next free byte in the current frame's part.
+    };
+    bool CreateTransientBuffer(VkBufferUsageFlags usage, size_t alignment, TransientBuffer& transientBuffer);
+    void DestroyTransientBuffer(TransientBuffer& transientBuffer);
+
+    static constexpr size_t gpuZoneHistorySize = 128;
+    struct GpuZone {
+        const char* name;
+        std::array<float, gpuZoneHistorySize> milliseconds;  // A ring of the most recent results.
+        size_t count;
+        size_t next;
+    };
+    size_t FindGpuZone(const char* name);
+
+private:
+    VkInstance instance = VK_NULL_HANDLE;
+    VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
+    VkPhysicalDeviceProperties physicalDeviceProperties{};
+    VkPhysicalDeviceFeatures enabledFeatures{};
+    VkPhysicalDeviceMemoryProperties memoryProperties{};
+    VkDevice device = VK_NULL_HANDLE;
+    uint32_t queueFamilyIndex = UINT32_MAX;
+    VkQueue queue = VK_NULL_HANDLE;
+    uint64_t timestampMask = 0;  // Zero if the queue does not support timestamps.
+
+    PFN_xrGetVulkanGraphicsRequirementsKHR xrGetVulkanGraphicsRequirementsKHR = nullptr;
+    PFN_xrGetVulkanInstanceExtensionsKHR xrGetVulkanInstanceExtensionsKHR = nullptr;
+    PFN_xrGetVulkanDeviceExtensionsKHR xrGetVulkanDeviceExtensionsKHR = nullptr;
+    PFN_xrGetVulkanGraphicsDeviceKHR xrGetVulkanGraphicsDeviceKHR = nullptr;
+    XrGraphicsBindingVulkanKHR graphicsBinding{};
+
+    // There are only ever a handful of swapchains, so these are searched linearly.
+    std::vector<Swapchain> swapchains{};
+
+    HandlePool<Buffer> buffers{};
+    HandlePool<Image> images{};
+    HandlePool<ImageView> imageViews{};
+    HandlePool<Sampler> samplers{};
+    HandlePool<Shader> shaders{};
+    HandlePool<Pipeline> pipelines{};
+
+    std::vector<RenderPass> renderPasses{};
+    std::vector<Framebuffer> framebuffers{};
+    std::vector<PendingClear> pendingClears{};
+    std::array<TransientBuffer, (size_t)BufferCreateInfo::Type::INDIRECT + 1> transientBuffers{};  // Indexed by BufferCreateInfo::Type.
+    TransientBuffer stagingBuffer{};
+
+    VkCommandPool immediateCommandPool = VK_NULL_HANDLE;
+    VkCommandPool secondaryCommandPool = VK_NULL_HANDLE;
+    std::array<FrameResources, framesInFlight> frames{};
+    size_t frameInFlightIndex = 0;
+    bool frameActive = false;
+    VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+
+    std::vector<GpuZone> gpuZones{};
+    std::vector<size_t> openGpuZoneQueries{};  // Indices into the current frame's zoneQueries, innermost last.
+    VkQueryPool recordedPassQueryPool = VK_NULL_HANDLE;
+    std::vector<uint32_t> freeRecordedPassQueryBlocks{};
+
+    std::unordered_map<uint64_t, RecordedPass> recordedPasses{};
+    RecordedPass uncachedPass{};  // For render passes begun outside Submit().
+    bool recordedPassesInvalid = false;
+    bool submitting = false;
+    uint64_t submitHash = 0;
+    uint32_t submitPassIndex = 0;
+
+    PassMode passMode = PassMode::NONE;
+    RecordedPass* recordedPass = nullptr;
+    std::array<HandlePool<ImageView>::Handle, maxColorAttachments + 1> passAttachments{};  // Color, then depth.
+    size_t passColorAttachmentCount = 0;
+    VkExtent2D passExtent{};
+    uint32_t passLayers = 1;
+    std::vector<size_t> openPassGpuZones{};  // Indices into the recorded pass's gpuZones, innermost last.
+
+    struct CachedDescriptorSet {
+        VkDescriptorSet descriptorSet;
+        VkDescriptorPool pool;
+    };
+    std::unordered_map<uint64_t, CachedDescriptorSet> descriptorSets{};
+    std::vector<VkDescriptorPool> descriptorPools{};
+
+    HandlePool<Pipeline>::Handle setPipeline = HandlePool<Pipeline>::NullHandle;
+    std::vector<DescriptorInfo> setDescriptors{};  // Indexed by binding index.
+    std::vector<VkViewport> setViewports{};
+    std::vector<VkRect2D> setScissors{};
+    std::array<HandlePool<Buffer>::Handle, maxVertexBindings> setVertexBuffers{};
+    size_t setVertexBufferCount = 0;
+    HandlePool<Buffer>::Handle setIndexBuffer = HandlePool<Buffer>::NullHandle;
+    uint32_t dirtyState = DIRTY_ALL;
+};
+#endif
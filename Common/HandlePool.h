@@ -0,0 +1,79 @@
+// Copyright 2023, The Khronos Group Inc.
+//
+// SPDX-License-Identifier: MIT
+
+// OpenXR Tutorial for Khronos Group
+
+#pragma once
+
+// C/C++ Headers
+#include <cstdint>
+#include <vector>
+
+// A dense slot array addressed by generational handles.
+// The values of a pool are stored contiguously, so looking one up is an index into an array rather than a hash. A handle
+// packs the slot index (plus one, so that a valid handle is never 0) into the low 32 bits and the slot's generation into the
+// high 32 bits. Freeing a slot bumps its generation, so a handle to a destroyed resource no longer resolves.
+template <typename T>
+class HandlePool {
+public:
+    typedef uint64_t Handle;
+    static constexpr Handle NullHandle = 0;
+
+    Handle Allocate(const T &value) {
+        uint32_t index = 0;
+        if (!freeIndices.empty()) {
+            index = freeIndices.back();
+            freeIndices.pop_back();
+            values[index] = value;
+        } else {
+            index = static_cast<uint32_t>(values.size());
+            values.push_back(value);
+            generations.push_back(0);
+        }
+        return MakeHandle(index, generations[index]);
+    }
+
+    // Returns false if the handle was stale or null.
+    bool Free(Handle handle) {
+        if (!IsValid(handle)) {
+            return false;
+        }
+        uint32_t index = GetIndex(handle);
+        values[index] = T{};
+        generations[index]++;
+        freeIndices.push_back(index);
+        return true;
+    }
+
+    bool IsValid(Handle handle) const {
+        uint32_t index = GetIndex(handle);
+        return handle != NullHandle && index < values.size() && generations[index] == GetGeneration(handle);
+    }
+
+    // Returns nullptr if the handle was stale or null. The pointer is invalidated by the next Allocate().
+    T *Get(Handle handle) { return IsValid(handle) ? &values[GetIndex(handle)] : nullptr; }
+    const T *Get(Handle handle) const { return IsValid(handle) ? &values[GetIndex(handle)] : nullptr; }
+
+    // Calls function(value) for every slot. Free slots hold a value-initialized T.
+    template <typename Function>
+    void ForEach(Function function) {
+        for (T &value : values) {
+            function(value);
+        }
+    }
+
+    // Handles are passed through the GraphicsAPI as void*.
+    static void *ToPointer(Handle handle) { return reinterpret_cast<void *>(static_cast<uintptr_t>(handle)); }
+    static Handle FromPointer(const void *pointer) { return static_cast<Handle>(reinterpret_cast<uintptr_t>(pointer)); }
+
+private:
+    static Handle MakeHandle(uint32_t index, uint32_t generation) { return (static_cast<Handle>(generation) << 32) | static_cast<Handle>(index + 1); }
+    static uint32_t GetIndex(Handle handle) { return static_cast<uint32_t>(handle & 0xFFFFFFFF) - 1; }
+    static uint32_t GetGeneration(Handle handle) { return static_cast<uint32_t>(handle >> 32); }
+
+private:
+    std::vector<T> values{};
+    std::vector<uint32_t> generations{};
+    std::vector<uint32_t> freeIndices{};
+};
@@ -8,6 +8,7 @@
 
 // C/C++ Headers
 #include <algorithm>
+#include <array>
 #include <cstring>
 #include <fstream>
 #include <iostream>
@@ -24,6 +25,12 @@
 #define DEBUG_BREAK raise(SIGTRAP)
 #endif
 
+// Directories
+#include <sys/stat.h>
+#if defined(_MSC_VER)
+#include <direct.h>
+#endif
+
 // XR_DOCS_TAG_BEGIN_Helper_Functions1
 inline bool IsStringInVector(std::vector<const char *> list, const char *name) {
     bool found = false;
@@ -46,6 +53,16 @@ T Align(T value, T alignment) {
     return (value + (alignment - 1)) & ~(alignment - 1);
 };
 
+// 64-bit FNV-1a. Pass a previous result as 'hash' to hash several pieces of data as one.
+inline uint64_t HashFNV1a(const void *data, size_t size, uint64_t hash = 0xcbf29ce484222325) {
+    const uint8_t *bytes = static_cast<const uint8_t *>(data);
+    for (size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 0x100000001b3;
+    }
+    return hash;
+}
+
 inline std::string GetEnv(const std::string &variable) {
     const char *value = std::getenv(variable.c_str());
     // It's invalid to assign nullptr to std::string
@@ -60,6 +77,23 @@ inline void SetEnv(const std::string &variable, const std::string &value) {
 #endif
 }
 
+// Creates the directory and any missing parents. Returns true if it exists afterwards.
+inline bool CreateDirectories(const std::string &path) {
+    for (size_t separator = path.find_first_of("/\\", 1); ; separator = path.find_first_of("/\\", separator + 1)) {
+        const std::string directory = path.substr(0, separator);
+#if defined(_MSC_VER)
+        _mkdir(directory.c_str());
+#else
+        mkdir(directory.c_str(), 0755);
+#endif
+        if (separator == std::string::npos) {
+            break;
+        }
+    }
+    struct stat info {};
+    return stat(path.c_str(), &info) == 0 && (info.st_mode & S_IFDIR) != 0;
+}
+
 inline std::string ReadTextFile(const std::string &filepath) {
     std::ifstream stream(filepath, std::fstream::in);
     std::string output;
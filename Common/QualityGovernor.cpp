@@ -0,0 +1,104 @@
+// Copyright 2023, The Khronos Group Inc.
+//
+// SPDX-License-Identifier: MIT
+
+// OpenXR Tutorial for Khronos Group
+
+#include <QualityGovernor.h>
+
+std::vector<QualityGovernor::Level> QualityGovernor::MakeDefaultLevels(uint32_t maxSampleCount, float maxResolutionScale) {
+    std::vector<Level> levels;
+    const float supersampledScale = std::min(maxResolutionScale, 1.2f);
+    if (supersampledScale > 1.05f) {
+        levels.push_back({supersampledScale, maxSampleCount >= 4 ? 4u : maxSampleCount >= 2 ? 2u : 1u});
+    }
+    if (maxSampleCount >= 4) {
+        levels.push_back({1.0f, 4});
+    }
+    if (maxSampleCount >= 2) {
+        levels.push_back({1.0f, 2});
+    }
+    levels.push_back({1.0f, 1});
+    for (float resolutionScale : {0.9f, 0.8f, 0.7f, 0.6f, 0.5f}) {
+        levels.push_back({resolutionScale, 1});
+    }
+    return levels;
+}
+
+const char *QualityGovernor::GetCauseName(Cause cause) {
+    switch (cause) {
+    case Cause::MISSED_FRAME:
+        return "missed frame";
+    case Cause::CPU_TIME:
+        return "CPU time over budget";
+    case Cause::GPU_TIME:
+        return "GPU time over budget";
+    case Cause::HEADROOM:
+        return "headroom";
+    default:
+        return "none";
+    }
+}
+
+QualityGovernor::QualityGovernor(const std::vector<Level> &levels, uint32_t initialLevel)
+    : levels(levels.empty() ? std::vector<Level>{{1.0f, 1}} : levels) {
+    levelIndex = std::min(initialLevel, static_cast<uint32_t>(this->levels.size() - 1));
+    lastChange = {levelIndex, levelIndex, Cause::NONE, 0.0f, 0.0f, 0.0f};
+}
+
+bool QualityGovernor::Update(const FrameTiming &timing) {
+    if (timing.periodMilliseconds <= 0.0f) {
+        return false;
+    }
+    // The timing still reflects the previous level until the new one's results arrive, so it is left out of the smoothed times.
+    if (++framesSinceChange <= settleFrames) {
+        return false;
+    }
+    cpuMilliseconds = cpuMilliseconds < 0.0f ? timing.cpuMilliseconds : cpuMilliseconds + smoothing * (timing.cpuMilliseconds - cpuMilliseconds);
+    if (timing.gpuMilliseconds >= 0.0f) {
+        gpuMilliseconds = gpuMilliseconds < 0.0f ? timing.gpuMilliseconds : gpuMilliseconds + smoothing * (timing.gpuMilliseconds - gpuMilliseconds);
+    }
+
+    const float budgetMilliseconds = budget * timing.periodMilliseconds;
+    const bool lowestLevel = levelIndex + 1 >= levels.size();
+    // A spike: react on this frame, without waiting for the smoothed times.
+    if (!lowestLevel && timing.missedPeriods > 0) {
+        ChangeLevel(levelIndex + 1, Cause::MISSED_FRAME, timing.periodMilliseconds);
+        return true;
+    }
+    const float frameMilliseconds = std::max(timing.cpuMilliseconds, timing.gpuMilliseconds);
+    const float smoothedMilliseconds = std::max(cpuMilliseconds, gpuMilliseconds);
+    if (frameMilliseconds > timing.periodMilliseconds || smoothedMilliseconds > budgetMilliseconds) {
+        framesWithHeadroom = 0;
+        if (frameMilliseconds > timing.periodMilliseconds || ++framesOverBudget >= overBudgetFrames) {
+            framesOverBudget = 0;
+            if (!lowestLevel) {
+                const bool gpuBound = timing.gpuMilliseconds >= timing.cpuMilliseconds || gpuMilliseconds >= cpuMilliseconds;
+                ChangeLevel(levelIndex + 1, gpuBound ? Cause::GPU_TIME : Cause::CPU_TIME, timing.periodMilliseconds);
+                return true;
+            }
+        }
+        return false;
+    }
+    framesOverBudget = 0;
+
+    if (levelIndex > 0 && smoothedMilliseconds < headroom * timing.periodMilliseconds) {
+        if (++framesWithHeadroom >= headroomFrames) {
+            ChangeLevel(levelIndex - 1, Cause::HEADROOM, timing.periodMilliseconds);
+            return true;
+        }
+    } else {
+        framesWithHeadroom = 0;
+    }
+    return false;
+}
+
+void QualityGovernor::ChangeLevel(uint32_t toLevel, Cause cause, float periodMilliseconds) {
+    lastChange = {levelIndex, toLevel, cause, cpuMilliseconds, gpuMilliseconds, periodMilliseconds};
+    levelIndex = toLevel;
+    cpuMilliseconds = -1.0f;
+    gpuMilliseconds = -1.0f;
+    framesOverBudget = 0;
+    framesWithHeadroom = 0;
+    framesSinceChange = 0;
+}
@@ -0,0 +1,86 @@
+// Copyright 2023, The Khronos Group Inc.
+//
+// SPDX-License-Identifier: MIT
+
+// OpenXR Tutorial for Khronos Group
+
+#pragma once
+#include <GraphicsAPI.h>
+
+// Picks a quality level each frame from the frame's timing, to hold the runtime's frame rate under load rather than miss display
+// periods. The levels go from the highest quality to the lowest. The governor steps down a level as soon as a frame misses a
+// display period or takes longer than the period, and after a few frames whose smoothed time is over the budget. It only steps
+// back up after many frames with plenty of headroom, and waits for the timing of the new level to arrive between changes, so that
+// it does not oscillate between two levels.
+class QualityGovernor {
+public:
+    struct Level {
+        float resolutionScale;  // Of the recommended image width and height. Above 1 supersamples, within the swapchain's maximum.
+        uint32_t sampleCount;
+    };
+
+    struct FrameTiming {
+        float cpuMilliseconds;     // Of the render thread's work for the frame.
+        float gpuMilliseconds;     // Negative if unknown. May lag the CPU time by a few frames.
+        float periodMilliseconds;  // XrFrameState::predictedDisplayPeriod.
+        uint32_t missedPeriods;    // Display periods skipped since the previous frame, from the XrFrameState cadence.
+    };
+
+    enum class Cause : uint8_t {
+        NONE,
+        MISSED_FRAME,  // The runtime's cadence skipped a display period.
+        CPU_TIME,      // The CPU time was over budget, and over the GPU time.
+        GPU_TIME,      // The GPU time was over budget.
+        HEADROOM       // Both times were well under budget for long enough to step up.
+    };
+
+    struct Change {
+        uint32_t fromLevel;
+        uint32_t toLevel;
+        Cause cause;
+        float cpuMilliseconds;  // Smoothed, when the change was made.
+        float gpuMilliseconds;
+        float periodMilliseconds;
+    };
+
+    // A ladder that first drops supersampling and MSAA, which cost little to notice, then lowers the resolution, down to half of
+    // the recommended one. maxSampleCount is the highest sample count the renderer supports; 1 leaves MSAA out. maxResolutionScale
+    // is the largest the swapchains allow; 1 leaves supersampling out.
+    static std::vector<Level> MakeDefaultLevels(uint32_t maxSampleCount, float maxResolutionScale);
+    static const char* GetCauseName(Cause cause);
+
+public:
+    QualityGovernor(const std::vector<Level>& levels, uint32_t initialLevel = 0);
+
+    // Returns true if the level changed, in which case GetLastChange() says why.
+    bool Update(const FrameTiming& timing);
+
+    uint32_t GetLevelIndex() const { return levelIndex; }
+    const Level& GetLevel() const { return levels[levelIndex]; }
+    size_t GetLevelCount() const { return levels.size(); }
+    const Change& GetLastChange() const { return lastChange; }
+
+private:
+    void ChangeLevel(uint32_t toLevel, Cause cause, float periodMilliseconds);
+
+    // The fraction of the display period a frame is budgeted, leaving the rest for the compositor and variance.
+    static constexpr float budget = 0.9f;
+    // Smoothed times under this fraction of the period count as headroom.
+    static constexpr float headroom = 0.7f;
+    // Consecutive frames over budget before stepping down, and with headroom before stepping up.
+    static constexpr uint32_t overBudgetFrames = 3;
+    static constexpr uint32_t headroomFrames = 90;
+    // Frames after a change during which the timing still reflects the previous level.
+    static constexpr uint32_t settleFrames = 4;
+    // Weight of the newest frame in the smoothed times.
+    static constexpr float smoothing = 0.2f;
+
+    std::vector<Level> levels;
+    uint32_t levelIndex = 0;
+    float cpuMilliseconds = -1.0f;  // Smoothed since the last change; negative until the first frame after it settles.
+    float gpuMilliseconds = -1.0f;
+    uint32_t framesOverBudget = 0;
+    uint32_t framesWithHeadroom = 0;
+    uint32_t framesSinceChange = 0;
+    Change lastChange{};
+};
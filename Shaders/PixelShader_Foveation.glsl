@@ -0,0 +1,23 @@
+#version 450
+// Upsamples the reduced resolution periphery into the image, around the full resolution inset, which is drawn separately.
+// gl_FragCoord and the periphery's texture coordinates share the framebuffer origin of the graphics API, so no flip is needed.
+#if defined(VULKAN)
+layout(binding = 0) uniform texture2D u_Periphery;
+layout(binding = 1) uniform sampler u_Sampler;
+#define PERIPHERY sampler2D(u_Periphery, u_Sampler)
+#else
+layout(binding = 0) uniform sampler2D u_Periphery;
+#define PERIPHERY u_Periphery
+#endif
+layout(location = 0) out vec4 o_Color;
+layout(std140, binding = 2) uniform Foveation {
+    vec4 insetRect;     // Min x, min y, max x, max y, in pixels.
+    vec4 rcpImageSize;  // 1 / width, 1 / height.
+};
+void main() {
+    vec2 pixel = gl_FragCoord.xy;
+    if (all(greaterThanEqual(pixel, insetRect.xy)) && all(lessThan(pixel, insetRect.zw))) {
+        discard;
+    }
+    o_Color = texture(PERIPHERY, pixel * rcpImageSize.xy);
+}
@@ -0,0 +1,20 @@
+#version 450
+// Resolves a multisampled image into the view's image by averaging the samples of each pixel.
+#if defined(VULKAN)
+layout(binding = 0) uniform texture2DMS u_Color;
+layout(binding = 1) uniform sampler u_Sampler;
+#define COLOR sampler2DMS(u_Color, u_Sampler)
+#else
+layout(binding = 0) uniform sampler2DMS u_Color;
+#define COLOR u_Color
+#endif
+layout(location = 0) out vec4 o_Color;
+void main() {
+    ivec2 pixel = ivec2(gl_FragCoord.xy);
+    int sampleCount = textureSamples(COLOR);
+    vec4 color = vec4(0.0);
+    for (int i = 0; i < sampleCount; i++) {
+        color += texelFetch(COLOR, pixel, i);
+    }
+    o_Color = color / float(sampleCount);
+}
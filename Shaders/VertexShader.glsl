@@ -1,25 +1,42 @@
 #version 450
 #extension GL_KHR_vulkan_glsl : enable
+#if defined(MULTIVIEW)
+#extension GL_OVR_multiview2 : require
+layout(num_views = 2) in;
+#define VIEW_INDEX gl_ViewID_OVR
+#else
+#define VIEW_INDEX 0
+#endif
+// glslangValidator defines VULKAN when compiling to SPIR-V for the Vulkan backend.
+#if defined(VULKAN)
+#define VERTEX_INDEX gl_VertexIndex
+#define INSTANCE_INDEX gl_InstanceIndex
+#else
+#define VERTEX_INDEX gl_VertexID
+#define INSTANCE_INDEX gl_InstanceID
+#endif
 layout(std140, binding = 0) uniform CameraConstants {
-    mat4 viewProj;
-    mat4 modelViewProj;
-    mat4 model;
-    vec4 color;
-    vec4 pad1;
-    vec4 pad2;
-    vec4 pad3;
+    mat4 viewProj[2];
 };
 layout(std140, binding = 1) uniform Normals {
     vec4 normals[6];
 };
+// Per object: the top three rows of the affine model transform, as the columns of a mat3x4, and the color packed as RGBA8.
+layout(std430, binding = 3) readonly buffer CuboidModels {
+    mat3x4 models[];
+};
+layout(std430, binding = 4) readonly buffer CuboidColors {
+    uint colors[];
+};
 layout(location = 0) in vec4 a_Positions;
 layout(location = 0) out flat uvec2 o_TexCoord;
 layout(location = 1) out flat vec3 o_Normal;
 layout(location = 2) out flat vec3 o_Color;
 void main() {
-    gl_Position = modelViewProj * a_Positions;
-    int face = gl_VertexID / 6;
+    mat3x4 model = models[INSTANCE_INDEX];
+    gl_Position = viewProj[VIEW_INDEX] * vec4(a_Positions * model, 1.0);
+    int face = VERTEX_INDEX / 6;
     o_TexCoord = uvec2(face, 0);
-    o_Normal = (model * normals[face]).xyz;
-    o_Color = color.rgb;
-}
\ No newline at end of file
+    o_Normal = normals[face] * model;
+    o_Color = unpackUnorm4x8(colors[INSTANCE_INDEX]).rgb;
+}
@@ -0,0 +1,12 @@
+#version 450
+#extension GL_KHR_vulkan_glsl : enable
+#if defined(VULKAN)
+#define VERTEX_INDEX gl_VertexIndex
+#else
+#define VERTEX_INDEX gl_VertexID
+#endif
+// One triangle covering the whole viewport, without a vertex buffer.
+void main() {
+    vec2 position = vec2(float((VERTEX_INDEX << 1) & 2), float(VERTEX_INDEX & 2));
+    gl_Position = vec4(position * 2.0 - 1.0, 0.0, 1.0);
+}
@@ -1,6 +1,24 @@
+#include <BoundedQueue.h>
+#include <CommandBuffer.h>
 #include <DebugOutput.h>
+#include <DrawQueue.h>
+#include <Foveation.h>
+#include <FrameGraph.h>
+#include <GraphicsAPI_Null.h>
 #include <GraphicsAPI_OpenGL.h>
+#include <GraphicsAPI_Vulkan.h>
 #include <OpenXRDebugUtils.h>
+#include <QualityGovernor.h>
+
+#include <atomic>
+#include <cctype>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <limits>
+#include <thread>
 
 #include <steam/steam_api.h>
 
@@ -17,6 +35,14 @@ XrVector3f operator*(XrVector3f a, float b) {
 class OpenXRTutorial {
 private:
   struct RenderLayerInfo;
+  struct FrameData;
+  struct FoveationStatistics;
+  // Groups a pass's draws by pipeline in their DrawQueue sort keys.
+  enum class PipelineId : uint32_t {
+    CUBOIDS,
+    FOVEATION,
+    RESOLVE
+  };
 
 public:
   OpenXRTutorial(GraphicsAPI_Type apiType)
@@ -28,6 +54,15 @@ public:
   }
   ~OpenXRTutorial() = default;
 
+  // Renders each view's periphery at a reduced resolution around a full resolution inset, which follows the lens center or, with
+  // EYE_TRACKED, the gaze. A non-empty gazeScript replaces the eye tracker: yaw and pitch in degrees from the head's forward
+  // direction, one sample per frame, looped. Call before Run() or RunBenchmark().
+  void SetFoveation(Foveation::Mode mode, const std::vector<XrVector2f> &gazeScript) {
+    m_foveationMode = mode;
+    m_gazeScript = gazeScript;
+    m_scriptedGaze = !gazeScript.empty();
+  }
+
   // void OverrideAuthenticationForDevelopment() {
   //   uint32_t YourDevSteamID = ;
 
@@ -69,20 +104,24 @@ public:
 
     CreateSession();
     CreateReferenceSpace();
+    CreateGazeActions();
     CreateSwapchains();
     CreateResources();
 
     while (m_applicationRunning) {
       PollSystemEvents();
       PollEvents();
-      if (m_sessionRunning) {
-        // Draw Frame.
-        RenderFrame();
+      if (m_sessionRunning && !m_framePipelineRunning) {
+        // Draw Frames on the pipeline threads until the session stops.
+        StartFramePipeline();
       }
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
     }
+    StopFramePipeline();
 
     DestroyResources();
     DestroySwapchains();
+    DestroyGazeActions();
     DestroyReferenceSpace();
     DestroySession();
 
@@ -92,6 +131,127 @@ public:
     // SteamAPI_Shutdown();
   }
 
+  // Simulates, records and submits frameCount frames on GraphicsAPI_Null, without OpenXR or a GPU, and prints the CPU time
+  // per frame with the commands, state changes and bytes uploaded. Use it to catch CPU regressions in the renderer on machines
+  // without a headset or display. With 'render', the frames are really rendered, still without OpenXR or a window: on
+  // GraphicsAPI_Vulkan on whichever device it finds for VULKAN, which may be lavapipe, and on a surfaceless GraphicsAPI_OpenGL
+  // context for OPENGL, which may be llvmpipe. Returns false if the API to render on could not be set up.
+  bool RunBenchmark(uint32_t frameCount, bool render) {
+    if (render && m_apiType == VULKAN) {
+#if defined(XR_USE_GRAPHICS_API_VULKAN)
+      std::unique_ptr<GraphicsAPI_Vulkan> graphicsAPI = std::make_unique<GraphicsAPI_Vulkan>();
+      if (!graphicsAPI->IsValid()) {
+        std::cout << "ERROR: The benchmark was asked for Vulkan, but no Vulkan device could be created." << std::endl;
+        return false;
+      }
+      m_graphicsAPI = std::move(graphicsAPI);
+      m_benchmarkColorFormat = VK_FORMAT_R8G8B8A8_UNORM;
+#else
+      std::cout << "ERROR: The benchmark was asked for Vulkan, but this build has no Vulkan support." << std::endl;
+      return false;
+#endif
+    } else if (render && m_apiType == OPENGL) {
+#if defined(XR_TUTORIAL_USE_OPENGL_SURFACELESS)
+      std::unique_ptr<GraphicsAPI_OpenGL> graphicsAPI = std::make_unique<GraphicsAPI_OpenGL>(GraphicsAPI_OpenGL::Context::SURFACELESS);
+      if (!graphicsAPI->IsValid()) {
+        std::cout << "ERROR: The benchmark was asked for OpenGL, but no surfaceless OpenGL context could be created." << std::endl;
+        return false;
+      }
+      m_graphicsAPI = std::move(graphicsAPI);
+      m_benchmarkColorFormat = GL_RGBA8;
+#else
+      std::cout << "ERROR: The benchmark was asked for OpenGL, but this build has no surfaceless OpenGL context support." << std::endl;
+      return false;
+#endif
+    } else {
+      m_graphicsAPI = std::make_unique<GraphicsAPI_Null>();
+      m_benchmarkColorFormat = GraphicsAPI_Null::COLOR_FORMAT;
+    }
+
+    // Stand in for a stereo headset: two views with a typical per eye resolution, rendered at 90 Hz.
+    XrViewConfigurationView viewConfigurationView{XR_TYPE_VIEW_CONFIGURATION_VIEW};
+    viewConfigurationView.recommendedImageRectWidth = 1832;
+    viewConfigurationView.recommendedImageRectHeight = 1920;
+    viewConfigurationView.maxImageRectWidth = 2560;
+    viewConfigurationView.maxImageRectHeight = 2688;
+    viewConfigurationView.recommendedSwapchainSampleCount = 1;
+    m_viewConfigurationViews.assign(2, viewConfigurationView);
+    m_environmentBlendMode = XR_ENVIRONMENT_BLEND_MODE_OPAQUE;
+    const XrDuration predictedDisplayPeriod = 1000000000 / 90;
+    // There is no eye tracker, so eye-tracked foveation follows the gaze script, or a built-in sweep without one.
+    m_scriptedGaze = m_foveationMode == Foveation::Mode::EYE_TRACKED;
+
+    CreateBenchmarkImages();
+    CreateResources();
+
+    std::vector<void *> colorViews, depthViews;
+    for (size_t i = 0; i < m_colorSwapchainInfos.size(); i++) {
+      colorViews.push_back(m_colorSwapchainInfos[i].imageViews[0]);
+      depthViews.push_back(m_depthSwapchainInfos[i].imageViews[0]);
+    }
+
+    FrameData &frame = m_frames[0];
+    double totalMilliseconds = 0.0;
+    uint64_t totalFullPixels = 0;
+    uint64_t totalShadedPixels = 0;
+    for (uint32_t frameIndex = 0; frameIndex < frameCount; frameIndex++) {
+      frame.frameState.predictedDisplayTime = frameIndex * predictedDisplayPeriod;
+      frame.frameState.predictedDisplayPeriod = predictedDisplayPeriod;
+
+      const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+      // The views are at the origin, 64 mm apart and looking down -Z.
+      frame.views.assign(m_viewConfigurationViews.size(), {XR_TYPE_VIEW});
+      for (size_t i = 0; i < frame.views.size(); i++) {
+        frame.views[i].pose = {{0.0f, 0.0f, 0.0f, 1.0f}, {(i == 0 ? -0.032f : 0.032f), 0.0f, 0.0f}};
+        frame.views[i].fov = {-0.785f, 0.785f, 0.785f, -0.785f};
+      }
+      LocateGaze(frame, frameIndex);
+      BuildScene(frame);
+
+      m_graphicsAPI->BeginFrame();
+      m_drawQueue.ResetStatistics();
+      UploadMaterial();
+      UploadCuboidInstances(frame);
+      RecordPasses(m_commandBuffer, frame, colorViews, depthViews);
+      WriteCameraConstants(frame.views);
+      m_graphicsAPI->Submit(m_commandBuffer);
+      m_graphicsAPI->EndFrame();
+      totalFullPixels += m_foveationStatistics.fullPixels;
+      totalShadedPixels += m_foveationStatistics.shadedPixels;
+
+      totalMilliseconds += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    const GraphicsAPI::FrameStatistics &frameStatistics = m_graphicsAPI->GetFrameStatistics();
+    std::cout << "Benchmark: " << frameCount << " frames, " << (frameCount ? totalMilliseconds / frameCount : 0.0) << " ms CPU per frame." << std::endl;
+    std::cout << "  Per frame: " << frameStatistics.commandsIssued << " commands, " << frameStatistics.drawCalls << " draw calls, ";
+    std::cout << "state calls issued: " << frameStatistics.stateCallsIssued << ", skipped: " << frameStatistics.stateCallsSkipped << ", ";
+    std::cout << "binds issued: " << frameStatistics.bindsIssued << " in " << frameStatistics.bindCalls << " calls, elided: " << frameStatistics.bindsElided << ", ";
+    std::cout << "bytes uploaded: " << frameStatistics.bytesUploaded << ", transient bytes: " << frameStatistics.transientBytesAllocated << std::endl;
+    for (const GraphicsAPI::GpuZoneStatistics &gpuZone : m_graphicsAPI->GetGpuZoneStatistics()) {
+      std::cout << "  GPU " << gpuZone.name << ": average " << gpuZone.averageMilliseconds << " ms, ";
+      std::cout << "p50 " << gpuZone.p50Milliseconds << " ms, p90 " << gpuZone.p90Milliseconds << " ms, p99 " << gpuZone.p99Milliseconds << " ms ";
+      std::cout << "(" << gpuZone.sampleCount << " samples)" << std::endl;
+    }
+    LogDrawQueueStatistics();
+    std::cout << "  Quality: ";
+    LogQualityLevel(m_qualityLevel);
+    std::cout << std::endl;
+    if (frameCount) {
+      LogFoveationStatistics({totalFullPixels / frameCount, totalShadedPixels / frameCount});
+    }
+    const FrameGraph::Statistics &frameGraphStatistics = m_frameGraph->GetStatistics();
+    std::cout << "  Frame graph: " << frameGraphStatistics.passesDeclared << " passes, " << frameGraphStatistics.passesCulled << " culled, ";
+    std::cout << frameGraphStatistics.passesMerged << " merged, " << frameGraphStatistics.clearsIssued << " clears, ";
+    std::cout << frameGraphStatistics.transientImages << " transient images, " << frameGraphStatistics.transientImagesAliased << " aliased" << std::endl;
+
+    DestroyResources();
+    DestroyBenchmarkImages();
+    m_graphicsAPI.reset();
+    return true;
+  }
+
 private:
   void CreateInstance() {
     XrApplicationInfo AI;
@@ -104,6 +264,9 @@ private:
     m_instanceExtensions.push_back(XR_EXT_DEBUG_UTILS_EXTENSION_NAME);
     // TODO make sure this is already defined when we add this line.
     m_instanceExtensions.push_back(GetGraphicsAPIInstanceExtensionString(m_apiType));
+    if (m_foveationMode == Foveation::Mode::EYE_TRACKED && !m_scriptedGaze) {
+      m_instanceExtensions.push_back(XR_EXT_EYE_GAZE_INTERACTION_EXTENSION_NAME);
+    }
 
     // Get all the API Layers from the OpenXR runtime.
     uint32_t apiLayerCount = 0;
@@ -179,7 +342,14 @@ private:
   void CreateSession() {
     XrSessionCreateInfo sessionCI{XR_TYPE_SESSION_CREATE_INFO};
 
-    m_graphicsAPI = std::make_unique<GraphicsAPI_OpenGL>(m_xrInstance, m_systemID);
+    if (m_apiType == OPENGL) {
+      m_graphicsAPI = std::make_unique<GraphicsAPI_OpenGL>(m_xrInstance, m_systemID);
+    }
+#if defined(XR_USE_GRAPHICS_API_VULKAN)
+    if (m_apiType == VULKAN) {
+      m_graphicsAPI = std::make_unique<GraphicsAPI_Vulkan>(m_xrInstance, m_systemID);
+    }
+#endif
 
     sessionCI.next = m_graphicsAPI->GetGraphicsBinding();
     sessionCI.createFlags = 0;
@@ -237,7 +407,8 @@ private:
           m_sessionRunning = true;
         }
         if (sessionStateChanged->state == XR_SESSION_STATE_STOPPING) {
-          // SessionState is stopping. End the XrSession.
+          // SessionState is stopping. Finish the frames in flight, then end the XrSession.
+          StopFramePipeline();
           OPENXR_CHECK(xrEndSession(m_session), "Failed to end Session.");
           m_sessionRunning = false;
         }
@@ -282,7 +453,14 @@ private:
     OPENXR_CHECK(xrGetSystem(m_xrInstance, &systemGI, &m_systemID), "Failed to get SystemID.");
 
     // Get the System's properties for some general information about the hardware and the vendor.
+    // With XR_EXT_eye_gaze_interaction, also ask whether the system has an eye tracker.
+    XrSystemEyeGazeInteractionPropertiesEXT eyeGazeProperties{XR_TYPE_SYSTEM_EYE_GAZE_INTERACTION_PROPERTIES_EXT};
+    if (IsStringInVector(m_activeInstanceExtensions, XR_EXT_EYE_GAZE_INTERACTION_EXTENSION_NAME)) {
+      m_systemProperties.next = &eyeGazeProperties;
+    }
     OPENXR_CHECK(xrGetSystemProperties(m_xrInstance, m_systemID, &m_systemProperties), "Failed to get SystemProperties.");
+    m_systemProperties.next = nullptr;
+    m_eyeGazeSupported = eyeGazeProperties.supportsEyeGazeInteraction;
   }
 
 
@@ -308,9 +486,16 @@ private:
 
     const XrViewConfigurationView &viewConfigurationView = m_viewConfigurationViews[0];
 
-    m_colorSwapchainInfos.resize(m_viewConfigurationViews.size());
-    m_depthSwapchainInfos.resize(m_viewConfigurationViews.size());
-    for (size_t i = 0; i < m_viewConfigurationViews.size(); i++) {
+    // With multiview, both eyes share one swapchain with an array layer per view, and are rendered in a single pass. Foveation
+    // places each view's inset on its own, so it renders the views in separate passes.
+    m_multiview = m_viewConfigurationViews.size() == 2 && m_graphicsAPI->SupportsMultiview() && m_foveationMode == Foveation::Mode::OFF;
+    const uint32_t swapchainCount = m_multiview ? 1 : static_cast<uint32_t>(m_viewConfigurationViews.size());
+    const uint32_t swapchainArraySize = m_multiview ? static_cast<uint32_t>(m_viewConfigurationViews.size()) : 1;
+    const GraphicsAPI::ImageViewCreateInfo::View swapchainView = m_multiview ? GraphicsAPI::ImageViewCreateInfo::View::TYPE_2D_ARRAY : GraphicsAPI::ImageViewCreateInfo::View::TYPE_2D;
+
+    m_colorSwapchainInfos.resize(swapchainCount);
+    m_depthSwapchainInfos.resize(swapchainCount);
+    for (size_t i = 0; i < swapchainCount; i++) {
       SwapchainInfo &colorSwapchainInfo = m_colorSwapchainInfos[i];
       SwapchainInfo &depthSwapchainInfo = m_depthSwapchainInfos[i];
 
@@ -321,10 +506,10 @@ private:
       swapchainCI.usageFlags = XR_SWAPCHAIN_USAGE_SAMPLED_BIT | XR_SWAPCHAIN_USAGE_COLOR_ATTACHMENT_BIT;
       swapchainCI.format = m_graphicsAPI->SelectColorSwapchainFormat(formats);          // Use GraphicsAPI to select the first compatible format.
       swapchainCI.sampleCount = viewConfigurationView.recommendedSwapchainSampleCount;  // Use the recommended values from the XrViewConfigurationView.
-      swapchainCI.width = viewConfigurationView.recommendedImageRectWidth;
-      swapchainCI.height = viewConfigurationView.recommendedImageRectHeight;
+      swapchainCI.width = viewConfigurationView.maxImageRectWidth;  // The maximum size, so that the quality levels can render above the recommended one.
+      swapchainCI.height = viewConfigurationView.maxImageRectHeight;
       swapchainCI.faceCount = 1;
-      swapchainCI.arraySize = 1;
+      swapchainCI.arraySize = swapchainArraySize;
       swapchainCI.mipCount = 1;
       OPENXR_CHECK(xrCreateSwapchain(m_session, &swapchainCI, &colorSwapchainInfo.swapchain), "Failed to create Color Swapchain");
       colorSwapchainInfo.swapchainFormat = swapchainCI.format;  // Save the swapchain format for later use.
@@ -334,10 +519,10 @@ private:
       swapchainCI.usageFlags = XR_SWAPCHAIN_USAGE_SAMPLED_BIT | XR_SWAPCHAIN_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
       swapchainCI.format = m_graphicsAPI->SelectDepthSwapchainFormat(formats);          // Use GraphicsAPI to select the first compatible format.
       swapchainCI.sampleCount = viewConfigurationView.recommendedSwapchainSampleCount;  // Use the recommended values from the XrViewConfigurationView.
-      swapchainCI.width = viewConfigurationView.recommendedImageRectWidth;
-      swapchainCI.height = viewConfigurationView.recommendedImageRectHeight;
+      swapchainCI.width = viewConfigurationView.maxImageRectWidth;  // The maximum size, so that the quality levels can render above the recommended one.
+      swapchainCI.height = viewConfigurationView.maxImageRectHeight;
       swapchainCI.faceCount = 1;
-      swapchainCI.arraySize = 1;
+      swapchainCI.arraySize = swapchainArraySize;
       swapchainCI.mipCount = 1;
       OPENXR_CHECK(xrCreateSwapchain(m_session, &swapchainCI, &depthSwapchainInfo.swapchain), "Failed to create Depth Swapchain");
       depthSwapchainInfo.swapchainFormat = swapchainCI.format;  // Save the swapchain format for later use.
@@ -360,33 +545,33 @@ private:
           GraphicsAPI::ImageViewCreateInfo imageViewCI;
           imageViewCI.image = m_graphicsAPI->GetSwapchainImage(colorSwapchainInfo.swapchain, j);
           imageViewCI.type = GraphicsAPI::ImageViewCreateInfo::Type::RTV;
-          imageViewCI.view = GraphicsAPI::ImageViewCreateInfo::View::TYPE_2D;
+          imageViewCI.view = swapchainView;
           imageViewCI.format = colorSwapchainInfo.swapchainFormat;
           imageViewCI.aspect = GraphicsAPI::ImageViewCreateInfo::Aspect::COLOR_BIT;
           imageViewCI.baseMipLevel = 0;
           imageViewCI.levelCount = 1;
           imageViewCI.baseArrayLayer = 0;
-          imageViewCI.layerCount = 1;
+          imageViewCI.layerCount = swapchainArraySize;
           colorSwapchainInfo.imageViews.push_back(m_graphicsAPI->CreateImageView(imageViewCI));
       }
       for (uint32_t j = 0; j < depthSwapchainImageCount; j++) {
           GraphicsAPI::ImageViewCreateInfo imageViewCI;
           imageViewCI.image = m_graphicsAPI->GetSwapchainImage(depthSwapchainInfo.swapchain, j);
           imageViewCI.type = GraphicsAPI::ImageViewCreateInfo::Type::DSV;
-          imageViewCI.view = GraphicsAPI::ImageViewCreateInfo::View::TYPE_2D;
+          imageViewCI.view = swapchainView;
           imageViewCI.format = depthSwapchainInfo.swapchainFormat;
           imageViewCI.aspect = GraphicsAPI::ImageViewCreateInfo::Aspect::DEPTH_BIT;
           imageViewCI.baseMipLevel = 0;
           imageViewCI.levelCount = 1;
           imageViewCI.baseArrayLayer = 0;
-          imageViewCI.layerCount = 1;
+          imageViewCI.layerCount = swapchainArraySize;
           depthSwapchainInfo.imageViews.push_back(m_graphicsAPI->CreateImageView(imageViewCI));
       }
     }
   }
   void DestroySwapchains() {
-    // Per view in the view configuration:
-    for (size_t i = 0; i < m_viewConfigurationViews.size(); i++) {
+    // Per swapchain:
+    for (size_t i = 0; i < m_colorSwapchainInfos.size(); i++) {
         SwapchainInfo &colorSwapchainInfo = m_colorSwapchainInfos[i];
         SwapchainInfo &depthSwapchainInfo = m_depthSwapchainInfos[i];
 
@@ -408,6 +593,44 @@ private:
     }
   }
 
+  // The benchmark has no OpenXR swapchains, so it renders each view into a color and a depth image of its own.
+  void CreateBenchmarkImages() {
+    m_colorSwapchainInfos.resize(m_viewConfigurationViews.size());
+    m_depthSwapchainInfos.resize(m_viewConfigurationViews.size());
+    for (size_t i = 0; i < m_viewConfigurationViews.size(); i++) {
+      const XrViewConfigurationView &viewConfigurationView = m_viewConfigurationViews[i];
+      SwapchainInfo &colorSwapchainInfo = m_colorSwapchainInfos[i];
+      SwapchainInfo &depthSwapchainInfo = m_depthSwapchainInfos[i];
+      colorSwapchainInfo.swapchainFormat = m_benchmarkColorFormat;
+      depthSwapchainInfo.swapchainFormat = m_graphicsAPI->GetDepthFormat();
+
+      GraphicsAPI::ImageCreateInfo imageCI{2, viewConfigurationView.maxImageRectWidth, viewConfigurationView.maxImageRectHeight, 1, 1, 1, viewConfigurationView.recommendedSwapchainSampleCount, colorSwapchainInfo.swapchainFormat, false, true, false, true};
+      m_benchmarkImages.push_back(m_graphicsAPI->CreateImage(imageCI));
+      colorSwapchainInfo.imageViews.push_back(m_graphicsAPI->CreateImageView({m_benchmarkImages.back(), GraphicsAPI::ImageViewCreateInfo::Type::RTV, GraphicsAPI::ImageViewCreateInfo::View::TYPE_2D, colorSwapchainInfo.swapchainFormat, GraphicsAPI::ImageViewCreateInfo::Aspect::COLOR_BIT, 0, 1, 0, 1}));
+
+      imageCI.format = depthSwapchainInfo.swapchainFormat;
+      imageCI.colorAttachment = false;
+      imageCI.depthAttachment = true;
+      m_benchmarkImages.push_back(m_graphicsAPI->CreateImage(imageCI));
+      depthSwapchainInfo.imageViews.push_back(m_graphicsAPI->CreateImageView({m_benchmarkImages.back(), GraphicsAPI::ImageViewCreateInfo::Type::DSV, GraphicsAPI::ImageViewCreateInfo::View::TYPE_2D, depthSwapchainInfo.swapchainFormat, GraphicsAPI::ImageViewCreateInfo::Aspect::DEPTH_BIT, 0, 1, 0, 1}));
+    }
+  }
+  void DestroyBenchmarkImages() {
+    for (size_t i = 0; i < m_colorSwapchainInfos.size(); i++) {
+      for (void *&imageView : m_colorSwapchainInfos[i].imageViews) {
+        m_graphicsAPI->DestroyImageView(imageView);
+      }
+      for (void *&imageView : m_depthSwapchainInfos[i].imageViews) {
+        m_graphicsAPI->DestroyImageView(imageView);
+      }
+    }
+    m_colorSwapchainInfos.clear();
+    m_depthSwapchainInfos.clear();
+    for (void *&image : m_benchmarkImages) {
+      m_graphicsAPI->DestroyImage(image);
+    }
+    m_benchmarkImages.clear();
+  }
   void GetEnvironmentBlendModes() {
     // Retrieves the available blend modes. The first call gets the size of the array that will be returned. The next call fills out the array.
     uint32_t environmentBlendModeSize = 0;
@@ -438,60 +661,359 @@ private:
     // Destroy the reference XrSpace.
     OPENXR_CHECK(xrDestroySpace(m_localOrStageSpace), "Failed to destroy Space.")
   }
-  void RenderFrame() {
-    // Get the XrFrameState for timing and rendering info.
-    XrFrameState frameState{XR_TYPE_FRAME_STATE};
-    XrFrameWaitInfo frameWaitInfo{XR_TYPE_FRAME_WAIT_INFO};
-    OPENXR_CHECK(xrWaitFrame(m_session, &frameWaitInfo, &frameState), "Failed to wait for XR Frame.");
+  void CreateGazeActions() {
+    // Eye-tracked foveation reads the gaze through a pose action bound to the eye gaze interaction profile, located as a space.
+    if (m_foveationMode != Foveation::Mode::EYE_TRACKED || m_scriptedGaze) {
+      return;
+    }
+    if (!m_eyeGazeSupported) {
+      std::cout << "Eye gaze interaction is not supported. Foveation follows the lens center instead." << std::endl;
+      return;
+    }
+    XrActionSetCreateInfo actionSetCI{XR_TYPE_ACTION_SET_CREATE_INFO};
+    strncpy(actionSetCI.actionSetName, "foveation", XR_MAX_ACTION_SET_NAME_SIZE);
+    strncpy(actionSetCI.localizedActionSetName, "Foveation", XR_MAX_LOCALIZED_ACTION_SET_NAME_SIZE);
+    actionSetCI.priority = 0;
+    OPENXR_CHECK(xrCreateActionSet(m_xrInstance, &actionSetCI, &m_gazeActionSet), "Failed to create ActionSet.");
+
+    XrActionCreateInfo actionCI{XR_TYPE_ACTION_CREATE_INFO};
+    actionCI.actionType = XR_ACTION_TYPE_POSE_INPUT;
+    strncpy(actionCI.actionName, "gaze", XR_MAX_ACTION_NAME_SIZE);
+    strncpy(actionCI.localizedActionName, "Gaze", XR_MAX_LOCALIZED_ACTION_NAME_SIZE);
+    OPENXR_CHECK(xrCreateAction(m_gazeActionSet, &actionCI, &m_gazeAction), "Failed to create Action.");
+
+    XrPath interactionProfilePath = XR_NULL_PATH;
+    XrPath gazePosePath = XR_NULL_PATH;
+    OPENXR_CHECK(xrStringToPath(m_xrInstance, "/interaction_profiles/ext/eye_gaze_interaction", &interactionProfilePath), "Failed to create XrPath.");
+    OPENXR_CHECK(xrStringToPath(m_xrInstance, "/user/eyes_ext/input/gaze_ext/pose", &gazePosePath), "Failed to create XrPath.");
+    XrActionSuggestedBinding suggestedBinding{m_gazeAction, gazePosePath};
+    XrInteractionProfileSuggestedBinding interactionProfileSuggestedBinding{XR_TYPE_INTERACTION_PROFILE_SUGGESTED_BINDING};
+    interactionProfileSuggestedBinding.interactionProfile = interactionProfilePath;
+    interactionProfileSuggestedBinding.countSuggestedBindings = 1;
+    interactionProfileSuggestedBinding.suggestedBindings = &suggestedBinding;
+    OPENXR_CHECK(xrSuggestInteractionProfileBindings(m_xrInstance, &interactionProfileSuggestedBinding), "Failed to suggest Bindings.");
+
+    XrSessionActionSetsAttachInfo actionSetsAttachInfo{XR_TYPE_SESSION_ACTION_SETS_ATTACH_INFO};
+    actionSetsAttachInfo.countActionSets = 1;
+    actionSetsAttachInfo.actionSets = &m_gazeActionSet;
+    OPENXR_CHECK(xrAttachSessionActionSets(m_session, &actionSetsAttachInfo), "Failed to attach ActionSet.");
+
+    XrActionSpaceCreateInfo actionSpaceCI{XR_TYPE_ACTION_SPACE_CREATE_INFO};
+    actionSpaceCI.action = m_gazeAction;
+    actionSpaceCI.poseInActionSpace = {{0.0f, 0.0f, 0.0f, 1.0f}, {0.0f, 0.0f, 0.0f}};
+    OPENXR_CHECK(xrCreateActionSpace(m_session, &actionSpaceCI, &m_gazeSpace), "Failed to create ActionSpace.");
+  }
+  void DestroyGazeActions() {
+    if (m_gazeSpace != XR_NULL_HANDLE) {
+      OPENXR_CHECK(xrDestroySpace(m_gazeSpace), "Failed to destroy Space.");
+      m_gazeSpace = XR_NULL_HANDLE;
+    }
+    if (m_gazeActionSet != XR_NULL_HANDLE) {
+      // Destroys m_gazeAction with it.
+      OPENXR_CHECK(xrDestroyActionSet(m_gazeActionSet), "Failed to destroy ActionSet.");
+      m_gazeActionSet = XR_NULL_HANDLE;
+      m_gazeAction = XR_NULL_HANDLE;
+    }
+  }
+  void StartFramePipeline() {
+    // Every frame passes through three threads, each owning one stage:
+    // - the frame thread calls xrWaitFrame() and so sets the pace,
+    // - the simulation thread locates the views and builds the scene at the predicted display time,
+    // - the render thread owns the graphics context, records and submits the GraphicsAPI work and calls xrEndFrame().
+    // Only m_framesInFlight FrameData exist, so frame N+1 is simulated while frame N is rendered, but no stage runs further ahead.
+    m_stopFramePipeline = false;
+    m_freeFrames.Reset();
+    m_simulateFrames.Reset();
+    m_renderFrames.Reset();
+    for (FrameData &frame : m_frames) {
+      m_freeFrames.Push(&frame);
+    }
+
+    // The render thread makes the graphics context current for itself.
+    m_graphicsAPI->ReleaseContext();
+    m_renderThread = std::thread(&OpenXRTutorial::RenderThread, this);
+    m_simulateThread = std::thread(&OpenXRTutorial::SimulateThread, this);
+    m_frameThread = std::thread(&OpenXRTutorial::FrameThread, this);
+    m_framePipelineRunning = true;
+  }
+  void StopFramePipeline() {
+    if (!m_framePipelineRunning) {
+      return;
+    }
+    // The frame thread stops waiting for new frames. The frames already waited on are still simulated, rendered and ended, as
+    // each stage drains its queue and then closes the next one.
+    m_stopFramePipeline = true;
+    m_frameThread.join();
+    m_simulateThread.join();
+    m_renderThread.join();
+    m_graphicsAPI->MakeContextCurrent();
+    m_framePipelineRunning = false;
+  }
+  void FrameThread() {
+    FrameData *frame = nullptr;
+    while (!m_stopFramePipeline && m_freeFrames.Pop(frame)) {
+      // Get the XrFrameState for timing and rendering info.
+      frame->frameState = {XR_TYPE_FRAME_STATE};
+      XrFrameWaitInfo frameWaitInfo{XR_TYPE_FRAME_WAIT_INFO};
+      OPENXR_CHECK(xrWaitFrame(m_session, &frameWaitInfo, &frame->frameState), "Failed to wait for XR Frame.");
+
+      // Check that the session is active and that we should render.
+      const XrSessionState sessionState = m_sessionState;
+      bool sessionActive = (sessionState == XR_SESSION_STATE_SYNCHRONIZED || sessionState == XR_SESSION_STATE_VISIBLE || sessionState == XR_SESSION_STATE_FOCUSED);
+      frame->shouldRender = sessionActive && frame->frameState.shouldRender;
+
+      m_simulateFrames.Push(frame);
+    }
+    m_simulateFrames.Close();
+  }
+  void SimulateThread() {
+    FrameData *frame = nullptr;
+    while (m_simulateFrames.Pop(frame)) {
+      if (frame->shouldRender) {
+        frame->shouldRender = Simulate(*frame);
+      }
+      m_renderFrames.Push(frame);
+    }
+    m_renderFrames.Close();
+  }
+  void RenderThread() {
+    m_graphicsAPI->MakeContextCurrent();
+    FrameData *frame = nullptr;
+    while (m_renderFrames.Pop(frame)) {
+      RenderFrame(*frame);
+      m_freeFrames.Push(frame);
+    }
+    m_graphicsAPI->ReleaseContext();
+  }
+  void RenderFrame(FrameData &frame) {
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    // The level is only changed between frames, so that every pass of a frame renders at the same one.
+    m_qualityLevel = m_qualityGovernor->GetLevel();
 
     // Tell the OpenXR compositor that the application is beginning the frame.
+    // This is called here rather than on the frame thread, as beginning a frame before the previous one has ended discards it.
     XrFrameBeginInfo frameBeginInfo{XR_TYPE_FRAME_BEGIN_INFO};
     OPENXR_CHECK(xrBeginFrame(m_session, &frameBeginInfo), "Failed to begin the XR Frame.");
 
+    m_graphicsAPI->BeginFrame();
+    m_graphicsAPI->BeginGpuZone("Frame");
+    m_drawQueue.ResetStatistics();
+
     // Variables for rendering and layer composition.
     bool rendered = false;
     RenderLayerInfo renderLayerInfo;
-    renderLayerInfo.predictedDisplayTime = frameState.predictedDisplayTime;
-
-    // Check that the session is active and that we should render.
-    bool sessionActive = (m_sessionState == XR_SESSION_STATE_SYNCHRONIZED || m_sessionState == XR_SESSION_STATE_VISIBLE || m_sessionState == XR_SESSION_STATE_FOCUSED);
-    if (sessionActive && frameState.shouldRender) {
-        // Render the stereo image and associate one of swapchain images with the XrCompositionLayerProjection structure.
-        rendered = RenderLayer(renderLayerInfo);
-        if (rendered) {
-            renderLayerInfo.layers.push_back(reinterpret_cast<XrCompositionLayerBaseHeader *>(&renderLayerInfo.layerProjection));
-        }
+    renderLayerInfo.predictedDisplayTime = frame.frameState.predictedDisplayTime;
+
+    if (frame.shouldRender) {
+      // Render the stereo image and associate one of swapchain images with the XrCompositionLayerProjection structure.
+      rendered = RenderLayer(renderLayerInfo, frame);
+      if (rendered) {
+        renderLayerInfo.layers.push_back(reinterpret_cast<XrCompositionLayerBaseHeader *>(&renderLayerInfo.layerProjection));
+      }
+    }
+
+    m_graphicsAPI->EndGpuZone();
+    m_graphicsAPI->EndFrame();
+    if (m_frameIndex++ % m_frameStatisticsInterval == 0) {
+        LogFrameStatistics(frame.frameState.predictedDisplayPeriod);
     }
 
     // Tell OpenXR that we are finished with this frame; specifying its display time, environment blending and layers.
     XrFrameEndInfo frameEndInfo{XR_TYPE_FRAME_END_INFO};
-    frameEndInfo.displayTime = frameState.predictedDisplayTime;
+    frameEndInfo.displayTime = frame.frameState.predictedDisplayTime;
     frameEndInfo.environmentBlendMode = m_environmentBlendMode;
     frameEndInfo.layerCount = static_cast<uint32_t>(renderLayerInfo.layers.size());
     frameEndInfo.layers = renderLayerInfo.layers.data();
     OPENXR_CHECK(xrEndFrame(m_session, &frameEndInfo), "Failed to end the XR Frame.");
+
+    if (rendered) {
+      UpdateQuality(frame.frameState, std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count());
+    } else {
+      // The frames that were not rendered are not misses.
+      m_lastDisplayTime = 0;
+    }
   }
-  bool RenderLayer(RenderLayerInfo& renderLayerInfo) {
+  // Feeds the frame's timing to the quality governor, which picks the level the next frames render at.
+  void UpdateQuality(const XrFrameState &frameState, float cpuMilliseconds) {
+    QualityGovernor::FrameTiming timing{};
+    timing.cpuMilliseconds = cpuMilliseconds;
+    // The GPU time lags the frame by the few frames its timer queries take to come back.
+    timing.gpuMilliseconds = m_graphicsAPI->GetLatestGpuZoneMilliseconds("Frame");
+    timing.periodMilliseconds = (float)frameState.predictedDisplayPeriod / 1000000.0f;
+    // The runtime paces the display times one period apart; a larger step means the frame missed the periods in between.
+    if (m_lastDisplayTime != 0 && frameState.predictedDisplayPeriod > 0) {
+      const double periods = (double)(frameState.predictedDisplayTime - m_lastDisplayTime) / (double)frameState.predictedDisplayPeriod;
+      timing.missedPeriods = static_cast<uint32_t>(std::max(std::round(periods) - 1.0, 0.0));
+    }
+    m_lastDisplayTime = frameState.predictedDisplayTime;
+
+    if (m_qualityGovernor->Update(timing)) {
+      const QualityGovernor::Change &change = m_qualityGovernor->GetLastChange();
+      std::cout << "Quality: level " << change.fromLevel << " -> " << change.toLevel << " (" << QualityGovernor::GetCauseName(change.cause) << "), ";
+      LogQualityLevel(m_qualityGovernor->GetLevel());
+      std::cout << ", CPU " << change.cpuMilliseconds << " ms, GPU " << change.gpuMilliseconds << " ms, period " << change.periodMilliseconds << " ms" << std::endl;
+    }
+  }
+  void LogQualityLevel(const QualityGovernor::Level &qualityLevel) {
+    std::cout << "resolution " << qualityLevel.resolutionScale * 100.0f << "%, MSAA " << qualityLevel.sampleCount << "x";
+  }
+  void LogFrameStatistics(XrDuration predictedDisplayPeriod) {
+    const GraphicsAPI::FrameStatistics &frameStatistics = m_graphicsAPI->GetFrameStatistics();
+    std::cout << "Frame " << m_frameIndex << ": ";
+    std::cout << "State calls issued: " << frameStatistics.stateCallsIssued << ", ";
+    std::cout << "skipped: " << frameStatistics.stateCallsSkipped << ", ";
+    std::cout << "Binds issued: " << frameStatistics.bindsIssued << " in " << frameStatistics.bindCalls << " calls, ";
+    std::cout << "elided: " << frameStatistics.bindsElided << ", ";
+    std::cout << "Transient bytes: " << frameStatistics.transientBytesAllocated << std::endl;
+    LogDrawQueueStatistics();
+    LogFoveationStatistics(m_foveationStatistics);
+    std::cout << "  Quality: level " << m_qualityGovernor->GetLevelIndex() << " of " << m_qualityGovernor->GetLevelCount() << ", ";
+    LogQualityLevel(m_qualityLevel);
+    std::cout << std::endl;
+#if defined(XR_TUTORIAL_OPENGL_CALL_COUNTERS)
+    if (m_apiType == OPENGL) {
+      const GraphicsAPI_OpenGL *graphicsAPI_OpenGL = static_cast<const GraphicsAPI_OpenGL *>(m_graphicsAPI.get());
+      for (const std::pair<const char *, uint32_t> &callCount : graphicsAPI_OpenGL->GetEntryPointCallCounts()) {
+        std::cout << "    " << callCount.first << ": " << callCount.second << std::endl;
+      }
+    }
+#endif
+    // Compare the GPU time of the "Frame" zone against this budget.
+    std::cout << "  Predicted display period: " << (float)predictedDisplayPeriod / 1000000.0f << " ms" << std::endl;
+    for (const GraphicsAPI::GpuZoneStatistics &gpuZone : m_graphicsAPI->GetGpuZoneStatistics()) {
+      std::cout << "  GPU " << gpuZone.name << ": average " << gpuZone.averageMilliseconds << " ms, ";
+      std::cout << "p50 " << gpuZone.p50Milliseconds << " ms, p90 " << gpuZone.p90Milliseconds << " ms, p99 " << gpuZone.p99Milliseconds << " ms ";
+      std::cout << "(" << gpuZone.sampleCount << " samples)" << std::endl;
+    }
+  }
+  void LogDrawQueueStatistics() {
+    const DrawQueue::Statistics &drawQueueStatistics = m_drawQueue.GetStatistics();
+    std::cout << "  Draw queue: " << drawQueueStatistics.draws << " draws, ";
+    std::cout << "pipeline switches: " << drawQueueStatistics.pipelineSwitches << " (" << drawQueueStatistics.pipelineSwitchesAvoided << " avoided), ";
+    std::cout << "binding switches: " << drawQueueStatistics.bindingSwitches << " (" << drawQueueStatistics.bindingSwitchesAvoided << " avoided), ";
+    std::cout << "scissor switches: " << drawQueueStatistics.scissorSwitches << " (" << drawQueueStatistics.scissorSwitchesAvoided << " avoided)" << std::endl;
+  }
+  void LogFoveationStatistics(const FoveationStatistics &foveationStatistics) {
+    const char *modeNames[] = {"off", "fixed", "eye-tracked"};
+    std::cout << "  Foveation: " << modeNames[static_cast<size_t>(m_foveationMode)];
+    if (m_foveationMode != Foveation::Mode::OFF) {
+      std::cout << ", inset " << m_foveationProfile.insetSize * 100.0f << "%, periphery " << m_foveationProfile.peripheryScale * 100.0f << "%";
+    }
+    const double saved = foveationStatistics.fullPixels ? 100.0 * (1.0 - (double)foveationStatistics.shadedPixels / (double)foveationStatistics.fullPixels) : 0.0;
+    std::cout << ", pixels shaded: " << foveationStatistics.shadedPixels << " of " << foveationStatistics.fullPixels << " (" << saved << "% saved)" << std::endl;
+  }
+  bool Simulate(FrameData &frame) {
     // Locate the views from the view configuration with in the (reference) space at the display time.
-    std::vector<XrView> views(m_viewConfigurationViews.size(), {XR_TYPE_VIEW});
+    frame.views.assign(m_viewConfigurationViews.size(), {XR_TYPE_VIEW});
 
     XrViewState viewState{XR_TYPE_VIEW_STATE};  // Will contain information on whether the position and/or orientation is valid and/or tracked.
     XrViewLocateInfo viewLocateInfo{XR_TYPE_VIEW_LOCATE_INFO};
     viewLocateInfo.viewConfigurationType = m_viewConfiguration;
-    viewLocateInfo.displayTime = renderLayerInfo.predictedDisplayTime;
+    viewLocateInfo.displayTime = frame.frameState.predictedDisplayTime;
     viewLocateInfo.space = m_localOrStageSpace;
     uint32_t viewCount = 0;
-    XrResult result = xrLocateViews(m_session, &viewLocateInfo, &viewState, static_cast<uint32_t>(views.size()), &viewCount, views.data());
+    XrResult result = xrLocateViews(m_session, &viewLocateInfo, &viewState, static_cast<uint32_t>(frame.views.size()), &viewCount, frame.views.data());
     if (result != XR_SUCCESS) {
       std::cout << "Failed to locate Views." << std::endl;
       return false;
     }
+    frame.views.resize(viewCount);
+
+    LocateGaze(frame, m_simulateFrameIndex++);
+    BuildScene(frame);
+    return true;
+  }
+  // Sets the frame's gaze direction, in the reference space, for eye-tracked foveation: from the gaze script if there is one,
+  // otherwise from the eye tracker. Without a valid gaze, the frame's foveation follows the lens center.
+  void LocateGaze(FrameData &frame, uint64_t frameIndex) {
+    frame.gazeValid = false;
+    if (m_foveationMode != Foveation::Mode::EYE_TRACKED || frame.views.empty()) {
+      return;
+    }
+    if (m_scriptedGaze) {
+      // Yaw and pitch from the head's forward direction, taken as the first view's.
+      XrVector2f yawPitch;
+      if (!m_gazeScript.empty()) {
+        yawPitch = m_gazeScript[frameIndex % m_gazeScript.size()];
+      } else {
+        // A sweep over the center of the field of view, repeating every 6 s at 90 Hz.
+        const float t = 6.28318530718f * static_cast<float>(frameIndex % 540) / 540.0f;
+        yawPitch = {20.0f * sinf(3.0f * t), 12.0f * sinf(2.0f * t)};
+      }
+      const float yaw = yawPitch.x * 0.01745329252f;
+      const float pitch = yawPitch.y * 0.01745329252f;
+      const XrVector3f headGaze{sinf(yaw) * cosf(pitch), sinf(pitch), -cosf(yaw) * cosf(pitch)};
+      XrMatrix4x4f headRotation;
+      XrMatrix4x4f_CreateFromQuaternion(&headRotation, &frame.views[0].pose.orientation);
+      XrMatrix4x4f_TransformVector3f(&frame.gazeDirection, &headRotation, &headGaze);
+      frame.gazeValid = true;
+      return;
+    }
+    if (m_gazeSpace == XR_NULL_HANDLE) {
+      return;
+    }
+
+    // Not focused returns XR_SESSION_NOT_FOCUSED, and the actions are inactive.
+    XrActiveActionSet activeActionSet{m_gazeActionSet, XR_NULL_PATH};
+    XrActionsSyncInfo actionsSyncInfo{XR_TYPE_ACTIONS_SYNC_INFO};
+    actionsSyncInfo.countActiveActionSets = 1;
+    actionsSyncInfo.activeActionSets = &activeActionSet;
+    if (xrSyncActions(m_session, &actionsSyncInfo) != XR_SUCCESS) {
+      return;
+    }
+    XrActionStateGetInfo actionStateGetInfo{XR_TYPE_ACTION_STATE_GET_INFO};
+    actionStateGetInfo.action = m_gazeAction;
+    XrActionStatePose actionStatePose{XR_TYPE_ACTION_STATE_POSE};
+    if (xrGetActionStatePose(m_session, &actionStateGetInfo, &actionStatePose) != XR_SUCCESS || !actionStatePose.isActive) {
+      return;
+    }
+    XrSpaceLocation gazeLocation{XR_TYPE_SPACE_LOCATION};
+    if (xrLocateSpace(m_gazeSpace, m_localOrStageSpace, frame.frameState.predictedDisplayTime, &gazeLocation) != XR_SUCCESS) {
+      return;
+    }
+    const XrSpaceLocationFlags orientationTracked = XR_SPACE_LOCATION_ORIENTATION_VALID_BIT | XR_SPACE_LOCATION_ORIENTATION_TRACKED_BIT;
+    if ((gazeLocation.locationFlags & orientationTracked) != orientationTracked) {
+      return;
+    }
+    // The gaze looks down the -Z axis of its pose.
+    const XrVector3f forward{0.0f, 0.0f, -1.0f};
+    XrMatrix4x4f gazeRotation;
+    XrMatrix4x4f_CreateFromQuaternion(&gazeRotation, &gazeLocation.pose.orientation);
+    XrMatrix4x4f_TransformVector3f(&frame.gazeDirection, &gazeRotation, &forward);
+    frame.gazeValid = true;
+  }
+  void BuildScene(FrameData &frame) {
+    // Collect this frame's cuboids. They are the same for every view, so their instance data is uploaded once and each view
+    // draws them all with a single instanced draw.
+    frame.cuboidInstances.clear();
+    // draw a small cube out past the origin
+    // {0.0f, 0.0f, 0.0f, 1.0f}
+    XrQuaternionf ori = {0.0f, 0.0f, 0.0f, 1.0f};
+    // spin around y axis
+    XrQuaternionf rot = {0.0f, 0.0f, 0.0f, 1.0f};
+    XrVector3f axis = {0.0f, 0.0f, -1.0f};
+    // from int64_t predictedDisplayTime to float time
+    float time = (float)frame.frameState.predictedDisplayTime / 1000000000.0f;
+    float TAU = 6.28318530718f;
+    XrQuaternionf_CreateFromAxisAngle(&rot, &axis, TAU * time); // 1 rev per sec
+    // XrQuaternionf_Multiply(&ori, &ori, &rot);
+    RenderCuboid(frame, {rot, {0.0f, sin(time * 0.1f) * 0.1f, -0.5f}}, {0.1f, 0.1f, 0.1f}, {0.5f, 0.5f, 0.5f});
+  }
+  bool RenderLayer(RenderLayerInfo& renderLayerInfo, const FrameData &frame) {
+    const std::vector<XrView> &views = frame.views;
+    const uint32_t viewCount = static_cast<uint32_t>(views.size());
 
     // Resize the layer projection views to match the view count. The layer projection views are used in the layer projection.
     renderLayerInfo.layerProjectionViews.resize(viewCount, {XR_TYPE_COMPOSITION_LAYER_PROJECTION_VIEW});
 
-    // Per view in the view configuration:
-    for (uint32_t i = 0; i < viewCount; i++) {
+    UploadMaterial();
+    UploadCuboidInstances(frame);
+
+    // Per render pass: one per view, or a single pass for all views with multiview.
+    const uint32_t passCount = m_multiview ? 1 : viewCount;
+    const uint32_t passViewCount = m_multiview ? viewCount : 1;
+    std::vector<void *> colorViews(passCount), depthViews(passCount);
+    for (uint32_t i = 0; i < passCount; i++) {
       SwapchainInfo &colorSwapchainInfo = m_colorSwapchainInfos[i];
       SwapchainInfo &depthSwapchainInfo = m_depthSwapchainInfos[i];
 
@@ -508,77 +1030,41 @@ private:
       waitInfo.timeout = XR_INFINITE_DURATION;
       OPENXR_CHECK(xrWaitSwapchainImage(colorSwapchainInfo.swapchain, &waitInfo), "Failed to wait for Image from the Color Swapchain");
       OPENXR_CHECK(xrWaitSwapchainImage(depthSwapchainInfo.swapchain, &waitInfo), "Failed to wait for Image from the Depth Swapchain");
+      colorViews[i] = colorSwapchainInfo.imageViews[colorImageIndex];
+      depthViews[i] = depthSwapchainInfo.imageViews[depthImageIndex];
+
+      // Get the width and height of the pass.
+      uint32_t width = 0, height = 0;
+      GetRenderExtent(i, width, height);
+
+      for (uint32_t j = 0; j < passViewCount; j++) {
+        const uint32_t viewIndex = i + j;
+
+        // Fill out the XrCompositionLayerProjectionView structure specifying the pose and fov from the view.
+        // This also associates the swapchain image with this layer projection view.
+        renderLayerInfo.layerProjectionViews[viewIndex] = {XR_TYPE_COMPOSITION_LAYER_PROJECTION_VIEW};
+        renderLayerInfo.layerProjectionViews[viewIndex].pose = views[viewIndex].pose;
+        renderLayerInfo.layerProjectionViews[viewIndex].fov = views[viewIndex].fov;
+        renderLayerInfo.layerProjectionViews[viewIndex].subImage.swapchain = colorSwapchainInfo.swapchain;
+        renderLayerInfo.layerProjectionViews[viewIndex].subImage.imageRect.offset.x = 0;
+        renderLayerInfo.layerProjectionViews[viewIndex].subImage.imageRect.offset.y = 0;
+        renderLayerInfo.layerProjectionViews[viewIndex].subImage.imageRect.extent.width = static_cast<int32_t>(width);
+        renderLayerInfo.layerProjectionViews[viewIndex].subImage.imageRect.extent.height = static_cast<int32_t>(height);
+        renderLayerInfo.layerProjectionViews[viewIndex].subImage.imageArrayIndex = j;  // The array layer used with multiview rendering.
+      }
+    }
 
-      // Get the width and height and construct the viewport and scissors.
-      const uint32_t &width = m_viewConfigurationViews[i].recommendedImageRectWidth;
-      const uint32_t &height = m_viewConfigurationViews[i].recommendedImageRectHeight;
-      GraphicsAPI::Viewport viewport = {0.0f, 0.0f, (float)width, (float)height, 0.0f, 1.0f};
-      GraphicsAPI::Rect2D scissor = {{(int32_t)0, (int32_t)0}, {width, height}};
-      float nearZ = 0.05f;
-      float farZ = 100.0f;
-
-      // Fill out the XrCompositionLayerProjectionView structure specifying the pose and fov from the view.
-      // This also associates the swapchain image with this layer projection view.
-      renderLayerInfo.layerProjectionViews[i] = {XR_TYPE_COMPOSITION_LAYER_PROJECTION_VIEW};
-      renderLayerInfo.layerProjectionViews[i].pose = views[i].pose;
-      renderLayerInfo.layerProjectionViews[i].fov = views[i].fov;
-      renderLayerInfo.layerProjectionViews[i].subImage.swapchain = colorSwapchainInfo.swapchain;
-      renderLayerInfo.layerProjectionViews[i].subImage.imageRect.offset.x = 0;
-      renderLayerInfo.layerProjectionViews[i].subImage.imageRect.offset.y = 0;
-      renderLayerInfo.layerProjectionViews[i].subImage.imageRect.extent.width = static_cast<int32_t>(width);
-      renderLayerInfo.layerProjectionViews[i].subImage.imageRect.extent.height = static_cast<int32_t>(height);
-      renderLayerInfo.layerProjectionViews[i].subImage.imageArrayIndex = 0;  // Useful for multiview rendering.
-
-      // Rendering code to clear the color and depth image views.
-      m_graphicsAPI->BeginRendering();
-
-      if (m_environmentBlendMode == XR_ENVIRONMENT_BLEND_MODE_OPAQUE) {
-        // VR mode use a background color.
-        m_graphicsAPI->ClearColor(colorSwapchainInfo.imageViews[colorImageIndex], 0.17f, 0.17f, 0.17f, 1.00f);
-      } else {
-        // In AR mode make the background color black.
-        m_graphicsAPI->ClearColor(colorSwapchainInfo.imageViews[colorImageIndex], 0.00f, 0.00f, 0.00f, 1.00f);
-      }
-      m_graphicsAPI->ClearDepth(depthSwapchainInfo.imageViews[depthImageIndex], 1.0f);
-
-
-      m_graphicsAPI->SetRenderAttachments(&colorSwapchainInfo.imageViews[colorImageIndex], 1, depthSwapchainInfo.imageViews[depthImageIndex], width, height, m_pipeline);
-      m_graphicsAPI->SetViewports(&viewport, 1);
-      m_graphicsAPI->SetScissors(&scissor, 1);
-
-      // Compute the view-projection transform.
-      // All matrices (including OpenXR's) are column-major, right-handed.
-      XrMatrix4x4f proj;
-      XrMatrix4x4f_CreateProjectionFov(&proj, m_apiType, views[i].fov, nearZ, farZ);
-      XrMatrix4x4f toView;
-      XrVector3f scale1m{1.0f, 1.0f, 1.0f};
-      XrMatrix4x4f_CreateTranslationRotationScale(&toView, &views[i].pose.position, &views[i].pose.orientation, &scale1m);
-      XrMatrix4x4f view;
-      XrMatrix4x4f_InvertRigidBody(&view, &toView);
-      XrMatrix4x4f_Multiply(&cameraConstants.viewProj, &proj, &view);
-
-      renderCuboidIndex = 0;
-      // draw a small cube out past the origin
-      // {0.0f, 0.0f, 0.0f, 1.0f}
-      XrQuaternionf ori = {0.0f, 0.0f, 0.0f, 1.0f};
-      // spin around y axis
-      XrQuaternionf rot = {0.0f, 0.0f, 0.0f, 1.0f};
-      XrVector3f axis = {0.0f, 0.0f, -1.0f};
-      // from int64_t viewLocateInfo.displayTime to float time
-      float time = (float)viewLocateInfo.displayTime / 1000000000.0f;
-      float TAU = 6.28318530718f;
-      XrQuaternionf_CreateFromAxisAngle(&rot, &axis, TAU * time); // 1 rev per sec
-      // XrQuaternionf_Multiply(&ori, &ori, &rot);
-      RenderCuboid({rot, {0.0f, sin(time * 0.1f) * 0.1f, -0.5f}}, {0.1f, 0.1f, 0.1f}, {0.5f, 0.5f, 0.5f});
-      
-
-
-      m_graphicsAPI->EndRendering();
-
-      // Give the swapchain image back to OpenXR, allowing the compositor to use the image.
+    // Record all the passes into a CommandBuffer, then submit it on this thread, which owns the graphics context. The view
+    // transforms are only written once recording is done, from the views located again just before the submission.
+    RecordPasses(m_commandBuffer, frame, colorViews, depthViews);
+    LateLatchViews(renderLayerInfo, frame);
+    m_graphicsAPI->Submit(m_commandBuffer);
+
+    // Give the swapchain images back to OpenXR, allowing the compositor to use the images.
+    for (uint32_t i = 0; i < passCount; i++) {
       XrSwapchainImageReleaseInfo releaseInfo{XR_TYPE_SWAPCHAIN_IMAGE_RELEASE_INFO};
-      OPENXR_CHECK(xrReleaseSwapchainImage(colorSwapchainInfo.swapchain, &releaseInfo), "Failed to release Image back to the Color Swapchain");
-      OPENXR_CHECK(xrReleaseSwapchainImage(depthSwapchainInfo.swapchain, &releaseInfo), "Failed to release Image back to the Depth Swapchain");
+      OPENXR_CHECK(xrReleaseSwapchainImage(m_colorSwapchainInfos[i].swapchain, &releaseInfo), "Failed to release Image back to the Color Swapchain");
+      OPENXR_CHECK(xrReleaseSwapchainImage(m_depthSwapchainInfos[i].swapchain, &releaseInfo), "Failed to release Image back to the Depth Swapchain");
     }
 
     // Fill out the XrCompositionLayerProjection structure for usage with xrEndFrame().
@@ -590,38 +1076,403 @@ private:
     return true;
   }
 
-  size_t renderCuboidIndex = 0;
-  void RenderCuboid(XrPosef pose, XrVector3f scale, XrVector3f color) {
-    XrMatrix4x4f_CreateTranslationRotationScale(&cameraConstants.model, &pose.position, &pose.orientation, &scale);
+  // Locates the views again at the frame's display time, now that the CPU work of the frame is done, and writes them into the
+  // passes' camera buffers and the projection views. The prediction is made closer to the display time, so head motion during
+  // the simulation and recording of the frame no longer adds to the latency. If the views cannot be located, the frame keeps
+  // the views it was built with.
+  void LateLatchViews(RenderLayerInfo &renderLayerInfo, const FrameData &frame) {
+    m_lateViews.assign(frame.views.size(), {XR_TYPE_VIEW});
+    XrViewState viewState{XR_TYPE_VIEW_STATE};
+    XrViewLocateInfo viewLocateInfo{XR_TYPE_VIEW_LOCATE_INFO};
+    viewLocateInfo.viewConfigurationType = m_viewConfiguration;
+    viewLocateInfo.displayTime = frame.frameState.predictedDisplayTime;
+    viewLocateInfo.space = m_localOrStageSpace;
+    uint32_t viewCount = 0;
+    XrResult result = xrLocateViews(m_session, &viewLocateInfo, &viewState, static_cast<uint32_t>(m_lateViews.size()), &viewCount, m_lateViews.data());
+    const XrViewStateFlags poseValid = XR_VIEW_STATE_ORIENTATION_VALID_BIT | XR_VIEW_STATE_POSITION_VALID_BIT;
+    if (result != XR_SUCCESS || viewCount != frame.views.size() || (viewState.viewStateFlags & poseValid) != poseValid) {
+      m_lateViews = frame.views;
+    }
 
-    XrMatrix4x4f_Multiply(&cameraConstants.modelViewProj, &cameraConstants.viewProj, &cameraConstants.model);
-    cameraConstants.color = {color.x, color.y, color.z, 1.0};
-    size_t offsetCameraUB = sizeof(CameraConstants) * renderCuboidIndex;
+    WriteCameraConstants(m_lateViews);
+    for (size_t i = 0; i < m_lateViews.size() && i < renderLayerInfo.layerProjectionViews.size(); i++) {
+      renderLayerInfo.layerProjectionViews[i].pose = m_lateViews[i].pose;
+      renderLayerInfo.layerProjectionViews[i].fov = m_lateViews[i].fov;
+    }
+  }
+  // Writes the view-projection transforms into the camera buffers RecordPasses() allocated: pass i renders the views from i.
+  // The buffers are persistently mapped, so this can wait until just before the command buffer is submitted.
+  void WriteCameraConstants(const std::vector<XrView> &views) {
+    const uint32_t passViewCount = m_multiview ? static_cast<uint32_t>(views.size()) : 1;
+    for (uint32_t i = 0; i < static_cast<uint32_t>(m_passCameraBuffers.size()); i++) {
+      if (!m_passCameraBuffers[i].data) {
+        continue;
+      }
+      CameraConstants cameraConstants{};
+      for (uint32_t j = 0; j < passViewCount && i + j < views.size(); j++) {
+        GetViewProj(cameraConstants.viewProj[j], views[i + j]);
+      }
+      memcpy(m_passCameraBuffers[i].data, &cameraConstants, sizeof(CameraConstants));
+    }
+  }
+  // Computes the view-projection transform of a view.
+  void GetViewProj(XrMatrix4x4f &viewProj, const XrView &xrView) {
+    // All matrices (including OpenXR's) are column-major, right-handed.
+    XrMatrix4x4f proj;
+    XrMatrix4x4f_CreateProjectionFov(&proj, m_apiType, xrView.fov, m_nearZ, m_farZ);
+    XrMatrix4x4f toView;
+    XrVector3f scale1m{1.0f, 1.0f, 1.0f};
+    XrMatrix4x4f_CreateTranslationRotationScale(&toView, &xrView.pose.position, &xrView.pose.orientation, &scale1m);
+    XrMatrix4x4f view;
+    XrMatrix4x4f_InvertRigidBody(&view, &toView);
+    XrMatrix4x4f_Multiply(&viewProj, &proj, &view);
+  }
+  // Records the render passes of the frame through the frame graph: pass i renders the views from i into colorViews[i] and
+  // depthViews[i], which are sized as m_viewConfigurationViews[i].
+  void RecordPasses(CommandBuffer &commandBuffer, const FrameData &frame, const std::vector<void *> &colorViews, const std::vector<void *> &depthViews) {
+    // VR mode use a background color. In AR mode make the background color black.
+    const float background = m_environmentBlendMode == XR_ENVIRONMENT_BLEND_MODE_OPAQUE ? 0.17f : 0.00f;
+
+    commandBuffer.Reset();
+    m_frameGraph->Reset();
+    m_foveationStatistics = {};
+    // Each pass reads its views from its own camera buffer, which WriteCameraConstants() fills after recording.
+    m_passCameraBuffers.resize(colorViews.size());
+    for (GraphicsAPI::TransientAllocation &cameraBuffer : m_passCameraBuffers) {
+      cameraBuffer = m_graphicsAPI->AllocateTransientBuffer(GraphicsAPI::BufferCreateInfo::Type::UNIFORM, sizeof(CameraConstants));
+    }
+    for (uint32_t i = 0; i < static_cast<uint32_t>(colorViews.size()); i++) {
+      // The images are imported at their full size, and the passes only render into the rectangle of the quality level.
+      uint32_t width = 0, height = 0;
+      GetRenderExtent(i, width, height);
+      const FrameGraph::Resource color = m_frameGraph->ImportImage("Color", colorViews[i], m_viewConfigurationViews[i].maxImageRectWidth, m_viewConfigurationViews[i].maxImageRectHeight);
+      const FrameGraph::Resource depth = m_frameGraph->ImportImage("Depth", depthViews[i], m_viewConfigurationViews[i].maxImageRectWidth, m_viewConfigurationViews[i].maxImageRectHeight);
+
+      const char *passName = m_passGpuZoneNames[std::min<size_t>(i, m_passGpuZoneNames.size() - 1)];
+      if (m_foveationMode != Foveation::Mode::OFF && i < frame.views.size()) {
+        AddFoveatedPasses(frame, i, color, depth, width, height, background);
+        continue;
+      }
+      m_foveationStatistics.fullPixels += static_cast<uint64_t>(width) * height;
+      m_foveationStatistics.shadedPixels += static_cast<uint64_t>(width) * height;
+      if (m_qualityLevel.sampleCount > 1 && !m_multiview && GetCuboidPipeline(m_qualityLevel.sampleCount)) {
+        AddMultisampledPasses(frame, i, color, depth, width, height, background);
+        continue;
+      }
+      auto drawViews = [this, &frame, i, width, height](CommandBuffer &commandBuffer) {
+        GraphicsAPI::Viewport viewport = {0.0f, 0.0f, (float)width, (float)height, 0.0f, 1.0f};
+        commandBuffer.SetViewports(&viewport, 1);
+
+        QueueCuboids(frame, m_passCameraBuffers[i], m_pipeline, {{(int32_t)0, (int32_t)0}, {width, height}});
+        m_drawQueue.Submit(commandBuffer);
+      };
+      m_frameGraph->AddPass(passName, drawViews)
+          .SetColorAttachment(color, FrameGraph::LoadOp::CLEAR, background, background, background, 1.00f)
+          .SetDepthAttachment(depth, FrameGraph::LoadOp::CLEAR, 1.0f);
+    }
+    m_frameGraph->Compile();
+    m_frameGraph->Execute(commandBuffer);
+  }
+  // Adds the passes of a foveated view: one renders the whole field of view into a transient image at the periphery's
+  // resolution, and the view's own pass upsamples it around the inset, then renders the inset at full resolution, scissored to it.
+  void AddFoveatedPasses(const FrameData &frame, uint32_t i, FrameGraph::Resource color, FrameGraph::Resource depth, uint32_t width, uint32_t height, float background) {
+    const XrView &view = frame.views[i];
+    const Foveation::Region region = Foveation::GetRegion(m_foveationProfile, view.fov, GetFoveationDirection(frame, view), width, height, m_apiType == VULKAN);
+    m_foveationStatistics.fullPixels += region.fullPixels;
+    m_foveationStatistics.shadedPixels += region.shadedPixels;
+
+    GraphicsAPI::ImageCreateInfo imageCI{2, region.peripheryWidth, region.peripheryHeight, 1, 1, 1, 1, m_colorSwapchainInfos[i].swapchainFormat, false, true, false, true};
+    const FrameGraph::Resource peripheryColor = m_frameGraph->CreateTransientImage("Periphery Color", imageCI);
+    imageCI.format = m_graphicsAPI->GetDepthFormat();
+    imageCI.colorAttachment = false;
+    imageCI.depthAttachment = true;
+    imageCI.sampled = false;
+    const FrameGraph::Resource peripheryDepth = m_frameGraph->CreateTransientImage("Periphery Depth", imageCI);
+
+    // The periphery is drawn with the same camera as the view, so it is written by WriteCameraConstants() like the view's pass.
+    auto drawPeriphery = [this, &frame, i, region](CommandBuffer &commandBuffer) {
+      GraphicsAPI::Viewport viewport = {0.0f, 0.0f, (float)region.peripheryWidth, (float)region.peripheryHeight, 0.0f, 1.0f};
+      commandBuffer.SetViewports(&viewport, 1);
+
+      QueueCuboids(frame, m_passCameraBuffers[i], m_pipeline, {{(int32_t)0, (int32_t)0}, {region.peripheryWidth, region.peripheryHeight}});
+      m_drawQueue.Submit(commandBuffer);
+    };
+    m_frameGraph->AddPass(m_peripheryGpuZoneNames[std::min<size_t>(i, m_peripheryGpuZoneNames.size() - 1)], drawPeriphery)
+        .SetColorAttachment(peripheryColor, FrameGraph::LoadOp::CLEAR, background, background, background, 1.00f)
+        .SetDepthAttachment(peripheryDepth, FrameGraph::LoadOp::CLEAR, 1.0f);
+
+    const GraphicsAPI::Rect2D &inset = region.inset;
+    const GraphicsAPI::TransientAllocation foveationUB = m_graphicsAPI->AllocateTransientBuffer(GraphicsAPI::BufferCreateInfo::Type::UNIFORM, sizeof(FoveationConstants));
+    if (foveationUB.data) {
+      FoveationConstants foveationConstants;
+      foveationConstants.insetRect = {(float)inset.offset.x, (float)inset.offset.y, (float)(inset.offset.x + inset.extent.width), (float)(inset.offset.y + inset.extent.height)};
+      foveationConstants.rcpImageSize = {1.0f / (float)width, 1.0f / (float)height, 0.0f, 0.0f};
+      memcpy(foveationUB.data, &foveationConstants, sizeof(FoveationConstants));
+    }
+    auto drawView = [this, &frame, i, width, height, inset, peripheryColor, foveationUB](CommandBuffer &commandBuffer) {
+      GraphicsAPI::Viewport viewport = {0.0f, 0.0f, (float)width, (float)height, 0.0f, 1.0f};
+      commandBuffer.SetViewports(&viewport, 1);
 
-    m_graphicsAPI->SetPipeline(m_pipeline);
+      QueuePeriphery(m_frameGraph->GetImage(peripheryColor), foveationUB, {{(int32_t)0, (int32_t)0}, {width, height}});
+      // The inset keeps the full viewport, so that it lines up with the periphery, and only its pixels are shaded.
+      QueueCuboids(frame, m_passCameraBuffers[i], m_pipeline, inset);
+      m_drawQueue.Submit(commandBuffer);
+    };
+    m_frameGraph->AddPass(m_passGpuZoneNames[std::min<size_t>(i, m_passGpuZoneNames.size() - 1)], drawView)
+        .SetColorAttachment(color, FrameGraph::LoadOp::CLEAR, background, background, background, 1.00f)
+        .SetDepthAttachment(depth, FrameGraph::LoadOp::CLEAR, 1.0f)
+        .Read(peripheryColor);
+  }
+  // Adds the passes of a multisampled view: one renders it into transient multisampled images, and the view's own pass resolves
+  // them into its image. The graphics APIs' resolves are not exposed through GraphicsAPI, so the resolve is a full screen draw.
+  void AddMultisampledPasses(const FrameData &frame, uint32_t i, FrameGraph::Resource color, FrameGraph::Resource depth, uint32_t width, uint32_t height, float background) {
+    const uint32_t sampleCount = m_qualityLevel.sampleCount;
+    GraphicsAPI::ImageCreateInfo imageCI{2, width, height, 1, 1, 1, sampleCount, m_colorSwapchainInfos[i].swapchainFormat, false, true, false, true};
+    const FrameGraph::Resource multisampledColor = m_frameGraph->CreateTransientImage("Multisampled Color", imageCI);
+    imageCI.format = m_graphicsAPI->GetDepthFormat();
+    imageCI.colorAttachment = false;
+    imageCI.depthAttachment = true;
+    imageCI.sampled = false;
+    const FrameGraph::Resource multisampledDepth = m_frameGraph->CreateTransientImage("Multisampled Depth", imageCI);
+
+    auto drawScene = [this, &frame, i, width, height, sampleCount](CommandBuffer &commandBuffer) {
+      GraphicsAPI::Viewport viewport = {0.0f, 0.0f, (float)width, (float)height, 0.0f, 1.0f};
+      commandBuffer.SetViewports(&viewport, 1);
 
-    m_graphicsAPI->SetBufferData(m_uniformBuffer_Camera, offsetCameraUB, sizeof(CameraConstants), &cameraConstants);
-    m_graphicsAPI->SetDescriptor({0, m_uniformBuffer_Camera, GraphicsAPI::DescriptorInfo::Type::BUFFER, GraphicsAPI::DescriptorInfo::Stage::VERTEX, false, offsetCameraUB, sizeof(CameraConstants)});
-    m_graphicsAPI->SetDescriptor({1, m_uniformBuffer_Normals, GraphicsAPI::DescriptorInfo::Type::BUFFER, GraphicsAPI::DescriptorInfo::Stage::VERTEX, false, 0, sizeof(normals)});
+      QueueCuboids(frame, m_passCameraBuffers[i], GetCuboidPipeline(sampleCount), {{(int32_t)0, (int32_t)0}, {width, height}});
+      m_drawQueue.Submit(commandBuffer);
+    };
+    m_frameGraph->AddPass(m_multisampledGpuZoneNames[std::min<size_t>(i, m_multisampledGpuZoneNames.size() - 1)], drawScene)
+        .SetColorAttachment(multisampledColor, FrameGraph::LoadOp::CLEAR, background, background, background, 1.00f)
+        .SetDepthAttachment(multisampledDepth, FrameGraph::LoadOp::CLEAR, 1.0f);
 
-    m_graphicsAPI->UpdateDescriptors();
+    auto drawView = [this, width, height, multisampledColor](CommandBuffer &commandBuffer) {
+      GraphicsAPI::Viewport viewport = {0.0f, 0.0f, (float)width, (float)height, 0.0f, 1.0f};
+      commandBuffer.SetViewports(&viewport, 1);
 
-    m_graphicsAPI->SetVertexBuffers(&m_vertexBuffer, 1);
-    m_graphicsAPI->SetIndexBuffer(m_indexBuffer);
-    m_graphicsAPI->DrawIndexed(36);
+      QueueResolve(m_frameGraph->GetImage(multisampledColor), {{(int32_t)0, (int32_t)0}, {width, height}});
+      m_drawQueue.Submit(commandBuffer);
+    };
+    m_frameGraph->AddPass(m_passGpuZoneNames[std::min<size_t>(i, m_passGpuZoneNames.size() - 1)], drawView)
+        .SetColorAttachment(color, FrameGraph::LoadOp::CLEAR, background, background, background, 1.00f)
+        .SetDepthAttachment(depth, FrameGraph::LoadOp::CLEAR, 1.0f)
+        .Read(multisampledColor);
+  }
+  // The size pass i renders at: the recommended size scaled by the quality level, within the swapchain's, which is the maximum.
+  void GetRenderExtent(uint32_t i, uint32_t &width, uint32_t &height) const {
+    const XrViewConfigurationView &viewConfigurationView = m_viewConfigurationViews[i];
+    width = std::max(static_cast<uint32_t>(std::round(viewConfigurationView.recommendedImageRectWidth * m_qualityLevel.resolutionScale)), 1u);
+    height = std::max(static_cast<uint32_t>(std::round(viewConfigurationView.recommendedImageRectHeight * m_qualityLevel.resolutionScale)), 1u);
+    width = std::min(width, viewConfigurationView.maxImageRectWidth);
+    height = std::min(height, viewConfigurationView.maxImageRectHeight);
+  }
+  // How far the quality levels can scale the resolution up before a view's image would exceed its swapchain.
+  float GetMaxResolutionScale() const {
+    float maxResolutionScale = std::numeric_limits<float>::max();
+    for (const XrViewConfigurationView &viewConfigurationView : m_viewConfigurationViews) {
+      maxResolutionScale = std::min(maxResolutionScale, (float)viewConfigurationView.maxImageRectWidth / (float)std::max(viewConfigurationView.recommendedImageRectWidth, 1u));
+      maxResolutionScale = std::min(maxResolutionScale, (float)viewConfigurationView.maxImageRectHeight / (float)std::max(viewConfigurationView.recommendedImageRectHeight, 1u));
+    }
+    return m_viewConfigurationViews.empty() ? 1.0f : maxResolutionScale;
+  }
+  // The direction of the inset's center in the view's space: the lens center, or the gaze with eye-tracked foveation.
+  XrVector3f GetFoveationDirection(const FrameData &frame, const XrView &view) {
+    XrVector3f direction{0.0f, 0.0f, -1.0f};
+    if (m_foveationMode != Foveation::Mode::EYE_TRACKED || !frame.gazeValid) {
+      return direction;
+    }
+    // The inverse of the view's rotation is its transpose.
+    XrMatrix4x4f viewRotation, toView;
+    XrMatrix4x4f_CreateFromQuaternion(&viewRotation, &view.pose.orientation);
+    XrMatrix4x4f_Transpose(&toView, &viewRotation);
+    XrMatrix4x4f_TransformVector3f(&direction, &toView, &frame.gazeDirection);
+    return direction;
+  }
+  // Queues the upsampling of a periphery into the view's image, everywhere but the inset. It goes in the BACKGROUND layer, ahead
+  // of the pass's other draws.
+  void QueuePeriphery(void *periphery, const GraphicsAPI::TransientAllocation &foveationUB, const GraphicsAPI::Rect2D &scissor) {
+    if (!periphery || !foveationUB.data || !m_graphicsAPI->IsPipelineReady(m_foveationPipeline)) {
+      return;
+    }
+    const GraphicsAPI::DescriptorInfo descriptors[] = {
+      {0, periphery, GraphicsAPI::DescriptorInfo::Type::IMAGE, GraphicsAPI::DescriptorInfo::Stage::FRAGMENT},
+      {GetSamplerBindingIndex(), m_linearClampSampler, GraphicsAPI::DescriptorInfo::Type::SAMPLER, GraphicsAPI::DescriptorInfo::Stage::FRAGMENT},
+      {2, foveationUB.buffer, GraphicsAPI::DescriptorInfo::Type::BUFFER, GraphicsAPI::DescriptorInfo::Stage::FRAGMENT, false, foveationUB.offset, foveationUB.size}};
+    QueueFullScreen(m_foveationPipeline, PipelineId::FOVEATION, descriptors, sizeof(descriptors) / sizeof(descriptors[0]), scissor);
+  }
+  // Queues the resolve of a multisampled image into the view's image.
+  void QueueResolve(void *multisampled, const GraphicsAPI::Rect2D &scissor) {
+    if (!multisampled || !m_graphicsAPI->IsPipelineReady(m_resolvePipeline)) {
+      return;
+    }
+    const GraphicsAPI::DescriptorInfo descriptors[] = {
+      {0, multisampled, GraphicsAPI::DescriptorInfo::Type::IMAGE, GraphicsAPI::DescriptorInfo::Stage::FRAGMENT},
+      {GetSamplerBindingIndex(), m_linearClampSampler, GraphicsAPI::DescriptorInfo::Type::SAMPLER, GraphicsAPI::DescriptorInfo::Stage::FRAGMENT}};
+    QueueFullScreen(m_resolvePipeline, PipelineId::RESOLVE, descriptors, sizeof(descriptors) / sizeof(descriptors[0]), scissor);
+  }
+  // A triangle over the viewport, without vertex or index buffers.
+  void QueueFullScreen(void *pipeline, PipelineId pipelineId, const GraphicsAPI::DescriptorInfo *descriptors, size_t descriptorCount, const GraphicsAPI::Rect2D &scissor) {
+    DrawQueue::DrawPacket packet{};
+    packet.sortKey = DrawQueue::MakeSortKey(DrawQueue::Layer::BACKGROUND, static_cast<uint32_t>(pipelineId), 0, 0.0f, m_farZ);
+    packet.pipeline = pipeline;
+    packet.count = 3;
+    packet.instanceCount = 1;
+    packet.scissor = scissor;
+    m_drawQueue.Add(packet, descriptors, descriptorCount);
+  }
+  // OpenGL pairs a sampler with the texture unit of its texture, where Vulkan has a binding for each.
+  uint32_t GetSamplerBindingIndex() const {
+    return m_apiType == VULKAN ? 1 : 0;
+  }
+  void *GetCuboidPipeline(uint32_t sampleCount) const {
+    if (sampleCount <= 1) {
+      return m_pipeline;
+    }
+    for (const std::pair<uint32_t, void *> &multisamplePipeline : m_multisamplePipelines) {
+      if (multisamplePipeline.first == sampleCount) {
+        return multisamplePipeline.second;
+      }
+    }
+    return nullptr;
+  }
 
-    renderCuboidIndex++;
+  // Queues a cuboid for the frame. Nothing is drawn until a pass queues them all with QueueCuboids().
+  void RenderCuboid(FrameData &frame, XrPosef pose, XrVector3f scale, XrVector3f color) {
+    XrMatrix4x4f model;
+    XrMatrix4x4f_CreateTranslationRotationScale(&model, &pose.position, &pose.orientation, &scale);
+    // The bottom row of an affine transform is always (0, 0, 0, 1), so only the top three rows are kept.
+    CuboidInstance cuboidInstance;
+    for (int row = 0; row < 3; row++) {
+      cuboidInstance.modelRows[row] = {model.m[row], model.m[4 + row], model.m[8 + row], model.m[12 + row]};
+    }
+    auto ToUnorm8 = [](float value) { return static_cast<uint32_t>(std::min(std::max(value, 0.0f), 1.0f) * 255.0f + 0.5f); };
+    cuboidInstance.color = ToUnorm8(color.x) | (ToUnorm8(color.y) << 8) | (ToUnorm8(color.z) << 16) | (255u << 24);
+    frame.cuboidInstances.push_back(cuboidInstance);
   }
+  void UploadCuboidInstances(const FrameData &frame) {
+    // Write the instances straight into this frame's part of the transient storage buffer, nearest to the views first, so
+    // that the instanced draw goes roughly front to back and the depth test rejects more of the hidden fragments early. The
+    // models and colors go into separate arrays, so that neither is padded to the alignment of the other.
+    m_cuboidModelBuffer = {};
+    m_cuboidColorBuffer = {};
+    if (frame.cuboidInstances.empty()) {
+      return;
+    }
+    m_cuboidModelBuffer = m_graphicsAPI->AllocateTransientBuffer(GraphicsAPI::BufferCreateInfo::Type::STORAGE, sizeof(CuboidInstance::modelRows) * frame.cuboidInstances.size());
+    m_cuboidColorBuffer = m_graphicsAPI->AllocateTransientBuffer(GraphicsAPI::BufferCreateInfo::Type::STORAGE, sizeof(CuboidInstance::color) * frame.cuboidInstances.size());
+    if (!m_cuboidModelBuffer.data || !m_cuboidColorBuffer.data) {
+      m_cuboidModelBuffer = {};
+      m_cuboidColorBuffer = {};
+      return;
+    }
+
+    XrVector3f viewsCenter{0.0f, 0.0f, 0.0f};
+    for (const XrView &view : frame.views) {
+      XrVector3f_Add(&viewsCenter, &viewsCenter, &view.pose.position);
+    }
+    XrVector3f_Scale(&viewsCenter, &viewsCenter, 1.0f / std::max<float>(static_cast<float>(frame.views.size()), 1.0f));
+    m_cuboidDepthKeys.resize(frame.cuboidInstances.size());
+    for (size_t i = 0; i < frame.cuboidInstances.size(); i++) {
+      const XrVector4f *modelRows = frame.cuboidInstances[i].modelRows;
+      XrVector3f toCuboid{modelRows[0].w, modelRows[1].w, modelRows[2].w};
+      XrVector3f_Sub(&toCuboid, &toCuboid, &viewsCenter);
+      m_cuboidDepthKeys[i] = DrawQueue::MakeSortKey(DrawQueue::Layer::SOLID, static_cast<uint32_t>(PipelineId::CUBOIDS), 0, XrVector3f_Length(&toCuboid), m_farZ);
+    }
+    DrawQueue::RadixSort(m_cuboidDepthKeys, m_cuboidOrder, m_cuboidOrderScratch);
+    uint8_t *models = static_cast<uint8_t *>(m_cuboidModelBuffer.data);
+    uint32_t *colors = static_cast<uint32_t *>(m_cuboidColorBuffer.data);
+    for (size_t i = 0; i < m_cuboidOrder.size(); i++) {
+      const CuboidInstance &cuboidInstance = frame.cuboidInstances[m_cuboidOrder[i]];
+      memcpy(models + i * sizeof(CuboidInstance::modelRows), cuboidInstance.modelRows, sizeof(CuboidInstance::modelRows));
+      colors[i] = cuboidInstance.color;
+    }
+    m_cuboidNearestKey = m_cuboidDepthKeys[m_cuboidOrder[0]];
+  }
+  // Queues the draw of this frame's cuboids into the pass's DrawQueue, scissored to 'scissor'. 'pipeline' is m_pipeline, or its
+  // counterpart for the sample count of a multisampled pass.
+  void QueueCuboids(const FrameData &frame, const GraphicsAPI::TransientAllocation &cameraUB, void *pipeline, const GraphicsAPI::Rect2D &scissor) {
+    // The pipeline links in the background. Until it is ready, skip the cuboids rather than stall the frame waiting for it.
+    if (!m_cuboidModelBuffer.data || !cameraUB.data || !pipeline || !m_graphicsAPI->IsPipelineReady(pipeline)) {
+      return;
+    }
+
+    const GraphicsAPI::DescriptorInfo descriptors[] = {
+      {0, cameraUB.buffer, GraphicsAPI::DescriptorInfo::Type::BUFFER, GraphicsAPI::DescriptorInfo::Stage::VERTEX, false, cameraUB.offset, cameraUB.size},
+      {1, m_uniformBuffer_Normals, GraphicsAPI::DescriptorInfo::Type::BUFFER, GraphicsAPI::DescriptorInfo::Stage::VERTEX, false, 0, sizeof(normals)},
+      {2, m_uniformBuffer_Material, GraphicsAPI::DescriptorInfo::Type::BUFFER, GraphicsAPI::DescriptorInfo::Stage::FRAGMENT, false, 0, sizeof(MaterialConstants)},
+      {3, m_cuboidModelBuffer.buffer, GraphicsAPI::DescriptorInfo::Type::BUFFER, GraphicsAPI::DescriptorInfo::Stage::VERTEX, false, m_cuboidModelBuffer.offset, m_cuboidModelBuffer.size},
+      {4, m_cuboidColorBuffer.buffer, GraphicsAPI::DescriptorInfo::Type::BUFFER, GraphicsAPI::DescriptorInfo::Stage::VERTEX, false, m_cuboidColorBuffer.offset, m_cuboidColorBuffer.size}};
+
+    // All the cuboids are one instanced draw, keyed by the nearest of them.
+    DrawQueue::DrawPacket packet{};
+    packet.sortKey = m_cuboidNearestKey;
+    packet.pipeline = pipeline;
+    packet.vertexBuffer = m_vertexBuffer;
+    packet.indexBuffer = m_indexBuffer;
+    packet.count = 36;
+    packet.instanceCount = static_cast<uint32_t>(frame.cuboidInstances.size());
+    packet.scissor = scissor;
+    m_drawQueue.Add(packet, descriptors, sizeof(descriptors) / sizeof(descriptors[0]));
+  }
+  // Writes the material constants into their uniform buffer if they changed since the last write.
+  void UploadMaterial() {
+    if (memcmp(&m_material, &m_uploadedMaterial, sizeof(MaterialConstants)) == 0) {
+      return;
+    }
+    m_graphicsAPI->SetBufferData(m_uniformBuffer_Material, 0, sizeof(MaterialConstants), &m_material);
+    m_uploadedMaterial = m_material;
+  }
+  // Uniform data is split by how often it changes. Per view: CameraConstants, written once per pass just before submission. Per material:
+  // MaterialConstants, kept in a uniform buffer that is only written when they change. Per object: a CuboidInstance, packed
+  // into the instance arrays of the frame's single instanced draw. The model-view-projection product is formed in the shader.
+  // One viewProj per view rendered in the pass; only the first is used without multiview.
   struct CameraConstants {
-    XrMatrix4x4f viewProj;
-    XrMatrix4x4f modelViewProj;
-    XrMatrix4x4f model;
-    XrVector4f color;
-    XrVector4f pad1;
-    XrVector4f pad2;
-    XrVector4f pad3;
+    XrMatrix4x4f viewProj[2];
+  };
+  // Matches Material in PixelShader.glsl (std140).
+  struct MaterialConstants {
+    XrVector4f lightDirection;
+    float ambient;
+    float diffuse;
+    float pad[2];
+  };
+  // Matches Foveation in PixelShader_Foveation.glsl (std140).
+  struct FoveationConstants {
+    XrVector4f insetRect;     // Min x, min y, max x, max y, in pixels.
+    XrVector4f rcpImageSize;  // 1 / width, 1 / height.
+  };
+  // Over the views of the last frame recorded. Without foveation, every pixel is shaded.
+  struct FoveationStatistics {
+    uint64_t fullPixels;
+    uint64_t shadedPixels;
   };
-  CameraConstants cameraConstants;
+  // The per-object data in VertexShader.glsl: 52 bytes, rather than the 80 of a full model matrix and a float color.
+  struct CuboidInstance {
+    XrVector4f modelRows[3];  // The top three rows of the affine model transform.
+    uint32_t color;           // RGBA8.
+  };
+  GraphicsAPI::TransientAllocation m_cuboidModelBuffer{};
+  GraphicsAPI::TransientAllocation m_cuboidColorBuffer{};
+  std::vector<uint64_t> m_cuboidDepthKeys;
+  std::vector<uint32_t> m_cuboidOrder;
+  std::vector<uint32_t> m_cuboidOrderScratch;
+  uint64_t m_cuboidNearestKey = 0;
+  DrawQueue m_drawQueue;  // Each pass queues all of its draws, then submits them once.
+  static constexpr float m_nearZ = 0.05f;
+  static constexpr float m_farZ = 100.0f;
+  CommandBuffer m_commandBuffer;
+  std::unique_ptr<FrameGraph> m_frameGraph;
+  // GPU zone names must outlive the GraphicsAPI. The last one is shared by any further passes.
+  const std::array<const char *, 3> m_passGpuZoneNames = {"Pass 0", "Pass 1", "Pass N"};
+  const std::array<const char *, 3> m_peripheryGpuZoneNames = {"Periphery 0", "Periphery 1", "Periphery N"};
+  const std::array<const char *, 3> m_multisampledGpuZoneNames = {"Multisampled 0", "Multisampled 1", "Multisampled N"};
+  std::vector<GraphicsAPI::TransientAllocation> m_passCameraBuffers;
+  std::vector<XrView> m_lateViews;
+  MaterialConstants m_material = {{0.4364358f, 0.8728716f, 0.2182179f, 0.0f}, 0.1f, 0.9f, {0.0f, 0.0f}};  // Light from (0.5, 1.0, 0.25).
+  MaterialConstants m_uploadedMaterial{};
+  Foveation::Mode m_foveationMode = Foveation::Mode::OFF;
+  Foveation::Profile m_foveationProfile = {0.4f, 0.5f};  // A full resolution inset 40% of the image across, the rest at half resolution.
+  FoveationStatistics m_foveationStatistics{};
   XrVector4f normals[6] = {
     {1.00f, 0.00f, 0.00f, 0},
     {-1.00f, 0.00f, 0.00f, 0},
@@ -667,18 +1518,60 @@ private:
 
     m_indexBuffer = m_graphicsAPI->CreateBuffer({GraphicsAPI::BufferCreateInfo::Type::INDEX, sizeof(uint32_t), sizeof(cubeIndices), &cubeIndices});
 
-    size_t numberOfCuboids = 2;
-    m_uniformBuffer_Camera = m_graphicsAPI->CreateBuffer({GraphicsAPI::BufferCreateInfo::Type::UNIFORM, 0, sizeof(CameraConstants) * numberOfCuboids, nullptr});
     m_uniformBuffer_Normals = m_graphicsAPI->CreateBuffer({GraphicsAPI::BufferCreateInfo::Type::UNIFORM, 0, sizeof(normals), &normals});
+    m_uniformBuffer_Material = m_graphicsAPI->CreateBuffer({GraphicsAPI::BufferCreateInfo::Type::UNIFORM, 0, sizeof(MaterialConstants), &m_material});
+    m_uploadedMaterial = m_material;
 
 
     if (m_apiType == OPENGL) {
       std::string vertexSource = ReadTextFile("VertexShader.glsl");
+      if (m_multiview) {
+        // Enable the multiview path in the shader; #defines must follow the #version line.
+        vertexSource.insert(vertexSource.find('\n') + 1, "#define MULTIVIEW\n");
+      }
       m_vertexShader = m_graphicsAPI->CreateShader({GraphicsAPI::ShaderCreateInfo::Type::VERTEX, vertexSource.data(), vertexSource.size()});
 
       std::string fragmentSource = ReadTextFile("PixelShader.glsl");
       m_fragmentShader = m_graphicsAPI->CreateShader({GraphicsAPI::ShaderCreateInfo::Type::FRAGMENT, fragmentSource.data(), fragmentSource.size()});
     }
+    if (m_apiType == VULKAN) {
+      // Compiled from the same GLSL by the build. GraphicsAPI_Vulkan does not support multiview, so there is no MULTIVIEW variant.
+      std::vector<char> vertexSource = ReadBinaryFile("VertexShader.spv");
+      m_vertexShader = m_graphicsAPI->CreateShader({GraphicsAPI::ShaderCreateInfo::Type::VERTEX, vertexSource.data(), vertexSource.size()});
+
+      std::vector<char> fragmentSource = ReadBinaryFile("PixelShader.spv");
+      m_fragmentShader = m_graphicsAPI->CreateShader({GraphicsAPI::ShaderCreateInfo::Type::FRAGMENT, fragmentSource.data(), fragmentSource.size()});
+    }
+    // The full screen passes' shaders, loaded like the cuboid's: GLSL for OpenGL, SPIR-V compiled from it for Vulkan.
+    auto CreateShader = [this](GraphicsAPI::ShaderCreateInfo::Type type, const std::string &name) -> void * {
+      if (m_apiType == VULKAN) {
+        std::vector<char> source = ReadBinaryFile(name + ".spv");
+        return m_graphicsAPI->CreateShader({type, source.data(), source.size()});
+      }
+      std::string source = ReadTextFile(name + ".glsl");
+      return m_graphicsAPI->CreateShader({type, source.data(), source.size()});
+    };
+
+    // MSAA renders into transient multisampled images and resolves them into the view's image, one view per pass.
+    const uint32_t maxSampleCount = (m_multiview || m_foveationMode != Foveation::Mode::OFF) ? 1 : 4;  // Every Vulkan and OpenGL ES 3 device supports 4x on color and depth.
+    const std::vector<QualityGovernor::Level> qualityLevels = QualityGovernor::MakeDefaultLevels(maxSampleCount, GetMaxResolutionScale());
+    // Start without MSAA, at the recommended resolution, and let the governor step up if there is headroom.
+    uint32_t initialQualityLevel = 0;
+    while (initialQualityLevel + 1 < qualityLevels.size() && (qualityLevels[initialQualityLevel].sampleCount > 1 || qualityLevels[initialQualityLevel].resolutionScale > 1.0f)) {
+      initialQualityLevel++;
+    }
+    m_qualityGovernor = std::make_unique<QualityGovernor>(qualityLevels, initialQualityLevel);
+    m_qualityLevel = m_qualityGovernor->GetLevel();
+
+    if (m_foveationMode != Foveation::Mode::OFF || maxSampleCount > 1) {
+      m_fullScreenVertexShader = CreateShader(GraphicsAPI::ShaderCreateInfo::Type::VERTEX, "VertexShader_FullScreen");
+    }
+    if (m_foveationMode != Foveation::Mode::OFF) {
+      m_foveationFragmentShader = CreateShader(GraphicsAPI::ShaderCreateInfo::Type::FRAGMENT, "PixelShader_Foveation");
+    }
+    if (maxSampleCount > 1) {
+      m_resolveFragmentShader = CreateShader(GraphicsAPI::ShaderCreateInfo::Type::FRAGMENT, "PixelShader_Resolve");
+    }
 
 
     GraphicsAPI::PipelineCreateInfo pipelineCI;
@@ -694,14 +1587,74 @@ private:
     pipelineCI.depthFormat = m_graphicsAPI->GetDepthFormat();
     pipelineCI.layout = {{0, nullptr, GraphicsAPI::DescriptorInfo::Type::BUFFER, GraphicsAPI::DescriptorInfo::Stage::VERTEX},
                          {1, nullptr, GraphicsAPI::DescriptorInfo::Type::BUFFER, GraphicsAPI::DescriptorInfo::Stage::VERTEX},
-                         {2, nullptr, GraphicsAPI::DescriptorInfo::Type::BUFFER, GraphicsAPI::DescriptorInfo::Stage::FRAGMENT}};
+                         {2, nullptr, GraphicsAPI::DescriptorInfo::Type::BUFFER, GraphicsAPI::DescriptorInfo::Stage::FRAGMENT},
+                         {3, nullptr, GraphicsAPI::DescriptorInfo::Type::BUFFER, GraphicsAPI::DescriptorInfo::Stage::VERTEX, true},   // readWrite: a storage buffer.
+                         {4, nullptr, GraphicsAPI::DescriptorInfo::Type::BUFFER, GraphicsAPI::DescriptorInfo::Stage::VERTEX, true}};
     m_pipeline = m_graphicsAPI->CreatePipeline(pipelineCI);
+    // The cuboids' pipeline for each sample count the quality levels render at.
+    for (const QualityGovernor::Level &qualityLevel : qualityLevels) {
+      if (qualityLevel.sampleCount > 1 && !GetCuboidPipeline(qualityLevel.sampleCount)) {
+        GraphicsAPI::PipelineCreateInfo multisamplePipelineCI = pipelineCI;
+        multisamplePipelineCI.multisampleState.rasterisationSamples = qualityLevel.sampleCount;
+        m_multisamplePipelines.push_back({qualityLevel.sampleCount, m_graphicsAPI->CreatePipeline(multisamplePipelineCI)});
+      }
+    }
+
+    // The full screen passes draw a triangle over the viewport: no vertex input, depth or blending.
+    GraphicsAPI::PipelineCreateInfo fullScreenPipelineCI = pipelineCI;
+    fullScreenPipelineCI.vertexInputState = {};
+    fullScreenPipelineCI.rasterisationState.cullMode = GraphicsAPI::CullMode::NONE;
+    fullScreenPipelineCI.depthStencilState = {false, false, GraphicsAPI::CompareOp::ALWAYS, false, false, {}, {}, 0.0f, 1.0f};
+    fullScreenPipelineCI.colorBlendState.attachments[0].blendEnable = false;
+    // OpenGL pairs a sampler with the texture unit of its texture, where Vulkan has a binding for each.
+    fullScreenPipelineCI.layout = {{0, nullptr, GraphicsAPI::DescriptorInfo::Type::IMAGE, GraphicsAPI::DescriptorInfo::Stage::FRAGMENT},
+                                   {GetSamplerBindingIndex(), nullptr, GraphicsAPI::DescriptorInfo::Type::SAMPLER, GraphicsAPI::DescriptorInfo::Stage::FRAGMENT}};
+    if (m_resolveFragmentShader) {
+      fullScreenPipelineCI.shaders = {m_fullScreenVertexShader, m_resolveFragmentShader};
+      m_resolvePipeline = m_graphicsAPI->CreatePipeline(fullScreenPipelineCI);
+    }
+    if (m_foveationFragmentShader) {
+      // Upsamples the periphery, before the inset is drawn.
+      fullScreenPipelineCI.shaders = {m_fullScreenVertexShader, m_foveationFragmentShader};
+      fullScreenPipelineCI.layout.push_back({2, nullptr, GraphicsAPI::DescriptorInfo::Type::BUFFER, GraphicsAPI::DescriptorInfo::Stage::FRAGMENT});
+      m_foveationPipeline = m_graphicsAPI->CreatePipeline(fullScreenPipelineCI);
+    }
+    if (m_fullScreenVertexShader) {
+      m_linearClampSampler = m_graphicsAPI->CreateSampler({GraphicsAPI::SamplerCreateInfo::Filter::LINEAR, GraphicsAPI::SamplerCreateInfo::Filter::LINEAR, GraphicsAPI::SamplerCreateInfo::MipmapMode::NEAREST,
+                                                           GraphicsAPI::SamplerCreateInfo::AddressMode::CLAMP_TO_EDGE, GraphicsAPI::SamplerCreateInfo::AddressMode::CLAMP_TO_EDGE, GraphicsAPI::SamplerCreateInfo::AddressMode::CLAMP_TO_EDGE,
+                                                           0.0f, false, GraphicsAPI::CompareOp::NEVER, 0.0f, 0.0f, {0.0f, 0.0f, 0.0f, 0.0f}});
+    }
+
+    const GraphicsAPI::PipelineCacheStatistics &pipelineCacheStatistics = m_graphicsAPI->GetPipelineCacheStatistics();
+    std::cout << "Pipeline cache: " << pipelineCacheStatistics.hits << " hits, " << pipelineCacheStatistics.misses << " misses, ";
+    std::cout << pipelineCacheStatistics.duplicates << " duplicates, ";
+    std::cout << pipelineCacheStatistics.millisecondsSaved << " ms saved." << std::endl;
+
+    m_frameGraph = std::make_unique<FrameGraph>(m_graphicsAPI.get());
   }
   void DestroyResources() {
+    m_frameGraph.reset();
+    if (m_fullScreenVertexShader) {
+      m_graphicsAPI->DestroySampler(m_linearClampSampler);
+      if (m_foveationPipeline) {
+        m_graphicsAPI->DestroyPipeline(m_foveationPipeline);
+        m_graphicsAPI->DestroyShader(m_foveationFragmentShader);
+      }
+      if (m_resolvePipeline) {
+        m_graphicsAPI->DestroyPipeline(m_resolvePipeline);
+        m_graphicsAPI->DestroyShader(m_resolveFragmentShader);
+      }
+      m_graphicsAPI->DestroyShader(m_fullScreenVertexShader);
+    }
+    for (std::pair<uint32_t, void *> &multisamplePipeline : m_multisamplePipelines) {
+      m_graphicsAPI->DestroyPipeline(multisamplePipeline.second);
+    }
+    m_multisamplePipelines.clear();
+    m_qualityGovernor.reset();
     m_graphicsAPI->DestroyPipeline(m_pipeline);
     m_graphicsAPI->DestroyShader(m_fragmentShader);
     m_graphicsAPI->DestroyShader(m_vertexShader);
-    m_graphicsAPI->DestroyBuffer(m_uniformBuffer_Camera);
+    m_graphicsAPI->DestroyBuffer(m_uniformBuffer_Material);
     m_graphicsAPI->DestroyBuffer(m_uniformBuffer_Normals);
     m_graphicsAPI->DestroyBuffer(m_indexBuffer);
     m_graphicsAPI->DestroyBuffer(m_vertexBuffer);
@@ -724,13 +1677,43 @@ private:
   std::unique_ptr<GraphicsAPI> m_graphicsAPI = nullptr;
 
   XrSession m_session = XR_NULL_HANDLE;
-  XrSessionState m_sessionState = XR_SESSION_STATE_UNKNOWN;
+  std::atomic<XrSessionState> m_sessionState{XR_SESSION_STATE_UNKNOWN};  // Written by PollEvents(), read by the frame thread.
 
   XrViewConfigurationType m_viewConfiguration = XR_VIEW_CONFIGURATION_TYPE_PRIMARY_STEREO;
 
   bool m_applicationRunning = true;
   bool m_sessionRunning = false;
 
+  // One frame passing through the pipeline: the frame thread waits on it, the simulation thread fills it in and the render
+  // thread draws and ends it.
+  struct FrameData {
+    XrFrameState frameState{XR_TYPE_FRAME_STATE};
+    bool shouldRender = false;
+    std::vector<XrView> views;
+    bool gazeValid = false;
+    XrVector3f gazeDirection{0.0f, 0.0f, -1.0f};  // In the reference space, for eye-tracked foveation.
+    std::vector<CuboidInstance> cuboidInstances;
+  };
+  static constexpr size_t m_framesInFlight = 2;
+  FrameData m_frames[m_framesInFlight];
+  BoundedQueue<FrameData *> m_freeFrames{m_framesInFlight};
+  BoundedQueue<FrameData *> m_simulateFrames{m_framesInFlight};
+  BoundedQueue<FrameData *> m_renderFrames{m_framesInFlight};
+  std::thread m_frameThread;
+  std::thread m_simulateThread;
+  std::thread m_renderThread;
+  std::atomic<bool> m_stopFramePipeline{false};
+  bool m_framePipelineRunning = false;
+
+  uint64_t m_frameIndex = 0;
+  uint64_t m_simulateFrameIndex = 0;  // Frames simulated, which step the gaze script.
+  uint64_t m_frameStatisticsInterval = 90;  // Log the GraphicsAPI::FrameStatistics roughly once a second.
+
+  // Picks the resolution and MSAA from the frame timing. The render thread reads the level at the start of a frame.
+  std::unique_ptr<QualityGovernor> m_qualityGovernor;
+  QualityGovernor::Level m_qualityLevel{1.0f, 1};
+  XrTime m_lastDisplayTime = 0;  // Of the last frame rendered, to count the display periods the next one misses.
+
 
   std::vector<XrViewConfigurationView> m_viewConfigurationViews;
 
@@ -741,12 +1724,22 @@ private:
   };
   std::vector<SwapchainInfo> m_colorSwapchainInfos = {};
   std::vector<SwapchainInfo> m_depthSwapchainInfos = {};
+  bool m_multiview = false;
+  std::vector<void *> m_benchmarkImages = {};  // Stand in for the swapchain images in RunBenchmark().
+  int64_t m_benchmarkColorFormat = 0;
 
   std::vector<XrEnvironmentBlendMode> m_applicationEnvironmentBlendModes = {XR_ENVIRONMENT_BLEND_MODE_OPAQUE, XR_ENVIRONMENT_BLEND_MODE_ADDITIVE};
   std::vector<XrEnvironmentBlendMode> m_environmentBlendModes = {};
   XrEnvironmentBlendMode m_environmentBlendMode = XR_ENVIRONMENT_BLEND_MODE_MAX_ENUM;
 
   XrSpace m_localOrStageSpace = XR_NULL_HANDLE;
+
+  bool m_eyeGazeSupported = false;
+  XrActionSet m_gazeActionSet = XR_NULL_HANDLE;
+  XrAction m_gazeAction = XR_NULL_HANDLE;
+  XrSpace m_gazeSpace = XR_NULL_HANDLE;
+  std::vector<XrVector2f> m_gazeScript;  // Yaw and pitch in degrees.
+  bool m_scriptedGaze = false;
   struct RenderLayerInfo {
     XrTime predictedDisplayTime;
     std::vector<XrCompositionLayerBaseHeader *> layers;
@@ -758,20 +1751,104 @@ private:
 
   void *m_vertexBuffer = nullptr;
   void *m_indexBuffer = nullptr;
-  void *m_uniformBuffer_Camera = nullptr;
   void *m_uniformBuffer_Normals = nullptr;
+  void *m_uniformBuffer_Material = nullptr;
   void *m_vertexShader = nullptr, *m_fragmentShader = nullptr;
   void *m_pipeline = nullptr;
+  std::vector<std::pair<uint32_t, void *>> m_multisamplePipelines;  // The cuboids' pipeline by sample count, above one.
+  void *m_fullScreenVertexShader = nullptr;
+  void *m_foveationFragmentShader = nullptr, *m_resolveFragmentShader = nullptr;
+  void *m_foveationPipeline = nullptr, *m_resolvePipeline = nullptr;
+  void *m_linearClampSampler = nullptr;
 };
 
-void OpenXRTutorial_Main(GraphicsAPI_Type apiType) {
+// Reads a gaze script: one "yaw pitch" sample in degrees per line. Returns no samples if the file cannot be read.
+std::vector<XrVector2f> ReadGazeScript(const std::string &path) {
+  std::vector<XrVector2f> gazeScript;
+  std::ifstream file(path);
+  if (!file) {
+    std::cout << "ERROR: Could not read the gaze script " << path << "." << std::endl;
+    return gazeScript;
+  }
+  XrVector2f yawPitch;
+  while (file >> yawPitch.x >> yawPitch.y) {
+    gazeScript.push_back(yawPitch);
+  }
+  return gazeScript;
+}
+
+// Parses the --benchmark frame count, which must be a whole number from 1 to UINT32_MAX.
+bool ParseFrameCount(const std::string &text, uint32_t &frameCount) {
+  if (text.empty() || !std::isdigit(static_cast<unsigned char>(text[0]))) {
+    return false;
+  }
+  char *end = nullptr;
+  errno = 0;
+  const unsigned long long value = std::strtoull(text.c_str(), &end, 10);
+  if (*end != '\0' || errno == ERANGE || value == 0 || value > std::numeric_limits<uint32_t>::max()) {
+    return false;
+  }
+  frameCount = static_cast<uint32_t>(value);
+  return true;
+}
+
+void OpenXRTutorial_Main(GraphicsAPI_Type apiType, Foveation::Mode foveationMode, const std::vector<XrVector2f> &gazeScript) {
   DebugOutput debugOutput;  // This redirects std::cerr and std::cout to the IDE's output or Android Studio's logcat.
   std::cout << "OpenXR Tutorial Chapter 2." << std::endl;
 
   OpenXRTutorial app(apiType);
+  app.SetFoveation(foveationMode, gazeScript);
   app.Run();
 }
 
 int main(int argc, char **argv) {
-  OpenXRTutorial_Main(OPENGL);
-}
\ No newline at end of file
+  // --vulkan renders with GraphicsAPI_Vulkan instead of GraphicsAPI_OpenGL.
+  // --benchmark [frames] measures the CPU cost of the renderer on GraphicsAPI_Null, without OpenXR or a GPU. With --vulkan or
+  // --opengl, it renders the frames on that API instead, still without OpenXR or a window.
+  // --foveation off|fixed|eye renders the periphery of each view at a reduced resolution, around an inset at the lens center or
+  // the gaze. --gaze-script <file> drives eye-tracked foveation from a script of "yaw pitch" lines in degrees instead of the
+  // eye tracker; the benchmark follows a built-in sweep without one.
+  GraphicsAPI_Type apiType = OPENGL;
+  bool render = false;
+  Foveation::Mode foveationMode = Foveation::Mode::OFF;
+  std::vector<XrVector2f> gazeScript;
+  std::vector<std::string> arguments;
+  for (int i = 1; i < argc; i++) {
+    if (std::string(argv[i]) == "--vulkan") {
+      apiType = VULKAN;
+      render = true;
+    } else if (std::string(argv[i]) == "--opengl") {
+      apiType = OPENGL;
+      render = true;
+    } else if (std::string(argv[i]) == "--foveation") {
+      const std::string mode = i + 1 < argc ? argv[++i] : "";
+      if (mode == "off") {
+        foveationMode = Foveation::Mode::OFF;
+      } else if (mode == "fixed") {
+        foveationMode = Foveation::Mode::FIXED;
+      } else if (mode == "eye") {
+        foveationMode = Foveation::Mode::EYE_TRACKED;
+      } else {
+        std::cout << "ERROR: --foveation expects off, fixed or eye, not '" << mode << "'." << std::endl;
+        return 1;
+      }
+    } else if (std::string(argv[i]) == "--gaze-script" && i + 1 < argc) {
+      gazeScript = ReadGazeScript(argv[++i]);
+    } else {
+      arguments.push_back(argv[i]);
+    }
+  }
+  if (!arguments.empty() && arguments[0] == "--benchmark") {
+    DebugOutput debugOutput;
+    uint32_t frameCount = 1000;
+    if (arguments.size() > 1 && !ParseFrameCount(arguments[1], frameCount)) {
+      std::cout << "ERROR: --benchmark expects a frame count from 1 to " << std::numeric_limits<uint32_t>::max() << ", not '" << arguments[1] << "'." << std::endl;
+      std::cout << "Usage: --benchmark [frames] [--vulkan | --opengl] [--foveation off|fixed|eye] [--gaze-script <file>]" << std::endl;
+      return 1;
+    }
+    OpenXRTutorial app(apiType);
+    app.SetFoveation(foveationMode, gazeScript);
+    return app.RunBenchmark(frameCount, render) ? 0 : 1;
+  }
+  OpenXRTutorial_Main(apiType, foveationMode, gazeScript);
+}